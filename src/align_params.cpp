@@ -21,6 +21,8 @@ File description:
     Image alignment parameters dialog.
 */
 
+#include <tuple>
+#include <vector>
 #include <wx/artprov.h>
 #include <wx/button.h>
 #include <wx/checkbox.h>
@@ -33,6 +35,7 @@ File description:
 #include <wx/msgdlg.h>
 #include <wx/radiobox.h>
 #include <wx/sizer.h>
+#include <wx/spinctrl.h>
 #include <wx/statline.h>
 #include <wx/stattext.h>
 #include <wx/textctrl.h>
@@ -43,6 +46,7 @@ File description:
 #include "appconfig.h"
 #include "common/common.h"
 #include "common/formats.h"
+#include "image/image.h"
 #include "scrollable_dlg.h"
 
 enum
@@ -58,7 +62,9 @@ enum
     ID_Crop,
     ID_CropBitmap,
     ID_Method,
-    ID_MethodBitmap
+    ID_MethodBitmap,
+    ID_Roi,
+    ID_CoarseToFine
 };
 
 const int BORDER = 5; ///< Border size (in pixels) between controls
@@ -97,6 +103,13 @@ class c_ImageAlignmentParams: public c_ScrollableDialog
     wxEditableListBox m_FileList;
     wxGenericStaticBitmap* m_CropBitmapCtrl{nullptr};
     wxStaticText* m_AlignMethodTextCtrl{nullptr};
+    wxRadioBox* m_MethodCtrl{nullptr};
+    wxRadioBox* m_RoiModeCtrl{nullptr};
+    std::vector<wxSpinCtrl*> m_RoiCtrls; ///< X, Y, width and height of user-specified region of interest
+    wxCheckBox* m_CoarseToFineCtrl{nullptr};
+
+    /// Enables the phase correlation controls applicable to the selected alignment method and ROI mode.
+    void UpdatePhaseCorrelationControls();
 
     wxBitmap m_CropBitmaps[2]; ///< Bitmaps illustrating the "pad to bounding box" and "crop to intersection" output modes
 
@@ -115,6 +128,7 @@ BEGIN_EVENT_TABLE(c_ImageAlignmentParams, wxDialog)
     EVT_BUTTON(ID_Start, c_ImageAlignmentParams::OnCommandEvent)
     EVT_RADIOBOX(ID_Crop, c_ImageAlignmentParams::OnCommandEvent)
     EVT_RADIOBOX(ID_Method, c_ImageAlignmentParams::OnCommandEvent)
+    EVT_RADIOBOX(ID_Roi, c_ImageAlignmentParams::OnCommandEvent)
     EVT_DIRPICKER_CHANGED(ID_OutputDir, c_ImageAlignmentParams::OnOutputDirChanged)
 END_EVENT_TABLE()
 
@@ -154,6 +168,17 @@ void c_ImageAlignmentParams::OnOutputDirChanged(wxFileDirPickerEvent& event)
 #endif
 }
 
+void c_ImageAlignmentParams::UpdatePhaseCorrelationControls()
+{
+    const bool isPhaseCorrelation = (m_MethodCtrl->GetSelection() == static_cast<int>(AlignmentMethod::PHASE_CORRELATION));
+    m_RoiModeCtrl->Enable(isPhaseCorrelation);
+    for (auto* ctrl: m_RoiCtrls)
+    {
+        ctrl->Enable(isPhaseCorrelation && m_RoiModeCtrl->GetSelection() == static_cast<int>(RoiMode::USER));
+    }
+    m_CoarseToFineCtrl->Enable(isPhaseCorrelation);
+}
+
 void c_ImageAlignmentParams::OnCommandEvent(wxCommandEvent& event)
 {
     switch (event.GetId())
@@ -164,9 +189,14 @@ void c_ImageAlignmentParams::OnCommandEvent(wxCommandEvent& event)
 
     case ID_Method:
         m_AlignMethodTextCtrl->SetLabel(GetAlignmentMethodDescription(static_cast<AlignmentMethod>(event.GetInt())));
+        UpdatePhaseCorrelationControls();
         Layout();
         break;
 
+    case ID_Roi:
+        UpdatePhaseCorrelationControls();
+        break;
+
     case ID_AddFiles:
         {
             wxFileDialog fileDlg(this, _("Choose input file(s)"), Configuration::AlignInputPath, wxEmptyString, INPUT_FILE_FILTERS, wxFD_OPEN | wxFD_MULTIPLE);
@@ -210,6 +240,17 @@ void c_ImageAlignmentParams::OnCommandEvent(wxCommandEvent& event)
             else
             {
                 TransferDataFromWindow();
+                if (m_Parameters.alignmentMethod == AlignmentMethod::PHASE_CORRELATION && m_Parameters.roiMode == RoiMode::USER)
+                {
+                    const auto imgSize = GetImageSize(ToFsPath(strings[0]));
+                    if (imgSize.has_value() && !IsRoiWithinImage(m_Parameters.roi, std::get<0>(*imgSize), std::get<1>(*imgSize)))
+                    {
+                        wxMessageBox(wxString::Format(_("Region of interest must lie within the first image (%dx%d)."),
+                            std::get<0>(*imgSize), std::get<1>(*imgSize)), _("Error"), wxICON_ERROR, this);
+                        break;
+                    }
+                }
+                Configuration::AlignCoarseToFine = m_Parameters.coarseToFine;
                 EndModal(wxID_OK);
             }
             break;
@@ -230,6 +271,11 @@ void c_ImageAlignmentParams::DoInitControls()
     m_Parameters.subpixelAlignment = true;
     m_Parameters.alignmentMethod = AlignmentMethod::PHASE_CORRELATION;
     m_Parameters.normalizeFitsValues = Configuration::NormalizeFITSValues;
+    m_Parameters.roiMode = RoiMode::WHOLE_IMAGE;
+    m_Parameters.roi = Rectangle_t(0, 0, 512, 512);
+    m_Parameters.coarseToFine = Configuration::AlignCoarseToFine;
+    m_Parameters.maxOutputThreads = Configuration::AlignMaxOutputThreads;
+    m_Parameters.frameCacheBudget = std::size_t{Configuration::AlignFrameCacheMiB} << 20;
 
     m_CropBitmaps[static_cast<size_t>(CropMode::CROP_TO_INTERSECTION)] = LoadBitmap("crop");
     m_CropBitmaps[static_cast<size_t>(CropMode::PAD_TO_BOUNDING_BOX)] = LoadBitmap("pad");
@@ -270,14 +316,50 @@ void c_ImageAlignmentParams::DoInitControls()
             wxArrayString methodChoices;
             methodChoices.Add(_("Stabilize high-contrast features"));
             methodChoices.Add(_("Align on the solar limb"));
-            rb = new wxRadioBox(GetContainer(), ID_Method, wxEmptyString, wxDefaultPosition, wxDefaultSize, methodChoices, 0, wxRA_SPECIFY_ROWS);
-            rb->SetValidator(wxGenericValidator(reinterpret_cast<int*>(&m_Parameters.alignmentMethod)));
-            szMethod->Add(rb, 0, wxALIGN_CENTER_VERTICAL | wxALL, BORDER);
+            m_MethodCtrl = new wxRadioBox(GetContainer(), ID_Method, wxEmptyString, wxDefaultPosition, wxDefaultSize, methodChoices, 0, wxRA_SPECIFY_ROWS);
+            m_MethodCtrl->SetValidator(wxGenericValidator(reinterpret_cast<int*>(&m_Parameters.alignmentMethod)));
+            szMethod->Add(m_MethodCtrl, 0, wxALIGN_CENTER_VERTICAL | wxALL, BORDER);
 
             szMethod->Add(m_AlignMethodTextCtrl = new wxStaticText(GetContainer(), wxID_ANY, GetAlignmentMethodDescription(AlignmentMethod::PHASE_CORRELATION)), 0, wxALIGN_CENTER_VERTICAL | wxALL, BORDER);
 
         szContents->Add(szMethod, 0, wxALIGN_LEFT | wxALIGN_CENTER_VERTICAL | wxGROW | wxLEFT | wxRIGHT, BORDER);
 
+        wxSizer* szRoi = new wxBoxSizer(wxHORIZONTAL);
+            wxArrayString roiChoices;
+            roiChoices.Add(_("Correlate whole images"));
+            roiChoices.Add(_("Correlate the highest-contrast area (automatic)"));
+            roiChoices.Add(_("Correlate area:"));
+            m_RoiModeCtrl = new wxRadioBox(GetContainer(), ID_Roi, wxEmptyString, wxDefaultPosition, wxDefaultSize, roiChoices, 0, wxRA_SPECIFY_ROWS);
+            m_RoiModeCtrl->SetValidator(wxGenericValidator(reinterpret_cast<int*>(&m_Parameters.roiMode)));
+            m_RoiModeCtrl->SetToolTip(_("Correlating only a high-contrast region of interest is much faster for large images. "
+                                        "The area is specified in the first image's coordinates"));
+            szRoi->Add(m_RoiModeCtrl, 0, wxALIGN_BOTTOM | wxALL, BORDER);
+
+            // label, value, min. value
+            const std::tuple<wxString, int*, int> roiValues[] = {
+                { _("X:"), &m_Parameters.roi.x, 0 },
+                { _("Y:"), &m_Parameters.roi.y, 0 },
+                { _("Width:"), &m_Parameters.roi.width, 16 },
+                { _("Height:"), &m_Parameters.roi.height, 16 }
+            };
+            for (const auto& [label, value, minValue]: roiValues)
+            {
+                szRoi->Add(new wxStaticText(GetContainer(), wxID_ANY, label), 0, wxALIGN_BOTTOM | wxALL, BORDER);
+                auto* ctrl = new wxSpinCtrl(GetContainer(), wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+                    wxSP_ARROW_KEYS, minValue, 65535, *value);
+                ctrl->SetValidator(wxGenericValidator(value));
+                szRoi->Add(ctrl, 0, wxALIGN_BOTTOM | wxALL, BORDER);
+                m_RoiCtrls.push_back(ctrl);
+            }
+        szContents->Add(szRoi, 0, wxALIGN_LEFT | wxLEFT | wxRIGHT, BORDER);
+
+        m_CoarseToFineCtrl = new wxCheckBox(GetContainer(), ID_CoarseToFine, _("Coarse-to-fine correlation"));
+        m_CoarseToFineCtrl->SetToolTip(_("Determine translations of large images (or regions of interest) from downsampled images "
+                                         "and refine them at full resolution. Faster, but may be less accurate; if unsure, leave unchecked"));
+        m_CoarseToFineCtrl->SetValidator(wxGenericValidator(&m_Parameters.coarseToFine));
+        szContents->Add(m_CoarseToFineCtrl, 0, wxALIGN_LEFT | wxALL, BORDER);
+        UpdatePhaseCorrelationControls();
+
         wxSizer* szOutputDir = new wxBoxSizer(wxHORIZONTAL);
         szOutputDir->Add(new wxStaticText(GetContainer(), wxID_ANY, _("Output folder:")), 0, wxALIGN_CENTER_VERTICAL | wxALL, BORDER);
         szOutputDir->Add(m_OutputDirCtrl = new wxDirPickerCtrl(GetContainer(), ID_OutputDir, Configuration::AlignOutputPath, _("Select output folder")),
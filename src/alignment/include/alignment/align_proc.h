@@ -24,8 +24,12 @@ File description:
 #ifndef IMPPG_IMAGE_ALIGNMENT_THREAD_HEADER
 #define IMPPG_IMAGE_ALIGNMENT_THREAD_HEADER
 
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
 #include <variant>
 #include <vector>
 #include <wx/arrstr.h>
@@ -51,6 +55,19 @@ enum class AlignmentMethod: int
     NUM // this has to be the last element
 };
 
+/// Area of images used by phase correlation alignment.
+enum class RoiMode: int
+{
+    WHOLE_IMAGE = 0,
+    AUTOMATIC = 1, ///< The highest-contrast area of the first image
+    USER = 2, ///< Area specified in `AlignmentParameters_t::roi`
+
+    NUM // this has to be the last element
+};
+
+/// Suggested value of `AlignmentParameters_t::frameCacheBudget`.
+constexpr std::size_t DEFAULT_ALIGNMENT_FRAME_CACHE_BUDGET = std::size_t{1} << 30;
+
 using InputImageList = std::vector<std::shared_ptr<const c_Image>>;
 using AlignmentInputs = std::variant<wxArrayString, InputImageList>;
 
@@ -63,6 +80,15 @@ struct AlignmentParameters_t
     wxString outputDir;
     bool normalizeFitsValues;
     std::optional<std::string> outputFNameSuffix;
+    RoiMode roiMode; ///< Phase correlation only
+    Rectangle_t roi; ///< Used if `roiMode` is `RoiMode::USER`; in the first image's coordinates
+    /// Phase correlation only; if 'true', translations of large images (or regions of interest) are estimated
+    /// from downsampled images and refined at full resolution (faster, but less tested than full-resolution correlation)
+    bool coarseToFine;
+    unsigned maxOutputThreads; ///< Max number of output images translated and saved concurrently; 0 means: number of hardware threads
+    /// Max total size (in bytes) of decoded input images kept in memory between alignment passes; the remaining ones
+    /// are stored in temporary files (see `DEFAULT_ALIGNMENT_FRAME_CACHE_BUDGET`)
+    std::size_t frameCacheBudget;
 
     std::size_t GetNumInputs() const
     {
@@ -72,6 +98,9 @@ struct AlignmentParameters_t
     }
 };
 
+/// Returns 'true' if `roi` is not empty and lies entirely within a `width` x `height` image.
+bool IsRoiWithinImage(const Rectangle_t& roi, unsigned width, unsigned height);
+
 enum class AlignmentAbortReason
 {
     USER_REQUESTED, ///< Abort requested by user
@@ -105,6 +134,7 @@ enum
 };
 
 class wxEvtHandler;
+class c_DecodedFrameCache;
 
 class c_ImageAlignmentWorkerThread: public wxThread
 {
@@ -118,12 +148,46 @@ class c_ImageAlignmentWorkerThread: public wxThread
     std::string m_ErrorMessage;
     AlignmentParameters_t m_Parameters;
 
+    mutable std::mutex m_FitsIoMutex; ///< Serializes FITS loading and saving (CFITSIO is not necessarily built as reentrant)
+
+    /// Provides the input images to all alignment passes; exists only while `Entry` runs.
+    std::unique_ptr<c_DecodedFrameCache> m_FrameCache;
+
     /// Arguments: image index and its determined translation vector
     void PhaseCorrImgTranslationCallback(int imgIdx, float Tx, float Ty);
     bool IsAbortRequested();
     void SendMessageToParent(int id, int value = 0, wxString msg = wxEmptyString, AlignmentEventPayload_t* payload = nullptr);
 
-    bool SaveTranslatedOutputImage(const wxString& inputFileName, const c_Image& image);
+    bool SaveTranslatedOutputImage(const wxString& inputFileName, const c_Image& image, std::string& errorMsg) const;
+
+    /// Loads the specified input image, translates it (see `CreateTranslatedOutput`) and saves it; thread-safe.
+    /** FITS values are not normalized (regardless of `AlignmentParameters_t::normalizeFitsValues`). */
+    bool TranslateAndSaveImage(
+        std::size_t index,
+        FloatPoint_t offset, ///< Offset of the input image in the output image
+        unsigned outputWidth,
+        unsigned outputHeight,
+        std::string& errorMsg ///< Receives error message (if any)
+    ) const;
+
+    /// Calls `processImage` for each input image from a pool of worker threads.
+    /** `onImageCompleted` is called from the alignment thread, in order of images. Returns 'false' on error
+        (sets `m_ErrorMessage`) or abort request. */
+    bool ProcessImagesConcurrently(
+        std::size_t numImages,
+        unsigned maxWorkers, ///< 0 means: number of hardware threads
+        /// Called concurrently; arguments: image index, error message (to be set on failure); returns 'false' on failure
+        const std::function<bool (std::size_t, std::string&)>& processImage,
+        const std::function<void (std::size_t)>& onImageCompleted
+    );
+
+    /// Translates and saves all input images concurrently (see `AlignmentParameters_t::maxOutputThreads`).
+    /** Sends `EID_SAVED_OUTPUT_IMAGE` in order of images. Returns 'false' on error or abort request. */
+    bool SaveTranslatedOutputImages(
+        const std::vector<FloatPoint_t>& offsets, ///< Offsets of input images in the output images
+        unsigned outputWidth,
+        unsigned outputHeight
+    );
 
     void PhaseCorrelationAlignment(); ///< Aligns the images by keeping the high-contrast features stationary
     void LimbAlignment(); ///< Aligns the images by keeping the limb stationary
@@ -153,13 +217,9 @@ public:
     c_ImageAlignmentWorkerThread(
         wxEvtHandler& parent,         ///< Object to receive notification messages from this worker thread
         AlignmentParameters_t params
-    )
-    : wxThread(wxTHREAD_JOINABLE),
-    m_Parent(parent),
-    m_ProcessingCompleted(false),
-    m_ThreadAborted(false),
-    m_Parameters(std::move(params))
-    { }
+    );
+
+    ~c_ImageAlignmentWorkerThread() override;
 
     ExitCode Entry() override;
 
@@ -26,6 +26,8 @@ File description:
 #include "image/image.h"
 
 #include <optional>
+#include <wx/filename.h>
+#include <wx/string.h>
 
 /// Accessor for an owned or non-owned image; may be empty.
 class ImageAccessor
@@ -62,3 +64,11 @@ private:
     std::optional<c_Image> m_Owned;
     const c_Image* m_NonOwned{nullptr};
 };
+
+/// Returns 'true' if 'path' has a FITS extension; FITS loading and saving has to be serialized
+/// (CFITSIO is not necessarily built as reentrant).
+inline bool IsFitsFile(const wxString& path)
+{
+    const wxString ext = wxFileName(path).GetExt().Lower();
+    return ext == "fit" || ext == "fits";
+}
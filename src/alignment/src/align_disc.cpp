@@ -26,6 +26,7 @@ File description:
 #include "math_utils/math_utils.h"
 
 #include <algorithm>
+#include <array>
 #include <boost/math/special_functions/fpclassify.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/operation.hpp>
@@ -38,21 +39,62 @@ File description:
 
 using namespace boost::numeric::ublas;
 
+// NOTE: MSVC 18 requires a signed integral type 'for' loop counter
+//       when using OpenMP
+
+namespace
+{
+
+/// Length of row segments summed with 32-bit accumulators in `CalcCentroid` (2048 * 2047 * 255 < 2^32).
+constexpr unsigned CENTROID_SEGMENT_LENGTH = 2048;
+
+/// Number of rows whose histogram is built by a single OpenMP loop iteration in `FindDiscBackgroundThreshold`.
+constexpr unsigned HISTOGRAM_BAND_ROWS = 64;
+
+}
+
 /// Calculates the centroid of a PIX_MONO8 image
 Point_t CalcCentroid(const c_Image& img)
 {
     // We use 64-bit accumulators which is enough for an 8-bit image with 2^28 x 2^28 pixels.
     IMPPG_ASSERT(img.GetPixelFormat() == PixelFormat::PIX_MONO8);
 
-    uint64_t sumX = 0, sumY = 0, sumVals = 0;
-    for (unsigned y = 0; y < img.GetHeight(); y++)
-        for (unsigned x = 0; x < img.GetWidth(); x++)
+    const unsigned width = img.GetWidth();
+    const unsigned height = img.GetHeight();
+
+    // Sums of values and of values weighted by X in each row
+    std::vector<uint64_t> rowSums(height), rowSumsX(height);
+
+    #pragma omp parallel for
+    for (int y = 0; y < static_cast<int>(height); y++)
+    {
+        const uint8_t* row = img.GetRowAs<uint8_t>(y);
+        uint64_t sum = 0, sumX = 0;
+        // Each segment is summed with 32-bit accumulators and relative X, which lets the loop be vectorized
+        for (unsigned x0 = 0; x0 < width; x0 += CENTROID_SEGMENT_LENGTH)
         {
-            uint8_t pixval = img.GetRowAs<uint8_t>(y)[x];
-            sumVals += pixval;
-            sumX += static_cast<uint64_t>(x) * pixval;
-            sumY += static_cast<uint64_t>(y) * pixval;
+            const unsigned length = std::min(CENTROID_SEGMENT_LENGTH, width - x0);
+            const uint8_t* segment = row + x0;
+            uint32_t segmentSum = 0, segmentSumX = 0;
+            for (unsigned i = 0; i < length; i++)
+            {
+                segmentSum += segment[i];
+                segmentSumX += i * segment[i];
+            }
+            sum += segmentSum;
+            sumX += static_cast<uint64_t>(x0) * segmentSum + segmentSumX;
         }
+        rowSums[y] = sum;
+        rowSumsX[y] = sumX;
+    }
+
+    uint64_t sumX = 0, sumY = 0, sumVals = 0;
+    for (unsigned y = 0; y < height; y++)
+    {
+        sumVals += rowSums[y];
+        sumX += rowSumsX[y];
+        sumY += static_cast<uint64_t>(y) * rowSums[y];
+    }
 
     if (sumVals > 0)
         return Point_t(sumX/sumVals, sumY/sumVals);
@@ -218,16 +260,43 @@ std::optional<std::uint8_t> FindDiscBackgroundThreshold(
 
     constexpr std::size_t NUM_HISTOGRAM_BINS = 256;
 
-    std::size_t histogram[NUM_HISTOGRAM_BINS]{0};
     const unsigned width = img.GetWidth();
     const unsigned height = img.GetHeight();
-    for (unsigned i = 0; i < height; i++)
+
+    // Each band of rows is counted into 4 partial histograms, which are updated by consecutive pixels in turn;
+    // this way an increment does not wait for the previous one to the same bin (frequent for smooth images).
+    using BandHistogram = std::array<std::array<std::uint32_t, NUM_HISTOGRAM_BINS>, 4>;
+    const int numBands = static_cast<int>((height + HISTOGRAM_BAND_ROWS - 1) / HISTOGRAM_BAND_ROWS);
+    std::vector<BandHistogram> bandHistograms(numBands);
+
+    #pragma omp parallel for
+    for (int band = 0; band < numBands; band++)
     {
-        const std::uint8_t* row = img.GetRowAs<uint8_t>(i);
-        for (unsigned j = 0; j < width; j++)
-            histogram[row[j]] += 1;
+        BandHistogram& h = bandHistograms[band];
+        for (auto& partial: h) { partial.fill(0); }
+
+        const unsigned yEnd = std::min(height, (band + 1) * HISTOGRAM_BAND_ROWS);
+        for (unsigned y = band * HISTOGRAM_BAND_ROWS; y < yEnd; y++)
+        {
+            const std::uint8_t* row = img.GetRowAs<uint8_t>(y);
+            unsigned x = 0;
+            for (; x + 4 <= width; x += 4)
+            {
+                h[0][row[x]] += 1;
+                h[1][row[x + 1]] += 1;
+                h[2][row[x + 2]] += 1;
+                h[3][row[x + 3]] += 1;
+            }
+            for (; x < width; x++)
+                h[0][row[x]] += 1;
+        }
     }
 
+    std::size_t histogram[NUM_HISTOGRAM_BINS]{0};
+    for (const auto& h: bandHistograms)
+        for (std::size_t i = 0; i < NUM_HISTOGRAM_BINS; i++)
+            histogram[i] += h[0][i] + h[1][i] + h[2][i] + h[3][i];
+
     // Use bisection to find the value 'currDivPos' in histogram which has
     // the lowest sum of squared pixel value differences from the average
     // for all pixels darker and brighter than 'currDivPos'.
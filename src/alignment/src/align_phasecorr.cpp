@@ -24,8 +24,16 @@ File description:
 #include <algorithm>
 #include <cmath>
 #include <complex>
+#include <condition_variable>
 #include <functional>
+#include <list>
+#include <map>
+#include <mutex>
 #include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <wx/arrstr.h>
 #include <wx/string.h>
 #include <wx/filename.h>
@@ -34,8 +42,10 @@ File description:
 #include "align_phasecorr.h"
 #include "common/common.h"
 #include "fft.h"
+#include "frame_cache.h"
 #include "image/image.h"
 #include "common/imppg_assert.h"
+#include "common/worker_pool.h"
 #include "logging/logging.h"
 #include "math_utils/math_utils.h"
 
@@ -80,13 +90,305 @@ c_Image CalcWindowFunction(
     return result;
 }
 
+namespace
+{
+
+/// Max number of plans (of different sizes) kept by 'AcquirePhaseCorrelationPlan'.
+constexpr std::size_t MAX_CACHED_PLANS = 4;
+
+class c_PhaseCorrelationPlanCache
+{
+public:
+    PhaseCorrelationPlanPtr Acquire(unsigned width, unsigned height)
+    {
+        {
+            std::lock_guard lock(m_Mutex);
+            for (auto it = m_Plans.begin(); it != m_Plans.end(); ++it)
+            {
+                if ((*it)->GetWidth() == width && (*it)->GetHeight() == height)
+                {
+                    PhaseCorrelationPlanPtr result((*it).release());
+                    m_Plans.erase(it);
+                    return result;
+                }
+            }
+        }
+
+        return PhaseCorrelationPlanPtr(new c_PhaseCorrelationPlan(width, height));
+    }
+
+    void Release(c_PhaseCorrelationPlan* plan)
+    {
+        plan->ReleaseWorkBuffers();
+
+        std::lock_guard lock(m_Mutex);
+        m_Plans.emplace_front(plan);
+        if (m_Plans.size() > MAX_CACHED_PLANS)
+            m_Plans.pop_back();
+    }
+
+private:
+    std::mutex m_Mutex;
+    std::list<std::unique_ptr<c_PhaseCorrelationPlan>> m_Plans; ///< Most recently used first.
+};
+
+c_PhaseCorrelationPlanCache& GetPlanCache()
+{
+    // Never destroyed, so that plans released during static destruction can still be returned.
+    static c_PhaseCorrelationPlanCache* cache = new c_PhaseCorrelationPlanCache();
+    return *cache;
+}
+
+/// Max total size of spectra held by the frame transform pipeline (transformed, but not yet correlated).
+constexpr std::size_t MAX_LOOKAHEAD_BYTES = std::size_t{512} << 20;
+
+/// Max number of frames transformed ahead of the one being correlated, per worker thread.
+constexpr std::size_t LOOKAHEAD_FRAMES_PER_WORKER = 2;
+
+/// Pads 'img' to the size of 'padded' (placing it in the center), multiplies it by the window function and transforms it.
+void PadAndTransform(
+    const c_Image& img,
+    c_Image& padded, ///< Work buffer; its size is the FFT size
+    const c_Image& windowFunc,
+    c_FFTPlan2D& fftPlan,
+    std::complex<float>* spectrum ///< Receives the half spectrum
+)
+{
+    c_Image::ResizeAndTranslate(img.GetBuffer(), padded.GetBuffer(),
+            0, 0, img.GetWidth()-1, img.GetHeight()-1,
+            (padded.GetWidth() - img.GetWidth())/2, (padded.GetHeight() - img.GetHeight())/2, true);
+
+    padded.Multiply(windowFunc);
+
+    fftPlan.Transform(padded.GetRowAs<float>(0), std::as_const(padded).GetBuffer().GetBytesPerRow(), spectrum);
+}
+
+/// Returns 'img' (PIX_MONO32F) reduced 'factor' times in each dimension; each output pixel is the average of a factor x factor block.
+c_Image Downsample(const c_Image& img, unsigned factor)
+{
+    const unsigned width = img.GetWidth() / factor;
+    const unsigned height = img.GetHeight() / factor;
+    c_Image result(width, height, PixelFormat::PIX_MONO32F);
+    const float scale = 1.0f / sqr(factor);
+
+    #pragma omp parallel for
+    for (int y = 0; y < static_cast<int>(height); y++)
+    {
+        float* destRow = result.GetRowAs<float>(y);
+        std::fill(destRow, destRow + width, 0.0f);
+        for (unsigned i = 0; i < factor; i++)
+        {
+            const float* srcRow = img.GetRowAs<float>(y * factor + i);
+            for (unsigned x = 0; x < width; x++)
+                for (unsigned j = 0; j < factor; j++)
+                    destRow[x] += srcRow[x * factor + j];
+        }
+        for (unsigned x = 0; x < width; x++)
+            destRow[x] *= scale;
+    }
+
+    return result;
+}
+
+/// Returns 'rect' moved (and, only if the image is smaller than 'rect', shrunk) to lie within a 'width' x 'height' image.
+Rectangle_t MoveIntoImage(const Rectangle_t& rect, int width, int height)
+{
+    const int areaWidth = std::min(rect.width, width);
+    const int areaHeight = std::min(rect.height, height);
+
+    return Rectangle_t(
+        std::clamp(rect.x, 0, width - areaWidth),
+        std::clamp(rect.y, 0, height - areaHeight),
+        areaWidth,
+        areaHeight
+    );
+}
+
+/// Image padded to the working buffer size, multiplied by the window function and transformed.
+struct TransformedFrame
+{
+    std::optional<c_AlignedArray<std::complex<float>>> spectrum; ///< Empty if the image could not be loaded.
+    std::string errorMsg;
+    int imgWidth{0}; ///< Width of the whole image.
+    int imgHeight{0}; ///< Height of the whole image.
+    Rectangle_t area; ///< Correlated area of the image (the whole image unless a region of interest is used).
+    std::optional<ImageAccessor> image; ///< The correlated area at full resolution; kept only if the spectrum is of a downsampled image.
+};
+
+/// Loads and transforms the images of a sequence using a pool of worker threads.
+/** The images are transformed in any order, but at most `m_Lookahead` images past the one last taken
+    by `Take`, which bounds the memory used. If a region of interest is specified, only this area of each image
+    is transformed. If the downsampling factor is greater than 1, images are downsampled before padding,
+    and the full-resolution images (or their regions of interest) are kept in `TransformedFrame::image`. */
+class c_FrameTransformPipeline
+{
+public:
+    using GetImageFunc = std::function<std::optional<ImageAccessor>(std::size_t idx, std::string& errorMsg)>;
+
+    c_FrameTransformPipeline(
+        unsigned Nwidth,
+        unsigned Nheight,
+        const c_Image& windowFunc,
+        std::size_t numImages,
+        GetImageFunc getImage, ///< Called concurrently from worker threads
+        std::optional<Rectangle_t> roi, ///< Region of interest (the same for all images)
+        unsigned downsamplingFactor, ///< Images are downsampled by this factor before padding to Nwidth x Nheight
+        std::size_t maxImageBytes ///< Upper bound of an input image's size (limits the memory used if downsampling)
+    ): m_Nwidth(Nwidth), m_Nheight(Nheight), m_WindowFunc(windowFunc), m_GetImage(std::move(getImage)),
+       m_Roi(roi), m_DownsamplingFactor(downsamplingFactor), m_Workers(numImages)
+    {
+        std::size_t frameBytes = sizeof(std::complex<float>) * Nheight * GetHalfSpectrumWidth(Nwidth);
+        if (downsamplingFactor > 1)
+            frameBytes += maxImageBytes;
+        const unsigned numCores = std::max(1U, std::thread::hardware_concurrency());
+
+        m_Lookahead = std::clamp<std::size_t>(MAX_LOOKAHEAD_BYTES / frameBytes, 1, LOOKAHEAD_FRAMES_PER_WORKER * numCores);
+        const unsigned numWorkers = static_cast<unsigned>(std::min({ std::size_t{numCores}, m_Lookahead, numImages }));
+
+        m_Workers.SetClaimLimit(m_Lookahead);
+        m_Workers.Start(numWorkers, numCores, [this] { WorkerThreadFunc(); });
+    }
+
+    c_FrameTransformPipeline(const c_FrameTransformPipeline&) = delete;
+    c_FrameTransformPipeline& operator=(const c_FrameTransformPipeline&) = delete;
+
+    /// Stops the workers (after they finish their current images).
+    ~c_FrameTransformPipeline()
+    {
+        m_Workers.Stop();
+    }
+
+    /// Waits until image `idx` is transformed and returns it; images have to be taken in order.
+    TransformedFrame Take(std::size_t idx)
+    {
+        std::unique_lock lock(m_Mutex);
+        IMPPG_ASSERT(idx == m_NextToTake);
+        m_TakerCondition.wait(lock, [&] { return m_Transformed.find(idx) != m_Transformed.end(); });
+
+        auto node = m_Transformed.extract(idx);
+        m_NextToTake = idx + 1;
+        lock.unlock();
+        m_Workers.SetClaimLimit(idx + 1 + m_Lookahead);
+
+        return std::move(node.mapped());
+    }
+
+private:
+    void WorkerThreadFunc()
+    {
+        c_FFTPlan2D fftPlan(m_Nheight, m_Nwidth);
+        c_Image padded(m_Nwidth, m_Nheight, PixelFormat::PIX_MONO32F);
+
+        while (const std::optional<std::size_t> claimed = m_Workers.Claim())
+        {
+            const std::size_t idx = *claimed;
+            TransformedFrame frame;
+            std::optional<ImageAccessor> src = m_GetImage(idx, frame.errorMsg);
+            if (src.has_value())
+            {
+                frame.imgWidth = src->Get()->GetWidth();
+                frame.imgHeight = src->Get()->GetHeight();
+                frame.area = Rectangle_t(0, 0, frame.imgWidth, frame.imgHeight);
+
+                if (m_Roi.has_value())
+                {
+                    // the region of interest lies within the first image; in images of a different size it is moved
+                    // inside, so that the correlated areas are of the same size
+                    frame.area = MoveIntoImage(*m_Roi, frame.imgWidth, frame.imgHeight);
+                    c_Image areaImg(frame.area.width, frame.area.height, PixelFormat::PIX_MONO32F);
+                    c_Image::Copy(*src->Get(), areaImg, frame.area.x, frame.area.y, frame.area.width, frame.area.height, 0, 0);
+                    src = ImageAccessor{std::move(areaImg)};
+                }
+            }
+
+            if (src.has_value())
+            {
+                const c_Image& img = *src->Get();
+                frame.spectrum.emplace(fftPlan.GetSpectrumLength());
+
+                if (m_DownsamplingFactor > 1)
+                {
+                    PadAndTransform(Downsample(img, m_DownsamplingFactor), padded, m_WindowFunc, fftPlan, frame.spectrum->get());
+                    frame.image = std::move(src);
+                }
+                else
+                {
+                    PadAndTransform(img, padded, m_WindowFunc, fftPlan, frame.spectrum->get());
+                }
+            }
+
+            {
+                std::lock_guard lock(m_Mutex);
+                m_Transformed.emplace(idx, std::move(frame));
+            }
+            m_TakerCondition.notify_one();
+        }
+    }
+
+    const unsigned m_Nwidth;
+    const unsigned m_Nheight;
+    const c_Image& m_WindowFunc;
+    GetImageFunc m_GetImage;
+    const std::optional<Rectangle_t> m_Roi;
+    const unsigned m_DownsamplingFactor;
+    std::size_t m_Lookahead{1};
+
+    // Guarded by `m_Mutex` ------------------------------------------
+
+    std::mutex m_Mutex;
+    std::condition_variable m_TakerCondition; ///< Signalled when an image is transformed.
+    std::size_t m_NextToTake{0};
+    std::map<std::size_t, TransformedFrame> m_Transformed;
+
+    // ---------------------------------------------------------------
+
+    c_WorkerPool m_Workers; ///< Claims images to transform (up to `m_Lookahead` images past the one last taken).
+};
+
+}
+
+c_PhaseCorrelationPlan::c_PhaseCorrelationPlan(unsigned width, unsigned height)
+: m_FFTPlan(height, width),
+  m_WindowFunction(CalcWindowFunction(width, height))
+{}
+
+std::complex<float>* c_PhaseCorrelationPlan::GetCrossPowerSpectrum()
+{
+    m_CrossPowerSpectrum.Reserve(m_FFTPlan.GetSpectrumLength());
+    return m_CrossPowerSpectrum.get();
+}
+
+float* c_PhaseCorrelationPlan::GetCrossCorrelation()
+{
+    m_CrossCorrelation.Reserve(std::size_t{GetWidth()} * GetHeight());
+    return m_CrossCorrelation.get();
+}
+
+void c_PhaseCorrelationPlan::ReleaseWorkBuffers()
+{
+    m_FFTPlan.ReleaseWorkBuffers();
+    m_CrossPowerSpectrum = c_AlignedArray<std::complex<float>>();
+    m_CrossCorrelation = c_AlignedArray<float>();
+}
+
+void PhaseCorrelationPlanReleaser::operator()(c_PhaseCorrelationPlan* plan) const
+{
+    GetPlanCache().Release(plan);
+}
+
+PhaseCorrelationPlanPtr AcquirePhaseCorrelationPlan(unsigned width, unsigned height)
+{
+    return GetPlanCache().Acquire(width, height);
+}
+
 /// Determines (using phase correlation) the vector by which image 2 (given by its discrete Fourier transform 'img2FFT') is translated w.r.t. image 1 ('img1FFT')
 FloatPoint_t DetermineImageTranslation(
-    unsigned Nwidth,  ///< FFT columns
-    unsigned Nheight, ///< FFT rows
-    const std::complex<float>* img1FFT, ///< FFT of the first image (Nwidth*Nheight elements)
-    const std::complex<float>* img2FFT, ///< FFT of the second image (Nwidth*Nheight elements)
-    bool subpixelAccuracy ///< If 'true', the translation is determined down to sub-pixel accuracy
+    c_PhaseCorrelationPlan& plan, ///< Plan for the FFT size
+    const std::complex<float>* img1FFT, ///< FFT (half spectrum) of the first image (plan.GetFFTPlan().GetSpectrumLength() elements)
+    const std::complex<float>* img2FFT, ///< FFT (half spectrum) of the second image (plan.GetFFTPlan().GetSpectrumLength() elements)
+    bool subpixelAccuracy, ///< If 'true', the translation is determined down to sub-pixel accuracy
+    /// If not null, receives the significance of the cross-correlation peak: its height above the mean, in standard deviations
+    float* peakSignificance = nullptr
 )
 {
 /*
@@ -100,35 +402,76 @@ FloatPoint_t DetermineImageTranslation(
           Using (accumulating) fractional vectors and then performing integer-only image translations gives poor results.
  */
 
-    // Using 'operator new[]' (raw memory allocation) instead of new[] to avoid Nwidth*Nheight std::complex constructor calls. All the elements will be assigned to before use.
+    const unsigned Nwidth = plan.GetWidth();
+    const unsigned Nheight = plan.GetHeight();
 
-    // Cross-power spectrum
-    std::unique_ptr<std::complex<float>, BlockDeleter> cps(
-        static_cast<std::complex<float>*>(operator new[](Nwidth * Nheight * sizeof(std::complex<float>)))
-    );
+    // Cross-power spectrum (half spectrum; the cross-correlation of real images is real)
+    std::complex<float>* cps = plan.GetCrossPowerSpectrum();
 
     // Cross-correlation
-    std::unique_ptr<std::complex<float>, BlockDeleter> cc(
-        static_cast<std::complex<float>*>(operator new[](Nwidth * Nheight * sizeof(std::complex<float>)))
-    );
+    float* cc = plan.GetCrossCorrelation();
 
-    CalcCrossPowerSpectrum2D(img1FFT, img2FFT, cps.get(), Nwidth * Nheight);
-    CalcFFTinv2D(cps.get(), Nheight, Nwidth, cc.get());
+    CalcCrossPowerSpectrum2D(img1FFT, img2FFT, cps, plan.GetFFTPlan().GetSpectrumLength());
+    plan.GetFFTPlan().TransformInverse(cps, cc);
 
-    // Find the highest-Re element in cross-correlation array
-    unsigned maxx = 0, maxy = 0;
-    float maxval = 0.0f;
-    for (unsigned y = 0; y < Nheight; y++)
+    // Find the highest-Re element in cross-correlation array: each row is searched in parallel,
+    // then the rows' maxima are compared in order (so that the first of equal maxima is chosen, as in a serial search)
+    struct RowPeak
+    {
+        float value{0.0f};
+        unsigned x{0};
+        double sum{0.0}; ///< Only if 'peakSignificance' is not null.
+        double sumSq{0.0}; ///< Only if 'peakSignificance' is not null.
+    };
+    std::vector<RowPeak> rowPeaks(Nheight);
+
+    #pragma omp parallel for
+    for (int y = 0; y < static_cast<int>(Nheight); y++)
+    {
+        const float* row = cc + static_cast<std::size_t>(y) * Nwidth;
+        RowPeak& peak = rowPeaks[y];
         for (unsigned x = 0; x < Nwidth; x++)
+            if (row[x] > peak.value)
+            {
+                peak.value = row[x];
+                peak.x = x;
+            }
+
+        if (peakSignificance)
         {
-            float currval = cc.get()[x + y*Nwidth].real();
-            if (currval > maxval)
+            float sum = 0.0f, sumSq = 0.0f;
+            for (unsigned x = 0; x < Nwidth; x++)
             {
-                maxval = currval;
-                maxx = x;
-                maxy = y;
+                sum += row[x];
+                sumSq += sqr(row[x]);
             }
+            peak.sum = sum;
+            peak.sumSq = sumSq;
         }
+    }
+
+    unsigned maxx = 0, maxy = 0;
+    float maxval = 0.0f;
+    double sum = 0.0, sumSq = 0.0;
+    for (unsigned y = 0; y < Nheight; y++)
+    {
+        if (rowPeaks[y].value > maxval)
+        {
+            maxval = rowPeaks[y].value;
+            maxx = rowPeaks[y].x;
+            maxy = y;
+        }
+        sum += rowPeaks[y].sum;
+        sumSq += rowPeaks[y].sumSq;
+    }
+
+    if (peakSignificance)
+    {
+        const double numElements = static_cast<double>(Nwidth) * Nheight;
+        const double mean = sum / numElements;
+        const double stdDev = std::sqrt(std::max(0.0, sumSq / numElements - sqr(mean)));
+        *peakSignificance = (stdDev > 0.0) ? static_cast<float>((maxval - mean) / stdDev) : 0.0f;
+    }
 
     // Infer the translation vector from the 'cc's largest element's indices
 
@@ -154,11 +497,11 @@ FloatPoint_t DetermineImageTranslation(
         #define CLAMPW(k) (((k)+Nwidth)%Nwidth)
         #define CLAMPH(k) (((k)+Nheight)%Nheight)
 
-        const float ccXhi = cc.get()[CLAMPW(maxx+1) + maxy*Nwidth].real();
-        const float ccXlo = cc.get()[CLAMPW(maxx-1) + maxy*Nwidth].real();
-        const float ccYhi = cc.get()[maxx + CLAMPH(maxy+1)*Nwidth].real();
-        const float ccYlo = cc.get()[maxx + CLAMPH(maxy-1)*Nwidth].real();
-        const float ccPeak = cc.get()[maxx + maxy*Nwidth].real();
+        const float ccXhi = cc[CLAMPW(maxx+1) + maxy*Nwidth];
+        const float ccXlo = cc[CLAMPW(maxx-1) + maxy*Nwidth];
+        const float ccYhi = cc[maxx + CLAMPH(maxy+1)*Nwidth];
+        const float ccYlo = cc[maxx + CLAMPH(maxy-1)*Nwidth];
+        const float ccPeak = cc[maxx + maxy*Nwidth];
 
         if (ccXhi > ccXlo)
         {
@@ -208,8 +551,9 @@ FloatPoint_t DetermineImageTranslation(
 
 /// Determines translation vector between specified images; the images have to be already multiplied by window function
 FloatPoint_t DetermineTranslationVector(
-    const c_Image& img1, ///< Width and height have to be the same as 'img2' and be powers of two
-    const c_Image& img2  ///< Width and height have to be the same as 'img1' and be powers of two
+    c_PhaseCorrelationPlan& plan, ///< Plan for the images' size
+    const c_Image& img1, ///< Width and height have to be the same as 'img2' and be valid FFT lengths (see `GetOptimalFFTLength`)
+    const c_Image& img2  ///< Width and height have to be the same as 'img1' and be valid FFT lengths (see `GetOptimalFFTLength`)
 )
 {
     // For details of this function's operation see comments in 'DetermineTranslationVectors()'
@@ -217,29 +561,102 @@ FloatPoint_t DetermineTranslationVector(
     IMPPG_ASSERT(img1.GetWidth() == img2.GetWidth());
     IMPPG_ASSERT(img1.GetHeight() == img2.GetHeight());
 
-    const int width = img1.GetWidth();
-    const int height = img1.GetHeight();
+    IMPPG_ASSERT(img1.GetWidth() == plan.GetWidth());
+    IMPPG_ASSERT(img1.GetHeight() == plan.GetHeight());
 
-    std::unique_ptr<std::complex<float>, BlockDeleter> fft1(
-        static_cast<std::complex<float>*>(operator new[](width * height * sizeof(std::complex<float>)))
-    );
+    c_FFTPlan2D& fftPlan = plan.GetFFTPlan();
 
-    std::unique_ptr<std::complex<float>, BlockDeleter> fft2(
-        static_cast<std::complex<float>*>(operator new[](width * height * sizeof(std::complex<float>)))
-    );
+    c_AlignedArray<std::complex<float>> fft1(fftPlan.GetSpectrumLength());
+
+    c_AlignedArray<std::complex<float>> fft2(fftPlan.GetSpectrumLength());
 
-    CalcFFT2D(img1.GetRowAs<float>(0), height, width, img1.GetBuffer().GetBytesPerRow(), fft1.get());
-    CalcFFT2D(img2.GetRowAs<float>(0), height, width, img2.GetBuffer().GetBytesPerRow(), fft2.get());
+    fftPlan.Transform(img1.GetRowAs<float>(0), img1.GetBuffer().GetBytesPerRow(), fft1.get());
+    fftPlan.Transform(img2.GetRowAs<float>(0), img2.GetBuffer().GetBytesPerRow(), fft2.get());
+
+    return DetermineImageTranslation(plan, fft1.get(), fft2.get(), true);
+}
+
+namespace
+{
+
+/// Max downsampling factor used by coarse-to-fine phase correlation.
+constexpr unsigned MAX_PYRAMID_FACTOR = 4;
+
+/// Min. width and height of the working area of coarse phase correlation.
+constexpr unsigned MIN_COARSE_AREA_SIZE = 512;
+
+/// Width and height of the full-resolution image areas correlated to refine a coarse translation estimate.
+constexpr unsigned REFINEMENT_AREA_SIZE = 256;
+
+/// Min. cross-correlation peak significance (see 'DetermineImageTranslation') of a reliable translation estimate.
+constexpr float MIN_PEAK_SIGNIFICANCE = 8.0f;
+
+/// Returns the downsampling factor for coarse phase correlation in an Nwidth x Nheight working area; 1 if not worthwhile.
+unsigned GetPyramidFactor(unsigned Nwidth, unsigned Nheight)
+{
+    unsigned factor = 1;
+    while (factor < MAX_PYRAMID_FACTOR && std::min(Nwidth, Nheight) / (2 * factor) >= MIN_COARSE_AREA_SIZE)
+        factor *= 2;
+
+    return factor;
+}
+
+/// Refines the estimated translation of 'img2' w.r.t. 'img1' (in image coordinates).
+/** Correlates an area in the center of 'img1' with the area of 'img2' at the estimated position.
+    Returns an empty value if the latter does not fit in 'img2' or the result is unreliable. */
+std::optional<FloatPoint_t> RefineTranslation(
+    c_PhaseCorrelationPlan& plan, ///< Plan for the size of the correlated areas
+    const c_Image& img1,
+    const c_Image& img2,
+    int estimatedTx,
+    int estimatedTy,
+    int maxError, ///< Max expected error of the estimate (in pixels)
+    bool subpixelAccuracy
+)
+{
+    const int areaWidth = plan.GetWidth();
+    const int areaHeight = plan.GetHeight();
+
+    const int x1 = (static_cast<int>(img1.GetWidth()) - areaWidth)/2;
+    const int y1 = (static_cast<int>(img1.GetHeight()) - areaHeight)/2;
+    const int x2 = x1 + estimatedTx;
+    const int y2 = y1 + estimatedTy;
+
+    if (x1 < 0 || y1 < 0 || x2 < 0 || y2 < 0 ||
+        x2 + areaWidth > static_cast<int>(img2.GetWidth()) || y2 + areaHeight > static_cast<int>(img2.GetHeight()))
+    {
+        return std::nullopt;
+    }
+
+    c_Image area1(areaWidth, areaHeight, PixelFormat::PIX_MONO32F);
+    c_Image area2(areaWidth, areaHeight, PixelFormat::PIX_MONO32F);
+    c_Image::Copy(img1, area1, x1, y1, areaWidth, areaHeight, 0, 0);
+    c_Image::Copy(img2, area2, x2, y2, areaWidth, areaHeight, 0, 0);
+    area1.Multiply(plan.GetWindowFunction());
+    area2.Multiply(plan.GetWindowFunction());
+
+    c_FFTPlan2D& fftPlan = plan.GetFFTPlan();
+    c_AlignedArray<std::complex<float>> fft1(fftPlan.GetSpectrumLength());
+    c_AlignedArray<std::complex<float>> fft2(fftPlan.GetSpectrumLength());
+    fftPlan.Transform(area1.GetRowAs<float>(0), std::as_const(area1).GetBuffer().GetBytesPerRow(), fft1.get());
+    fftPlan.Transform(area2.GetRowAs<float>(0), std::as_const(area2).GetBuffer().GetBytesPerRow(), fft2.get());
+
+    float significance;
+    const FloatPoint_t residual = DetermineImageTranslation(plan, fft1.get(), fft2.get(), subpixelAccuracy, &significance);
+    if (significance < MIN_PEAK_SIGNIFICANCE || std::abs(residual.x) > maxError || std::abs(residual.y) > maxError)
+        return std::nullopt;
+
+    return FloatPoint_t(estimatedTx + residual.x, estimatedTy + residual.y);
+}
 
-    return DetermineImageTranslation(width, height, fft1.get(), fft2.get(), true);
 }
 
 /// Determines translation vectors of an image sequence
 bool DetermineTranslationVectors(
         unsigned Nwidth, ///< FFT width
         unsigned Nheight, ///< FFT height
-        const AlignmentInputs& inputFiles,
-        /// Receives list of translation vectors between files in 'inputFiles'; each vector is a translation relative to the first image
+        c_DecodedFrameCache& frames,
+        /// Receives list of translation vectors between images in 'frames'; each vector is a translation relative to the first image
         std::vector<FloatPoint_t>& translation,
         /// Receives the bounding box (within the Nwidth x Nheight working area) of all images after alignment
         Rectangle_t& bBox,
@@ -249,83 +666,83 @@ bool DetermineTranslationVectors(
         bool subpixelAlignment,
         std::function<void (int, float, float)> progressCallback, ///< Called after determining translation of an image; arguments: image index, trans. vector
         std::function<bool ()> checkAbort, ///< Called periodically to check if there was an "abort processing" request
-        bool normalizeFitsValues
+        const std::optional<Rectangle_t>& roi,
+        bool coarseToFine
 )
 {
     bool result = true;
 
-    int imgWidth, imgHeight; // Dimensions of the recently read image (before padding to Nwidth*Nheight)
-
-    c_Image windowFunc = CalcWindowFunction(Nwidth, Nheight);
-    // Window function smoothly varies from 0 at the array boundaries to 1 at the center and is used to
-    // "blunt" the image, starting from the edges. Without it they would produce prominent
-    // false peaks in the cross-correlation (as any sudden change in brightness generates
-    // lots if high frequencies after FFT), making it very hard or impossible to detect
-    // the true peak which corresponds to the actual image translation.
+    const std::size_t numImages = frames.GetNumFrames();
+    IMPPG_ASSERT(numImages > 0);
 
-    std::unique_ptr<c_Image> prevImg(new c_Image(Nwidth, Nheight, PixelFormat::PIX_MONO32F)); // previous image in the sequence (padded to Nwidth*Nheight pixels and with window func. applied)
-    std::unique_ptr<c_Image> currImg(new c_Image(Nwidth, Nheight, PixelFormat::PIX_MONO32F)); // current image in the sequence (padded to Nwidth*Nheight pixels and with window func. applied)
+    // Working area for the correlated areas of images (the whole images, or their regions of interest)
+    const unsigned areaNwidth = roi.has_value() ? GetWorkingBufferSize(roi->width) : Nwidth;
+    const unsigned areaNheight = roi.has_value() ? GetWorkingBufferSize(roi->height) : Nheight;
 
-    // Use 'operator new[]' instead of new[] to avoid Nwidth*Nheight std::complex constructor calls. All the elements will be assigned to before use.
+    // In coarse-to-fine mode, the pipeline transforms downsampled images, padded to a correspondingly smaller working area
+    const unsigned pyramidFactor = coarseToFine ? GetPyramidFactor(areaNwidth, areaNheight) : 1;
+    const unsigned corrWidth = (pyramidFactor > 1) ? GetOptimalFFTLength((areaNwidth + pyramidFactor - 1) / pyramidFactor) : areaNwidth;
+    const unsigned corrHeight = (pyramidFactor > 1) ? GetOptimalFFTLength((areaNheight + pyramidFactor - 1) / pyramidFactor) : areaNheight;
 
-    std::unique_ptr<std::complex<float>, BlockDeleter> prevFFT(
-        static_cast<std::complex<float>*>(operator new[](Nwidth * Nheight * sizeof(std::complex<float>)))
-    );
+    const PhaseCorrelationPlanPtr plan = AcquirePhaseCorrelationPlan(corrWidth, corrHeight);
 
-    std::unique_ptr<std::complex<float>, BlockDeleter> currFFT(
-        static_cast<std::complex<float>*>(operator new[](Nwidth * Nheight * sizeof(std::complex<float>)))
-    );
+    // Used only in coarse-to-fine mode
+    PhaseCorrelationPlanPtr refinementPlan;
+    PhaseCorrelationPlanPtr fullResPlan; // acquired only if needed
+    std::optional<c_Image> fullResPadded;
+    std::optional<c_AlignedArray<std::complex<float>>> prevFullResSpectrum; // full-res. spectrum of 'prevFrame' (if calculated)
+    std::size_t numFullResFallbacks = 0;
+    if (pyramidFactor > 1)
+    {
+        refinementPlan = AcquirePhaseCorrelationPlan(REFINEMENT_AREA_SIZE, REFINEMENT_AREA_SIZE);
+        Log::Print(wxString::Format("Using coarse-to-fine phase correlation (downsampling factor: %u).\n", pyramidFactor));
+    }
 
-    const auto loadFileByIndex = [&](const wxArrayString& fnames, std::size_t idx) -> std::optional<c_Image> {
-        IMPPG_ASSERT(fnames.Count() > idx);
-        Log::Print(wxString::Format("Loading %s... ", fnames[idx]));
-        std::string localErrorMsg;
-        const auto loadResult = LoadImageFileAsMono32f(
-            ToFsPath(fnames[idx]),
-            normalizeFitsValues,
-            &localErrorMsg
-        );
-        Log::Print("done.\n");
-        if (!loadResult)
+    // Fallback of coarse-to-fine mode: the translation determined from the full-resolution images
+    const auto determineFullResTranslation = [&](const c_Image& prevImg, const c_Image& currImg) {
+        if (!fullResPlan)
         {
-            if (errorMsg)
-            {
-                *errorMsg = localErrorMsg;
-            }
+            fullResPlan = AcquirePhaseCorrelationPlan(areaNwidth, areaNheight);
+            fullResPadded.emplace(areaNwidth, areaNheight, PixelFormat::PIX_MONO32F);
         }
-        return loadResult;
-    };
-
-    std::optional<ImageAccessor> src = std::visit(Overload{
-        [&](const wxArrayString& fnames) -> std::optional<ImageAccessor> {
-            auto loadResult = loadFileByIndex(fnames, 0);
-            if (!loadResult.has_value())
-            {
-                return std::nullopt;
-            }
-            else
-            {
-                return ImageAccessor{std::move(*loadResult)};
-            }
-        },
-
-        [](const InputImageList& images) -> std::optional<ImageAccessor> { return ImageAccessor{images.at(0).get()}; },
-    }, inputFiles);
+        c_FFTPlan2D& fftPlan = fullResPlan->GetFFTPlan();
+        if (!prevFullResSpectrum.has_value())
+        {
+            prevFullResSpectrum.emplace(fftPlan.GetSpectrumLength());
+            PadAndTransform(prevImg, *fullResPadded, fullResPlan->GetWindowFunction(), fftPlan, prevFullResSpectrum->get());
+        }
+        c_AlignedArray<std::complex<float>> currSpectrum(fftPlan.GetSpectrumLength());
+        PadAndTransform(currImg, *fullResPadded, fullResPlan->GetWindowFunction(), fftPlan, currSpectrum.get());
 
-    if (!src.has_value()) { return false; }
+        const FloatPoint_t T = DetermineImageTranslation(*fullResPlan, prevFullResSpectrum->get(), currSpectrum.get(), subpixelAlignment);
+        prevFullResSpectrum = std::move(currSpectrum);
+        return T;
+    };
 
-    imgWidth = src->Get()->GetWidth();
-    imgHeight = src->Get()->GetHeight();
+    // Window function smoothly varies from 0 at the array boundaries to 1 at the center and is used to
+    // "blunt" the image, starting from the edges. Without it they would produce prominent
+    // false peaks in the cross-correlation (as any sudden change in brightness generates
+    // lots if high frequencies after FFT), making it very hard or impossible to detect
+    // the true peak which corresponds to the actual image translation.
+    const c_Image& windowFunc = plan->GetWindowFunction();
 
-    c_Image::ResizeAndTranslate(src->Get()->GetBuffer(), prevImg->GetBuffer(),
-            0, 0, src->Get()->GetWidth()-1, src->Get()->GetHeight()-1,
-            (Nwidth - src->Get()->GetWidth())/2, (Nheight - src->Get()->GetHeight())/2, true);
+    // Called concurrently from the pipeline's worker threads
+    const auto getImageByIdx = [&](std::size_t idx, std::string& frameErrorMsg) -> std::optional<ImageAccessor> {
+        ImageAccessor frame = frames.Get(idx, PixelFormat::PIX_MONO32F, &frameErrorMsg);
+        if (frame.Empty()) { return std::nullopt; }
+        return frame;
+    };
 
-    prevImg->Multiply(windowFunc);
+    c_FrameTransformPipeline pipeline(corrWidth, corrHeight, windowFunc, numImages, getImageByIdx,
+                                      roi, pyramidFactor, sizeof(float) * areaNwidth * areaNheight);
 
-    Log::Print("Calculating FFT... ");
-    CalcFFT2D(prevImg->GetRowAs<float>(0), prevImg->GetHeight(), prevImg->GetWidth(), prevImg->GetBuffer().GetBytesPerRow(), prevFFT.get());
-    Log::Print("done.");
+    // Spectrum of the previous image in the sequence (padded to corrWidth*corrHeight pixels and with window func. applied)
+    TransformedFrame prevFrame = pipeline.Take(0);
+    if (!prevFrame.spectrum.has_value())
+    {
+        if (errorMsg) { *errorMsg = prevFrame.errorMsg; }
+        return false;
+    }
 
     // Iterate over the remaining images and detect their translation
 
@@ -337,55 +754,82 @@ bool DetermineTranslationVectors(
     // starts at (Nwidth - imgWidth)/2, (Nheight - imgHeight)/2).
     //
     // Initially corresponds to dimensions and position of the first image.
-    bBox.x = (Nwidth - imgWidth)/2;
-    bBox.y = (Nheight - imgHeight)/2;
-
-    int xmax = bBox.x + imgWidth - 1;
-    int ymax = bBox.y + imgHeight - 1;
-
-    const std::size_t numImages = std::visit(Overload{
-        [](const wxArrayString& fnames) { return fnames.Count(); },
-        [](const InputImageList& images) { return images.size(); }
-    }, inputFiles);
-
-    const auto getFileByIdx = [&](const AlignmentInputs& inputs, std::size_t idx) {
-        return std::visit(Overload{
-            [&](const wxArrayString& fnames) -> std::optional<ImageAccessor> {
-                auto loadResult = loadFileByIndex(fnames, idx);
-                if (!loadResult.has_value())
-                {
-                    return std::nullopt;
-                }
-                else
-                {
-                    return ImageAccessor{std::move(*loadResult)};
-                }
-            },
+    bBox.x = (Nwidth - prevFrame.imgWidth)/2;
+    bBox.y = (Nheight - prevFrame.imgHeight)/2;
 
-            [&](const InputImageList& images) -> std::optional<ImageAccessor> { return ImageAccessor{images[idx].get()}; }
-        }, inputs);
-    };
+    int xmax = bBox.x + prevFrame.imgWidth - 1;
+    int ymax = bBox.y + prevFrame.imgHeight - 1;
 
     for (std::size_t i = 1; i < numImages; ++i)
     {
-        const auto src = getFileByIdx(inputFiles, i);
-        if (!src.has_value()) { return false; }
-
-        imgWidth = src->Get()->GetWidth();
-        imgHeight = src->Get()->GetHeight();
+        TransformedFrame currFrame = pipeline.Take(i);
+        if (!currFrame.spectrum.has_value())
+        {
+            if (errorMsg) { *errorMsg = currFrame.errorMsg; }
+            return false;
+        }
 
-        c_Image::ResizeAndTranslate(src->Get()->GetBuffer(), currImg->GetBuffer(),
-                0, 0, src->Get()->GetWidth()-1, src->Get()->GetHeight()-1,
-                (Nwidth - src->Get()->GetWidth())/2, (Nheight - src->Get()->GetHeight())/2, true);
+        // Dimensions of the current image (before padding to Nwidth*Nheight)
+        const int imgWidth = currFrame.imgWidth;
+        const int imgHeight = currFrame.imgHeight;
 
-        currImg->Multiply(windowFunc);
+        FloatPoint_t T;
+        if (pyramidFactor == 1)
+        {
+            T = DetermineImageTranslation(*plan, prevFrame.spectrum->get(), currFrame.spectrum->get(), subpixelAlignment);
+        }
+        else
+        {
+            const c_Image& prevImg = *prevFrame.image->Get();
+            const c_Image& currImg = *currFrame.image->Get();
+
+            // Offsets of the images' positions in the working areas; the translation determined by phase correlation
+            // is the translation of image contents plus the difference of offsets
+            const int prevOffsetX = static_cast<int>(areaNwidth - prevImg.GetWidth())/2;
+            const int prevOffsetY = static_cast<int>(areaNheight - prevImg.GetHeight())/2;
+            const int currOffsetX = static_cast<int>(areaNwidth - currImg.GetWidth())/2;
+            const int currOffsetY = static_cast<int>(areaNheight - currImg.GetHeight())/2;
+            const int prevCoarseOffsetX = static_cast<int>(corrWidth - prevImg.GetWidth() / pyramidFactor)/2;
+            const int prevCoarseOffsetY = static_cast<int>(corrHeight - prevImg.GetHeight() / pyramidFactor)/2;
+            const int currCoarseOffsetX = static_cast<int>(corrWidth - currImg.GetWidth() / pyramidFactor)/2;
+            const int currCoarseOffsetY = static_cast<int>(corrHeight - currImg.GetHeight() / pyramidFactor)/2;
+
+            float significance;
+            const FloatPoint_t coarseT = DetermineImageTranslation(*plan, prevFrame.spectrum->get(), currFrame.spectrum->get(), true, &significance);
+
+            std::optional<FloatPoint_t> refinedT;
+            if (significance >= MIN_PEAK_SIGNIFICANCE)
+            {
+                refinedT = RefineTranslation(
+                    *refinementPlan, prevImg, currImg,
+                    static_cast<int>(std::lround(pyramidFactor * (coarseT.x - (currCoarseOffsetX - prevCoarseOffsetX)))),
+                    static_cast<int>(std::lround(pyramidFactor * (coarseT.y - (currCoarseOffsetY - prevCoarseOffsetY)))),
+                    pyramidFactor,
+                    subpixelAlignment
+                );
+            }
 
-        // Calculate the current image's FFT
-        Log::Print("Calculating FFT... ");
-        CalcFFT2D(currImg->GetRowAs<float>(0), currImg->GetHeight(), currImg->GetWidth(), currImg->GetBuffer().GetBytesPerRow(), currFFT.get());
-        Log::Print("done.\n");
+            if (refinedT.has_value())
+            {
+                T = FloatPoint_t(refinedT->x + (currOffsetX - prevOffsetX), refinedT->y + (currOffsetY - prevOffsetY));
+                prevFullResSpectrum.reset();
+            }
+            else
+            {
+                T = determineFullResTranslation(prevImg, currImg);
+                numFullResFallbacks += 1;
+            }
+        }
 
-        FloatPoint_t T = DetermineImageTranslation(Nwidth, Nheight, prevFFT.get(), currFFT.get(), subpixelAlignment);
+        if (roi.has_value())
+        {
+            // Convert the translation of the correlated areas (padded to areaNwidth x areaNheight)
+            // to the translation of whole images (padded to Nwidth x Nheight)
+            T.x += GetRoiOffsetDelta(Nwidth, areaNwidth, prevFrame.area.width, currFrame.area.width,
+                                     prevFrame.area.x, currFrame.area.x, prevFrame.imgWidth, imgWidth);
+            T.y += GetRoiOffsetDelta(Nheight, areaNheight, prevFrame.area.height, currFrame.area.height,
+                                     prevFrame.area.y, currFrame.area.y, prevFrame.imgHeight, imgHeight);
+        }
 
         FloatPoint_t Tprev = translation.back();
         translation.push_back(FloatPoint_t(Tprev.x + T.x, Tprev.y + T.y));
@@ -403,9 +847,7 @@ bool DetermineTranslationVectors(
         if (newXmax > xmax) xmax = newXmax;
         if (newYmax > ymax) ymax = newYmax;
 
-        // Swap pointers for the next iteration
-        currImg.swap(prevImg);
-        prevFFT.swap(currFFT);
+        prevFrame = std::move(currFrame);
 
         progressCallback(i, translation.back().x, translation.back().y);
         if (checkAbort())
@@ -415,23 +857,31 @@ bool DetermineTranslationVectors(
         }
     }
 
+    if (numFullResFallbacks > 0)
+        Log::Print(wxString::Format("Full-resolution phase correlation used for %zu image(s).\n", numFullResFallbacks));
+
     bBox.width = xmax - bBox.x + 1;
     bBox.height = ymax - bBox.y + 1;
 
     return result;
 }
 
-/// Returns the smallest power of 2 which is > n
-unsigned GetClosestGPowerOf2(unsigned n)
+int GetRoiOffsetDelta(int N, int areaN, int prevArea, int currArea, int prevAreaStart, int currAreaStart,
+                      int prevImgSize, int currImgSize)
 {
-    int msb = 0;
-    while (n != 0)
-    {
-        n >>= 1;
-        msb++;
-    }
+    return (currAreaStart - prevAreaStart) - ((areaN - currArea)/2 - (areaN - prevArea)/2)
+        + ((N - currImgSize)/2 - (N - prevImgSize)/2);
+}
 
-    return (1U << msb);
+/// Returns the width (or height) of the working buffer (i.e. FFT arrays) for images of width (height) 'n'
+unsigned GetWorkingBufferSize(unsigned n)
+{
+    // Leave a margin of at least n/8 (in total) for image translation; use a mixed-radix FFT length instead of
+    // the next power of two, which could almost double the size. The margin must not be much larger: the window
+    // function spans the whole buffer (with the image centred in it), so with a larger margin the image edges lie
+    // closer to the window's flat centre, are not tapered enough, and the discontinuities there produce false
+    // correlation peaks (with n/4, and with the next power of two, some frames in `phase_correlation_tests` are misaligned).
+    return GetOptimalFFTLength(n + std::max(n / 8, 1U));
 }
 
 /// Returns the set-theoretic intersection, i.e. the largest shared area, of specified images
@@ -24,26 +24,89 @@ File description:
 #ifndef IMPPG_PHASE_CORRELATION_ALIGNMENT_HEADER
 #define IMPPG_PHASE_CORRELATION_ALIGNMENT_HEADER
 
+#include <complex>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <vector>
 #include <wx/arrstr.h>
 #include <wx/string.h>
 
 #include "alignment/align_proc.h"
 #include "common/common.h"
+#include "fft.h"
+#include "frame_cache.h"
+#include "image/buffer_pool.h"
 #include "image/image.h"
 
+/// FFT plan, window function and work buffers for phase correlation of images of a fixed size
+class c_PhaseCorrelationPlan
+{
+public:
+    c_PhaseCorrelationPlan(unsigned width, unsigned height);
 
-/// Returns the smallest power of 2 which is > n
-unsigned GetClosestGPowerOf2(unsigned n);
+    unsigned GetWidth() const { return m_FFTPlan.GetCols(); }
+
+    unsigned GetHeight() const { return m_FFTPlan.GetRows(); }
+
+    c_FFTPlan2D& GetFFTPlan() { return m_FFTPlan; }
+
+    /// Returns the window function (see 'CalcWindowFunction').
+    const c_Image& GetWindowFunction() const { return m_WindowFunction; }
+
+    /// Returns the buffer for cross-power spectrum (GetFFTPlan().GetSpectrumLength() elements).
+    std::complex<float>* GetCrossPowerSpectrum();
+
+    /// Returns the buffer for cross-correlation (width*height elements).
+    float* GetCrossCorrelation();
+
+    /// Frees the work buffers (until they are needed again).
+    void ReleaseWorkBuffers();
+
+private:
+    c_FFTPlan2D m_FFTPlan;
+    c_Image m_WindowFunction;
+    c_AlignedArray<std::complex<float>> m_CrossPowerSpectrum;
+    c_AlignedArray<float> m_CrossCorrelation;
+};
+
+/// Returns a phase correlation plan to the cache (see 'AcquirePhaseCorrelationPlan').
+struct PhaseCorrelationPlanReleaser
+{
+    void operator()(c_PhaseCorrelationPlan* plan) const;
+};
+
+using PhaseCorrelationPlanPtr = std::unique_ptr<c_PhaseCorrelationPlan, PhaseCorrelationPlanReleaser>;
+
+/// Returns a phase correlation plan for images of the specified size, for exclusive use by the caller.
+/** Plans of recently used sizes are cached. When the returned pointer is destroyed, the plan's work buffers
+    are released and the plan (twiddle factors, window function) is kept for subsequent alignment runs. Thread-safe. */
+PhaseCorrelationPlanPtr AcquirePhaseCorrelationPlan(unsigned width, unsigned height);
+
+
+/// Returns the width (or height) of the working buffer (i.e. FFT arrays) for images of width (height) 'n'
+unsigned GetWorkingBufferSize(unsigned n);
+
+/// Converts a translation component between the correlated areas of two images to one between the whole images.
+/** Area widths (heights) are the ones correlated in an 'areaN'-wide (-high) working area, whole images are padded
+    to 'N'. Returns the value to add to the areas' translation component. */
+int GetRoiOffsetDelta(
+    int N, ///< Working area size of whole images
+    int areaN, ///< Working area size of the correlated areas
+    int prevArea, ///< Correlated area size in the previous image
+    int currArea, ///< Correlated area size in the current image
+    int prevAreaStart, ///< Correlated area start in the previous image
+    int currAreaStart, ///< Correlated area start in the current image
+    int prevImgSize, ///< Size of the previous image
+    int currImgSize ///< Size of the current image
+);
 
 /// Determines translation vectors of an image sequence
 bool DetermineTranslationVectors(
         unsigned Nwidth, ///< FFT width
         unsigned Nheight, ///< FFT height
-        const AlignmentInputs& inputFiles,
-        /// Receives list of translation vectors between files in 'inputFiles'; each vector is a translation relative to the first image
+        c_DecodedFrameCache& frames, ///< Input images
+        /// Receives list of translation vectors between images in 'frames'; each vector is a translation relative to the first image
         std::vector<FloatPoint_t>& translation,
         /// Receives the bounding box (within the NxN working area) of all images after alignment
         Rectangle_t& bBox,
@@ -53,7 +116,13 @@ bool DetermineTranslationVectors(
         bool subpixelAlignment,
         std::function<void (int, float, float)> progressCallback, ///< Called after determining translation of an image; arguments: image index, trans. vector
         std::function<bool ()> checkAbort, ///< Called periodically to check if there was an "abort processing" request
-        bool normalizeFitsValues
+        /// If set, only this area of each image is correlated, in a working area of size
+        /// GetWorkingBufferSize(roi->width) x GetWorkingBufferSize(roi->height); it has to lie within the first image
+        /// (in images of a different size, it is moved inside)
+        const std::optional<Rectangle_t>& roi,
+        /// If 'true' and the working area is large enough, translations are estimated from downsampled images and refined
+        /// by correlating small full-resolution areas; full-resolution correlation is used if an estimate is unreliable
+        bool coarseToFine
 );
 
 /// Returns the set-theoretic intersection, i.e. the largest shared area, of specified images
@@ -66,8 +135,9 @@ Rectangle_t DetermineImageIntersection(
 
 /// Determines translation vector between specified images; the images have to be already multiplied by window function
 FloatPoint_t DetermineTranslationVector(
-    const c_Image& img1, ///< Width and height have to be the same as 'img2' and be powers of two
-    const c_Image& img2  ///< Width and height have to be the same as 'img1' and be powers of two
+    c_PhaseCorrelationPlan& plan, ///< Plan for the images' size
+    const c_Image& img1, ///< Width and height have to be the same as 'img2' and be valid FFT lengths (see `GetOptimalFFTLength`)
+    const c_Image& img2  ///< Width and height have to be the same as 'img1' and be valid FFT lengths (see `GetOptimalFFTLength`)
 );
 
 /// Calculates window function (Blackman) and returns its values as a PIX_MONO32F image
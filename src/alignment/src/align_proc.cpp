@@ -23,13 +23,19 @@ File description:
 
 #include <algorithm>
 #include <boost/math/special_functions/round.hpp>
+#include <chrono>
 #include <climits>
 #include <cmath>
+#include <condition_variable>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <utility>
 #include <vector>
 #include <wx/filename.h>
 
@@ -39,6 +45,8 @@ File description:
 #include "align_phasecorr.h"
 #include "alignment/align_proc.h"
 #include "common/common.h"
+#include "common/worker_pool.h"
+#include "frame_cache.h"
 #include "image/image.h"
 #include "logging/logging.h"
 #include "math_utils/convolution.h"
@@ -54,6 +62,12 @@ File description:
 namespace
 {
 
+/// Max total size of input and output images held by the output workers (see `SaveTranslatedOutputImages`).
+constexpr std::size_t MAX_OUTPUT_BYTES_IN_FLIGHT = std::size_t{2} << 30;
+
+/// Interval of checking for abort requests while waiting for the output workers.
+constexpr std::chrono::milliseconds ABORT_CHECK_INTERVAL{100};
+
 c_Image CreateTranslatedOutput(const c_Image& source, unsigned outWidth, unsigned outHeight, float tx, float ty)
 {
     std::optional<c_Image> converted;
@@ -80,30 +94,92 @@ c_Image CreateTranslatedOutput(const c_Image& source, unsigned outWidth, unsigne
     return output;
 }
 
-ImageAccessor GetInputImageByIndex(
-    const AlignmentInputs& inputs,
-    std::size_t index,
-    std::string* fileLoadErrorMsg
-)
+/// Returns the quality of the specified image area: the sum of squared gradients
+float GetQuality(const c_Image& img, const Rectangle_t& area)
 {
-    return std::visit(Overload{
-        [&](const wxArrayString& fnames) {
-            //FIXME: on empty error message, put sth generic there
-            auto loadResult = LoadImage(
-                ToFsPath(fnames[index]),
-                std::nullopt,
-                fileLoadErrorMsg,
-                false
-            );
-            if (!loadResult) { return ImageAccessor{}; }
-            c_Image srcImage{std::move(loadResult.value())};
-            return ImageAccessor{std::move(srcImage)};
-        },
+    IMPPG_ASSERT(img.GetPixelFormat() == PixelFormat::PIX_MONO32F);
 
-        [&](const InputImageList& images) {
-            return ImageAccessor{images[index].get()};
+    float result = 0;
+
+    // Skip the border pixels in case there is a bright leftover from wavelet sharpening
+    const int BORDER_SKIP = 3;
+
+    for (int y = BORDER_SKIP; y < area.height - BORDER_SKIP - 1; y++)
+        for (int x = BORDER_SKIP; x < area.width - BORDER_SKIP - 1; x++)
+        {
+            float val00 = img.GetRowAs<float>(area.y + y)[area.x + x];
+            float val10 = img.GetRowAs<float>(area.y + y)[area.x + x+1];
+            float val01 = img.GetRowAs<float>(area.y + y+1)[area.x + x];
+
+            result += sqr(val10 - val00) + sqr(val01 - val00);
         }
-    }, inputs);
+
+    return result;
+}
+
+c_Image GetBlurredImage(const c_Image& srcImg, float gaussianSigma)
+{
+    IMPPG_ASSERT(srcImg.GetPixelFormat() == PixelFormat::PIX_MONO32F);
+
+    c_Image result(srcImg.GetWidth(), srcImg.GetHeight(), PixelFormat::PIX_MONO32F);
+
+    ConvolveSeparable(
+            c_PaddedArrayPtr(srcImg.GetRowAs<float>(0), srcImg.GetWidth(), srcImg.GetHeight(), srcImg.GetBuffer().GetBytesPerRow()),
+            c_PaddedArrayPtr(result.GetRowAs<float>(0), result.GetWidth(), result.GetHeight(), std::as_const(result).GetBuffer().GetBytesPerRow()),
+            gaussianSigma);
+
+    return result;
+}
+
+/// Returns the center (relative to 'searchArea' origin) of the highest-quality (see 'GetQuality') square area within 'searchArea'.
+/** Areas of size 'areaSize' are checked at 'areaSize'/2 steps. */
+Point_t FindHighestContrastArea(const c_Image& img, const Rectangle_t& searchArea, int areaSize)
+{
+    Point_t result;
+    float maxQuality = 0;
+    for (int i = 0; i < searchArea.width / (areaSize/2) - 1; i++)
+        for (int j = 0; j < searchArea.height / (areaSize/2) - 1; j++)
+        {
+            Rectangle_t currentArea(i*areaSize/2, j*areaSize/2, areaSize, areaSize);
+            float quality = GetQuality(img,
+                Rectangle_t(searchArea.x + currentArea.x,
+                            searchArea.y + currentArea.y,
+                            currentArea.width, currentArea.height));
+            if (quality > maxQuality)
+            {
+                maxQuality = quality;
+                result = Point_t(currentArea.x + currentArea.width/2, currentArea.y + currentArea.height/2);
+            }
+        }
+
+    return result;
+}
+
+/// Max width and height of an automatically selected region of interest for phase correlation.
+constexpr int AUTO_ROI_MAX_SIZE = 512;
+
+/// Min width and height of an automatically selected region of interest for phase correlation.
+constexpr int AUTO_ROI_MIN_SIZE = 64;
+
+/// Returns the highest-contrast area of 'img' (PIX_MONO32F) to be used as region of interest for phase correlation.
+/** Returns an empty value if the image is too small for the region of interest to be worthwhile. */
+std::optional<Rectangle_t> SelectRoi(const c_Image& img)
+{
+    const int width = img.GetWidth();
+    const int height = img.GetHeight();
+
+    // Leave room for the images' drift
+    int size = AUTO_ROI_MAX_SIZE;
+    while (size > std::min(width, height) / 2)
+        size /= 2;
+
+    if (size < AUTO_ROI_MIN_SIZE)
+        return std::nullopt;
+
+    // Blur the image first to remove the impact of noise
+    const Point_t center = FindHighestContrastArea(GetBlurredImage(img, 1.0f), Rectangle_t(0, 0, width, height), size);
+
+    return Rectangle_t(center.x - size/2, center.y - size/2, size, size);
 }
 
 std::size_t GetNumInputs(const AlignmentInputs& inputs)
@@ -116,6 +192,13 @@ std::size_t GetNumInputs(const AlignmentInputs& inputs)
 
 }
 
+bool IsRoiWithinImage(const Rectangle_t& roi, unsigned width, unsigned height)
+{
+    return roi.width > 0 && roi.height > 0 && roi.x >= 0 && roi.y >= 0
+        && static_cast<unsigned>(roi.x + roi.width) <= width
+        && static_cast<unsigned>(roi.y + roi.height) <= height;
+}
+
 /// Arguments: image index and its determined translation vector.
 void c_ImageAlignmentWorkerThread::PhaseCorrImgTranslationCallback(int imgIdx, float Tx, float Ty)
 {
@@ -126,30 +209,7 @@ void c_ImageAlignmentWorkerThread::PhaseCorrImgTranslationCallback(int imgIdx, f
     SendMessageToParent(EID_PHASECORR_IMG_TRANSLATION, imgIdx, wxEmptyString, &payload);
 }
 
-/// Returns (input image loaded from `inputFileName`, output image ready to be filled); returns `nullopt` on error.
-std::optional<std::tuple<c_Image, c_Image>> PrepareInputAndOutputImages(
-    wxString inputFileName,
-    unsigned outputWidth,
-    unsigned outputHeight,
-    std::string& errorMsg,
-    bool normalizeFitsValues
-)
-{
-    auto loadResult = LoadImage(ToFsPath(inputFileName), std::nullopt, &errorMsg, normalizeFitsValues);
-    if (!loadResult) { return std::nullopt; }
-    c_Image srcImage{std::move(loadResult.value())};
-    // subpixel translation of palettised images is not supported, so convert to RGB8
-    if (srcImage.GetPixelFormat() == PixelFormat::PIX_PAL8)
-    {
-        srcImage = srcImage.ConvertPixelFormat(PixelFormat::PIX_RGB8);
-    }
-
-    c_Image destImage{outputWidth, outputHeight, srcImage.GetPixelFormat()};
-
-    return std::make_tuple(std::move(srcImage), std::move(destImage));
-}
-
-bool c_ImageAlignmentWorkerThread::SaveTranslatedOutputImage(const wxString& inputFileName, const c_Image& image)
+bool c_ImageAlignmentWorkerThread::SaveTranslatedOutputImage(const wxString& inputFileName, const c_Image& image, std::string& errorMsg) const
 {
     //-----------------------
 
@@ -175,13 +235,150 @@ bool c_ImageAlignmentWorkerThread::SaveTranslatedOutputImage(const wxString& inp
 
     if (!saved)
     {
-        m_ErrorMessage = wxString::Format(_("Failed to save output file: %s"), outputFileName.GetFullPath());
+        errorMsg = wxString::Format(_("Failed to save output file: %s"), outputFileName.GetFullPath());
         return false;
     }
 
     return true;
 }
 
+bool c_ImageAlignmentWorkerThread::TranslateAndSaveImage(
+    std::size_t index,
+    FloatPoint_t offset,
+    unsigned outputWidth,
+    unsigned outputHeight,
+    std::string& errorMsg
+) const
+{
+    const auto* fnames = std::get_if<wxArrayString>(&m_Parameters.inputs);
+    const bool isFits = fnames && IsFitsFile((*fnames)[index]);
+
+    // FITS values of the output are not normalized, regardless of `normalizeFitsValues`
+    const ImageAccessor source = m_FrameCache->Get(index, &errorMsg);
+    if (source.Empty()) { return false; }
+
+    const c_Image output = CreateTranslatedOutput(*source.Get(), outputWidth, outputHeight, offset.x, offset.y);
+
+    if (fnames)
+    {
+        std::unique_lock fitsLock(m_FitsIoMutex, std::defer_lock);
+        if (isFits) { fitsLock.lock(); }
+        return SaveTranslatedOutputImage((*fnames)[index], output, errorMsg);
+    }
+
+    return true;
+}
+
+bool c_ImageAlignmentWorkerThread::ProcessImagesConcurrently(
+    std::size_t numImages,
+    unsigned maxWorkers,
+    const std::function<bool (std::size_t, std::string&)>& processImage,
+    const std::function<void (std::size_t)>& onImageCompleted
+)
+{
+    const unsigned numCores = std::max(1U, std::thread::hardware_concurrency());
+    const unsigned numWorkers = static_cast<unsigned>(std::min<std::size_t>(maxWorkers > 0 ? maxWorkers : numCores, numImages));
+
+    // Guarded by `mutex` --------------------------------------------
+
+    std::mutex mutex;
+    std::condition_variable completedCondition; ///< Signalled when a worker finishes an image.
+    std::vector<bool> completed(numImages, false);
+    std::optional<std::string> workerError;
+    bool stopRequested = false;
+
+    // ---------------------------------------------------------------
+
+    c_WorkerPool workers(numImages);
+    workers.Start(numWorkers, numCores, [&]() {
+        while (const std::optional<std::size_t> idx = workers.Claim())
+        {
+            std::string errorMsg;
+            const bool success = processImage(*idx, errorMsg);
+
+            {
+                std::lock_guard lock(mutex);
+                if (success)
+                {
+                    completed[*idx] = true;
+                }
+                else if (!workerError.has_value())
+                {
+                    workerError = errorMsg;
+                    stopRequested = true;
+                    workers.RequestStop();
+                }
+            }
+            completedCondition.notify_one();
+        }
+    });
+
+    // Report the completed images in order; abort requests can only be checked from this thread
+    std::size_t numReported = 0;
+    {
+        std::unique_lock lock(mutex);
+        while (numReported < numImages && !stopRequested)
+        {
+            completedCondition.wait_for(lock, ABORT_CHECK_INTERVAL, [&] { return stopRequested || completed[numReported]; });
+
+            while (numReported < numImages && completed[numReported])
+            {
+                onImageCompleted(numReported);
+                ++numReported;
+            }
+
+            if (numReported < numImages && !stopRequested)
+            {
+                lock.unlock();
+                const bool abortRequested = IsAbortRequested();
+                lock.lock();
+                if (abortRequested)
+                {
+                    stopRequested = true;
+                    workers.RequestStop();
+                }
+            }
+        }
+    }
+
+    workers.Stop();
+
+    if (workerError.has_value())
+    {
+        m_ErrorMessage = *workerError;
+        return false;
+    }
+
+    return numReported == numImages;
+}
+
+bool c_ImageAlignmentWorkerThread::SaveTranslatedOutputImages(
+    const std::vector<FloatPoint_t>& offsets,
+    unsigned outputWidth,
+    unsigned outputHeight
+)
+{
+    const unsigned numCores = std::max(1U, std::thread::hardware_concurrency());
+
+    // Each worker holds an input and an output image; assume the largest pixel format (RGB, 32-bit floating point)
+    const std::size_t maxBytesPerWorker = 2 * std::size_t{outputWidth} * outputHeight * 3 * sizeof(float);
+    const std::size_t maxWorkersByMemory = std::max<std::size_t>(1, MAX_OUTPUT_BYTES_IN_FLIGHT / std::max<std::size_t>(1, maxBytesPerWorker));
+
+    const unsigned maxWorkers = static_cast<unsigned>(std::min<std::size_t>(
+        m_Parameters.maxOutputThreads > 0 ? m_Parameters.maxOutputThreads : numCores,
+        maxWorkersByMemory
+    ));
+
+    return ProcessImagesConcurrently(
+        offsets.size(),
+        maxWorkers,
+        [&](std::size_t idx, std::string& errorMsg) {
+            return TranslateAndSaveImage(idx, offsets[idx], outputWidth, outputHeight, errorMsg);
+        },
+        [&](std::size_t idx) { SendMessageToParent(EID_SAVED_OUTPUT_IMAGE, idx); }
+    );
+}
+
 /// Aligns the images by keeping the high-contrast features stationary
 void c_ImageAlignmentWorkerThread::PhaseCorrelationAlignment()
 {
@@ -236,17 +433,51 @@ void c_ImageAlignmentWorkerThread::PhaseCorrelationAlignment()
     if (!getSizesResult) { return; }
 
     // Width and height of FFT arrays and the translation working buffer
-    unsigned Nwidth = GetClosestGPowerOf2(maxWidth),
-        Nheight = GetClosestGPowerOf2(maxHeight);
+    unsigned Nwidth = GetWorkingBufferSize(maxWidth),
+        Nheight = GetWorkingBufferSize(maxHeight);
+
+    // Region of interest (in images' coordinates) to correlate instead of whole images
+    std::optional<Rectangle_t> roi;
+    if (m_Parameters.roiMode == RoiMode::USER)
+    {
+        if (!IsRoiWithinImage(m_Parameters.roi, imgSize[0].x, imgSize[0].y))
+        {
+            m_ErrorMessage = wxString::Format(_("Region of interest must lie within the first image (%dx%d)."),
+                imgSize[0].x, imgSize[0].y);
+            return;
+        }
+        roi = m_Parameters.roi;
+    }
+    else if (m_Parameters.roiMode == RoiMode::AUTOMATIC)
+    {
+        const ImageAccessor firstImg = m_FrameCache->Get(0, PixelFormat::PIX_MONO32F, &m_ErrorMessage);
+        if (firstImg.Empty()) { return; }
+
+        roi = SelectRoi(*firstImg.Get());
+        if (!roi.has_value())
+            Log::Print("Images too small for automatic selection of region of interest, using whole images.\n");
+    }
+
+    if (roi.has_value())
+    {
+        if (roi->width <= 0 || roi->height <= 0)
+        {
+            m_ErrorMessage = _("Region of interest is empty.");
+            return;
+        }
+
+        Log::Print(wxString::Format("Using region of interest: %d, %d, %dx%d.\n", roi->x, roi->y, roi->width, roi->height));
+    }
 
     std::vector<FloatPoint_t> translation;
     Rectangle_t bbox; // bounding box of all images after alignment
 
-    if (!DetermineTranslationVectors(Nwidth, Nheight, m_Parameters.inputs,
+    if (!DetermineTranslationVectors(Nwidth, Nheight, *m_FrameCache,
         translation, bbox, &m_ErrorMessage, m_Parameters.subpixelAlignment,
         [this](int imgIdx, float tX, float tY) { PhaseCorrImgTranslationCallback(imgIdx, tX, tY); },
         [this]() { return IsAbortRequested(); },
-        m_Parameters.normalizeFitsValues
+        roi,
+        m_Parameters.coarseToFine
     ))
     {
         return;
@@ -263,88 +494,36 @@ void c_ImageAlignmentWorkerThread::PhaseCorrelationAlignment()
 
     Rectangle_t imgIntersection = DetermineImageIntersection(Nwidth, Nheight, translation, imgSize);
 
-    // Iterate again over all images, load, pad to the bounding box size or crop to intersection, translate and save
+    // Load all images again, pad to the bounding box size or crop to intersection, translate and save
 
     int outputWidth = m_Parameters.cropMode == CropMode::CROP_TO_INTERSECTION ? imgIntersection.width : bbox.width;
     int outputHeight = m_Parameters.cropMode == CropMode::CROP_TO_INTERSECTION ? imgIntersection.height : bbox.height;
 
-    for (size_t i = 0; i < GetNumInputs(m_Parameters.inputs); i++)
+    Point_t translationOrigin;
+    if (m_Parameters.cropMode == CropMode::CROP_TO_INTERSECTION)
     {
-        if (IsAbortRequested())
-            return;
-
-        Point_t translationOrigin;
-        if (m_Parameters.cropMode == CropMode::CROP_TO_INTERSECTION)
-        {
-            translationOrigin.x = imgIntersection.x;
-            translationOrigin.y = imgIntersection.y;
-        }
-        else
-        {
-            translationOrigin.x = bbox.x;
-            translationOrigin.y = bbox.y;
-        }
-
-        const auto source = GetInputImageByIndex(m_Parameters.inputs, i, &m_ErrorMessage);
-        if (source.Empty()) { return; }
+        translationOrigin.x = imgIntersection.x;
+        translationOrigin.y = imgIntersection.y;
+    }
+    else
+    {
+        translationOrigin.x = bbox.x;
+        translationOrigin.y = bbox.y;
+    }
 
-        auto output = CreateTranslatedOutput(
-            *source.Get(),
-            outputWidth,
-            outputHeight,
+    std::vector<FloatPoint_t> offsets;
+    for (size_t i = 0; i < GetNumInputs(m_Parameters.inputs); i++)
+    {
+        offsets.emplace_back(
             (Nwidth - imgSize[i].x)/2 - translation[i].x - translationOrigin.x,
             (Nheight - imgSize[i].y)/2 - translation[i].y - translationOrigin.y
         );
-
-        if (const auto* fnames = std::get_if<wxArrayString>(&m_Parameters.inputs))
-        {
-            if (!SaveTranslatedOutputImage((*fnames)[i], output))
-            {
-                return;
-            }
-        }
-
-        SendMessageToParent(EID_SAVED_OUTPUT_IMAGE, i);
     }
 
-    m_ProcessingCompleted = true;
-}
-
-/// Returns the quality of the specified image area: the sum of squared gradients
-float GetQuality(const c_Image& img, const Rectangle_t& area)
-{
-    IMPPG_ASSERT(img.GetPixelFormat() == PixelFormat::PIX_MONO32F);
-
-    float result = 0;
-
-    // Skip the border pixels in case there is a bright leftover from wavelet sharpening
-    const int BORDER_SKIP = 3;
-
-    for (int y = BORDER_SKIP; y < area.height - BORDER_SKIP - 1; y++)
-        for (int x = BORDER_SKIP; x < area.width - BORDER_SKIP - 1; x++)
-        {
-            float val00 = img.GetRowAs<float>(area.y + y)[area.x + x];
-            float val10 = img.GetRowAs<float>(area.y + y)[area.x + x+1];
-            float val01 = img.GetRowAs<float>(area.y + y+1)[area.x + x];
-
-            result += sqr(val10 - val00) + sqr(val01 - val00);
-        }
-
-    return result;
-}
-
-c_Image GetBlurredImage(const c_Image& srcImg, float gaussianSigma)
-{
-    IMPPG_ASSERT(srcImg.GetPixelFormat() == PixelFormat::PIX_MONO32F);
-
-    c_Image result(srcImg.GetWidth(), srcImg.GetHeight(), PixelFormat::PIX_MONO32F);
-
-    ConvolveSeparable(
-            c_PaddedArrayPtr(srcImg.GetRowAs<float>(0), srcImg.GetWidth(), srcImg.GetHeight(), srcImg.GetBuffer().GetBytesPerRow()),
-            c_PaddedArrayPtr(result.GetRowAs<float>(0), result.GetWidth(), result.GetHeight(), result.GetBuffer().GetBytesPerRow()),
-            gaussianSigma);
+    if (!SaveTranslatedOutputImages(offsets, outputWidth, outputHeight))
+        return;
 
-    return result;
+    m_ProcessingCompleted = true;
 }
 
 /// Performs the final stabilization phase of limb alignment; returns 'true' on success
@@ -383,53 +562,36 @@ bool c_ImageAlignmentWorkerThread::StabilizeLimbAlignment(
     //TODO: (optional) display the first image and ask the user to select a feature that is
     //visible in every image
 
-    // Size of the (square) stabilization area in pixels; has to be a power of 2
+    // Size of the (square) stabilization area in pixels; has to be a supported FFT length
     const int STBL_AREA_SIZE = 128;
 
     // Size of the intersection area
 
     if (intrWidth >= STBL_AREA_SIZE && intrHeight >= STBL_AREA_SIZE)
     {
-        // Center of the stabilization area (the high-contrast feature) in the first image
-        // relative to the images' intersection origin
-        Point_t stabilizationPos;
-
         // Scan the first image's intersection portion for the highest-contrast area
         IMPPG_ASSERT(!fnames->IsEmpty());
-        auto loadResult = LoadImageFileAsMono32f(
-            ToFsPath((*fnames)[0]),
-            m_Parameters.normalizeFitsValues
-        );
-        if (!loadResult)
+        const auto loadResult = m_FrameCache->Get(0, PixelFormat::PIX_MONO32F);
+        if (loadResult.Empty())
         {
             errorMsg = wxString::Format(_("Could not read %s."), (*fnames)[0]);
             return false;
         }
-        c_Image firstImg = std::move(loadResult.value());
+        c_Image firstImg = *loadResult.Get();
 
         // Blur the image first to remove the impact of noise
         firstImg = GetBlurredImage(firstImg, 1.0f);
 
-        float maxQuality = 0;
-        for (int i = 0; i < intrWidth / (STBL_AREA_SIZE/2) - 1; i++)
-            for (int j = 0; j < intrHeight / (STBL_AREA_SIZE/2) - 1; j++)
-            {
-                Rectangle_t currentArea(i*STBL_AREA_SIZE/2, j*STBL_AREA_SIZE/2, STBL_AREA_SIZE, STBL_AREA_SIZE);
-                float quality = GetQuality(firstImg,
-                    Rectangle_t(intersectionStart.x + currentArea.x,
-                                intersectionStart.y + currentArea.y,
-                                currentArea.width, currentArea.height));
-                if (quality > maxQuality)
-                {
-                    maxQuality = quality;
-                    stabilizationPos = Point_t(currentArea.x + currentArea.width/2, currentArea.y + currentArea.height/2);
-                }
-            }
+        // Center of the stabilization area (the high-contrast feature) in the first image
+        // relative to the images' intersection origin
+        Point_t stabilizationPos = FindHighestContrastArea(
+            firstImg, Rectangle_t(intersectionStart.x, intersectionStart.y, intrWidth, intrHeight), STBL_AREA_SIZE);
 
         // 2. Trace the movement of the stabilization area
 
         // Window function for blunting the stabilization area's edges; Has a 1.0 peak in the middle and tapers to zero near the edges
-        c_Image wndFunc = CalcWindowFunction(STBL_AREA_SIZE, STBL_AREA_SIZE);
+        const PhaseCorrelationPlanPtr stblPlan = AcquirePhaseCorrelationPlan(STBL_AREA_SIZE, STBL_AREA_SIZE);
+        const c_Image& wndFunc = stblPlan->GetWindowFunction();
 
         // Each element is the position of the stabilization area in subsequent images relative to the images' intersection origin
         std::vector<FloatPoint_t> stAreaImagePos;
@@ -454,16 +616,13 @@ bool c_ImageAlignmentWorkerThread::StabilizeLimbAlignment(
 
             SendMessageToParent(EID_LIMB_STABILIZATION_PROGRESS, i);
 
-            const auto loadResult = LoadImageFileAsMono32f(
-                ToFsPath((*fnames)[i]),
-                m_Parameters.normalizeFitsValues
-            );
-            if (!loadResult)
+            const auto loadResult = m_FrameCache->Get(i, PixelFormat::PIX_MONO32F);
+            if (loadResult.Empty())
             {
                 errorMsg = wxString::Format(_("Could not read %s."), (*fnames)[i]);
                 return false;
             }
-            const c_Image& currImg = loadResult.value();
+            const c_Image& currImg = *loadResult.Get();
 
             Point_t Tint;
             FloatPoint_t Tfrac;
@@ -480,7 +639,7 @@ bool c_ImageAlignmentWorkerThread::StabilizeLimbAlignment(
 
             currArea->Multiply(wndFunc);
 
-            FloatPoint_t areaTranslation = DetermineTranslationVector(*prevArea, *currArea);
+            FloatPoint_t areaTranslation = DetermineTranslationVector(*stblPlan, *prevArea, *currArea);
             FloatPoint_t& prev = stAreaImagePos.back();
 
             // We also need to take the fractional parts of current and previous translation into account,
@@ -624,160 +783,193 @@ void CountNeighborsAboveThreshold(
             }
 }
 
-/// Finds disc radii in input images; returns 'true' on success
-bool c_ImageAlignmentWorkerThread::FindRadii(
-    const wxArrayString& fnames,
-    std::vector<std::vector<FloatPoint_t>>& limbPoints, ///< Receives limb points found in n-th image
-    std::vector<float>& radii, ///< Receives disc radii determined for each image
-    std::vector<Point_t>& imgSizes, ///< Receives input image sizes
-    std::vector<Point_t>& centroids ///< Receives image centroids
+namespace
+{
+
+struct DiscLimb
+{
+    std::vector<FloatPoint_t> limbPoints;
+    float radius;
+    Point_t centroid;
+};
+
+/// Finds the limb of the solar disc in a PIX_MONO8 image; returns `std::nullopt` on failure.
+std::optional<DiscLimb> FindDiscLimb(
+    const c_Image& img,
+    const wxString& fname, ///< Used in messages
+    std::string& errorMsg ///< Receives error message (if any)
 )
 {
-    AlignmentEventPayload_t payload;
+    DiscLimb result;
+
+    // 1. Find the threshold value of brightness which separates
+    //      the disc from the background.
 
-    for (size_t i = 0; i < fnames.Count(); i++)
+    uint8_t avgDisc, avgBkgrnd;
+    const std::optional<std::uint8_t> threshold = FindDiscBackgroundThreshold(img, &avgDisc, &avgBkgrnd);
+    if (!threshold.has_value())
     {
-        if (IsAbortRequested())
-            return false;
+        errorMsg = wxString::Format(_("Could not find solar disc in %s."), fname);
+        return std::nullopt;
+    }
 
-        const auto loadResult = LoadImageFileAsMono8(
-            ToFsPath(fnames[i]),
-            m_Parameters.normalizeFitsValues
-        );
-        if (!loadResult)
-        {
-            m_ErrorMessage = wxString::Format(_("Could not read %s."), fnames[i]);
-            return false;
-        }
-        const c_Image img = loadResult.value();
+    // 2. Calculate the image centroid
 
-        imgSizes.push_back(Point_t(img.GetWidth(), img.GetHeight()));
+    const Point_t centroid = CalcCentroid(img);
+    result.centroid = centroid;
 
-        // 1. Find the threshold value of brightness which separates
-        //      the disc from the background.
+    // 3. Trace a number of rays originating at the centroid
 
-        uint8_t avgDisc, avgBkgrnd;
-        const std::optional<std::uint8_t> threshold = FindDiscBackgroundThreshold(img, &avgDisc, &avgBkgrnd);
-        if (!threshold.has_value())
-        {
-            m_ErrorMessage = wxString::Format(_("Could not find solar disc in %s."), fnames[i]);
-            return false;
-        }
+    const int NUM_RAYS = 64; //TODO: make it configurable
+    std::unique_ptr<Ray_t[]> rays(new Ray_t[NUM_RAYS]);
 
-        // 2. Calculate the image centroid
+    for (int j = 0; j < NUM_RAYS; j++)
+    {
+        Point_t dir;
+        dir.x = NUM_RAYS * std::cos(j * 2*3.14159f / NUM_RAYS);
+        dir.y = NUM_RAYS * std::sin(j * 2*3.14159f / NUM_RAYS);
+        GetRayPoints(centroid, dir, img, rays[j]);
+    }
 
-        Point_t centroid = CalcCentroid(img);
-        centroids.push_back(centroid);
+    // 4. Find limb crossing points along 'rays'
 
-        // 3. Trace a number of rays originating at the centroid
+    // Key: steepness of transition (higher = better)
+    std::multimap<int, Point_t> limbPointsCandidates;
+    for (int j = 0; j < NUM_RAYS; j++)
+    {
+        Point_t limbPt;
+        int varSum = FindLimbCrossing(rays[j], threshold.value(), limbPt);
+        limbPointsCandidates.insert(std::pair<int, Point_t>(varSum, limbPt));
+    }
 
-        const int NUM_RAYS = 64; //TODO: make it configurable
-        std::unique_ptr<Ray_t[]> rays(new Ray_t[NUM_RAYS]);
+    const int THRESHOLD_DIV = 3;
+    // 4.1. Some of the points may be misidentified (e.g. an edge of prominence or a sunspot).
+    // Assume that if the point's steepness is less than 1/THRESHOLD_DIV of the expected avg steepness,
+    // it is not in fact a limb point - and discard it.
 
-        for (int j = 0; j < NUM_RAYS; j++)
-        {
-            Point_t dir;
-            dir.x = NUM_RAYS * std::cos(j * 2*3.14159f / NUM_RAYS);
-            dir.y = NUM_RAYS * std::sin(j * 2*3.14159f / NUM_RAYS);
-            GetRayPoints(centroid, dir, img, rays[j]);
-        }
+    int avgSteepness = DIFF_SIZE * (static_cast<int>(avgDisc) - avgBkgrnd);
 
-        // 4. Find limb crossing points along 'rays'
+    std::vector<FloatPoint_t>& limbPoints = result.limbPoints;
 
-        // Key: steepness of transition (higher = better)
-        std::multimap<int, Point_t> limbPointsCandidates;
-        for (int j = 0; j < NUM_RAYS; j++)
-        {
-            Point_t limbPt;
-            int varSum = FindLimbCrossing(rays[j], threshold.value(), limbPt);
-            limbPointsCandidates.insert(std::pair<int, Point_t>(varSum, limbPt));
-        }
+    // A multimap is sorted by keys ascending and we are interested in the steepest transitions,
+    // so start the iteration from the last element ('rbegin')
+    for (std::multimap<int, Point_t>::const_reverse_iterator rIt = limbPointsCandidates.rbegin();
+        rIt != limbPointsCandidates.rend();
+        rIt++)
+    {
+        if (rIt->first >= 1*avgSteepness/THRESHOLD_DIV)
+            limbPoints.push_back(FloatPoint_t(rIt->second.x, rIt->second.y));
+        else
+            break;
+    }
 
-        const int THRESHOLD_DIV = 3;
-        // 4.1. Some of the points may be misidentified (e.g. an edge of prominence or a sunspot).
-        // Assume that if the point's steepness is less than 1/THRESHOLD_DIV of the expected avg steepness,
-        // it is not in fact a limb point - and discard it.
+    // 4.2. The previous step is sometimes insufficient to remove non-limb points (e.g. if a point was detected
+    //      on the edge of a wide dark filament). Perform the final verification step: the point lies on the limb
+    //      if a sufficient fraction of its neighbors has values below the disc/background threshold.
+    //
+    //      In an ideal, simplified situation the "above threshold" fraction should be always < 0.5 (as the disc
+    //      is convex). In practice, it may be higher (e.g. if we have an overexposed disc with quite bright halo
+    //      + prominences).
+    //
 
-        int avgSteepness = DIFF_SIZE * (static_cast<int>(avgDisc) - avgBkgrnd);
+    // Max. fraction of "above threshold" neighbors which is acceptable for a limb point
+    const float MAX_ABOVE_THRESHOLD_FRACTION = 0.6f;
 
-        // A multimap is sorted by keys ascending and we are interested in the steepest transitions,
-        // so start the iteration from the last element ('rbegin')
-        for (std::multimap<int, Point_t>::const_reverse_iterator rIt = limbPointsCandidates.rbegin();
-            rIt != limbPointsCandidates.rend();
-            rIt++)
-        {
-            if (rIt->first >= 1*avgSteepness/THRESHOLD_DIV)
-                limbPoints[i].push_back(FloatPoint_t(rIt->second.x, rIt->second.y));
-            else
-                break;
-        }
+    std::vector<float> aboveThFraction;
+    size_t numPointsExceedingMaxFraction = 0;
+    for (size_t j = 0; j < limbPoints.size(); j++)
+    {
+        size_t numTotal, numAbove;
+        int radius = DIFF_SIZE;
+        CountNeighborsAboveThreshold(limbPoints[j], img, radius, threshold.value(), numAbove, numTotal);
 
-        // 4.2. The previous step is sometimes insufficient to remove non-limb points (e.g. if a point was detected
-        //      on the edge of a wide dark filament). Perform the final verification step: the point lies on the limb
-        //      if a sufficient fraction of its neighbors has values below the disc/background threshold.
-        //
-        //      In an ideal, simplified situation the "above threshold" fraction should be always < 0.5 (as the disc
-        //      is convex). In practice, it may be higher (e.g. if we have an overexposed disc with quite bright halo
-        //      + prominences).
-        //
-
-        // Max. fraction of "above threshold" neighbors which is acceptable for a limb point
-        const float MAX_ABOVE_THRESHOLD_FRACTION = 0.6f;
-
-        std::vector<float> aboveThFraction;
-        size_t numPointsExceedingMaxFraction = 0;
-        for (size_t j = 0; j < limbPoints[i].size(); j++)
-        {
-            size_t numTotal, numAbove;
-            int radius = DIFF_SIZE;
-            CountNeighborsAboveThreshold(limbPoints[i][j], img, radius, threshold.value(), numAbove, numTotal);
+        float fraction = static_cast<float>(numAbove)/numTotal;
+        aboveThFraction.push_back(fraction);
 
-            float fraction = static_cast<float>(numAbove)/numTotal;
-            aboveThFraction.push_back(fraction);
+        if (fraction > MAX_ABOVE_THRESHOLD_FRACTION)
+            numPointsExceedingMaxFraction++;
+    }
 
-            if (fraction > MAX_ABOVE_THRESHOLD_FRACTION)
-                numPointsExceedingMaxFraction++;
-        }
+    // Assume that if more than 3/4 of points have the "above threshold" fraction exceeding the limit,
+    // we are dealing with an overexposed disc. In this case, do not remove any points.
+    if (numPointsExceedingMaxFraction < 3*limbPoints.size()/4)
+    {
+        // Not an overexposed disc, so the fractions are fine; remove points which exceed the limit
+        for (int j = static_cast<int>(limbPoints.size()) - 1; j >= 0; j--)
+            if (aboveThFraction[j] > MAX_ABOVE_THRESHOLD_FRACTION)
+                limbPoints.erase(limbPoints.begin() + j);
+    }
 
-        // Assume that if more than 3/4 of points have the "above threshold" fraction exceeding the limit,
-        // we are dealing with an overexposed disc. In this case, do not remove any points.
-        if (numPointsExceedingMaxFraction < 3*limbPoints[i].size()/4)
-        {
-            // Not an overexposed disc, so the fractions are fine; remove points which exceed the limit
-            for (int j = static_cast<int>(limbPoints[i].size()) - 1; j >= 0; j--)
-                if (aboveThFraction[j] > MAX_ABOVE_THRESHOLD_FRACTION)
-                    limbPoints[i].erase(limbPoints[i].begin() + j);
-        }
+    Log::Print(wxString::Format("Found %d limb point candidates in %s, used %d (%d%%).\n",
+        static_cast<int>(limbPointsCandidates.size()),
+        fname,
+        static_cast<int>(limbPoints.size()),
+        static_cast<int>(100*limbPoints.size()/limbPointsCandidates.size()))
+    );
 
-        Log::Print(wxString::Format("Found %d limb point candidates, used %d (%d%%).\n",
-            static_cast<int>(limbPointsCandidates.size()),
-            static_cast<int>(limbPoints[i].size()),
-            static_cast<int>(100*limbPoints[i].size()/limbPointsCandidates.size()))
-        );
+    if (limbPoints.size() < 3)
+    {
+        errorMsg = wxString::Format(_("Could not find the limb in %s."), fname);
+        return std::nullopt;
+    }
 
-        if (limbPoints[i].size() < 3)
-        {
-            m_ErrorMessage = wxString::Format(_("Could not find the limb in %s."), fnames[i]);
-            return false;
-        }
+    // 5. Determine disc radius. Theoretically it is the same in each image, in practice
+    //      the radii will differ due to seeing, stacking and post-processing variability.
 
-        // 5. Determine disc radius. Theoretically it is the same in each image, in practice
-        //      the radii will differ due to seeing, stacking and post-processing variability.
+    float cx = centroid.x, cy = centroid.y;
+    if (!FitCircleToPoints(limbPoints, &cx, &cy, &result.radius, 0.0f, true))
+    {
+        errorMsg = wxString::Format(_("Could not find the limb in %s."), fname);
+        return std::nullopt;
+    }
 
-        float radius, cx = centroid.x, cy = centroid.y;
-        if (!FitCircleToPoints(limbPoints[i], &cx, &cy, &radius, 0.0f, true))
-        {
-            m_ErrorMessage = wxString::Format(_("Could not find the limb in %s."), fnames[i]);
-            return false;
-        }
-        radii.push_back(radius);
+    return result;
+}
 
+}
 
-        payload.radius = radius;
-        SendMessageToParent(EID_LIMB_FOUND_DISC_RADIUS, i, wxEmptyString, &payload);
-    }
+/// Finds disc radii in input images; returns 'true' on success
+bool c_ImageAlignmentWorkerThread::FindRadii(
+    const wxArrayString& fnames,
+    std::vector<std::vector<FloatPoint_t>>& limbPoints, ///< Receives limb points found in n-th image
+    std::vector<float>& radii, ///< Receives disc radii determined for each image
+    std::vector<Point_t>& imgSizes, ///< Receives input image sizes
+    std::vector<Point_t>& centroids ///< Receives image centroids
+)
+{
+    // The images are processed independently by a pool of workers
+    radii.resize(fnames.Count());
+    imgSizes.resize(fnames.Count());
+    centroids.resize(fnames.Count());
+
+    return ProcessImagesConcurrently(
+        fnames.Count(),
+        0,
+        [&](std::size_t i, std::string& errorMsg) {
+            const auto loadResult = m_FrameCache->Get(i, PixelFormat::PIX_MONO8);
+            if (loadResult.Empty())
+            {
+                errorMsg = wxString::Format(_("Could not read %s."), fnames[i]);
+                return false;
+            }
+            const c_Image& img = *loadResult.Get();
 
-    return true;
+            imgSizes[i] = Point_t(img.GetWidth(), img.GetHeight());
+
+            auto disc = FindDiscLimb(img, fnames[i], errorMsg);
+            if (!disc.has_value()) { return false; }
+
+            limbPoints[i] = std::move(disc->limbPoints);
+            radii[i] = disc->radius;
+            centroids[i] = disc->centroid;
+            return true;
+        },
+        [&](std::size_t i) {
+            AlignmentEventPayload_t payload;
+            payload.radius = radii[i];
+            SendMessageToParent(EID_LIMB_FOUND_DISC_RADIUS, i, wxEmptyString, &payload);
+        }
+    );
 }
 
 /// Aligns the images by keeping the limb stationary
@@ -911,11 +1103,9 @@ void c_ImageAlignmentWorkerThread::LimbAlignment()
         outputHeight = intersection.ymax - intersection.ymin + 1;
     }
 
+    std::vector<FloatPoint_t> offsets;
     for (size_t i = 0; i < fnames->Count(); i++)
     {
-        if (IsAbortRequested())
-            return;
-
         float Tx, Ty;
         if (m_Parameters.cropMode == CropMode::PAD_TO_BOUNDING_BOX)
         {
@@ -934,22 +1124,28 @@ void c_ImageAlignmentWorkerThread::LimbAlignment()
             Ty = boost::math::round(Ty);
         }
 
-        auto loadResult = LoadImage(ToFsPath((*fnames)[i]), std::nullopt, &m_ErrorMessage, false);
-        if (!loadResult) { return; }
-
-        const c_Image output = CreateTranslatedOutput(loadResult.value(), outputWidth, outputHeight, Tx, Ty);
-
-        if (!SaveTranslatedOutputImage((*fnames)[i], output))
-        {
-             return;
-        }
-
-        SendMessageToParent(EID_SAVED_OUTPUT_IMAGE, i);
+        offsets.emplace_back(Tx, Ty);
     }
 
+    if (!SaveTranslatedOutputImages(offsets, outputWidth, outputHeight))
+        return;
+
     m_ProcessingCompleted = true;
 }
 
+c_ImageAlignmentWorkerThread::c_ImageAlignmentWorkerThread(
+    wxEvtHandler& parent,
+    AlignmentParameters_t params
+)
+: wxThread(wxTHREAD_JOINABLE),
+  m_Parent(parent),
+  m_ProcessingCompleted(false),
+  m_ThreadAborted(false),
+  m_Parameters(std::move(params))
+{}
+
+c_ImageAlignmentWorkerThread::~c_ImageAlignmentWorkerThread() = default;
+
 wxThread::ExitCode c_ImageAlignmentWorkerThread::Entry()
 {
     if (m_Parameters.GetNumInputs() == 0)
@@ -958,6 +1154,13 @@ wxThread::ExitCode c_ImageAlignmentWorkerThread::Entry()
         return 0;
     }
 
+    m_FrameCache = std::make_unique<c_DecodedFrameCache>(
+        m_Parameters.inputs,
+        m_Parameters.normalizeFitsValues,
+        m_Parameters.frameCacheBudget,
+        m_FitsIoMutex
+    );
+
     switch (m_Parameters.alignmentMethod)
     {
     case AlignmentMethod::PHASE_CORRELATION: PhaseCorrelationAlignment(); break;
@@ -965,6 +1168,11 @@ wxThread::ExitCode c_ImageAlignmentWorkerThread::Entry()
     default: IMPPG_ABORT();
     }
 
+    // removes the temporary files (if any)
+    m_FrameCache.reset();
+
+    Log::Print(FormatBufferPoolStats(GetBufferPoolStats()) + "\n");
+
     if (m_ProcessingCompleted)
     {
         SendMessageToParent(EID_COMPLETED);
@@ -1,6 +1,6 @@
 /*
 ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
-Copyright (C) 2016-2019 Filip Szczerek <ga.software@yahoo.com>
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
 
 This file is part of ImPPG.
 
@@ -26,184 +26,553 @@ File description:
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
-#include <memory>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <utility>
+#include <vector>
 
-#include "common/common.h"
+#include "common/imppg_assert.h"
 #include "fft.h"
+#include "image/buffer_pool.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 using std::complex;
 
+namespace
+{
+
+/// Number of columns gathered into contiguous buffers and transformed together.
+constexpr unsigned COLUMN_BATCH = 8;
 
-const float PI = 3.1415926536f;
-const complex<float> I = complex<float>(0, 1);
+/// Number of elements of a cross-power spectrum calculated by a single OpenMP loop iteration.
+constexpr unsigned CROSS_POWER_BLOCK = 4096;
 
-/// Returns floor(log2(N))
-inline unsigned quickLog2(unsigned N)
+int GetMaxThreads()
 {
-    unsigned result = 0;
-    if (N == 0)
-        return 0;
+#if defined(_OPENMP)
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
 
-    while (N > 0)
-    {
-        N >>= 1;
-        result++;
-    }
-    return result - 1;
+int GetThreadNum()
+{
+#if defined(_OPENMP)
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
 }
 
-/// Calculates 1-dimensional discrete Fourier transform or its inverse (not normalized by N, caller must do this)
-template<typename InputT>
-void fft1d(
-    const InputT* input,  ///< Input vector of length 'N'
-    unsigned N,      ///< Number of elements in 'input', has to be a power of two
-    complex<float> output[], ///< Output vector of length 'N'
-    int stride,       ///< Stride of the input vector in bytes
-    int outputStride, ///< Stride of the output vector in bytes
+// Complex arithmetic is written out explicitly, so that the butterflies can be vectorized by the compiler
+// (`std::complex` multiplication handles infinities and NaNs, which prevents that).
 
-    /// Pointer to the initial twiddle factor for N, i.e. exp(-2*pi*i/N) (or exp(2*pi*i/N) for inverse transform).
-    /// NOTE: (twiddlePtr-1) has to point to the lower twiddle factor, i.e. exp(+-2*pi*i/(N/2))
-    const complex<float>* twiddlePtr
-)
+inline complex<float> Mul(complex<float> a, complex<float> b)
 {
-    if (N == 1)
-        output[0] = input[0];
+    return complex<float>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+inline complex<float> MulConj(complex<float> a, complex<float> b)
+{
+    return complex<float>(a.real() * b.real() + a.imag() * b.imag(), a.imag() * b.real() - a.real() * b.imag());
+}
+
+/// Multiplies by a twiddle factor (by its conjugate for the inverse transform).
+template<bool Inverse>
+inline complex<float> MulTwiddle(complex<float> a, complex<float> w)
+{
+    if constexpr (Inverse)
+        return MulConj(a, w);
     else
+        return Mul(a, w);
+}
+
+/// Multiplies by -i (by i for the inverse transform).
+template<bool Inverse>
+inline complex<float> MulMinusI(complex<float> a)
+{
+    if constexpr (Inverse)
+        return complex<float>(-a.imag(), a.real());
+    else
+        return complex<float>(a.imag(), -a.real());
+}
+
+template<unsigned Radix, bool Inverse>
+struct Butterfly;
+
+template<bool Inverse>
+struct Butterfly<2, Inverse>
+{
+    static void Calc(const complex<float>* in, std::size_t inStride, complex<float>* out, std::size_t outStride, const complex<float>* w)
     {
-        fft1d(input, N/2, output, 2*stride, outputStride, twiddlePtr - 1);
-        fft1d(reinterpret_cast<const InputT*>(
-            reinterpret_cast<const uint8_t*>(input) + stride),
-            N/2,
-            reinterpret_cast<complex<float>*>(reinterpret_cast<uint8_t*>(output) + N/2*outputStride),
-            2*stride,
-            outputStride,
-            twiddlePtr - 1
-        );
-
-        // Initial twiddle factor
-        complex<float> tfactor0 = *twiddlePtr;
-
-        complex<float> tfactor = 1.0f;
-        for (unsigned k = 0; k <= N/2 - 1; k++)
+        const complex<float> a0 = in[0];
+        const complex<float> a1 = in[inStride];
+        out[0]         = a0 + a1;
+        out[outStride] = MulTwiddle<Inverse>(a0 - a1, w[0]);
+    }
+};
+
+template<bool Inverse>
+struct Butterfly<4, Inverse>
+{
+    static void Calc(const complex<float>* in, std::size_t inStride, complex<float>* out, std::size_t outStride, const complex<float>* w)
+    {
+        const complex<float> a0 = in[0];
+        const complex<float> a1 = in[inStride];
+        const complex<float> a2 = in[2 * inStride];
+        const complex<float> a3 = in[3 * inStride];
+
+        const complex<float> t0 = a0 + a2;
+        const complex<float> t1 = a0 - a2;
+        const complex<float> t2 = a1 + a3;
+        const complex<float> t3 = MulMinusI<Inverse>(a1 - a3);
+
+        out[0]             = t0 + t2;
+        out[outStride]     = MulTwiddle<Inverse>(t1 + t3, w[0]);
+        out[2 * outStride] = MulTwiddle<Inverse>(t0 - t2, w[1]);
+        out[3 * outStride] = MulTwiddle<Inverse>(t1 - t3, w[2]);
+    }
+};
+
+/// Cosines and sines of 2*pi*j/P, j = 1, ..., (P-1)/2.
+template<unsigned P>
+struct OddRadixRoots;
+
+template<>
+struct OddRadixRoots<3>
+{
+    static constexpr float cosines[] = { -0.5f };
+    static constexpr float sines[] = { 0.86602540378443865f };
+};
+
+template<>
+struct OddRadixRoots<5>
+{
+    static constexpr float cosines[] = { 0.30901699437494742f, -0.80901699437494742f };
+    static constexpr float sines[] = { 0.95105651629515357f, 0.58778525229247313f };
+};
+
+template<>
+struct OddRadixRoots<7>
+{
+    static constexpr float cosines[] = { 0.62348980185873353f, -0.22252093395631440f, -0.90096886790241913f };
+    static constexpr float sines[] = { 0.78183148246802981f, 0.97492791218182361f, 0.43388373911755812f };
+};
+
+/// Butterfly of an odd prime radix P.
+/** Uses the symmetry of the roots of unity: for k = 1, ..., (P-1)/2
+      y[k]   = a[0] + sum_j cos(2*pi*j*k/P) * (a[j] + a[P-j])  -  i * sum_j sin(2*pi*j*k/P) * (a[j] - a[P-j]),
+      y[P-k] = a[0] + sum_j cos(2*pi*j*k/P) * (a[j] + a[P-j])  +  i * sum_j sin(2*pi*j*k/P) * (a[j] - a[P-j]),
+    where j = 1, ..., (P-1)/2 (signs of the imaginary terms are swapped for the inverse transform). */
+template<unsigned P, bool Inverse>
+struct OddButterfly
+{
+    static void Calc(const complex<float>* in, std::size_t inStride, complex<float>* out, std::size_t outStride, const complex<float>* w)
+    {
+        constexpr unsigned H = (P - 1) / 2;
+        using Roots = OddRadixRoots<P>;
+
+        const complex<float> a0 = in[0];
+        complex<float> sums[H];
+        complex<float> diffs[H];
+        complex<float> y0 = a0;
+        for (unsigned j = 1; j <= H; ++j)
         {
-            complex<float> t = *reinterpret_cast<complex<float>*>(reinterpret_cast<uint8_t*>(output) + k*outputStride);
-            complex<float> h = tfactor * (*(reinterpret_cast<complex<float>*>(reinterpret_cast<uint8_t*>(output) + (k + (N>>1))*outputStride)));
+            const complex<float> a = in[j * inStride];
+            const complex<float> b = in[(P - j) * inStride];
+            sums[j - 1] = a + b;
+            diffs[j - 1] = a - b;
+            y0 += sums[j - 1];
+        }
+        out[0] = y0;
 
-            *reinterpret_cast<complex<float>*>(reinterpret_cast<uint8_t*>(output) + k*outputStride) = t + h;
-            *reinterpret_cast<complex<float>*>(reinterpret_cast<uint8_t*>(output) + (k + (N>>1))*outputStride) = t - h;
+        for (unsigned k = 1; k <= H; ++k)
+        {
+            complex<float> re = a0;
+            complex<float> im = 0.0f;
+            for (unsigned j = 1; j <= H; ++j)
+            {
+                const unsigned idx = j * k % P;
+                const float c = (idx <= H) ? Roots::cosines[idx - 1] : Roots::cosines[P - idx - 1];
+                const float s = (idx <= H) ? Roots::sines[idx - 1] : -Roots::sines[P - idx - 1];
+                re += c * sums[j - 1];
+                im += s * diffs[j - 1];
+            }
+            const complex<float> rotated = MulMinusI<Inverse>(im);
+            out[k * outStride]       = MulTwiddle<Inverse>(re + rotated, w[k - 1]);
+            out[(P - k) * outStride] = MulTwiddle<Inverse>(re - rotated, w[P - k - 1]);
+        }
+    }
+};
 
-            tfactor *= tfactor0; // in effect, tfactor = exp(-2*PI*I * k/N)
+template<bool Inverse> struct Butterfly<3, Inverse>: OddButterfly<3, Inverse> {};
+template<bool Inverse> struct Butterfly<5, Inverse>: OddButterfly<5, Inverse> {};
+template<bool Inverse> struct Butterfly<7, Inverse>: OddButterfly<7, Inverse> {};
+
+/// Performs a single stage of the self-sorting (Stockham) decimation-in-frequency FFT.
+/** The stage splits `s` interleaved sub-transforms of length Radix*m into Radix*s interleaved sub-transforms
+    of length m: y[q + s*(Radix*p + k)] = w^(p*k) * sum_j x[q + s*(p + j*m)] * exp(-2*pi*i*j*k/Radix). */
+template<unsigned Radix, bool Inverse>
+void RunStage(const complex<float>* x, complex<float>* y, unsigned m, unsigned s, const complex<float>* twiddles)
+{
+    if (s == 1)
+    {
+        // First stage; the loop over `p` is the long one
+        for (unsigned p = 0; p < m; ++p)
+            Butterfly<Radix, Inverse>::Calc(x + p, m, y + Radix * p, 1, twiddles + p * (Radix - 1));
+    }
+    else
+    {
+        for (unsigned p = 0; p < m; ++p)
+        {
+            const complex<float>* w = twiddles + p * (Radix - 1);
+            const complex<float>* xp = x + s * p;
+            complex<float>* yp = y + s * Radix * p;
+            for (unsigned q = 0; q < s; ++q)
+                Butterfly<Radix, Inverse>::Calc(xp + q, s * m, yp + q, s, w);
         }
     }
 }
 
-void CalcTwiddleFactors(unsigned N, complex<float> table[], bool inverse)
+} // anonymous namespace
+
+/// Iterative 1-dimensional FFT of a fixed length (a product of powers of 2, 3, 5 and 7).
+/** Uses radix-4 stages (and a radix-2 stage for odd powers of two), followed by radix-3, 5 and 7 stages,
+    with precomputed twiddle factors stored contiguously in the order in which the stages access them.
+    The self-sorting formulation needs no digit-reversal permutation; stages alternate between the data
+    and a work buffer. */
+class c_Fft1D
 {
-    for (int n = quickLog2(N); n >= 0; n--)
+public:
+    explicit c_Fft1D(unsigned n): m_N(n)
+    {
+        IMPPG_ASSERT(IsSupportedFFTLength(n));
+
+        const double PI = 3.14159265358979323846;
+        unsigned length = n;
+        unsigned s = 1;
+        while (length > 1)
+        {
+            unsigned radix = 0;
+            for (unsigned r: { 4, 2, 3, 5, 7 })
+                if (length % r == 0)
+                {
+                    radix = r;
+                    break;
+                }
+            const unsigned m = length / radix;
+            m_Stages.push_back(Stage{radix, m, s, m_Twiddles.size()});
+            for (unsigned p = 0; p < m; ++p)
+                for (unsigned k = 1; k < radix; ++k)
+                {
+                    const double angle = -2.0 * PI * p * k / length;
+                    m_Twiddles.emplace_back(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+                }
+
+            length = m;
+            s *= radix;
+        }
+    }
+
+    unsigned GetLength() const { return m_N; }
+
+    /// Transforms `data` in place (not normalized); `work` must have room for `GetLength()` elements.
+    template<bool Inverse>
+    void Transform(complex<float>* data, complex<float>* work) const
+    {
+        complex<float>* x = data;
+        complex<float>* y = work;
+        for (const Stage& stage: m_Stages)
+        {
+            const complex<float>* twiddles = m_Twiddles.data() + stage.twiddleOffset;
+            switch (stage.radix)
+            {
+            case 2: RunStage<2, Inverse>(x, y, stage.m, stage.s, twiddles); break;
+            case 3: RunStage<3, Inverse>(x, y, stage.m, stage.s, twiddles); break;
+            case 4: RunStage<4, Inverse>(x, y, stage.m, stage.s, twiddles); break;
+            case 5: RunStage<5, Inverse>(x, y, stage.m, stage.s, twiddles); break;
+            case 7: RunStage<7, Inverse>(x, y, stage.m, stage.s, twiddles); break;
+            default: IMPPG_ABORT();
+            }
+
+            std::swap(x, y);
+        }
+
+        if (x != data)
+            std::memcpy(data, x, m_N * sizeof(complex<float>));
+    }
+
+private:
+    struct Stage
     {
-        table[n] = (inverse ?
-            exp(2.0f * PI * I * (1.0f/N)) :
-            exp(-2.0f * PI * I * (1.0f/N)));
+        unsigned radix;
+        unsigned m; ///< Length of sub-transforms after this stage.
+        unsigned s; ///< Number of sub-transforms before this stage.
+        std::size_t twiddleOffset;
+    };
+
+    unsigned m_N;
+    std::vector<Stage> m_Stages;
+    std::vector<complex<float>> m_Twiddles;
+};
+
+bool IsSupportedFFTLength(unsigned n)
+{
+    if (n == 0)
+        return false;
+
+    for (unsigned factor: { 2, 3, 5, 7 })
+        while (n % factor == 0)
+            n /= factor;
+
+    return n == 1;
+}
 
-        N >>= 1;
+unsigned GetOptimalFFTLength(unsigned n)
+{
+    unsigned powerOf2 = 2;
+    while (powerOf2 < n)
+        powerOf2 *= 2;
+
+    // Lengths with large prime factors, although supported, may take longer to transform than some greater lengths;
+    // choose the one with the lowest estimated cost (number of elements times the sum of relative costs per element
+    // of all the stages). The next power of two is always a candidate.
+    unsigned result = powerOf2;
+    float minCost = std::numeric_limits<float>::max();
+    for (unsigned length = std::max(2U, n + n % 2); length <= powerOf2; length += 2)
+    {
+        if (!IsSupportedFFTLength(length))
+            continue;
+
+        float stagesCost = 0.0f;
+        unsigned remaining = length;
+        while (remaining % 4 == 0) { remaining /= 4; stagesCost += 1.0f; }
+        while (remaining % 2 == 0) { remaining /= 2; stagesCost += 0.85f; }
+        while (remaining % 3 == 0) { remaining /= 3; stagesCost += 1.1f; }
+        while (remaining % 5 == 0) { remaining /= 5; stagesCost += 2.0f; }
+        while (remaining % 7 == 0) { remaining /= 7; stagesCost += 3.0f; }
+
+        const float cost = length * stagesCost;
+        if (cost < minCost)
+        {
+            minCost = cost;
+            result = length;
+        }
     }
+
+    return result;
 }
 
-/// Calculates 2-dimensional discrete Fourier transform
-/** Uses the row-column algorithm. */
-void CalcFFT2D(
-    const float input[], ///< Input array containing rows*cols elements
-    unsigned rows, ///< Number of rows, has to be a power of two
-    unsigned cols, ///< Number of columns, has to be a power of two
-    int stride,    ///< Number of bytes per row in 'input'
-    std::complex<float> output[] ///< Output array containing rows*cols elements
-)
+c_FFTPlan2D::c_FFTPlan2D(unsigned rows, unsigned cols)
+: m_Rows(rows),
+  m_Cols(cols),
+  m_RowFFT(std::make_unique<c_Fft1D>(cols)),
+  m_ColumnFFT(std::make_unique<c_Fft1D>(rows))
+{}
+
+c_FFTPlan2D::~c_FFTPlan2D() = default;
+
+std::size_t c_FFTPlan2D::GetSpectrumLength() const
 {
-    unsigned maxDim = std::max(rows, cols);
+    return static_cast<std::size_t>(m_Rows) * GetHalfSpectrumWidth(m_Cols);
+}
 
-    // Allocate without calling the complex<float> constructor
-    std::unique_ptr<complex<float>, BlockDeleter> twiddleFactors(
-        static_cast<complex<float>*>(operator new[]((quickLog2(maxDim) + 1) * sizeof(complex<float>)))
-    );
+void c_FFTPlan2D::ReleaseWorkBuffers()
+{
+    m_WorkBuffers.clear();
+}
 
-    CalcTwiddleFactors(maxDim, twiddleFactors.get(), false);
+int c_FFTPlan2D::PrepareWorkBuffers()
+{
+    const int numThreads = GetMaxThreads();
+    if (m_WorkBuffers.size() < static_cast<std::size_t>(numThreads))
+        m_WorkBuffers.resize(numThreads);
 
-    // Calculate 1-dimensional transforms of all the rows
-    std::unique_ptr<complex<float>, BlockDeleter> fftrows(
-        static_cast<complex<float>*>(operator new[](rows * cols * sizeof(complex<float>)))
-    );
+    // Room for: a row and the 1D transform's work buffer, or a batch of columns and the work buffer
+    const std::size_t length = std::max(2 * std::size_t{m_Cols}, (COLUMN_BATCH + 1) * std::size_t{m_Rows});
+    for (auto& buffer: m_WorkBuffers)
+        buffer.Reserve(length);
 
-    #pragma omp parallel for
-    for (unsigned k = 0; k < rows; k++)
-        fft1d<float>(
-            reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(input) + k*stride),
-            cols,
-            fftrows.get() + k*cols,
-            1 * sizeof(float),
-            1 * sizeof(complex<float>), twiddleFactors.get() + quickLog2(cols)
-        );
-
-    // Calculate 1-dimensional transforms of all columns in 'fftrows' to get the final result
-    #pragma omp parallel for
-    for (unsigned k = 0; k < cols; k++)
-        fft1d<complex<float>>(fftrows.get() + k, rows, output + k, cols * sizeof(complex<float>), cols * sizeof(complex<float>), twiddleFactors.get() + quickLog2(rows));
+    return numThreads;
 }
 
-/// Calculates 2-dimensional inverse discrete Fourier transform
-/** Uses the row-column algorithm. */
-void CalcFFTinv2D(
-    const std::complex<float> input[], ///< Input array containing rows*cols elements
-    unsigned rows, ///< Number of rows, has to be a power of two
-    unsigned cols, ///< Number of columns, has to be a power of two
-    std::complex<float> output[] ///< Output array containing rows*cols elements
-    )
+template<bool Inverse>
+void c_FFTPlan2D::TransformColumns(std::complex<float> data[])
 {
-    float rowsInv = 1.0f/rows;
-    float colsInv = 1.0f/cols;
+    const unsigned rows = m_Rows;
+    const unsigned numCols = GetHalfSpectrumWidth(m_Cols);
+    const int numBatches = (numCols + COLUMN_BATCH - 1) / COLUMN_BATCH;
+    const int numThreads = PrepareWorkBuffers();
 
-    unsigned maxDim = std::max(rows, cols);
-    // Allocate without calling the complex<float> constructor
-    std::unique_ptr<complex<float>, BlockDeleter> twiddleFactors(
-        static_cast<complex<float>*>(operator new[]((quickLog2(maxDim)+1) * sizeof(complex<float>)))
-    );
+    #pragma omp parallel num_threads(numThreads)
+    {
+        // Columns of a batch are gathered into contiguous buffers, so that the transforms do not stride over rows
+        complex<float>* columns = m_WorkBuffers[GetThreadNum()].get();
+        complex<float>* work = columns + COLUMN_BATCH * rows;
 
-    CalcTwiddleFactors(maxDim, twiddleFactors.get(), true);
+        #pragma omp for
+        for (int batch = 0; batch < numBatches; ++batch)
+        {
+            const unsigned x0 = batch * COLUMN_BATCH;
+            const unsigned batchCols = std::min(COLUMN_BATCH, numCols - x0);
 
-    // Calculate 1-dimensional inverse transforms of all the rows
-    std::unique_ptr<complex<float>, BlockDeleter> fftrows(
-        static_cast<complex<float>*>(operator new[](rows * cols * sizeof(complex<float>)))
-    );
+            for (unsigned y = 0; y < rows; ++y)
+                for (unsigned i = 0; i < batchCols; ++i)
+                    columns[i * rows + y] = data[y * numCols + x0 + i];
 
-    #pragma omp parallel for
-    for (unsigned k = 0; k < rows; k++)
-        fft1d<complex<float>>(
-            input + k*cols,
-            cols,
-            fftrows.get() + k*cols,
-            1 * sizeof(complex<float>),
-            1 * sizeof(complex<float>),
-            twiddleFactors.get() + quickLog2(cols)
-        );
+            for (unsigned i = 0; i < batchCols; ++i)
+                m_ColumnFFT->Transform<Inverse>(columns + i * rows, work);
 
+            for (unsigned y = 0; y < rows; ++y)
+                for (unsigned i = 0; i < batchCols; ++i)
+                    data[y * numCols + x0 + i] = columns[i * rows + y];
+        }
+    }
+}
 
-    for (unsigned k = 0; k < rows*cols; k++)
-        fftrows.get()[k] *= colsInv;
+void c_FFTPlan2D::Transform(const float input[], int stride, std::complex<float> output[])
+{
+    const unsigned rows = m_Rows;
+    const unsigned cols = m_Cols;
+    const unsigned halfCols = GetHalfSpectrumWidth(cols);
+    const int numRowPairs = (rows + 1) / 2;
+    const int numThreads = PrepareWorkBuffers();
+
+    // Transform pairs of rows (a, b) as single complex rows z = a + ib and separate the results using Hermitian symmetry:
+    //   A[k] = (Z[k] + conj(Z[N-k])) / 2,   B[k] = -i/2 * (Z[k] - conj(Z[N-k]))
+    #pragma omp parallel num_threads(numThreads)
+    {
+        complex<float>* z = m_WorkBuffers[GetThreadNum()].get();
+        complex<float>* work = z + cols;
 
-    // Calculate 1-dimensional inverse transforms of all columns in 'fftrows' to get the final result
-    #pragma omp parallel for
-    for (unsigned k = 0; k < cols; k++)
-        fft1d<complex<float>>(
-            fftrows.get() + k,
-            rows,
-            output + k,
-            cols * sizeof(complex<float>),
-            cols * sizeof(complex<float>),
-            twiddleFactors.get() + quickLog2(rows)
-        );
+        #pragma omp for
+        for (int pair = 0; pair < numRowPairs; ++pair)
+        {
+            const unsigned y0 = 2 * pair;
+            const bool hasSecondRow = (y0 + 1 < rows);
+            const float* a = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(input) + y0 * stride);
+
+            if (hasSecondRow)
+            {
+                const float* b = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(input) + (y0 + 1) * stride);
+                for (unsigned x = 0; x < cols; ++x)
+                    z[x] = complex<float>(a[x], b[x]);
+            }
+            else
+            {
+                for (unsigned x = 0; x < cols; ++x)
+                    z[x] = complex<float>(a[x], 0.0f);
+            }
+
+            m_RowFFT->Transform<false>(z, work);
+
+            complex<float>* outA = output + y0 * halfCols;
+            complex<float>* outB = output + (y0 + 1) * halfCols;
+            for (unsigned k = 0; k < halfCols; ++k)
+            {
+                const complex<float> zk = z[k];
+                const complex<float> zn = std::conj(z[(k == 0) ? 0 : cols - k]);
+                outA[k] = 0.5f * (zk + zn);
+                if (hasSecondRow)
+                {
+                    const complex<float> d = zk - zn;
+                    outB[k] = complex<float>(0.5f * d.imag(), -0.5f * d.real());
+                }
+            }
+        }
+    }
+
+    TransformColumns<false>(output);
+}
+
+void c_FFTPlan2D::TransformInverse(std::complex<float> input[], float output[])
+{
+    TransformColumns<true>(input);
+
+    const unsigned rows = m_Rows;
+    const unsigned cols = m_Cols;
+    const unsigned halfCols = GetHalfSpectrumWidth(cols);
+    const float scale = 1.0f / (static_cast<float>(rows) * cols);
+    const int numRowPairs = (rows + 1) / 2;
+    const int numThreads = PrepareWorkBuffers();
+
+    // Each row of the column-transformed input is the half spectrum of a real row; restore the full spectra
+    // of a pair of rows (A, B) and transform them as a single complex row Z = A + iB, whose inverse is a + ib.
+    #pragma omp parallel num_threads(numThreads)
+    {
+        complex<float>* z = m_WorkBuffers[GetThreadNum()].get();
+        complex<float>* work = z + cols;
+
+        #pragma omp for
+        for (int pair = 0; pair < numRowPairs; ++pair)
+        {
+            const unsigned y0 = 2 * pair;
+            const bool hasSecondRow = (y0 + 1 < rows);
+            const complex<float>* inA = input + y0 * halfCols;
+
+            if (hasSecondRow)
+            {
+                const complex<float>* inB = input + (y0 + 1) * halfCols;
+                for (unsigned k = 0; k < halfCols; ++k)
+                    z[k] = complex<float>(inA[k].real() - inB[k].imag(), inA[k].imag() + inB[k].real());
+                for (unsigned k = halfCols; k < cols; ++k)
+                {
+                    // conj(A[N-k]) + i*conj(B[N-k])
+                    const complex<float> a = inA[cols - k];
+                    const complex<float> b = inB[cols - k];
+                    z[k] = complex<float>(a.real() + b.imag(), b.real() - a.imag());
+                }
+            }
+            else
+            {
+                for (unsigned k = 0; k < halfCols; ++k)
+                    z[k] = inA[k];
+                for (unsigned k = halfCols; k < cols; ++k)
+                    z[k] = std::conj(inA[cols - k]);
+            }
+
+            m_RowFFT->Transform<true>(z, work);
+
+            float* outA = output + y0 * cols;
+            for (unsigned x = 0; x < cols; ++x)
+                outA[x] = z[x].real() * scale;
+
+            if (hasSecondRow)
+            {
+                float* outB = output + (y0 + 1) * cols;
+                for (unsigned x = 0; x < cols; ++x)
+                    outB[x] = z[x].imag() * scale;
+            }
+        }
+    }
+}
 
-    for (unsigned k = 0; k < rows*cols; k++)
-        output[k] *= rowsInv;
+void CalcFFT2DReal(
+    const float input[],
+    unsigned rows,
+    unsigned cols,
+    int stride,
+    std::complex<float> output[]
+)
+{
+    c_FFTPlan2D(rows, cols).Transform(input, stride, output);
+}
+
+void CalcFFTinv2DReal(
+    std::complex<float> input[],
+    unsigned rows,
+    unsigned cols,
+    float output[]
+)
+{
+    c_FFTPlan2D(rows, cols).TransformInverse(input, output);
 }
 
 /// Calculates cross-power spectrum of two 2D discrete Fourier transforms
@@ -214,12 +583,34 @@ void CalcCrossPowerSpectrum2D(
     unsigned N ///< Number of array elements
 )
 {
+    // Operate on real and imaginary parts (std::complex<float> is layout-compatible with float[2]) instead of
+    // complex multiplication and 'abs' (which calls 'hypot'), so that the inner loop gets vectorized; normalization
+    // multiplies by the reciprocal square root of the squared magnitude.
+    const float* f1 = reinterpret_cast<const float*>(F1);
+    const float* f2 = reinterpret_cast<const float*>(F2);
+    float* out = reinterpret_cast<float*>(output);
+
+    const int numBlocks = static_cast<int>((N + CROSS_POWER_BLOCK - 1) / CROSS_POWER_BLOCK);
+
     #pragma omp parallel for
-    for (unsigned i = 0; i < N; i++)
+    for (int block = 0; block < numBlocks; block++)
     {
-        output[i] = conj(F1[i]) * F2[i];
-        float magn = abs(output[i]);
-        if (magn > 1.0e-8f)
-            output[i] /= magn;
+        const std::size_t start = static_cast<std::size_t>(block) * CROSS_POWER_BLOCK;
+        const std::size_t end = std::min<std::size_t>(N, start + CROSS_POWER_BLOCK);
+        for (std::size_t i = start; i < end; i++)
+        {
+            const float re1 = f1[2*i], im1 = f1[2*i + 1];
+            const float re2 = f2[2*i], im2 = f2[2*i + 1];
+
+            // conj(F1) * F2
+            const float re = re1 * re2 + im1 * im2;
+            const float im = re1 * im2 - im1 * re2;
+
+            const float magnSq = re * re + im * im;
+            const float scale = (magnSq > 1.0e-16f) ? 1.0f / std::sqrt(magnSq) : 1.0f;
+
+            out[2*i] = re * scale;
+            out[2*i + 1] = im * scale;
+        }
     }
 }
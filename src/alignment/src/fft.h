@@ -24,26 +24,91 @@ File description:
 #define IMPPG_FFT_HEADER
 
 #include <complex>
+#include <cstddef>
+#include <memory>
+#include <vector>
 
-/// Calculates 2-dimensional discrete Fourier transform
-/** Uses the row-column algorithm. */
-void CalcFFT2D(
+#include "image/buffer_pool.h"
+
+/// Returns 'true' if 'n' is a product of powers of 2, 3, 5 and 7 (i.e. the FFT functions accept it as a dimension).
+bool IsSupportedFFTLength(unsigned n);
+
+/// Returns an even supported FFT length which is >= n and has the lowest estimated transform time.
+/** The result is not greater than the smallest power of two which is >= n. */
+unsigned GetOptimalFFTLength(unsigned n);
+
+/// Returns the number of columns of the half spectrum of a real 2D array with `cols` columns.
+inline unsigned GetHalfSpectrumWidth(unsigned cols) { return cols / 2 + 1; }
+
+/// Calculates 2-dimensional discrete Fourier transform of real input
+/** Uses the row-column algorithm; pairs of rows are transformed together as single complex rows.
+    Only the non-redundant half of the transform (columns 0 to cols/2) is stored, the remaining elements
+    follow from Hermitian symmetry: F[y][x] = conj(F[(rows - y) % rows][cols - x]). */
+void CalcFFT2DReal(
     const float input[], ///< Input array containing rows*cols elements
-    unsigned rows, ///< Number of rows, has to be a power of two
-    unsigned cols, ///< Number of columns, has to be a power of two
+    unsigned rows, ///< Number of rows, has to be a supported FFT length
+    unsigned cols, ///< Number of columns, has to be a supported FFT length
     int stride,    ///< Number of bytes per row in 'input'
-    std::complex<float> output[] ///< Output array containing rows*cols elements
+    std::complex<float> output[] ///< Output array containing rows*GetHalfSpectrumWidth(cols) elements
 );
 
-/// Calculates 2-dimensional inverse discrete Fourier transform
-/** Uses the row-column algorithm. */
-void CalcFFTinv2D(
-    const std::complex<float> input[], ///< Input array containing rows*cols elements
-    unsigned rows, ///< Number of rows, has to be a power of two
-    unsigned cols, ///< Number of columns, has to be a power of two
-    std::complex<float> output[] ///< Output array containing rows*cols elements
+/// Calculates 2-dimensional inverse discrete Fourier transform of a half spectrum (see 'CalcFFT2DReal') with real result
+void CalcFFTinv2DReal(
+    std::complex<float> input[], ///< Input array containing rows*GetHalfSpectrumWidth(cols) elements; contents are destroyed
+    unsigned rows, ///< Number of rows, has to be a supported FFT length
+    unsigned cols, ///< Number of columns, has to be a supported FFT length
+    float output[] ///< Output array containing rows*cols elements
 );
 
+class c_Fft1D;
+
+/// Precomputed twiddle factors and work buffers for 2D real FFTs (see 'CalcFFT2DReal') of a fixed size
+/** Reusing a plan for multiple transforms avoids recalculation of twiddle factors and reallocation of work buffers.
+    A plan must not be used by multiple threads concurrently (the transforms themselves are parallelized). */
+class c_FFTPlan2D
+{
+public:
+    c_FFTPlan2D(
+        unsigned rows, ///< Number of rows, has to be a supported FFT length
+        unsigned cols  ///< Number of columns, has to be a supported FFT length
+    );
+
+    ~c_FFTPlan2D();
+
+    c_FFTPlan2D(const c_FFTPlan2D&) = delete;
+    c_FFTPlan2D& operator=(const c_FFTPlan2D&) = delete;
+
+    unsigned GetRows() const { return m_Rows; }
+
+    unsigned GetCols() const { return m_Cols; }
+
+    /// Returns the number of elements of the half spectrum, i.e. rows*GetHalfSpectrumWidth(cols).
+    std::size_t GetSpectrumLength() const;
+
+    /// Calculates the transform of 'input' (containing rows*cols elements, 'stride' bytes per row); see 'CalcFFT2DReal'.
+    void Transform(const float input[], int stride, std::complex<float> output[]);
+
+    /// Calculates the inverse transform of a half spectrum; see 'CalcFFTinv2DReal'.
+    void TransformInverse(std::complex<float> input[], float output[]);
+
+    /// Frees the work buffers (until the next transform).
+    void ReleaseWorkBuffers();
+
+private:
+    /// Makes sure there is a work buffer for each thread; returns the number of threads to use.
+    int PrepareWorkBuffers();
+
+    /// Transforms columns of a half spectrum in place (not normalized).
+    template<bool Inverse>
+    void TransformColumns(std::complex<float> data[]);
+
+    unsigned m_Rows;
+    unsigned m_Cols;
+    std::unique_ptr<c_Fft1D> m_RowFFT; ///< Transform of length 'm_Cols'.
+    std::unique_ptr<c_Fft1D> m_ColumnFFT; ///< Transform of length 'm_Rows'.
+    std::vector<c_AlignedArray<std::complex<float>>> m_WorkBuffers; ///< One per thread.
+};
+
 /// Calculates cross-power spectrum of two 2D discrete Fourier transforms
 void CalcCrossPowerSpectrum2D(
     const std::complex<float> F1[], ///< First discrete Fourier transform (N elements)
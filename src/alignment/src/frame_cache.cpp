@@ -0,0 +1,258 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Decoded input frame cache implementation.
+*/
+
+#include "common/common.h"
+#include "common/imppg_assert.h"
+#include "frame_cache.h"
+#include "image/mapped_file.h"
+#include "logging/logging.h"
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <wx/intl.h>
+#include <wx/utils.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+/// Returns a directory path unique to this process and cache instance.
+fs::path CreateSpillDirPath()
+{
+    static std::atomic<unsigned> counter{0};
+
+    std::error_code ec;
+    fs::path tempDir = fs::temp_directory_path(ec);
+    if (ec) { tempDir = fs::current_path(ec); }
+
+    return tempDir / ("imppg-frames-" + std::to_string(wxGetProcessId()) + "-" + std::to_string(counter++));
+}
+
+std::size_t GetPackedRowSize(unsigned width, PixelFormat pixFmt)
+{
+    return std::size_t{width} * BytesPerPixel[static_cast<std::size_t>(pixFmt)];
+}
+
+}
+
+c_DecodedFrameCache::c_DecodedFrameCache(
+    AlignmentInputs inputs,
+    bool normalizeFitsValues,
+    std::size_t memoryBudget,
+    std::mutex& fitsIoMutex
+)
+: m_Inputs(std::move(inputs)),
+  m_NormalizeFitsValues(normalizeFitsValues),
+  m_MemoryBudget(memoryBudget),
+  m_FitsIoMutex(fitsIoMutex),
+  m_SpillDir(CreateSpillDirPath())
+{
+    m_Frames.resize(GetNumFrames());
+}
+
+c_DecodedFrameCache::~c_DecodedFrameCache()
+{
+    std::error_code ec;
+    fs::remove_all(m_SpillDir, ec);
+}
+
+std::size_t c_DecodedFrameCache::GetNumFrames() const
+{
+    return std::visit(Overload{
+        [](const wxArrayString& fnames) { return fnames.Count(); },
+        [](const InputImageList& images) { return images.size(); }
+    }, m_Inputs);
+}
+
+ImageAccessor c_DecodedFrameCache::Get(std::size_t index, std::string* errorMsg)
+{
+    // clamped the same way as by `LoadImage` without normalization
+    return GetLimited(index, false, errorMsg);
+}
+
+ImageAccessor c_DecodedFrameCache::Get(std::size_t index, PixelFormat pixFmt, std::string* errorMsg)
+{
+    IMPPG_ASSERT(pixFmt == PixelFormat::PIX_MONO8 || pixFmt == PixelFormat::PIX_MONO32F);
+
+    ImageAccessor frame = GetLimited(index, m_NormalizeFitsValues, errorMsg);
+    if (frame.Empty() || frame.Get()->GetPixelFormat() == pixFmt)
+    {
+        return frame;
+    }
+    else
+    {
+        return ImageAccessor{frame.Get()->ConvertPixelFormat(pixFmt)};
+    }
+}
+
+ImageAccessor c_DecodedFrameCache::GetLimited(std::size_t index, bool normalizeFitsValues, std::string* errorMsg)
+{
+    ImageAccessor frame = GetStored(index, errorMsg);
+
+    const auto* fnames = std::get_if<wxArrayString>(&m_Inputs);
+    if (frame.Empty() || !fnames || !IsFitsFile((*fnames)[index]) || frame.Get()->GetPixelFormat() != PixelFormat::PIX_MONO32F)
+    {
+        return frame;
+    }
+
+    // shares the pixel buffer until modified
+    c_Image limited{*frame.Get()};
+    LimitFitsValues(limited, normalizeFitsValues);
+    return ImageAccessor{std::move(limited)};
+}
+
+ImageAccessor c_DecodedFrameCache::GetStored(std::size_t index, std::string* errorMsg)
+{
+    const auto* fnames = std::get_if<wxArrayString>(&m_Inputs);
+    if (!fnames)
+    {
+        return ImageAccessor{std::get<InputImageList>(m_Inputs).at(index).get()};
+    }
+    IMPPG_ASSERT(index < fnames->Count());
+
+    std::optional<SpilledFrame> spilled;
+    {
+        std::lock_guard lock(m_Mutex);
+        const Frame& frame = m_Frames[index];
+        if (frame.image.has_value())
+        {
+            // shares the pixel buffer
+            return ImageAccessor{c_Image{*frame.image}};
+        }
+        spilled = frame.spilled;
+    }
+
+    if (spilled.has_value())
+    {
+        if (auto image = ReadSpillFile(index, *spilled))
+        {
+            return ImageAccessor{std::move(*image)};
+        }
+        Log::Print(wxString::Format("Failed to read cached frame %s, decoding it again.\n", (*fnames)[index]));
+    }
+
+    std::optional<c_Image> loadResult;
+#if USE_CFITSIO
+    if (IsFitsFile((*fnames)[index]))
+    {
+        std::lock_guard fitsLock(m_FitsIoMutex);
+        loadResult = LoadRawFitsImage(ToFsPath((*fnames)[index]));
+    }
+    else
+#endif
+    {
+        loadResult = LoadImage(ToFsPath((*fnames)[index]), std::nullopt, errorMsg);
+    }
+
+    if (!loadResult.has_value())
+    {
+        if (errorMsg && errorMsg->empty())
+        {
+            *errorMsg = wxString::Format(_("Could not read %s."), (*fnames)[index]);
+        }
+        return ImageAccessor{};
+    }
+    Log::Print(wxString::Format("Loaded %s.\n", (*fnames)[index]));
+    c_Image image = std::move(*loadResult);
+
+    const std::size_t numBytes = GetPackedRowSize(image.GetWidth(), image.GetPixelFormat()) * image.GetHeight();
+    {
+        std::lock_guard lock(m_Mutex);
+        Frame& frame = m_Frames[index];
+        if (frame.image.has_value() || frame.spilled.has_value())
+        {
+            // already stored by a concurrent call
+            return ImageAccessor{std::move(image)};
+        }
+        else if (m_BytesInMemory + numBytes <= m_MemoryBudget)
+        {
+            frame.image = image;
+            m_BytesInMemory += numBytes;
+            return ImageAccessor{std::move(image)};
+        }
+    }
+
+    if (WriteSpillFile(index, image))
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Frames[index].spilled = SpilledFrame{image.GetWidth(), image.GetHeight(), image.GetPixelFormat()};
+    }
+
+    return ImageAccessor{std::move(image)};
+}
+
+fs::path c_DecodedFrameCache::GetSpillFilePath(std::size_t index) const
+{
+    return m_SpillDir / (std::to_string(index) + ".raw");
+}
+
+bool c_DecodedFrameCache::WriteSpillFile(std::size_t index, const c_Image& image)
+{
+    std::error_code ec;
+    fs::create_directories(m_SpillDir, ec);
+    if (!fs::is_directory(m_SpillDir, ec)) { return false; }
+
+    // The same frame may be written concurrently by two threads (after a concurrent decoding), so write
+    // to a unique temporary file first; renaming it (atomically) ensures the spill file is never torn.
+    const fs::path path = GetSpillFilePath(index);
+    const fs::path tempPath = path.string() + "." + std::to_string(m_TempFileCounter++) + ".tmp";
+    const std::size_t rowSize = GetPackedRowSize(image.GetWidth(), image.GetPixelFormat());
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    for (unsigned y = 0; y < image.GetHeight() && file; ++y)
+    {
+        file.write(static_cast<const char*>(image.GetRow(y)), static_cast<std::streamsize>(rowSize));
+    }
+    file.close();
+    if (!file.fail())
+    {
+        fs::rename(tempPath, path, ec);
+        if (!ec) { return true; }
+    }
+
+    Log::Print(wxString::Format("Failed to write cached frame to %s.\n", path.string()));
+    fs::remove(tempPath, ec);
+    return false;
+}
+
+std::optional<c_Image> c_DecodedFrameCache::ReadSpillFile(std::size_t index, const SpilledFrame& spilled) const
+{
+    const auto mapping = c_MappedFile::Open(GetSpillFilePath(index));
+    const std::size_t rowSize = GetPackedRowSize(spilled.width, spilled.pixFmt);
+    if (!mapping.has_value() || mapping->GetSize() != rowSize * spilled.height)
+    {
+        return std::nullopt;
+    }
+
+    c_Image image(spilled.width, spilled.height, spilled.pixFmt);
+    const std::uint8_t* data = mapping->GetData();
+    #pragma omp parallel for
+    for (int y = 0; y < static_cast<int>(spilled.height); ++y)
+    {
+        std::memcpy(image.GetRow(y), data + static_cast<std::size_t>(y) * rowSize, rowSize);
+    }
+
+    return image;
+}
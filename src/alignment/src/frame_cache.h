@@ -0,0 +1,120 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Decoded input frame cache header.
+*/
+
+#ifndef IMPPG_ALIGNMENT_FRAME_CACHE_HEADER
+#define IMPPG_ALIGNMENT_FRAME_CACHE_HEADER
+
+#include "align_common.h"
+#include "alignment/align_proc.h"
+#include "image/image.h"
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+/// Provides the input images to all alignment passes, so that each input file is decoded only once.
+/** Frames are kept in their native pixel format (as decoded by `LoadImage`); floating-point values of FITS frames
+    are kept as read and limited (see `LimitFitsValues`) on each access. Once the frames kept in memory
+    reach the memory budget, each subsequently decoded frame is written (without row padding) to a temporary
+    file, which is memory-mapped when the frame is needed again. If a frame cannot be written, it is simply
+    decoded again on next access.
+
+    Images provided via `InputImageList` are not copied. All methods are thread-safe. */
+class c_DecodedFrameCache
+{
+public:
+    c_DecodedFrameCache(
+        AlignmentInputs inputs,
+        bool normalizeFitsValues, ///< Applies to frames converted to a specified pixel format
+        std::size_t memoryBudget, ///< Max total size (in bytes) of decoded frames kept in memory
+        std::mutex& fitsIoMutex ///< Serializes FITS loading (CFITSIO is not necessarily built as reentrant)
+    );
+
+    c_DecodedFrameCache(const c_DecodedFrameCache&) = delete;
+    c_DecodedFrameCache& operator=(const c_DecodedFrameCache&) = delete;
+
+    /// Removes the temporary files.
+    ~c_DecodedFrameCache();
+
+    std::size_t GetNumFrames() const;
+
+    /// Returns the specified frame in its native pixel format; returns an empty accessor on error.
+    /** Floating-point values of a FITS frame are clamped to [0; 1] regardless of `normalizeFitsValues`. */
+    ImageAccessor Get(std::size_t index, std::string* errorMsg = nullptr);
+
+    /// Returns the specified frame converted to `pixFmt` (PIX_MONO8 or PIX_MONO32F); returns an empty accessor on error.
+    /** Floating-point values of a FITS frame are normalized if so specified by `normalizeFitsValues`. */
+    ImageAccessor Get(std::size_t index, PixelFormat pixFmt, std::string* errorMsg = nullptr);
+
+private:
+    struct SpilledFrame
+    {
+        unsigned width;
+        unsigned height;
+        PixelFormat pixFmt;
+    };
+
+    struct Frame
+    {
+        std::optional<c_Image> image; ///< Set if the frame is kept in memory.
+        std::optional<SpilledFrame> spilled; ///< Set if the frame has been written to a temporary file.
+    };
+
+    /// Returns the frame as decoded (with unlimited FITS values); keeps it in memory or in a temporary file.
+    ImageAccessor GetStored(std::size_t index, std::string* errorMsg);
+
+    ImageAccessor GetLimited(std::size_t index, bool normalizeFitsValues, std::string* errorMsg);
+
+    std::filesystem::path GetSpillFilePath(std::size_t index) const;
+
+    /// Returns 'true' on success.
+    bool WriteSpillFile(std::size_t index, const c_Image& image);
+
+    std::optional<c_Image> ReadSpillFile(std::size_t index, const SpilledFrame& spilled) const;
+
+    const AlignmentInputs m_Inputs;
+
+    const bool m_NormalizeFitsValues;
+
+    const std::size_t m_MemoryBudget;
+
+    std::mutex& m_FitsIoMutex;
+
+    const std::filesystem::path m_SpillDir; ///< Created on first spill.
+
+    std::atomic<unsigned> m_TempFileCounter{0};
+
+    // Guarded by `m_Mutex` ------------------------------------------
+
+    std::mutex m_Mutex;
+    std::vector<Frame> m_Frames;
+    std::size_t m_BytesInMemory{0};
+
+    // ---------------------------------------------------------------
+};
+
+#endif // IMPPG_ALIGNMENT_FRAME_CACHE_HEADER
@@ -0,0 +1,86 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Disc detection unit tests.
+*/
+
+#include "align_disc.h"
+
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <random>
+
+namespace
+{
+
+/// Returns a noisy image of a bright disc on a dark background.
+c_Image CreateDiscImage(unsigned width, unsigned height, int centerX, int centerY, int radius)
+{
+    std::mt19937 generator(width * 1000 + height);
+    std::uniform_int_distribution<int> noise(-10, 10);
+
+    c_Image image(width, height, PixelFormat::PIX_MONO8);
+    for (unsigned y = 0; y < height; ++y)
+    {
+        auto* row = image.GetRowAs<std::uint8_t>(y);
+        for (unsigned x = 0; x < width; ++x)
+        {
+            const int dx = static_cast<int>(x) - centerX;
+            const int dy = static_cast<int>(y) - centerY;
+            const int value = (dx * dx + dy * dy <= radius * radius) ? 200 : 30;
+            row[x] = static_cast<std::uint8_t>(value + noise(generator));
+        }
+    }
+    return image;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(CentroidMatchesDirectSummation)
+{
+    // wider than a single summation segment
+    const c_Image image = CreateDiscImage(4100, 301, 2500, 140, 120);
+
+    std::uint64_t sumX = 0, sumY = 0, sumVals = 0;
+    for (unsigned y = 0; y < image.GetHeight(); ++y)
+        for (unsigned x = 0; x < image.GetWidth(); ++x)
+        {
+            const std::uint8_t value = image.GetRowAs<std::uint8_t>(y)[x];
+            sumVals += value;
+            sumX += static_cast<std::uint64_t>(x) * value;
+            sumY += static_cast<std::uint64_t>(y) * value;
+        }
+
+    const Point_t centroid = CalcCentroid(image);
+    BOOST_CHECK_EQUAL(static_cast<std::uint64_t>(centroid.x), sumX / sumVals);
+    BOOST_CHECK_EQUAL(static_cast<std::uint64_t>(centroid.y), sumY / sumVals);
+}
+
+BOOST_AUTO_TEST_CASE(ThresholdSeparatesDiscFromBackground)
+{
+    const c_Image image = CreateDiscImage(403, 397, 190, 210, 140);
+
+    std::uint8_t avgDisc{0}, avgBkgrnd{0};
+    const auto threshold = FindDiscBackgroundThreshold(image, &avgDisc, &avgBkgrnd);
+    BOOST_REQUIRE(threshold.has_value());
+    BOOST_CHECK(*threshold > 40 && *threshold <= 190);
+    BOOST_CHECK(avgDisc >= 198 && avgDisc <= 202);
+    BOOST_CHECK(avgBkgrnd >= 28 && avgBkgrnd <= 32);
+}
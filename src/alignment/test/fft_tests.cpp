@@ -0,0 +1,264 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Fast Fourier Transform unit tests.
+*/
+
+#include "fft.h"
+
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <complex>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+/// Straightforward O(N^2) 2D discrete Fourier transform used as reference; returns rows*cols elements.
+std::vector<std::complex<double>> CalcReferenceDFT2D(const std::vector<float>& input, unsigned rows, unsigned cols)
+{
+    const double PI = 3.14159265358979323846;
+    std::vector<std::complex<double>> result(rows * cols);
+    for (unsigned v = 0; v < rows; ++v)
+        for (unsigned u = 0; u < cols; ++u)
+        {
+            std::complex<double> sum = 0.0;
+            for (unsigned y = 0; y < rows; ++y)
+                for (unsigned x = 0; x < cols; ++x)
+                {
+                    const double angle = -2.0 * PI * (static_cast<double>(u * x % cols) / cols + static_cast<double>(v * y % rows) / rows);
+                    sum += static_cast<double>(input[y * cols + x]) * std::polar(1.0, angle);
+                }
+            result[v * cols + u] = sum;
+        }
+
+    return result;
+}
+
+std::vector<float> CreateRandomArray(unsigned rows, unsigned cols)
+{
+    std::mt19937 generator(rows * 1000 + cols);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    std::vector<float> result(rows * cols);
+    for (auto& value: result)
+        value = distribution(generator);
+
+    return result;
+}
+
+const unsigned TEST_SIZES[][2] = {
+    {1, 1}, {1, 2}, {2, 1}, {2, 2}, {1, 16}, {16, 1}, {4, 8}, {8, 4}, {2, 64}, {32, 16}, {16, 32}, {64, 128},
+    {3, 5}, {5, 3}, {7, 6}, {6, 7}, {1, 21}, {9, 10}, {12, 18}, {30, 14}, {49, 24}, {25, 60}, {24, 105}
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(RealFFTMatchesReferenceDFT)
+{
+    for (const auto& size: TEST_SIZES)
+    {
+        const unsigned rows = size[0];
+        const unsigned cols = size[1];
+        const unsigned halfCols = GetHalfSpectrumWidth(cols);
+
+        const auto input = CreateRandomArray(rows, cols);
+        std::vector<std::complex<float>> output(rows * halfCols);
+        CalcFFT2DReal(input.data(), rows, cols, cols * sizeof(float), output.data());
+
+        const auto expected = CalcReferenceDFT2D(input, rows, cols);
+        // Magnitude of the DC term; the error of single-precision FFT grows roughly with log(N)
+        const double tolerance = 1.0e-6 * std::abs(expected[0]) * std::log2(2.0 * rows * cols);
+        for (unsigned v = 0; v < rows; ++v)
+            for (unsigned u = 0; u < halfCols; ++u)
+            {
+                const std::complex<double> value(output[v * halfCols + u]);
+                BOOST_TEST_CONTEXT(rows << "x" << cols << ", element (" << u << ", " << v << ")")
+                {
+                    BOOST_CHECK_SMALL(std::abs(value - expected[v * cols + u]), tolerance);
+                }
+            }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RealFFTHonorsInputStride)
+{
+    const unsigned rows = 8;
+    const unsigned cols = 16;
+    const unsigned paddedCols = 21;
+    const unsigned halfCols = GetHalfSpectrumWidth(cols);
+
+    const auto input = CreateRandomArray(rows, cols);
+    std::vector<float> paddedInput(rows * paddedCols, -1.0f);
+    for (unsigned y = 0; y < rows; ++y)
+        for (unsigned x = 0; x < cols; ++x)
+            paddedInput[y * paddedCols + x] = input[y * cols + x];
+
+    std::vector<std::complex<float>> output(rows * halfCols);
+    std::vector<std::complex<float>> outputPadded(rows * halfCols);
+    CalcFFT2DReal(input.data(), rows, cols, cols * sizeof(float), output.data());
+    CalcFFT2DReal(paddedInput.data(), rows, cols, paddedCols * sizeof(float), outputPadded.data());
+
+    for (unsigned i = 0; i < rows * halfCols; ++i)
+        BOOST_CHECK(output[i] == outputPadded[i]);
+}
+
+BOOST_AUTO_TEST_CASE(InverseRealFFTRestoresInput)
+{
+    for (const auto& size: TEST_SIZES)
+    {
+        const unsigned rows = size[0];
+        const unsigned cols = size[1];
+
+        const auto input = CreateRandomArray(rows, cols);
+        std::vector<std::complex<float>> spectrum(rows * GetHalfSpectrumWidth(cols));
+        CalcFFT2DReal(input.data(), rows, cols, cols * sizeof(float), spectrum.data());
+
+        std::vector<float> output(rows * cols);
+        CalcFFTinv2DReal(spectrum.data(), rows, cols, output.data());
+
+        for (unsigned i = 0; i < rows * cols; ++i)
+        {
+            BOOST_TEST_CONTEXT(rows << "x" << cols << ", element " << i)
+            {
+                BOOST_CHECK_SMALL(output[i] - input[i], 1.0e-5f);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ReusedPlanGivesSameResults)
+{
+    const unsigned rows = 30;
+    const unsigned cols = 48;
+    c_FFTPlan2D plan(rows, cols);
+    BOOST_REQUIRE_EQUAL(plan.GetSpectrumLength(), rows * GetHalfSpectrumWidth(cols));
+
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        const auto input = CreateRandomArray(rows, cols + i);
+        const int stride = (cols + i) * sizeof(float);
+
+        std::vector<std::complex<float>> expected(plan.GetSpectrumLength());
+        CalcFFT2DReal(input.data(), rows, cols, stride, expected.data());
+        std::vector<std::complex<float>> spectrum(plan.GetSpectrumLength());
+        plan.Transform(input.data(), stride, spectrum.data());
+        BOOST_CHECK(spectrum == expected);
+
+        std::vector<float> expectedInverse(rows * cols);
+        CalcFFTinv2DReal(expected.data(), rows, cols, expectedInverse.data());
+        std::vector<float> inverse(rows * cols);
+        plan.TransformInverse(spectrum.data(), inverse.data());
+        BOOST_CHECK(inverse == expectedInverse);
+
+        if (i == 1)
+            plan.ReleaseWorkBuffers();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CrossCorrelationPeakIndicatesTranslation)
+{
+    const unsigned rows = 64;
+    const unsigned cols = 128;
+    const unsigned halfCols = GetHalfSpectrumWidth(cols);
+    const int dx = 13;
+    const int dy = -7;
+
+    const auto image1 = CreateRandomArray(rows, cols);
+    std::vector<float> image2(rows * cols);
+    for (unsigned y = 0; y < rows; ++y)
+        for (unsigned x = 0; x < cols; ++x)
+            image2[((y + dy + rows) % rows) * cols + (x + dx + cols) % cols] = image1[y * cols + x];
+
+    std::vector<std::complex<float>> fft1(rows * halfCols);
+    std::vector<std::complex<float>> fft2(rows * halfCols);
+    CalcFFT2DReal(image1.data(), rows, cols, cols * sizeof(float), fft1.data());
+    CalcFFT2DReal(image2.data(), rows, cols, cols * sizeof(float), fft2.data());
+
+    std::vector<std::complex<float>> cps(rows * halfCols);
+    CalcCrossPowerSpectrum2D(fft1.data(), fft2.data(), cps.data(), rows * halfCols);
+    std::vector<float> cc(rows * cols);
+    CalcFFTinv2DReal(cps.data(), rows, cols, cc.data());
+
+    unsigned maxIdx = 0;
+    for (unsigned i = 1; i < rows * cols; ++i)
+        if (cc[i] > cc[maxIdx])
+            maxIdx = i;
+
+    BOOST_CHECK_EQUAL(maxIdx % cols, static_cast<unsigned>(dx + cols) % cols);
+    BOOST_CHECK_EQUAL(maxIdx / cols, static_cast<unsigned>(dy + rows) % rows);
+    BOOST_CHECK_CLOSE(cc[maxIdx], 1.0f, 0.1f);
+}
+
+BOOST_AUTO_TEST_CASE(CrossPowerSpectrumIsNormalizedProduct)
+{
+    // more elements than calculated by a single parallel loop iteration, and not a multiple of it
+    const unsigned N = 10007;
+    std::mt19937 gen(3);
+    std::normal_distribution<float> dist;
+    std::vector<std::complex<float>> F1(N), F2(N);
+    for (unsigned i = 0; i < N; ++i)
+    {
+        F1[i] = { dist(gen), dist(gen) };
+        F2[i] = { dist(gen), dist(gen) };
+    }
+    F1[5] = 0.0f; // a zero product must not be normalized
+
+    std::vector<std::complex<float>> cps(N);
+    CalcCrossPowerSpectrum2D(F1.data(), F2.data(), cps.data(), N);
+
+    BOOST_CHECK_EQUAL(cps[5], std::complex<float>(0.0f, 0.0f));
+    for (unsigned i = 0; i < N; ++i)
+    {
+        if (i == 5) { continue; }
+        const std::complex<float> expected = std::conj(F1[i]) * F2[i] / std::abs(std::conj(F1[i]) * F2[i]);
+        BOOST_REQUIRE_SMALL(std::abs(cps[i] - expected), 1.0e-5f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(OptimalFFTLengthIsSupportedAndNotGreaterThanPowerOf2)
+{
+    BOOST_CHECK(IsSupportedFFTLength(1));
+    BOOST_CHECK(IsSupportedFFTLength(2 * 3 * 5 * 7 * 64));
+    BOOST_CHECK(!IsSupportedFFTLength(0));
+    BOOST_CHECK(!IsSupportedFFTLength(11));
+    BOOST_CHECK(!IsSupportedFFTLength(2 * 13));
+
+    BOOST_CHECK_EQUAL(GetOptimalFFTLength(0), 2U);
+    BOOST_CHECK_EQUAL(GetOptimalFFTLength(1), 2U);
+    BOOST_CHECK_EQUAL(GetOptimalFFTLength(21), 24U);
+    BOOST_CHECK_EQUAL(GetOptimalFFTLength(2048), 2048U);
+    BOOST_CHECK_EQUAL(GetOptimalFFTLength(2049), 2304U);
+    BOOST_CHECK_EQUAL(GetOptimalFFTLength(4097), 4608U);
+
+    unsigned powerOf2 = 2;
+    for (unsigned n = 1; n < 3000; ++n)
+    {
+        if (n > powerOf2)
+            powerOf2 *= 2;
+
+        const unsigned length = GetOptimalFFTLength(n);
+        BOOST_TEST_CONTEXT("n = " << n)
+        {
+            BOOST_CHECK(length >= n && length <= powerOf2);
+            BOOST_CHECK(length % 2 == 0 && IsSupportedFFTLength(length));
+        }
+    }
+}
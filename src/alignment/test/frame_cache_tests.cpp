@@ -0,0 +1,123 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Decoded frame cache unit tests.
+*/
+
+#include "frame_cache.h"
+#include "test_images.h"
+
+#include <atomic>
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <wx/arrstr.h>
+
+BOOST_AUTO_TEST_CASE(FramesExceedingMemoryBudgetAreReadBackUnchanged)
+{
+    const auto root = std::filesystem::temp_directory_path() / "imppg_tests" / "frame_cache";
+    std::filesystem::create_directories(root);
+
+    constexpr unsigned WIDTH = 53;
+    constexpr unsigned HEIGHT = 37;
+    constexpr unsigned NUM_FRAMES = 4;
+
+    std::vector<c_Image> images;
+    wxArrayString fnames;
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        images.push_back(CreateTestImage(WIDTH, HEIGHT, PixelFormat::PIX_MONO16, i));
+        const auto path = root / ("frame" + std::to_string(i) + ".tif");
+        BOOST_REQUIRE(images.back().SaveToFile(path, OutputFormat::TIFF_16));
+        fnames.Add(path.native());
+    }
+
+    std::mutex fitsIoMutex;
+    // only the first frame fits in memory, the remaining ones are spilled
+    c_DecodedFrameCache cache(fnames, false, WIDTH * HEIGHT * sizeof(std::uint16_t), fitsIoMutex);
+    BOOST_REQUIRE_EQUAL(NUM_FRAMES, cache.GetNumFrames());
+
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        const ImageAccessor frame = cache.Get(i);
+        BOOST_REQUIRE(!frame.Empty());
+        BOOST_CHECK(AreEqual(images[i], *frame.Get()));
+    }
+
+    // subsequent accesses must not need the input files
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        std::filesystem::remove(root / ("frame" + std::to_string(i) + ".tif"));
+    }
+
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        const ImageAccessor frame = cache.Get(i);
+        BOOST_REQUIRE(!frame.Empty());
+        BOOST_CHECK(AreEqual(images[i], *frame.Get()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentlySpilledFramesAreReadBackUnchanged)
+{
+    const auto root = std::filesystem::temp_directory_path() / "imppg_tests" / "frame_cache_concurrent";
+    std::filesystem::create_directories(root);
+
+    constexpr unsigned WIDTH = 211;
+    constexpr unsigned HEIGHT = 173;
+    constexpr unsigned NUM_FRAMES = 3;
+    constexpr unsigned NUM_THREADS = 4;
+
+    std::vector<c_Image> images;
+    wxArrayString fnames;
+    for (unsigned i = 0; i < NUM_FRAMES; ++i)
+    {
+        images.push_back(CreateTestImage(WIDTH, HEIGHT, PixelFormat::PIX_MONO16, i));
+        const auto path = root / ("frame" + std::to_string(i) + ".tif");
+        BOOST_REQUIRE(images.back().SaveToFile(path, OutputFormat::TIFF_16));
+        fnames.Add(path.native());
+    }
+
+    std::mutex fitsIoMutex;
+    // no frame fits in memory; concurrent first accesses decode and spill the same frame
+    c_DecodedFrameCache cache(fnames, false, 0, fitsIoMutex);
+
+    std::atomic<unsigned> numMismatches{0};
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < NUM_THREADS; ++t)
+    {
+        threads.emplace_back([&]() {
+            for (unsigned pass = 0; pass < 2; ++pass)
+            {
+                for (unsigned i = 0; i < NUM_FRAMES; ++i)
+                {
+                    const ImageAccessor frame = cache.Get(i);
+                    if (frame.Empty() || !AreEqual(images[i], *frame.Get())) { ++numMismatches; }
+                }
+            }
+        });
+    }
+    for (auto& thread: threads) { thread.join(); }
+
+    BOOST_CHECK_EQUAL(0, numMismatches.load());
+}
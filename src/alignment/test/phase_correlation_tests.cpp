@@ -0,0 +1,222 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Phase correlation alignment unit tests.
+*/
+
+#include "align_phasecorr.h"
+#include "frame_cache.h"
+
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+/// Max translation (in pixels, along each axis) between test frames.
+constexpr int MAX_DRIFT = 10;
+
+struct TestSequence
+{
+    InputImageList images;
+    std::vector<FloatPoint_t> expectedTranslation; ///< Relative to the first image
+};
+
+/// Creates images of random Gaussian blobs and noise, cut from a larger scene at random offsets.
+TestSequence CreateTestSequence(unsigned width, unsigned height, unsigned numImages, unsigned seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+    const int sceneWidth = static_cast<int>(width) + MAX_DRIFT;
+    const int sceneHeight = static_cast<int>(height) + MAX_DRIFT;
+    std::vector<float> scene(sceneWidth * sceneHeight, 0.0f);
+    const int numBlobs = sceneWidth * sceneHeight / 300;
+    for (int i = 0; i < numBlobs; ++i)
+    {
+        const float cx = uniform(generator) * sceneWidth;
+        const float cy = uniform(generator) * sceneHeight;
+        const float radius = 2.0f + uniform(generator) * 8.0f;
+        const float amplitude = uniform(generator);
+
+        const int x0 = std::max(0, static_cast<int>(cx - 3 * radius));
+        const int x1 = std::min(sceneWidth, static_cast<int>(cx + 3 * radius) + 1);
+        const int y0 = std::max(0, static_cast<int>(cy - 3 * radius));
+        const int y1 = std::min(sceneHeight, static_cast<int>(cy + 3 * radius) + 1);
+        for (int y = y0; y < y1; ++y)
+            for (int x = x0; x < x1; ++x)
+            {
+                const float distSq = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+                scene[y * sceneWidth + x] += amplitude * std::exp(-distSq / (radius * radius));
+            }
+    }
+
+    TestSequence result;
+    std::uniform_int_distribution<int> offset(0, MAX_DRIFT);
+    std::normal_distribution<float> noise(0.0f, 0.01f);
+    int firstX = 0, firstY = 0;
+    for (unsigned i = 0; i < numImages; ++i)
+    {
+        const int ox = offset(generator);
+        const int oy = offset(generator);
+        if (i == 0) { firstX = ox; firstY = oy; }
+        result.expectedTranslation.push_back(FloatPoint_t(firstX - ox, firstY - oy));
+
+        auto image = std::make_shared<c_Image>(width, height, PixelFormat::PIX_MONO32F);
+        for (unsigned y = 0; y < height; ++y)
+        {
+            float* row = image->GetRowAs<float>(y);
+            for (unsigned x = 0; x < width; ++x)
+            {
+                row[x] = scene[(y + oy) * sceneWidth + x + ox] + noise(generator);
+            }
+        }
+        result.images.push_back(image);
+    }
+
+    return result;
+}
+
+std::vector<FloatPoint_t> Align(
+    const InputImageList& images,
+    const std::optional<Rectangle_t>& roi,
+    bool coarseToFine = false
+)
+{
+    unsigned maxWidth = 0, maxHeight = 0;
+    for (const auto& image: images)
+    {
+        maxWidth = std::max(maxWidth, image->GetWidth());
+        maxHeight = std::max(maxHeight, image->GetHeight());
+    }
+
+    std::mutex fitsIoMutex;
+    c_DecodedFrameCache frames(AlignmentInputs{images}, false, 0, fitsIoMutex);
+    std::vector<FloatPoint_t> translation;
+    Rectangle_t bBox;
+    std::string errorMsg;
+    BOOST_REQUIRE_MESSAGE(DetermineTranslationVectors(
+        GetWorkingBufferSize(maxWidth), GetWorkingBufferSize(maxHeight), frames, translation, bBox, &errorMsg,
+        false, [](int, float, float) {}, [] { return false; }, roi, coarseToFine
+    ), errorMsg);
+    BOOST_REQUIRE_EQUAL(translation.size(), images.size());
+
+    return translation;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(TranslationsAreRecoveredForNonPowerOfTwoSizes)
+{
+    // The window function spans the whole working buffer; if its margin around the image is too large, the image edges
+    // are not tapered enough and their discontinuities produce false correlation peaks, misaligning some of the frames.
+    const unsigned sizes[][2] = { {517, 389}, {1000, 200}, {800, 600}, {1280, 960} };
+    for (const auto& size: sizes)
+    {
+        for (const unsigned seed: { 1U, 2U })
+        {
+            BOOST_TEST_CONTEXT(size[0] << "x" << size[1] << ", seed " << seed)
+            {
+                const TestSequence sequence = CreateTestSequence(size[0], size[1], 5, seed);
+                const std::vector<FloatPoint_t> translation = Align(sequence.images, std::nullopt);
+                for (std::size_t i = 0; i < translation.size(); ++i)
+                {
+                    BOOST_CHECK_EQUAL(translation[i].x, sequence.expectedTranslation[i].x);
+                    BOOST_CHECK_EQUAL(translation[i].y, sequence.expectedTranslation[i].y);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RoiOffsetDeltaAccountsForAreaAndImagePositions)
+{
+    // identical areas and images
+    BOOST_CHECK_EQUAL(GetRoiOffsetDelta(640, 320, 200, 200, 50, 50, 500, 500), 0);
+    // area moved within the current image
+    BOOST_CHECK_EQUAL(GetRoiOffsetDelta(640, 320, 200, 200, 50, 57, 500, 500), 7);
+    // smaller area in the current image (centered 5 pixels further in the working area)
+    BOOST_CHECK_EQUAL(GetRoiOffsetDelta(640, 320, 200, 190, 50, 50, 500, 500), -5);
+    // smaller current image (centered 10 pixels further in the whole images' working area)
+    BOOST_CHECK_EQUAL(GetRoiOffsetDelta(640, 320, 200, 200, 50, 50, 500, 480), 10);
+    // all of the above
+    BOOST_CHECK_EQUAL(GetRoiOffsetDelta(640, 320, 200, 190, 50, 57, 500, 480), 7 - 5 + 10);
+}
+
+BOOST_AUTO_TEST_CASE(RoiTranslationsMatchWholeImageTranslations)
+{
+    constexpr unsigned WIDTH = 517;
+    constexpr unsigned HEIGHT = 389;
+    TestSequence sequence = CreateTestSequence(WIDTH, HEIGHT, 5, 1);
+
+    // crop some images, so that the region of interest does not fit in them at its first image's position
+    for (const std::size_t i: { 2, 3 })
+    {
+        const unsigned croppedWidth = WIDTH - 60 - i;
+        const unsigned croppedHeight = HEIGHT - 50 + i;
+        auto cropped = std::make_shared<c_Image>(croppedWidth, croppedHeight, PixelFormat::PIX_MONO32F);
+        c_Image::Copy(*sequence.images[i], *cropped, 0, 0, croppedWidth, croppedHeight, 0, 0);
+        sequence.images[i] = cropped;
+    }
+
+    const std::vector<FloatPoint_t> expected = Align(sequence.images, std::nullopt);
+    for (const std::size_t i: { 0, 1, 4 })
+    {
+        BOOST_REQUIRE(expected[i] == sequence.expectedTranslation[i]);
+    }
+
+    const std::vector<FloatPoint_t> translation = Align(sequence.images, Rectangle_t(300, 220, 200, 150));
+    for (std::size_t i = 0; i < translation.size(); ++i)
+    {
+        BOOST_TEST_CONTEXT("image " << i)
+        {
+            BOOST_CHECK_EQUAL(translation[i].x, expected[i].x);
+            BOOST_CHECK_EQUAL(translation[i].y, expected[i].y);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CoarseToFineTranslationsMatchFullResolutionTranslations)
+{
+    // large enough for the coarse correlation of images downsampled 2x
+    const unsigned sizes[][2] = { {1300, 1100}, {1700, 1150} };
+    for (const auto& size: sizes)
+    {
+        BOOST_TEST_CONTEXT(size[0] << "x" << size[1])
+        {
+            const TestSequence sequence = CreateTestSequence(size[0], size[1], 5, 3);
+            const std::vector<FloatPoint_t> expected = Align(sequence.images, std::nullopt, false);
+            const std::vector<FloatPoint_t> translation = Align(sequence.images, std::nullopt, true);
+            for (std::size_t i = 0; i < translation.size(); ++i)
+            {
+                BOOST_CHECK(expected[i] == sequence.expectedTranslation[i]);
+                BOOST_CHECK_EQUAL(translation[i].x, expected[i].x);
+                BOOST_CHECK_EQUAL(translation[i].y, expected[i].y);
+            }
+        }
+    }
+}
@@ -124,6 +124,28 @@ namespace Keys
     const char* OpenGLInitIncomplete = OpenGLGroup"/OpenGLInitIncomplete";
 
     const char* NormalizeFITSValues = "/NormalizeFITSValues";
+
+#define BatchGroup "/Batch"
+
+    const char* BatchConcurrentFiles = BatchGroup"/ConcurrentFiles";
+    const char* BatchMaxThreads = BatchGroup"/MaxThreads";
+    const char* BatchMemoryBudgetMiB = BatchGroup"/MemoryBudgetMiB";
+
+#define AlignmentGroup "/Alignment"
+
+    const char* AlignMaxOutputThreads = AlignmentGroup"/MaxOutputThreads";
+    const char* AlignFrameCacheMiB = AlignmentGroup"/FrameCacheMiB";
+    const char* AlignCoarseToFine = AlignmentGroup"/CoarseToFine";
+
+#define TiffOutputGroup "/TiffOutput"
+
+    const char* TiffRowsPerStrip = TiffOutputGroup"/RowsPerStrip";
+    const char* TiffUsePredictor = TiffOutputGroup"/UsePredictor";
+
+#define BufferPoolGroup "/BufferPool"
+
+    const char* BufferPoolMaxCachedMiB = BufferPoolGroup"/MaxCachedMiB";
+    const char* BufferPoolUseHugePages = BufferPoolGroup"/UseHugePages";
 }
 
 void Initialize(wxFileConfig* _appConfig)
@@ -321,6 +343,20 @@ void EmptyMruList()
 
 PROPERTY_UNSIGNED(LRCmdBatchSizeMpixIters, 1);
 
+PROPERTY_UNSIGNED(BatchConcurrentFiles, 2);
+PROPERTY_UNSIGNED(BatchMaxThreads, 0);
+PROPERTY_UNSIGNED(BatchMemoryBudgetMiB, 2048);
+
+PROPERTY_UNSIGNED(AlignMaxOutputThreads, 0);
+PROPERTY_UNSIGNED(AlignFrameCacheMiB, 1024);
+PROPERTY_BOOL(AlignCoarseToFine, false);
+
+PROPERTY_UNSIGNED(TiffRowsPerStrip, 64);
+PROPERTY_BOOL(TiffUsePredictor, true);
+
+PROPERTY_UNSIGNED(BufferPoolMaxCachedMiB, 1024);
+PROPERTY_BOOL(BufferPoolUseHugePages, true);
+
 c_Property<ScalingMethod> DisplayScalingMethod(
     []()
     {
@@ -109,6 +109,26 @@ namespace Configuration
     /// responsiveness of the L-R controls (i.e. each change of L-R parameters will block the GUI for
     /// a noticeable moment - a time it takes for the OpenGL command batch to complete).
     extern c_Property<unsigned>              LRCmdBatchSizeMpixIters;
+    /// Number of files processed concurrently during batch processing (applies to the CPU back end only).
+    extern c_Property<unsigned>              BatchConcurrentFiles;
+    /// Total number of batch processing threads; 0 means: number of hardware threads.
+    extern c_Property<unsigned>              BatchMaxThreads;
+    /// Max total size of images held by the batch processing pipeline.
+    extern c_Property<unsigned>              BatchMemoryBudgetMiB;
+    /// Max number of aligned images translated and saved concurrently; 0 means: number of hardware threads.
+    extern c_Property<unsigned>              AlignMaxOutputThreads;
+    /// Max total size of decoded input images kept in memory during alignment; the remaining ones are stored in temporary files.
+    extern c_Property<unsigned>              AlignFrameCacheMiB;
+    /// If true, phase correlation alignment of large images uses coarse-to-fine correlation.
+    extern c_Property<bool>                  AlignCoarseToFine;
+    /// Number of rows in each strip of saved TIFF files; 0 means: the whole image is a single strip.
+    extern c_Property<unsigned>              TiffRowsPerStrip;
+    /// If true, compressed TIFF files are saved using the horizontal or floating-point predictor.
+    extern c_Property<bool>                  TiffUsePredictor;
+    /// Max total size of released image and work buffers kept for reuse.
+    extern c_Property<unsigned>              BufferPoolMaxCachedMiB;
+    /// If true, large image and work buffers are backed by transparent huge pages (where supported by the OS).
+    extern c_Property<bool>                  BufferPoolUseHugePages;
     extern c_Property<wxRect>                ScriptDialogPosSize;
     extern c_Property<wxString>              ScriptOpenPath;
 }
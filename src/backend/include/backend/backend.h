@@ -24,11 +24,13 @@ File description:
 #ifndef IMPPG_BACKEND_HEADER
 #define IMPPG_BACKEND_HEADER
 
+#include "backend/processing_plan.h"
 #include "common/proc_settings.h"
 #include "common/scrolled_view.h"
 #include "image/image.h"
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <wx/scrolwin.h>
 
@@ -112,6 +114,14 @@ class IProcessingBackEnd
 public:
     virtual void StartProcessing(c_Image img, ProcessingSettings procSettings) = 0;
 
+    /// Starts processing using a precompiled plan; to be used when processing many images with the same settings.
+    /** The plan must not be used by another back end at the same time. Back ends which do not benefit
+        from a plan process the image using `plan->GetSettings()`. */
+    virtual void StartProcessing(c_Image img, std::shared_ptr<ProcessingPlan> plan)
+    {
+        StartProcessing(std::move(img), plan->GetSettings());
+    }
+
     /// Can only be called after processing completes.
     virtual const c_Image& GetProcessedOutput() = 0;
 
@@ -123,6 +133,10 @@ public:
     /// Shall be called by the main window from "on idle" handler; the back end may call `event.RequestMore()`.
     virtual void OnIdle(wxIdleEvent& event) { (void)event; }
 
+    /// Limits the number of threads used for processing (0 means: no limit); to be used when several
+    /// back end instances process images concurrently.
+    virtual void SetMaxThreadCount(unsigned count) { (void)count; }
+
     virtual void AbortProcessing() = 0;
 
     virtual ~IProcessingBackEnd() = default;
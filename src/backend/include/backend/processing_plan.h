@@ -0,0 +1,104 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Processing plan header.
+*/
+
+#ifndef IMPPG_PROCESSING_PLAN_HEADER
+#define IMPPG_PROCESSING_PLAN_HEADER
+
+#include "common/proc_settings.h"
+#include "common/tcrv.h"
+#include "image/image.h"
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+
+class c_GaussianConvolution;
+
+namespace imppg::backend {
+
+/// Processing setup compiled from `ProcessingSettings`.
+/** Holds the Gaussian convolutions (kernel projections or recursive filter coefficients), adaptive unsharp
+    masking transition curves, the tone curve LUT and scratch buffers. A plan compiled once can be reused
+    for processing many images (e.g., during batch processing or by a script), without repeating the setup
+    work and allocations for each image.
+
+    Not thread-safe: a plan must not be used by more than one processing back end at a time. */
+class ProcessingPlan
+{
+public:
+    /// Number of scratch buffers available via `GetScratchBuffer`.
+    static constexpr std::size_t NUM_SCRATCH_BUFFERS = 6;
+
+    /// Compiles the plan; if image dimensions are specified, also allocates the scratch buffers.
+    explicit ProcessingPlan(const ProcessingSettings& settings, unsigned width = 0, unsigned height = 0);
+
+    ~ProcessingPlan();
+
+    ProcessingPlan(const ProcessingPlan&) = delete;
+    ProcessingPlan& operator=(const ProcessingPlan&) = delete;
+
+    /// Replaces the settings; components depending on changed parameters are recompiled on next use.
+    void Update(const ProcessingSettings& settings);
+
+    const ProcessingSettings& GetSettings() const { return m_Settings; }
+
+    /// Returns the Gaussian convolution for the specified sigma (compiling it if necessary).
+    c_GaussianConvolution& GetGaussian(float sigma);
+
+    /// Returns the adaptive transition curve of the specified unsharp mask (see `GetAdaptiveUnshMaskTransitionCurve`).
+    const std::array<float, 4>& GetUnshMaskTransitionCurve(std::size_t maskIdx) const { return m_TransitionCurves.at(maskIdx); }
+
+    /// Returns the tone curve with its LUT calculated.
+    const c_ToneCurve& GetToneCurve();
+
+    /// Returns the specified scratch buffer, having at least `numElements` elements; contents are unspecified.
+    /** The buffer is aligned to `IMAGE_ROW_ALIGNMENT`; callers lay out rows using `GetPaddedRowStride`. */
+    float* GetScratchBuffer(std::size_t idx, std::size_t numElements);
+
+private:
+    /// Returns sigmas of all Gaussian convolutions required by `m_Settings`.
+    std::vector<float> GetRequiredSigmas() const;
+
+    ProcessingSettings m_Settings;
+
+    std::map<float, std::unique_ptr<c_GaussianConvolution>> m_Gaussians; ///< Key: sigma.
+
+    std::vector<std::array<float, 4>> m_TransitionCurves; ///< Element [i] corresponds to `m_Settings.unsharpMask[i]`.
+
+    c_ToneCurve m_ToneCurve; ///< Copy of `m_Settings.toneCurve`, with LUT.
+    bool m_ToneCurveLutValid{false};
+
+    struct ScratchBuffer
+    {
+        AlignedBlock storage;
+        std::size_t numElements{0};
+    };
+
+    std::array<ScratchBuffer, NUM_SCRATCH_BUFFERS> m_ScratchBuffers;
+};
+
+} // namespace imppg::backend
+
+#endif // IMPPG_PROCESSING_PLAN_HEADER
@@ -22,6 +22,9 @@ File description:
 */
 
 #include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 #include <wx/dcclient.h>
 #include <wx/dcmemory.h>
 
@@ -83,9 +86,57 @@ static void MarkSelection(const wxRect& physSelection, wxDC& dc)
 static wxBitmap ImageToRgbBitmap(const c_Image& src, int x0, int y0, int width, int height)
 {
     c_Image rgbImage = src.GetConvertedPixelFormatSubImage(PixelFormat::PIX_RGB8, x0, y0, width, height);
-    // for storage, `rgbImage` uses `c_SimpleBuffer`, which has no row padding, so we can pass it directly to wxImage's constructor
-    wxImage wximg(width, height, rgbImage.GetRowAs<unsigned char>(0), true);
-    return wxBitmap(wximg);
+
+    // `rgbImage` rows are padded, wxImage requires contiguous rows; wxImage takes ownership of the buffer and frees it with `free`
+    const std::size_t rowBytes = static_cast<std::size_t>(width) * 3;
+    auto* rgb = static_cast<unsigned char*>(std::malloc(rowBytes * height));
+    IMPPG_ASSERT(rgb != nullptr);
+    for (int y = 0; y < height; y++)
+    {
+        std::memcpy(rgb + y * rowBytes, rgbImage.GetRow(y), rowBytes);
+    }
+
+    return wxBitmap(wxImage(width, height, rgb, false));
+}
+
+/// Converts processing output channels (luminance or R, G, B; PIX_MONO32F) to a 24-bit RGB bitmap.
+/** Avoids interleaving the channels into an intermediate RGB32F image. */
+static wxBitmap ChannelsToRgbBitmap(const std::vector<c_Image>& channels)
+{
+    IMPPG_ASSERT(channels.size() == 1 || channels.size() == 3);
+    const int width = channels.at(0).GetWidth();
+    const int height = channels.at(0).GetHeight();
+
+    // wxImage takes ownership of the buffer and frees it with `free`
+    auto* rgb = static_cast<unsigned char*>(std::malloc(static_cast<std::size_t>(width) * height * 3));
+    IMPPG_ASSERT(rgb != nullptr);
+
+    #pragma omp parallel for
+    for (int y = 0; y < height; y++)
+    {
+        unsigned char* dest = rgb + static_cast<std::size_t>(y) * width * 3;
+        if (channels.size() == 1)
+        {
+            const float* src = channels[0].GetRowAs<float>(y);
+            for (int x = 0; x < width; x++)
+            {
+                dest[3*x] = dest[3*x + 1] = dest[3*x + 2] = static_cast<unsigned char>(src[x] * 0xFF);
+            }
+        }
+        else
+        {
+            for (std::size_t ch = 0; ch < 3; ++ch)
+            {
+                const float* src = channels[ch].GetRowAs<float>(y);
+                for (int x = 0; x < width; x++)
+                {
+                    dest[3*x + ch] = static_cast<unsigned char>(src[x] * 0xFF);
+                }
+            }
+        }
+    }
+
+    return wxBitmap(wxImage(width, height, rgb, false));
 }
 
 void c_CpuAndBitmaps::RefreshRect(const wxRect& rect)
@@ -430,10 +481,7 @@ void c_CpuAndBitmaps::UpdateSelectionAfterProcessing()
 {
     Log::Print("Updating selection after processing\n");
 
-    const c_Image& toneMappingOutput = m_Processor.GetProcessedOutput();
-    wxBitmap updatedArea = ImageToRgbBitmap(toneMappingOutput, 0, 0,
-        toneMappingOutput.GetWidth(),
-        toneMappingOutput.GetHeight());
+    wxBitmap updatedArea = ChannelsToRgbBitmap(m_Processor.GetProcessedChannels());
 
     wxMemoryDC dcUpdated(updatedArea), dcMain(m_ImgBmp.value());
     dcMain.Blit(m_Selection.GetTopLeft(), m_Selection.GetSize(), &dcUpdated, wxPoint(0, 0));
@@ -28,8 +28,10 @@ File description:
 #include "logging/logging.h"
 #include "math_utils/convolution.h"
 #include "w_lrdeconv.h"
+#include "w_pipeline.h"
 #include "w_tcurve.h"
-#include "w_unshmask.h"
+
+#include <utility>
 
 namespace imppg::backend {
 
@@ -43,13 +45,49 @@ c_Image CreateBlurredMonoImage(const c_Image& source)
 
     ConvolveSeparable(
         c_PaddedArrayPtr(source.GetRowAs<const float>(0), width, height, source.GetBuffer().GetBytesPerRow()),
-        c_PaddedArrayPtr(blurred.GetRowAs<float>(0), width, height, blurred.GetBuffer().GetBytesPerRow()),
+        c_PaddedArrayPtr(blurred.GetRowAs<float>(0), width, height, std::as_const(blurred).GetBuffer().GetBytesPerRow()),
         RAW_IMAGE_BLUR_SIGMA_FOR_ADAPTIVE_UNSHARP_MASK
     );
 
     return blurred;
 }
 
+/// Makes sure `img` contains `numChannels` images of the size of `selection`.
+/** R, G, B channels are planes of a single `c_PlanarBuffer`. */
+void AllocateChannelImages(std::vector<c_Image>& img, std::size_t numChannels, const wxRect& selection)
+{
+    if (img.size() != numChannels ||
+        static_cast<int>(img.at(0).GetWidth()) != selection.width ||
+        static_cast<int>(img.at(0).GetHeight()) != selection.height)
+    {
+        img.clear();
+        if (numChannels == 3)
+        {
+            c_PlanarBuffer planes(selection.width, selection.height, PixelFormat::PIX_MONO32F);
+            for (auto& channel: planes.ShareChannels())
+            {
+                img.emplace_back(std::move(channel));
+            }
+        }
+        else
+        {
+            for (std::size_t ch = 0; ch < numChannels; ++ch)
+            {
+                img.emplace_back(selection.width, selection.height, PixelFormat::PIX_MONO32F);
+            }
+        }
+    }
+    else
+    {
+        // the previous contents may be still referenced by a copy handed out by `GetProcessedOutput`;
+        // avoid copying them, as they are about to be overwritten
+        for (auto& channel: img)
+        {
+            channel.PrepareForOverwrite();
+        }
+    }
+}
+
 std::unique_ptr<IProcessingBackEnd> CreateCpuBmpProcessingBackend()
 {
     return std::make_unique<c_CpuAndBitmapsProcessing>();
@@ -89,6 +127,14 @@ void c_CpuAndBitmapsProcessing::StartProcessing(c_Image img, ProcessingSettings
     ScheduleProcessing(req_type::Sharpening{});
 }
 
+void c_CpuAndBitmapsProcessing::StartProcessing(c_Image img, std::shared_ptr<ProcessingPlan> plan)
+{
+    IMPPG_ASSERT(plan != nullptr);
+    // Replacing the plan is safe here: the previous worker (if any) holds its own reference to the old plan.
+    m_Plan = plan;
+    StartProcessing(std::move(img), plan->GetSettings());
+}
+
 void c_CpuAndBitmapsProcessing::SetProcessingCompletedHandler(std::function<void(CompletionStatus)> handler)
 {
     m_OnProcessingCompleted = handler;
@@ -113,10 +159,29 @@ const c_Image& c_CpuAndBitmapsProcessing::GetProcessedOutput()
     }
     else
     {
+        if (!m_Output.toneCurve.combined.has_value())
+        {
+            m_Output.toneCurve.combined = c_Image::CombineRGB(
+                m_Output.toneCurve.img.at(0),
+                m_Output.toneCurve.img.at(1),
+                m_Output.toneCurve.img.at(2)
+            );
+        }
         return m_Output.toneCurve.combined.value();
     }
 }
 
+const std::vector<c_Image>& c_CpuAndBitmapsProcessing::GetProcessedChannels()
+{
+    if (m_Worker)
+    {
+        m_Worker->Wait();
+    }
+    IMPPG_ASSERT(m_Output.toneCurve.valid);
+
+    return m_Output.toneCurve.img;
+}
+
 c_CpuAndBitmapsProcessing::c_CpuAndBitmapsProcessing()
 {
     m_EvtHandler.Bind(wxEVT_THREAD, &c_CpuAndBitmapsProcessing::OnThreadEvent, this);
@@ -166,6 +231,12 @@ void c_CpuAndBitmapsProcessing::OnThreadEvent(wxThreadEvent& event)
             Log::Print(wxString::Format("Received a processing completion event from threadId = %d, status = %s\n",
                     event.GetInt(), p.completionStatus == CompletionStatus::COMPLETED ? "COMPLETED" : "ABORTED"));
 
+            if (m_AbortRequestTime.has_value())
+            {
+                Log::Print(wxString::Format("Worker thread finished %s s after abort request\n",
+                        (wxDateTime::UNow() - m_AbortRequestTime.value()).Format("%S.%l")));
+            }
+
             OnProcessingStepCompleted(p.completionStatus);
 
             if (m_ProcessingScheduled)
@@ -177,7 +248,14 @@ void c_CpuAndBitmapsProcessing::OnThreadEvent(wxThreadEvent& event)
                 Log::Print("done\n");
 
                 StartProcessing();
+
+                if (m_AbortRequestTime.has_value())
+                {
+                    Log::Print(wxString::Format("Processing restarted %s s after abort request\n",
+                            (wxDateTime::UNow() - m_AbortRequestTime.value()).Format("%S.%l")));
+                }
             }
+            m_AbortRequestTime = std::nullopt;
             break;
         }
     }
@@ -231,6 +309,10 @@ void c_CpuAndBitmapsProcessing::ScheduleProcessing(ProcessingRequest request)
     else
     {
         // Signal the worker thread to finish ASAP.
+        if (!m_ProcessingScheduled)
+        {
+            m_AbortRequestTime = wxDateTime::UNow();
+        }
         if (m_Worker) { m_Worker->Delete(); }
 
         // Set a flag so that we immediately restart the worker thread
@@ -259,35 +341,15 @@ void c_CpuAndBitmapsProcessing::OnProcessingStepCompleted(CompletionStatus statu
 
             [&](const req_type::UnsharpMasking& umaskRequest)
             {
-                m_Output.unsharpMask.at(umaskRequest.maskIdx).valid = true;
-                if (umaskRequest.maskIdx < m_Output.unsharpMask.size() - 1)
-                {
-                    ScheduleProcessing(req_type::UnsharpMasking{umaskRequest.maskIdx + 1});
-                }
-                else
+                // the subsequent unsharp masks and tone curve have been applied by the same worker thread
+                for (std::size_t i = umaskRequest.maskIdx; i < m_Output.unsharpMask.size(); ++i)
                 {
-                    ScheduleProcessing(req_type::ToneCurve{});
+                    m_Output.unsharpMask.at(i).valid = true;
                 }
+                OnToneCurveCompleted();
             },
 
-            [&](const req_type::ToneCurve&)
-            {
-                m_Output.toneCurve.valid = true;
-
-                if (m_Img.size() == 3)
-                {
-                    m_Output.toneCurve.combined = c_Image::CombineRGB(
-                        m_Output.toneCurve.img.at(0),
-                        m_Output.toneCurve.img.at(1),
-                        m_Output.toneCurve.img.at(2)
-                    );
-                }
-
-                if (m_OnProcessingCompleted)
-                {
-                    m_OnProcessingCompleted(status);
-                }
-            }
+            [&](const req_type::ToneCurve&) { OnToneCurveCompleted(); }
         }, m_ProcessingRequest.value());
     }
     else if (status == CompletionStatus::ABORTED && m_OnProcessingCompleted)
@@ -296,19 +358,23 @@ void c_CpuAndBitmapsProcessing::OnProcessingStepCompleted(CompletionStatus statu
     }
 }
 
-void c_CpuAndBitmapsProcessing::StartLRDeconvolution()
+void c_CpuAndBitmapsProcessing::OnToneCurveCompleted()
 {
-    auto& img = m_Output.sharpening.img;
-    if (img.empty() ||
-        static_cast<int>(img.at(0).GetWidth()) != m_Selection.width ||
-        static_cast<int>(img.at(0).GetHeight()) != m_Selection.height)
+    m_Output.toneCurve.valid = true;
+    // created on demand by `GetProcessedOutput`
+    m_Output.toneCurve.combined = std::nullopt;
+
+    Log::Print(FormatBufferPoolStats(GetBufferPoolStats()) + "\n");
+
+    if (m_OnProcessingCompleted)
     {
-        img.clear();
-        for (std::size_t i = 0; i < m_Img.size(); ++i)
-        {
-            img.emplace_back(m_Selection.width, m_Selection.height, PixelFormat::PIX_MONO32F);
-        }
+        m_OnProcessingCompleted(CompletionStatus::COMPLETED);
     }
+}
+
+void c_CpuAndBitmapsProcessing::StartLRDeconvolution()
+{
+    AllocateChannelImages(m_Output.sharpening.img, m_Img.size(), m_Selection);
 
     // invalidate the current output and those of subsequent steps
     m_Output.sharpening.valid = false;
@@ -348,7 +414,7 @@ void c_CpuAndBitmapsProcessing::StartLRDeconvolution()
         std::vector<c_View<IImageBuffer>> output;
         for (std::size_t ch = 0; ch < m_Img.size(); ++ch)
         {
-            input.emplace_back(m_Img.at(ch).GetBuffer(), m_Selection.x, m_Selection.y, m_Selection.width, m_Selection.height);
+            input.emplace_back(std::as_const(m_Img).at(ch).GetBuffer(), m_Selection.x, m_Selection.y, m_Selection.width, m_Selection.height);
             output.emplace_back(m_Output.sharpening.img.at(ch).GetBuffer());
         }
 
@@ -358,8 +424,10 @@ void c_CpuAndBitmapsProcessing::StartLRDeconvolution()
                 0, // in the future we will pass the index of the currently open image
                 std::move(input),
                 std::move(output),
-                m_CurrentThreadId
+                m_CurrentThreadId,
+                m_MaxThreadCount
             },
+            m_Plan,
             m_ProcSettings.LucyRichardson.sigma,
             m_ProcSettings.LucyRichardson.iterations,
             m_ProcSettings.LucyRichardson.deringing.enabled,
@@ -378,18 +446,14 @@ void c_CpuAndBitmapsProcessing::StartLRDeconvolution()
 
 void c_CpuAndBitmapsProcessing::StartUnsharpMasking(std::size_t maskIdx)
 {
-    auto& img = m_Output.unsharpMask.at(maskIdx).img;
-    if (img.empty() ||
-        static_cast<int>(img.at(0).GetWidth()) != m_Selection.width ||
-        static_cast<int>(img.at(0).GetHeight()) != m_Selection.height)
+    // Unsharp masking is always followed by applying of tone curve; both are local operators, so they are
+    // performed together by a single worker thread (see `c_TilePipelineThread`).
+
+    for (std::size_t i = maskIdx; i < m_Output.unsharpMask.size(); ++i)
     {
-        // create a new empty image to hold the unsharp masking result
-        img.clear();
-        for (std::size_t ch = 0; ch < m_Img.size(); ++ch)
-        {
-            img.emplace_back(m_Selection.width, m_Selection.height, PixelFormat::PIX_MONO32F);
-        }
+        AllocateChannelImages(m_Output.unsharpMask.at(i).img, m_Img.size(), m_Selection);
     }
+    AllocateChannelImages(m_Output.toneCurve.img, m_Img.size(), m_Selection);
 
     // invalidate the current output and those of subsequent steps
     for (std::size_t i = maskIdx; i < m_Output.unsharpMask.size(); ++i)
@@ -409,70 +473,57 @@ void c_CpuAndBitmapsProcessing::StartUnsharpMasking(std::size_t maskIdx)
         }
     }();
 
-    if (!m_ProcSettings.unsharpMask.at(maskIdx).IsEffective())
+    Log::Print(wxString::Format("Launching unsharp masking and tone curve worker thread (id = %d)\n", m_CurrentThreadId));
+
+    std::vector<c_View<const IImageBuffer>> input;
+    std::vector<c_View<IImageBuffer>> output;
+    for (std::size_t ch = 0; ch < m_Img.size(); ++ch)
     {
-        // no processing required, just take the previous step's output
-        const auto numChannels = m_Img.size();
-        for (std::size_t ch = 0; ch < numChannels; ++ch)
-        {
-            c_Image::Copy(
-                prevStepOutput.at(ch),
-                m_Output.unsharpMask.at(maskIdx).img.at(ch),
-                0, 0, m_Selection.width, m_Selection.height, 0, 0
-            );
-        }
-        OnProcessingStepCompleted(CompletionStatus::COMPLETED);
+        input.emplace_back(prevStepOutput.at(ch).GetBuffer());
+        output.emplace_back(m_Output.toneCurve.img.at(ch).GetBuffer());
     }
-    else
-    {
-        Log::Print(wxString::Format("Launching unsharp masking worker thread (id = %d)\n", m_CurrentThreadId));
 
-        std::vector<c_View<const IImageBuffer>> input;
-        std::vector<c_View<IImageBuffer>> output;
+    std::vector<c_TilePipelineThread::UnsharpMaskStage> unsharpMaskStages;
+    for (std::size_t i = maskIdx; i < m_Output.unsharpMask.size(); ++i)
+    {
+        c_TilePipelineThread::UnsharpMaskStage stage{m_ProcSettings.unsharpMask.at(i), m_Plan->GetUnshMaskTransitionCurve(i), {}};
         for (std::size_t ch = 0; ch < m_Img.size(); ++ch)
         {
-            input.emplace_back(prevStepOutput.at(ch).GetBuffer());
-            output.emplace_back(m_Output.unsharpMask.at(maskIdx).img.at(ch).GetBuffer());
-        }
-
-        auto blurred = m_ImgMonoBlurred.has_value()
-            ? std::make_optional(c_View<const IImageBuffer>(m_ImgMonoBlurred.value().GetBuffer(), m_Selection))
-            : std::nullopt;
-
-        m_Worker = std::make_unique<c_UnsharpMaskingThread>(
-            WorkerParameters{
-                m_EvtHandler,
-                0,
-                std::move(input),
-                std::move(output),
-                m_CurrentThreadId
-            },
-            std::move(blurred),
-            m_ProcSettings.unsharpMask.at(maskIdx)
-        );
-
-        if (m_ProgressTextHandler)
-        {
-            m_ProgressTextHandler(wxString(_("Unsharp masking...")));
+            stage.output.emplace_back(m_Output.unsharpMask.at(i).img.at(ch).GetBuffer());
         }
+        unsharpMaskStages.push_back(std::move(stage));
+    }
+
+    auto blurred = m_ImgMonoBlurred.has_value()
+        ? std::make_optional(c_View<const IImageBuffer>(std::as_const(m_ImgMonoBlurred).value().GetBuffer(), m_Selection))
+        : std::nullopt;
+
+    m_Worker = std::make_unique<c_TilePipelineThread>(
+        WorkerParameters{
+            m_EvtHandler,
+            0,
+            std::move(input),
+            std::move(output),
+            m_CurrentThreadId,
+            m_MaxThreadCount
+        },
+        std::move(blurred),
+        std::move(unsharpMaskStages),
+        m_Plan,
+        m_UsePreciseToneCurveValues
+    );
 
-        m_Worker->Run();
+    if (m_ProgressTextHandler)
+    {
+        m_ProgressTextHandler(wxString(_("Unsharp masking...")));
     }
+
+    m_Worker->Run();
 }
 
 void c_CpuAndBitmapsProcessing::StartToneCurve()
 {
-    auto& img = m_Output.toneCurve.img;
-    if (img.empty() ||
-        static_cast<int>(img.at(0).GetWidth()) != m_Selection.width ||
-        static_cast<int>(img.at(0).GetHeight()) != m_Selection.height)
-    {
-        img.clear();
-        for (std::size_t i = 0; i < m_Img.size(); ++i)
-        {
-            img.emplace_back(m_Selection.width, m_Selection.height, PixelFormat::PIX_MONO32F);
-        }
-    }
+    AllocateChannelImages(m_Output.toneCurve.img, m_Img.size(), m_Selection);
 
     Log::Print("Created tone curve output image\n");
 
@@ -510,7 +561,7 @@ void c_CpuAndBitmapsProcessing::StartToneCurve()
         std::vector<c_View<IImageBuffer>> output;
         for (std::size_t ch = 0; ch < m_Img.size(); ++ch)
         {
-            input.emplace_back(checked_back(m_Output.unsharpMask).img.at(ch).GetBuffer());
+            input.emplace_back(std::as_const(checked_back(m_Output.unsharpMask).img).at(ch).GetBuffer());
             output.emplace_back(m_Output.toneCurve.img.at(ch).GetBuffer());
         }
 
@@ -520,9 +571,10 @@ void c_CpuAndBitmapsProcessing::StartToneCurve()
                 0, // in the future we will pass the index of currently open image
                 std::move(input),
                 std::move(output),
-                m_CurrentThreadId
+                m_CurrentThreadId,
+                m_MaxThreadCount
             },
-            m_ProcSettings.toneCurve,
+            m_Plan,
             m_UsePreciseToneCurveValues
         );
 
@@ -550,6 +602,8 @@ void c_CpuAndBitmapsProcessing::StartProcessing()
 
     m_ProcessingScheduled = false;
 
+    PreparePlan();
+
     // Make sure that if there are outdated thread events out there, they will be recognized
     // as such and discarded (`currentThreadId` will be sent from worker in event.GetInt()).
     // See also: OnThreadEvent().
@@ -564,6 +618,18 @@ void c_CpuAndBitmapsProcessing::StartProcessing()
     }, m_ProcessingRequest.value());
 }
 
+void c_CpuAndBitmapsProcessing::PreparePlan()
+{
+    if (!m_Plan)
+    {
+        m_Plan = std::make_shared<ProcessingPlan>(m_ProcSettings, m_Selection.width, m_Selection.height);
+    }
+    else
+    {
+        m_Plan->Update(m_ProcSettings);
+    }
+}
+
 c_CpuAndBitmapsProcessing::~c_CpuAndBitmapsProcessing()
 {
     if (m_Worker)
@@ -578,8 +644,10 @@ void c_CpuAndBitmapsProcessing::AbortProcessing()
     if (m_Worker)
     {
         Log::Print("Sending abort request to the worker thread\n");
+        const wxDateTime tstart = wxDateTime::UNow();
         m_Worker->Delete();
         m_Worker->Wait();
+        Log::Print(wxString::Format("Worker thread aborted in %s s\n", (wxDateTime::UNow() - tstart).Format("%S.%l")));
     }
 }
 
@@ -597,10 +665,7 @@ void c_CpuAndBitmapsProcessing::ApplyPreciseToneCurveValues()
         for (auto& umOutput: m_Output.unsharpMask)
         {
             umOutput.img.clear();
-            for (std::size_t i = 0; i < m_Img.size(); ++i)
-            {
-                umOutput.img.emplace_back(m_Selection.width, m_Selection.height, PixelFormat::PIX_MONO32F);
-            }
+            AllocateChannelImages(umOutput.img, m_Img.size(), m_Selection);
 
             const auto numChannels = m_Img.size();
             for (std::size_t ch = 0; ch < numChannels; ++ch)
@@ -622,10 +687,7 @@ void c_CpuAndBitmapsProcessing::ApplyPreciseToneCurveValues()
     if (!m_Output.toneCurve.valid)
     {
         m_Output.toneCurve.img.clear();
-        for (std::size_t i = 0; i < m_Img.size(); ++i)
-        {
-            m_Output.toneCurve.img.emplace_back(m_Selection.width, m_Selection.height, PixelFormat::PIX_MONO32F);
-        }
+        AllocateChannelImages(m_Output.toneCurve.img, m_Img.size(), m_Selection);
 
         for (std::size_t i = 0; i < m_Img.size(); ++i)
         {
@@ -728,7 +790,7 @@ void c_CpuAndBitmapsProcessing::SetProcessingSettings(ProcessingSettings procSet
         }
         else
         {
-            const auto mono = c_Image::CombineRGB(m_Img.at(0), m_Img.at(1), m_Img.at(2));
+            const auto mono = c_Image::CombineRGB(m_Img.at(0), m_Img.at(1), m_Img.at(2)).ConvertPixelFormat(PixelFormat::PIX_MONO32F);
             m_ImgMonoBlurred = CreateBlurredMonoImage(mono);
         }
     }
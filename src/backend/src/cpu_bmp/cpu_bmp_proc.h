@@ -25,11 +25,14 @@ File description:
 #define IMPPG_CPU_BMP_PROC_HEADER
 
 #include "backend/backend.h"
+#include "backend/processing_plan.h"
 #include "cpu_bmp/worker.h"
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <vector>
+#include <wx/datetime.h>
 
 namespace imppg::backend {
 
@@ -41,6 +44,8 @@ public:
 
     void StartProcessing(c_Image img, ProcessingSettings procSettings) override;
 
+    void StartProcessing(c_Image img, std::shared_ptr<ProcessingPlan> plan) override;
+
     void SetProcessingCompletedHandler(std::function<void(CompletionStatus)> handler) override;
 
     void SetProgressTextHandler(std::function<void(wxString)> handler) override;
@@ -49,10 +54,15 @@ public:
 
     void AbortProcessing() override;
 
+    void SetMaxThreadCount(unsigned count) override { m_MaxThreadCount = count; }
+
     // --------------------------------------------------------------------------------------------
 
     c_CpuAndBitmapsProcessing();
 
+    /// Returns the tone curve output channels (luminance or R, G, B); unlike `GetProcessedOutput`, does not interleave RGB channels.
+    const std::vector<c_Image>& GetProcessedChannels();
+
     c_CpuAndBitmapsProcessing(const c_CpuAndBitmapsProcessing&) = delete;
 
     c_CpuAndBitmapsProcessing& operator=(const c_CpuAndBitmapsProcessing&) = delete;
@@ -87,6 +97,9 @@ private:
     /// Creates and starts a background processing thread.
     void StartProcessing();
 
+    /// Makes `m_Plan` correspond to `m_ProcSettings`.
+    void PreparePlan();
+
     void StartLRDeconvolution();
 
     void StartUnsharpMasking(std::size_t maskIdx);
@@ -95,6 +108,9 @@ private:
 
     void OnProcessingStepCompleted(CompletionStatus status);
 
+    /// Marks the tone curve output as valid and notifies about completion of processing.
+    void OnToneCurveCompleted();
+
     void OnThreadEvent(wxThreadEvent& event);
 
     /// Image being processed; if not empty, contains 1 element (mono luminance) or 3 (R, G, B channels).
@@ -113,6 +129,10 @@ private:
 
     std::vector<uint8_t> m_DeringingWorkBuf;
 
+    /// Compiled `m_ProcSettings`; may be provided by the caller to be reused across images.
+    /** Shared with the running worker thread; updated only when no worker is running. */
+    std::shared_ptr<ProcessingPlan> m_Plan;
+
     std::unique_ptr<IWorkerThread> m_Worker;
 
     /// Identifier increased by 1 after each creation of a new thread
@@ -133,6 +153,10 @@ private:
     /// If `true`, processing has been scheduled to start ASAP (as soon as `m_Processing.worker` is not running)
     bool m_ProcessingScheduled{false};
 
+    /// Time when the running worker thread was last asked to abort (because of a newly scheduled request);
+    /// used to log the request-to-abort and request-to-restart latencies.
+    std::optional<wxDateTime> m_AbortRequestTime;
+
     struct UnsharpMaskResult
     {
         std::vector<c_Image> img; ///< 1 or 3 elements: luminance or R, G, B channels.
@@ -158,7 +182,7 @@ private:
         struct
         {
             std::vector<c_Image> img; ///< 1 or 3 elements: luminance or R, G, B channels.
-            std::optional<c_Image> combined; ///< Luminance or combined R, G, B channels.
+            std::optional<c_Image> combined; ///< Combined R, G, B channels; created on demand.
             bool valid{false}; ///< `true` if the last tone curve application request completed.
             bool preciseValuesApplied{false}; ///< 'true' if precise values of tone curve have been applied; happens only when saving output file.
         } toneCurve;
@@ -167,6 +191,8 @@ private:
     std::function<void(CompletionStatus)> m_OnProcessingCompleted;
 
     bool m_UsePreciseToneCurveValues{false};
+
+    unsigned m_MaxThreadCount{0}; ///< 0 means: no limit.
 };
 
 }  // namespace imppg::backend
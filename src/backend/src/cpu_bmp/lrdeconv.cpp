@@ -26,12 +26,10 @@ File description:
 #include <cmath>
 #include <cstdint>
 #include <cstring>
-#include <memory>
 #include <tuple>
 #include <vector>
 
 #include "lrdeconv.h"
-#include "math_utils/gauss.h"
 
 
 // NOTE: MSVC 18 requires a signed integral type 'for' loop counter
@@ -59,89 +57,79 @@ void LucyRichardsonGaussian(
     c_View<const IImageBuffer>& input, ///< Contains a single 'float' value per pixel; size the same as 'output'
     c_View<IImageBuffer>& output, ///< Contains a single 'float' value per pixel; size the same as 'input'
     int numIters,  ///< Number of iterations
-    float sigma,   ///< sigma of the Gaussian kernel
-    ConvolutionMethod convMethod,
+    c_GaussianConvolution& gaussian, ///< Convolution with the Gaussian kernel
+    const LucyRichardsonBuffers& buffers,
 
     /// Called after every iteration; arguments: current iteration, total iterations
     std::function<void (int, int)> progressCallback,
 
-    /// Called periodically to check if there was an "abort processing" request
-    std::function<bool ()> checkAbort
+    /// Called periodically (every ABORT_CHECK_TILE_ROWS rows of each convolution pass)
+    /// to check if there was an "abort processing" request
+    const AbortCheck& checkAbort
 )
 {
     IMPPG_ASSERT(input.GetPixelFormat() == PixelFormat::PIX_MONO32F);
     int width = input.GetWidth(), height = input.GetHeight();
 
-    auto prev = std::unique_ptr<float[]>(new float[width * height]);
-    auto next = std::unique_ptr<float[]>(new float[width * height]);
+    float* prev = buffers.prev;
+    float* next = buffers.next;
+    float* inputConvolvedDivT = buffers.inputConvolvedDivT;
+    float* estimateConvolvedT = buffers.estimateConvolvedT;
+    float* conv2 = buffers.conv2;
+    float* inputT = buffers.inputT;
 
-    auto inputConvolvedDivT = std::unique_ptr<float[]>(new float[input.GetHeight() * input.GetWidth()]); // a transposed array
-    auto estimateConvolvedT = std::unique_ptr<float[]>(new float[input.GetHeight() * input.GetWidth()]); // a transposed array
-    auto conv2 = std::unique_ptr<float[]>(new float[input.GetWidth() * input.GetHeight()]);
+    // strides in elements
+    const std::size_t stride = buffers.bytesPerRow / sizeof(float);
+    const std::size_t strideT = buffers.bytesPerRowT / sizeof(float);
 
-    auto inputT = std::unique_ptr<float[]>(new float[input.GetHeight() * input.GetWidth()]); // a transposed array
-
-    Transpose(input.GetRowAs<const float>(0), inputT.get(), input.GetWidth(), input.GetHeight(),
-        input.GetBytesPerRow(), input.GetHeight() * sizeof(float), TRANSPOSITION_BLOCK_SIZE);
-
-    auto tempBuf1 = std::unique_ptr<float[]>(new float[input.GetWidth() * input.GetHeight()]);
-    auto tempBuf2 = std::unique_ptr<float[]>(new float[input.GetWidth() * input.GetHeight()]);
-
-    int kernelRadius = static_cast<int>(ceil(sigma * 3.0f));
-    auto kernel = std::unique_ptr<float[]>(new float[2 * kernelRadius - 1]);
-    CalculateGaussianKernelProjection(kernel.get(), kernelRadius, sigma, true);
+    Transpose(input.GetRowAs<const float>(0), inputT, input.GetWidth(), input.GetHeight(),
+        input.GetBytesPerRow(), buffers.bytesPerRowT, TRANSPOSITION_BLOCK_SIZE);
 
     for (unsigned i = 0; i < input.GetHeight(); i++)
-        memcpy(prev.get() + i * input.GetWidth(), input.GetRow(i), input.GetWidth() * sizeof(float));
+        memcpy(prev + i * stride, input.GetRow(i), input.GetWidth() * sizeof(float));
 
     for (int i = 0; i < numIters; i++)
     {
-        if (convMethod == ConvolutionMethod::STANDARD ||
-            convMethod == ConvolutionMethod::AUTO && kernelRadius < YOUNG_VAN_VLIET_MIN_KERNEL_RADIUS)
+        if (!gaussian.ConvolveTranspose(
+                c_PaddedArrayPtr<const float>(prev, width, height, buffers.bytesPerRow),
+                c_PaddedArrayPtr<float>(estimateConvolvedT, height, width, buffers.bytesPerRowT),
+                checkAbort))
         {
-            ConvolveSeparableTranspose(
-                    c_PaddedArrayPtr<const float>(prev.get(), width, height),
-                    c_PaddedArrayPtr<float>(estimateConvolvedT.get(), height, width),
-                    kernel.get(), kernelRadius, tempBuf1.get(), tempBuf2.get());
+            break;
         }
-        else
-            ConvolveGaussianRecursiveTranspose(
-                    c_PaddedArrayPtr<const float>(prev.get(), width, height),
-                    c_PaddedArrayPtr<float>(estimateConvolvedT.get(), height, width),
-                    sigma, tempBuf1.get(), tempBuf2.get());
 
         #pragma omp parallel for
-        for (unsigned j = 0; j < input.GetHeight() * input.GetWidth(); j++)
-            inputConvolvedDivT[j] = inputT[j] / (estimateConvolvedT[j] + 1.0e-8f); // add a small epsilon to prevent division by 0 and propagation of NaNs across output pixels
+        for (int j = 0; j < width; j++)
+        {
+            const std::size_t ofs = j * strideT;
+            for (int k = 0; k < height; k++)
+                inputConvolvedDivT[ofs + k] = inputT[ofs + k] / (estimateConvolvedT[ofs + k] + 1.0e-8f); // add a small epsilon to prevent division by 0 and propagation of NaNs across output pixels
+        }
 
-        // Note that 'height' and 'width' are switched in the below calls, as we use transposed arrays for input
-        if (convMethod == ConvolutionMethod::STANDARD ||
-            convMethod == ConvolutionMethod::AUTO && kernelRadius < YOUNG_VAN_VLIET_MIN_KERNEL_RADIUS)
+        // Note that 'height' and 'width' are switched in the below call, as we use transposed arrays for input
+        if (!gaussian.ConvolveTranspose(
+                c_PaddedArrayPtr<const float>(inputConvolvedDivT, height, width, buffers.bytesPerRowT),
+                c_PaddedArrayPtr<float>(conv2, width, height, buffers.bytesPerRow),
+                checkAbort))
         {
-            ConvolveSeparableTranspose(
-                    c_PaddedArrayPtr<const float>(inputConvolvedDivT.get(), height, width),
-                    c_PaddedArrayPtr<float>(conv2.get(), width, height),
-                    kernel.get(), kernelRadius, tempBuf1.get(), tempBuf2.get());
+            break;
         }
-        else
-            ConvolveGaussianRecursiveTranspose(
-                    c_PaddedArrayPtr<const float>(inputConvolvedDivT.get(), height, width),
-                    c_PaddedArrayPtr<float>(conv2.get(), width, width),
-                    sigma, tempBuf1.get(), tempBuf2.get());
 
         #pragma omp parallel for
-        for (unsigned j = 0; j < input.GetWidth() * input.GetHeight(); j++)
-            next[j] = prev[j] * conv2[j];
+        for (int j = 0; j < height; j++)
+        {
+            const std::size_t ofs = j * stride;
+            for (int k = 0; k < width; k++)
+                next[ofs + k] = prev[ofs + k] * conv2[ofs + k];
+        }
 
         std::swap(prev, next);
 
         progressCallback(i, numIters);
-        if (checkAbort())
-            break;
     }
 
     for (unsigned i = 0; i < input.GetHeight(); i++)
-        memcpy(output.GetRow(i), next.get() + i*input.GetWidth(), input.GetWidth() * sizeof(float));
+        memcpy(output.GetRow(i), next + i * stride, input.GetWidth() * sizeof(float));
 }
 
 // Functions to encode/decode (x,y) pairs into a 64-bit integer.
@@ -214,12 +202,13 @@ void FillTresholdVicinityMask(
     }
 }
 
-void BlurThresholdVicinity(
+bool BlurThresholdVicinity(
     c_View<const IImageBuffer> input,
     c_View<IImageBuffer> output,
     std::vector<uint8_t>& workBuf,
     float threshold, ///< Threshold to qualify pixels as "border pixels".
-    float sigma
+    c_GaussianConvolution& gaussian,
+    const AbortCheck& checkAbort
 )
 {
     IMPPG_ASSERT(input.GetWidth() == output.GetWidth());
@@ -228,13 +217,16 @@ void BlurThresholdVicinity(
     IMPPG_ASSERT(input.GetPixelFormat() == PixelFormat::PIX_MONO32F);
     IMPPG_ASSERT(input.GetPixelFormat() == output.GetPixelFormat());
 
-    FillTresholdVicinityMask(input, workBuf, threshold, sigma);
+    FillTresholdVicinityMask(input, workBuf, threshold, gaussian.GetSigma());
 
-    ConvolveSeparable(
+    if (!gaussian.Convolve(
         c_PaddedArrayPtr(input.GetRowAs<const float>(0), input.GetWidth(), input.GetHeight(), input.GetBytesPerRow()),
         c_PaddedArrayPtr(output.GetRowAs<float>(0), output.GetWidth(), output.GetHeight(), output.GetBytesPerRow()),
-        sigma
-    );
+        checkAbort
+    ))
+    {
+        return false;
+    }
 
     for (unsigned y = 0; y < input.GetHeight(); ++y)
     {
@@ -247,4 +239,19 @@ void BlurThresholdVicinity(
             destRow[x] = (maskRow[x] == 0) ? srcRow[x] : destRow[x];
         }
     }
+
+    return true;
+}
+
+bool BlurThresholdVicinity(
+    c_View<const IImageBuffer> input,
+    c_View<IImageBuffer> output,
+    std::vector<uint8_t>& workBuf,
+    float threshold, ///< Threshold to qualify pixels as "border pixels".
+    float sigma,
+    const AbortCheck& checkAbort
+)
+{
+    c_GaussianConvolution gaussian(sigma);
+    return BlurThresholdVicinity(input, output, workBuf, threshold, gaussian, checkAbort);
 }
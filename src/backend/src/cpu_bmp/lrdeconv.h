@@ -27,34 +27,55 @@ File description:
 #include "image/image.h"
 #include "math_utils/convolution.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <vector>
 
 /// Clamps the values of the specified PIX_MONO32F buffer to [0.0, 1.0]
 void Clamp(c_View<IImageBuffer>& buf);
 
-/// Calculates convolution of 'input' with a Gaussian kernel
-void ConvolveSeparable(
-        c_PaddedArrayPtr<const float> input, ///< Input array
-        c_PaddedArrayPtr<float> output,      ///< Output array having as much rows and columns as 'input' does
-        float sigma                           ///< Gaussian sigma
-);
+/// Work buffers of `LucyRichardsonGaussian`; each must have `GetNumElements()` elements.
+/** Rows are aligned and padded (see `GetPaddedRowStride`). */
+struct LucyRichardsonBuffers
+{
+    float* prev;
+    float* next;
+    float* inputT;             ///< Transposed.
+    float* estimateConvolvedT; ///< Transposed.
+    float* inputConvolvedDivT; ///< Transposed.
+    float* conv2;
+
+    std::size_t bytesPerRow;  ///< Stride of non-transposed buffers (`width` elements per row).
+    std::size_t bytesPerRowT; ///< Stride of transposed buffers (`height` elements per row).
+
+    /// Returns the required size (in elements) of each buffer.
+    static std::size_t GetNumElements(unsigned width, unsigned height)
+    {
+        return std::max(
+            GetPaddedRowStride(width, sizeof(float)) * height,
+            GetPaddedRowStride(height, sizeof(float)) * width
+        ) / sizeof(float);
+    }
+};
 
 /// Reproduces original image from image in 'input' convolved with Gaussian kernel and writes it to 'output'.
 void LucyRichardsonGaussian(
         c_View<const IImageBuffer>& input, ///< Contains a single 'float' value per pixel; size the same as 'output'
         c_View<IImageBuffer>& output, ///< Contains a single 'float' value per pixel; size the same as 'input'
         int numIters,  ///< Number of iterations
-        float sigma,   ///< sigma of the Gaussian kernel
-        ConvolutionMethod convMethod,
+        c_GaussianConvolution& gaussian, ///< Convolution with the Gaussian kernel
+        const LucyRichardsonBuffers& buffers,
 
         /// Called after every iteration; arguments: current iteration, total iterations
         //boost::function<void(int, int)> progressCallback,
         std::function<void (int, int)> progressCallback,
 
-        /// Called periodically to check if there was an "abort processing" request
+        /// Called periodically (every ABORT_CHECK_TILE_ROWS rows of each convolution pass)
+        /// to check if there was an "abort processing" request
         //boost::function<bool()> checkAbort
-        std::function<bool ()> checkAbort
+        const AbortCheck& checkAbort
 );
 
 // c_Image GetTresholdVicinityMask(
@@ -64,13 +85,24 @@ void LucyRichardsonGaussian(
 // );
 
 
-/// Blurs pixels around borders of brightness areas defined by 'threshold'
-void BlurThresholdVicinity(
+/// Blurs pixels around borders of brightness areas defined by 'threshold'; returns `false` if aborted.
+bool BlurThresholdVicinity(
+    c_View<const IImageBuffer> input,
+    c_View<IImageBuffer> output,
+    std::vector<uint8_t>& workBuf,
+    float threshold, ///< Threshold to qualify pixels as "border pixels".
+    float sigma,
+    const AbortCheck& checkAbort = {}
+);
+
+/// Overload using a precompiled Gaussian convolution (whose sigma is used instead of `sigma`).
+bool BlurThresholdVicinity(
     c_View<const IImageBuffer> input,
     c_View<IImageBuffer> output,
     std::vector<uint8_t>& workBuf,
     float threshold, ///< Threshold to qualify pixels as "border pixels".
-    float sigma
+    c_GaussianConvolution& gaussian,
+    const AbortCheck& checkAbort = {}
 );
 
 #endif // IMPP_LRDECONV_H
@@ -27,10 +27,13 @@ File description:
 #include "cpu_bmp/message_ids.h"
 #include "logging/logging.h"
 
+#include <utility>
+
 namespace imppg::backend {
 
 c_LucyRichardsonThread::c_LucyRichardsonThread(
     WorkerParameters&& params,
+    std::shared_ptr<ProcessingPlan> plan,
     float lrSigma,
     int numIterations,
     bool deringing,
@@ -38,6 +41,7 @@ c_LucyRichardsonThread::c_LucyRichardsonThread(
     float deringingSigma,
     std::vector<uint8_t>& deringingWorkBuf
 ): IWorkerThread(std::move(params)),
+   m_Plan(std::move(plan)),
    lrSigma(lrSigma),
    numIterations(numIterations),
    m_Deringing{deringing, deringingThreshold, deringingSigma, deringingWorkBuf}
@@ -69,6 +73,8 @@ void c_LucyRichardsonThread::DoWork()
 
     const std::size_t numChannels = m_Params.input.size();
 
+    const AbortCheck checkAbort = [this]() { return IsAbortRequested(); };
+
     std::vector<c_Image> preprocessedInputImg;
     if (m_Deringing.enabled)
     {
@@ -80,19 +86,44 @@ void c_LucyRichardsonThread::DoWork()
         for (std::size_t ch = 0; ch < numChannels; ++ch)
         {
             auto preprocView = c_View(preprocessedInputImg.at(ch).GetBuffer());
-            BlurThresholdVicinity(m_Params.input.at(ch), preprocView, m_Deringing.workBuf, m_Deringing.threshold, m_Deringing.sigma);
-            preprocessedInput[ch] = c_View<const IImageBuffer>(preprocessedInputImg.at(ch).GetBuffer());
+            if (!BlurThresholdVicinity(m_Params.input.at(ch), preprocView, m_Deringing.workBuf,
+                m_Deringing.threshold, m_Plan->GetGaussian(m_Deringing.sigma), checkAbort))
+            {
+                return;
+            }
+            preprocessedInput[ch] = c_View<const IImageBuffer>(std::as_const(preprocessedInputImg).at(ch).GetBuffer());
         }
     }
 
+    const unsigned width = m_Params.input.at(0).GetWidth();
+    const unsigned height = m_Params.input.at(0).GetHeight();
+    const std::size_t numElements = LucyRichardsonBuffers::GetNumElements(width, height);
+    const LucyRichardsonBuffers buffers{
+        m_Plan->GetScratchBuffer(0, numElements),
+        m_Plan->GetScratchBuffer(1, numElements),
+        m_Plan->GetScratchBuffer(2, numElements),
+        m_Plan->GetScratchBuffer(3, numElements),
+        m_Plan->GetScratchBuffer(4, numElements),
+        m_Plan->GetScratchBuffer(5, numElements),
+        GetPaddedRowStride(width, sizeof(float)),
+        GetPaddedRowStride(height, sizeof(float))
+    };
+    auto& gaussian = m_Plan->GetGaussian(lrSigma);
+
     for (std::size_t ch = 0; ch < numChannels; ++ch)
     {
-        LucyRichardsonGaussian(preprocessedInput.at(ch), m_Params.output.at(ch), numIterations, lrSigma, ConvolutionMethod::AUTO,
+        LucyRichardsonGaussian(preprocessedInput.at(ch), m_Params.output.at(ch), numIterations, gaussian, buffers,
             [this, ch, numChannels](int currentIter, int totalIters) {
                 IterationNotification(ch * totalIters + currentIter, totalIters * numChannels);
             },
-            [this]() { return IsAbortRequested(); }
+            checkAbort
         );
+
+        if (IsAbortRequested())
+        {
+            Log::Print(wxString::Format("L-R deconvolution aborted after %s s\n", (wxDateTime::UNow() - tstart).Format("%S.%l")));
+            return;
+        }
     }
 
     Log::Print(wxString::Format("L-R deconvolution finished in %s s\n", (wxDateTime::UNow() - tstart).Format("%S.%l")));
@@ -24,14 +24,18 @@ File description:
 #ifndef IMPPG_LR_DECONV_WORKER_THREAD_H
 #define IMPPG_LR_DECONV_WORKER_THREAD_H
 
+#include "backend/processing_plan.h"
 #include "cpu_bmp/worker.h"
 
+#include <memory>
+
 namespace imppg::backend {
 
 class c_LucyRichardsonThread : public IWorkerThread
 {
     void DoWork() override;
 
+    std::shared_ptr<ProcessingPlan> m_Plan;
     float lrSigma;
     int numIterations;
     struct
@@ -49,6 +53,7 @@ class c_LucyRichardsonThread : public IWorkerThread
 public:
     c_LucyRichardsonThread(
         WorkerParameters&& params,
+        std::shared_ptr<ProcessingPlan> plan, ///< Provides the Gaussian convolutions and work buffers.
         float lrSigma,             ///< Lucy-Richardson deconvolution Gaussian kernel's sigma.
         int numIterations,         ///< Number of L-R deconvolution iterations.
         bool deringing,            ///< If 'true', ringing around a specified threshold of brightness will be reduced.
@@ -0,0 +1,198 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Tile pipeline (unsharp masking followed by tone curve) worker thread implementation.
+*/
+
+#include "cpu_bmp/message_ids.h"
+#include "cpu_bmp/w_pipeline.h"
+#include "logging/logging.h"
+#include "math_utils/convolution.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <wx/datetime.h>
+
+// NOTE: MSVC 18 requires a signed integral type 'for' loop counter
+//       when using OpenMP
+
+namespace imppg::backend {
+
+c_TilePipelineThread::c_TilePipelineThread(
+    WorkerParameters&& params,
+    std::optional<c_View<const IImageBuffer>>&& blurredRawInput,
+    std::vector<UnsharpMaskStage>&& unsharpMaskStages,
+    std::shared_ptr<ProcessingPlan> plan,
+    bool usePreciseToneCurveValues
+): IWorkerThread(std::move(params)),
+   m_BlurredRawInput(std::move(blurredRawInput)),
+   m_UnsharpMaskStages(std::move(unsharpMaskStages)),
+   m_Plan(std::move(plan)),
+   m_UsePreciseToneCurveValues(usePreciseToneCurveValues)
+{
+    for (const auto& stage: m_UnsharpMaskStages)
+    {
+        IMPPG_ASSERT(stage.output.size() == m_Params.input.size());
+        if (stage.unsharpMask.adaptive)
+        {
+            IMPPG_ASSERT(m_BlurredRawInput.has_value() && m_BlurredRawInput->GetPixelFormat() == PixelFormat::PIX_MONO32F);
+        }
+    }
+}
+
+bool c_TilePipelineThread::ApplyUnsharpMask(
+    const std::vector<c_PaddedArrayPtr<const float>>& input,
+    UnsharpMaskStage& stage,
+    const AbortCheck& checkAbort
+)
+{
+    const int width = input.at(0).width();
+    const int height = input.at(0).height();
+    const UnsharpMask& um = stage.unsharpMask;
+
+    if (!um.IsEffective())
+    {
+        for (std::size_t ch = 0; ch < input.size(); ++ch)
+        {
+            for (int y = 0; y < height; y++)
+            {
+                std::memcpy(stage.output.at(ch).GetRowAs<float>(y), input[ch].row_const(y), width * sizeof(float));
+            }
+        }
+        return true;
+    }
+
+    // Standard unsharp masking - the amount (taken from `amountMax`) is constant for the whole image.
+    //
+    // Adaptive unsharp masking - the amount depends on input image's local brightness. It is taken from the raw,
+    // unprocessed image smoothed by Gaussian with sigma = RAW_IMAGE_BLUR_SIGMA_FOR_ADAPTIVE_UNSHARP_MASK
+    // to alleviate noise (`m_BlurredRawInput`). See the declaration of `GetAdaptiveUnshMaskTransitionCurve`
+    // for further details.
+    const std::array<float, 4>& curve = stage.transitionCurve;
+
+    // Gaussian-blurred image of one channel.
+    const std::size_t gaussianStride = GetPaddedRowStride(width, sizeof(float));
+    float* gaussianImg = m_Plan->GetScratchBuffer(0, gaussianStride / sizeof(float) * height);
+    auto& gaussian = m_Plan->GetGaussian(um.sigma);
+
+    for (std::size_t ch = 0; ch < input.size(); ++ch)
+    {
+        if (!gaussian.Convolve(input[ch], c_PaddedArrayPtr(gaussianImg, width, height, static_cast<int>(gaussianStride)), checkAbort))
+        {
+            return false;
+        }
+
+        #pragma omp parallel for
+        for (int y = 0; y < height; y++)
+        {
+            const float* srcRow = input[ch].row_const(y);
+            const float* gaussianRow = &gaussianImg[static_cast<std::size_t>(y) * gaussianStride / sizeof(float)];
+            const float* lumRow = um.adaptive ? m_BlurredRawInput.value().GetRowAs<const float>(y) : nullptr;
+            float* destRow = stage.output.at(ch).GetRowAs<float>(y);
+
+            for (int x = 0; x < width; x++)
+            {
+                float amount = um.amountMax;
+                if (um.adaptive)
+                {
+                    const float lum = lumRow[x];
+                    if (lum < um.threshold - um.width)
+                        amount = um.amountMin;
+                    else if (lum <= um.threshold + um.width)
+                        amount = lum * (lum * (curve[0] * lum + curve[1]) + curve[2]) + curve[3];
+                }
+
+                destRow[x] = std::clamp(amount * srcRow[x] + (1.0f - amount) * gaussianRow[x], 0.0f, 1.0f);
+            }
+        }
+    }
+
+    return true;
+}
+
+void c_TilePipelineThread::ApplyToneCurve(const std::vector<c_PaddedArrayPtr<const float>>& input)
+{
+    const int width = input.at(0).width();
+    const int height = input.at(0).height();
+    const c_ToneCurve& toneCurve = m_Plan->GetToneCurve();
+    const bool isIdentity = toneCurve.IsIdentity();
+
+    for (std::size_t ch = 0; ch < input.size(); ++ch)
+    {
+        #pragma omp parallel for
+        for (int y = 0; y < height; y++)
+        {
+            const float* srcRow = input[ch].row_const(y);
+            float* destRow = m_Params.output.at(ch).GetRowAs<float>(y);
+
+            if (isIdentity)
+                std::memcpy(destRow, srcRow, width * sizeof(float));
+            else if (m_UsePreciseToneCurveValues)
+                toneCurve.ApplyPreciseToneCurve(srcRow, destRow, width);
+            else
+                toneCurve.ApplyApproximatedToneCurve(srcRow, destRow, width);
+        }
+    }
+}
+
+void c_TilePipelineThread::DoWork()
+{
+    wxDateTime tstart = wxDateTime::UNow();
+
+    const int width = m_Params.input.at(0).GetWidth();
+    const int height = m_Params.input.at(0).GetHeight();
+
+    const AbortCheck checkAbort = [this]() { return IsAbortRequested(); };
+
+    // Input of each unsharp mask is the output of the preceding one; the tone curve is applied to the last output.
+    std::vector<c_PaddedArrayPtr<const float>> stageInput;
+    for (auto& input: m_Params.input)
+    {
+        stageInput.emplace_back(input.GetRowAs<const float>(0), width, height, input.GetBytesPerRow());
+    }
+
+    const std::size_t numStages = m_UnsharpMaskStages.size() + 1;
+    for (std::size_t s = 0; s < m_UnsharpMaskStages.size(); ++s)
+    {
+        auto& stage = m_UnsharpMaskStages[s];
+        if (!ApplyUnsharpMask(stageInput, stage, checkAbort) || IsAbortRequested())
+        {
+            Log::Print(wxString::Format("Unsharp masking aborted after %s s\n", (wxDateTime::UNow() - tstart).Format("%S.%l")));
+            return;
+        }
+
+        stageInput.clear();
+        for (auto& output: stage.output)
+        {
+            stageInput.emplace_back(output.GetRowAs<float>(0), width, height, output.GetBytesPerRow());
+        }
+
+        WorkerEventPayload payload;
+        payload.percentageComplete = static_cast<int>(100 * (s + 1) / numStages);
+        SendMessageToParent(ID_PROCESSING_PROGRESS, payload);
+    }
+
+    ApplyToneCurve(stageInput);
+
+    Log::Print(wxString::Format("Unsharp masking and tone curve finished in %s s\n", (wxDateTime::UNow() - tstart).Format("%S.%l")));
+}
+
+} // namespace imppg::backend
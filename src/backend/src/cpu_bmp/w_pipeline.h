@@ -0,0 +1,87 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Tile pipeline (unsharp masking followed by tone curve) worker thread header.
+*/
+
+#ifndef IMPPG_TILE_PIPELINE_WORKER_THREAD_H
+#define IMPPG_TILE_PIPELINE_WORKER_THREAD_H
+
+#include "backend/processing_plan.h"
+#include "common/proc_settings.h"
+#include "cpu_bmp/worker.h"
+#include "math_utils/convolution.h"
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace imppg::backend {
+
+/// Performs unsharp masking (one or more masks) and applies the tone curve.
+/** Each unsharp mask is applied to the whole image (the output of the preceding one), so that the results
+    are the same as when the steps are performed separately.
+
+    Worker parameters: `input` is the sharpening (or preceding unsharp masking) output,
+    `output` receives the tone-mapped result. */
+class c_TilePipelineThread: public IWorkerThread
+{
+public:
+    struct UnsharpMaskStage
+    {
+        UnsharpMask unsharpMask;
+        std::array<float, 4> transitionCurve; ///< See `GetAdaptiveUnshMaskTransitionCurve`.
+        std::vector<c_View<IImageBuffer>> output; ///< Luminance or R, G, B channels.
+    };
+
+    c_TilePipelineThread(
+        WorkerParameters&& params,
+        std::optional<c_View<const IImageBuffer>>&& blurredRawInput, ///< Required if any of the unsharp masks is adaptive.
+        std::vector<UnsharpMaskStage>&& unsharpMaskStages,
+        std::shared_ptr<ProcessingPlan> plan, ///< Provides the Gaussian convolutions, tone curve and work buffers.
+        bool usePreciseToneCurveValues ///< If 'false', the approximated curve's values will be used.
+    );
+
+private:
+    void DoWork() override;
+
+    /// Performs unsharp masking of `input`; returns 'false' if aborted.
+    bool ApplyUnsharpMask(
+        const std::vector<c_PaddedArrayPtr<const float>>& input,
+        UnsharpMaskStage& stage,
+        const AbortCheck& checkAbort
+    );
+
+    /// Applies tone curve to `input`.
+    void ApplyToneCurve(const std::vector<c_PaddedArrayPtr<const float>>& input);
+
+    std::optional<c_View<const IImageBuffer>> m_BlurredRawInput; ///< Raw/original image fragment smoothed to alleviate noise.
+
+    std::vector<UnsharpMaskStage> m_UnsharpMaskStages;
+
+    std::shared_ptr<ProcessingPlan> m_Plan;
+
+    bool m_UsePreciseToneCurveValues;
+};
+
+} // namespace imppg::backend
+
+#endif
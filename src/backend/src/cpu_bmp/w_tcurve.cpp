@@ -31,10 +31,10 @@ namespace imppg::backend {
 
 c_ToneCurveThread::c_ToneCurveThread(
     WorkerParameters&& params,
-    const c_ToneCurve& toneCurve,   ///< Tone curve to apply to 'output'; an internal copy will be created
+    std::shared_ptr<ProcessingPlan> plan, ///< Provides the tone curve to apply to 'output'.
     bool usePreciseValues           ///< If 'false', the approximated curve's values will be used
 ): IWorkerThread(std::move(params)),
-   toneCurve(toneCurve),
+   m_Plan(std::move(plan)),
    m_UsePreciseValues(usePreciseValues)
 {
 }
@@ -42,7 +42,7 @@ c_ToneCurveThread::c_ToneCurveThread(
 void c_ToneCurveThread::DoWork()
 {
     wxDateTime tstart = wxDateTime::UNow();
-    toneCurve.RefreshLut();
+    const c_ToneCurve& toneCurve = m_Plan->GetToneCurve();
 
     const std::size_t numChannels = m_Params.input.size();
 
@@ -82,7 +82,10 @@ void c_ToneCurveThread::DoWork()
             }
 
             if (IsAbortRequested())
-                break;
+            {
+                Log::Print(wxString::Format("Applying of tone curve aborted after %s s\n", (wxDateTime::UNow() - tstart).Format("%S.%l")));
+                return;
+            }
         }
     }
     Log::Print(wxString::Format("Applying of tone curve finished in %s s\n", (wxDateTime::UNow() - tstart).Format("%S.%l")));
@@ -24,8 +24,10 @@ File description:
 #ifndef IMPPG_TONE_CURVE_WORKER_THREAD_H
 #define IMPPG_TONE_CURVE_WORKER_THREAD_H
 
+#include "backend/processing_plan.h"
 #include "cpu_bmp/worker.h"
-#include "common/tcrv.h"
+
+#include <memory>
 
 namespace imppg::backend {
 
@@ -33,13 +35,13 @@ class c_ToneCurveThread: public IWorkerThread
 {
     void DoWork() override;
 
-    c_ToneCurve toneCurve;
+    std::shared_ptr<ProcessingPlan> m_Plan;
     bool m_UsePreciseValues;
 
 public:
     c_ToneCurveThread(
         WorkerParameters&& params,
-        const c_ToneCurve &toneCurve,   ///< Tone curve to apply to 'output'; an internal copy will be created
+        std::shared_ptr<ProcessingPlan> plan, ///< Provides the tone curve to apply to 'output'.
         bool usePreciseValues           ///< If 'false', the approximated curve's values will be used
     );
 
@@ -26,11 +26,21 @@ File description:
 #include "cpu_bmp/message_ids.h"
 #include "logging/logging.h"
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 namespace imppg::backend {
 
 wxThread::ExitCode IWorkerThread::Entry()
 {
     Log::Print(wxString::Format("Worker thread (id = %d): started work\n", m_Params.threadId));
+#if defined(_OPENMP)
+    if (m_Params.maxThreadCount > 0)
+    {
+        omp_set_num_threads(static_cast<int>(m_Params.maxThreadCount));
+    }
+#endif
     DoWork();
     Log::Print(wxString::Format("Worker thread (id = %d): work finished\n", m_Params.threadId));
 
@@ -55,6 +55,7 @@ struct WorkerParameters
     std::vector<c_View<const IImageBuffer>> input; ///< Image fragment to process (luminance or R, G, B channels).
     std::vector<c_View<IImageBuffer>> output; ///< Output image (luminance or R, G, B channels).
     int threadId; ///< Unique thread id (not reused by new threads).
+    unsigned maxThreadCount; ///< Max number of (OpenMP) threads to use for processing; 0 means: no limit.
 };
 
 /// Base class representing a worker thread performing processing in the background.
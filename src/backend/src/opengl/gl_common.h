@@ -24,6 +24,8 @@ File description:
 #ifndef IMPPG_GL_COMMON_H
 #define IMPPG_GL_COMMON_H
 
+#include "image/image.h"
+
 #include <GL/glew.h>
 
 namespace imppg::backend::gl {
@@ -64,6 +66,13 @@ inline void SpecifyVertexAttribPointers()
     );
 }
 
+/// Returns the number of pixels between starts of consecutive rows of `buf` (for GL_[UN]PACK_ROW_LENGTH).
+inline GLint GetRowLength(const IImageBuffer& buf)
+{
+    IMPPG_ASSERT(buf.GetBytesPerRow() % buf.GetBytesPerPixel() == 0);
+    return static_cast<GLint>(buf.GetBytesPerRow() / buf.GetBytesPerPixel());
+}
+
 } // namespace imppg::backend::gl
 
 #endif  // IMPPG_GL_COMMON_H
@@ -153,23 +153,35 @@ public:
     c_Texture& operator=(c_Texture&&)      = default;
 
     /// Creates a rectangle texture.
-    static c_Texture Create(GLsizei width, GLsizei height, const GLvoid* data, bool linearInterpolation, bool mono)
+    /** @param rowLength Number of pixels between starts of consecutive rows of `data`; 0 means `width`. */
+    static c_Texture Create(GLsizei width, GLsizei height, const GLvoid* data, bool linearInterpolation, bool mono, GLint rowLength = 0)
     {
         // using RGBA instead of just RGB, because Intel HD Graphics 5500 (Broadwell GT2) + Mesa 11.1.0 (git-525f3c2)
         // cannot create a framebuffer with RGB32F color attachments
         GLenum format = mono ? GL_RED : GL_RGB;
         GLenum internalFormat = mono ? GL_R32F : GL_RGBA32F;
 
-        return c_Texture(internalFormat, width, height, format, GL_FLOAT, data, linearInterpolation);
+        return c_Texture(internalFormat, width, height, format, GL_FLOAT, data, linearInterpolation, rowLength);
     }
 
     /// Creates a rectangle texture.
-    c_Texture(GLint internalFormat, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* data, bool linearInterpolation = false)
+    c_Texture(
+        GLint internalFormat,
+        GLsizei width,
+        GLsizei height,
+        GLenum format,
+        GLenum type,
+        const GLvoid* data,
+        bool linearInterpolation = false,
+        GLint rowLength = 0 ///< Number of pixels between starts of consecutive rows of `data`; 0 means `width`.
+    )
     {
         glGenTextures(1, &m_Texture.Get());
         IMPPG_ASSERT(m_Texture);
         glBindTexture(GL_TEXTURE_RECTANGLE, m_Texture.Get());
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
         glTexImage2D(GL_TEXTURE_RECTANGLE, 0, internalFormat, width, height, 0, format, type, data);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
         const GLint interpolation = linearInterpolation ? GL_LINEAR : GL_NEAREST;
         glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MIN_FILTER, interpolation);
@@ -193,6 +205,17 @@ public:
     int GetHeight() const { return m_Height; }
 
     GLuint Get() const { return m_Texture.GetConst(); }
+
+    /// Reads the texture's contents as floats into `dest`.
+    /** @param rowLength Number of pixels between starts of consecutive rows of `dest`; 0 means texture's width. */
+    void ReadAsFloat(GLenum format, GLvoid* dest, GLint rowLength = 0) const
+    {
+        glBindTexture(GL_TEXTURE_RECTANGLE, m_Texture.GetConst());
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glPixelStorei(GL_PACK_ROW_LENGTH, rowLength);
+        glGetTexImage(GL_TEXTURE_RECTANGLE, 0, format, GL_FLOAT, dest);
+        glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    }
 };
 
 class c_Shader
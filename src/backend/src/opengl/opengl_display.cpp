@@ -374,9 +374,7 @@ Histogram c_OpenGLDisplay::GetHistogram()
     {
         const auto pixFmt = m_Img->GetPixelFormat();
         c_Image img(unshMaskOutput->GetWidth(), unshMaskOutput->GetHeight(), pixFmt);
-        glBindTexture(GL_TEXTURE_RECTANGLE, unshMaskOutput->Get());
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glGetTexImage(GL_TEXTURE_RECTANGLE, 0, IsMono(pixFmt) ? GL_RED : GL_RGB, GL_FLOAT, img.GetRow(0));
+        unshMaskOutput->ReadAsFloat(IsMono(pixFmt) ? GL_RED : GL_RGB, img.GetRow(0), gl::GetRowLength(std::as_const(img).GetBuffer()));
         return DetermineHistogram(img, img.GetImageRect());
     }
     else if (m_Img.has_value())
@@ -30,6 +30,7 @@ File description:
 #include "common/imppg_assert.h"
 
 #include <array>
+#include <utility>
 #include <vector>
 
 namespace imppg::backend {
@@ -76,9 +77,8 @@ const c_Image& c_OpenGLProcessing::GetProcessedOutput()
         const gl::c_Texture& srcTex = m_TexFBOs.toneCurve.tex;
         const auto pixFmt = m_Img->GetPixelFormat();
         m_ProcessedOutput = c_Image(srcTex.GetWidth(), srcTex.GetHeight(), pixFmt);
-        glBindTexture(GL_TEXTURE_RECTANGLE, srcTex.Get());
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glGetTexImage(GL_TEXTURE_RECTANGLE, 0, IsMono(pixFmt) ? GL_RED : GL_RGB, GL_FLOAT, m_ProcessedOutput.value().GetRow(0));
+        auto& outBuf = m_ProcessedOutput.value().GetBuffer();
+        srcTex.ReadAsFloat(IsMono(pixFmt) ? GL_RED : GL_RGB, outBuf.GetRow(0), gl::GetRowLength(outBuf));
     }
 
     return m_ProcessedOutput.value();
@@ -613,19 +613,13 @@ void c_OpenGLProcessing::SetImage(c_Image img, bool linearInterpolation)
     };
     gl::c_Buffer wholeImageVBO = gl::c_Buffer(GL_ARRAY_BUFFER, vertexDataImg, sizeof(vertexDataImg), GL_DYNAMIC_DRAW);
 
-    /// Only buffers with no row padding are currently accepted.
-    ///
-    /// To change it, use appropriate glPixelStore* calls in `c_Texture` constructor
-    /// before calling `glTexImage2D`.
-    IMPPG_ASSERT(m_Img->GetBuffer().GetBytesPerRow() ==
-        m_Img->GetWidth() * NumChannels[static_cast<std::size_t>(m_Img->GetPixelFormat())] * sizeof(float));
-
     m_OriginalImg = gl::c_Texture::Create(
         m_Img->GetWidth(),
         m_Img->GetHeight(),
-        m_Img->GetBuffer().GetRow(0),
+        std::as_const(m_Img)->GetBuffer().GetRow(0),
         linearInterpolation,
-        IsMono(m_Img->GetPixelFormat())
+        IsMono(m_Img->GetPixelFormat()),
+        gl::GetRowLength(std::as_const(m_Img)->GetBuffer())
     );
 
     InitTextureAndFBO(m_TexFBOs.inputBlurred, m_Img->GetImageRect().GetSize());
@@ -750,9 +744,7 @@ c_Image c_OpenGLProcessing::GetProcessedSelection()
 
     const auto pixFmt = m_Img->GetPixelFormat();
     c_Image img(srcTex->GetWidth(), srcTex->GetHeight(), pixFmt);
-    glBindTexture(GL_TEXTURE_RECTANGLE, srcTex->Get());
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glGetTexImage(GL_TEXTURE_RECTANGLE, 0, IsMono(pixFmt) ? GL_RED : GL_RGB, GL_FLOAT, img.GetRow(0));
+    srcTex->ReadAsFloat(IsMono(pixFmt) ? GL_RED : GL_RGB, img.GetRow(0), gl::GetRowLength(std::as_const(img).GetBuffer()));
 
     return img;
 }
@@ -764,7 +756,7 @@ void c_OpenGLProcessing::BlurForDeringing(double sigma)
     if (IsMono(m_Img->GetPixelFormat()))
     {
         BlurThresholdVicinity(
-            c_View<const IImageBuffer>(m_Img->GetBuffer(), m_Selection),
+            c_View<const IImageBuffer>(std::as_const(m_Img)->GetBuffer(), m_Selection),
             c_View(m_BlurredForDeringing.image.value().GetBuffer()),
             m_BlurredForDeringing.workBuf,
             DERINGING_BRIGHTNESS_THRESHOLD,
@@ -790,7 +782,7 @@ void c_OpenGLProcessing::BlurForDeringing(double sigma)
         for (int i = 0; i < 3; ++i)
         {
             BlurThresholdVicinity(
-                c_View<const IImageBuffer>(inChannel.at(i).GetBuffer(), m_Selection),
+                c_View<const IImageBuffer>(std::as_const(inChannel).at(i).GetBuffer(), m_Selection),
                 c_View(outChannel.at(i).GetBuffer()),
                 m_BlurredForDeringing.workBuf,
                 DERINGING_BRIGHTNESS_THRESHOLD,
@@ -804,9 +796,10 @@ void c_OpenGLProcessing::BlurForDeringing(double sigma)
     m_BlurredForDeringing.texture = gl::c_Texture::Create(
         m_BlurredForDeringing.image.value().GetWidth(),
         m_BlurredForDeringing.image.value().GetHeight(),
-        m_BlurredForDeringing.image.value().GetBuffer().GetRow(0),
+        std::as_const(m_BlurredForDeringing.image).value().GetBuffer().GetRow(0),
         false,
-        IsMono(m_Img->GetPixelFormat())
+        IsMono(m_Img->GetPixelFormat()),
+        gl::GetRowLength(std::as_const(m_BlurredForDeringing.image).value().GetBuffer())
     );
 }
 
@@ -39,6 +39,8 @@ class c_OpenGLProcessing: public IProcessingBackEnd
 public:
     // IProcessingBackEnd functions ---------------------------------------------------------------
 
+    using IProcessingBackEnd::StartProcessing;
+
     void StartProcessing(c_Image img, ProcessingSettings procSettings) override;
 
     void SetProcessingCompletedHandler(std::function<void(CompletionStatus)> handler) override;
@@ -0,0 +1,148 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Processing plan implementation.
+*/
+
+#include "backend/processing_plan.h"
+#include "common/common.h"
+#include "common/imppg_assert.h"
+#include "math_utils/convolution.h"
+
+#include <algorithm>
+
+namespace imppg::backend {
+
+ProcessingPlan::ProcessingPlan(const ProcessingSettings& settings, unsigned width, unsigned height)
+{
+    Update(settings);
+
+    // Compile everything up front, so that the first processed image does not pay for it.
+    const std::size_t numPixels = static_cast<std::size_t>(width) * height;
+    for (const float sigma: GetRequiredSigmas())
+    {
+        auto& gaussian = GetGaussian(sigma);
+        if (numPixels > 0) { gaussian.Reserve(numPixels); }
+    }
+    GetToneCurve();
+    if (numPixels > 0)
+    {
+        // enough for a padded image and its padded transposition
+        const std::size_t numElements = std::max(
+            GetPaddedRowStride(width, sizeof(float)) * height,
+            GetPaddedRowStride(height, sizeof(float)) * width
+        ) / sizeof(float);
+
+        for (std::size_t i = 0; i < NUM_SCRATCH_BUFFERS; ++i)
+        {
+            GetScratchBuffer(i, numElements);
+        }
+    }
+}
+
+ProcessingPlan::~ProcessingPlan() = default;
+
+std::vector<float> ProcessingPlan::GetRequiredSigmas() const
+{
+    std::vector<float> sigmas;
+
+    if (m_Settings.LucyRichardson.iterations > 0)
+    {
+        sigmas.push_back(m_Settings.LucyRichardson.sigma);
+    }
+    for (const auto& um: m_Settings.unsharpMask)
+    {
+        if (um.IsEffective()) { sigmas.push_back(um.sigma); }
+    }
+    if (m_Settings.AdaptiveUnshMaskEnabled())
+    {
+        sigmas.push_back(RAW_IMAGE_BLUR_SIGMA_FOR_ADAPTIVE_UNSHARP_MASK);
+    }
+
+    return sigmas;
+}
+
+void ProcessingPlan::Update(const ProcessingSettings& settings)
+{
+    if (!m_TransitionCurves.empty() && settings == m_Settings)
+    {
+        return;
+    }
+
+    if (!(settings.toneCurve == m_Settings.toneCurve))
+    {
+        m_ToneCurveLutValid = false;
+    }
+
+    m_Settings = settings;
+
+    // Discard the convolutions no longer needed; new ones are compiled on first use.
+    const auto required = GetRequiredSigmas();
+    for (auto it = m_Gaussians.begin(); it != m_Gaussians.end();)
+    {
+        if (std::find(required.begin(), required.end(), it->first) == required.end())
+            it = m_Gaussians.erase(it);
+        else
+            ++it;
+    }
+
+    m_TransitionCurves.clear();
+    for (const auto& um: m_Settings.unsharpMask)
+    {
+        m_TransitionCurves.push_back(GetAdaptiveUnshMaskTransitionCurve(um));
+    }
+}
+
+c_GaussianConvolution& ProcessingPlan::GetGaussian(float sigma)
+{
+    auto& gaussian = m_Gaussians[sigma];
+    if (!gaussian)
+    {
+        gaussian = std::make_unique<c_GaussianConvolution>(sigma);
+    }
+
+    return *gaussian;
+}
+
+const c_ToneCurve& ProcessingPlan::GetToneCurve()
+{
+    if (!m_ToneCurveLutValid)
+    {
+        m_ToneCurve = m_Settings.toneCurve;
+        m_ToneCurve.RefreshLut();
+        m_ToneCurveLutValid = true;
+    }
+
+    return m_ToneCurve;
+}
+
+float* ProcessingPlan::GetScratchBuffer(std::size_t idx, std::size_t numElements)
+{
+    auto& buffer = m_ScratchBuffers.at(idx);
+    if (buffer.numElements < numElements)
+    {
+        buffer.storage = AllocateAligned(numElements * sizeof(float));
+        buffer.numElements = numElements;
+    }
+
+    return reinterpret_cast<float*>(buffer.storage.get());
+}
+
+} // namespace imppg::backend
@@ -21,9 +21,8 @@ File description:
     Batch progress dialog implementation.
 */
 
-#include <limits.h>
-#include <optional>
-#include <string>
+#include <cstddef>
+#include <memory>
 #include <wx/button.h>
 #include <wx/dialog.h>
 #include <wx/event.h>
@@ -37,6 +36,7 @@ File description:
 #include "appconfig.h"
 #include "backend/backend.h"
 #include "batch_params.h"
+#include "batch_pipeline.h"
 #include "batch.h"
 #include "ctrl_ids.h"
 #include "image/image.h"
@@ -71,22 +71,14 @@ class c_BatchDialog: public wxDialog
         OutputFormat outputFmt;
     } m_Settings;
 
-    std::optional<size_t> m_CurrentFileIdx; ///< Index of the currently processed file.
+    std::size_t m_NumFilesCompleted{0};
 
-    std::unique_ptr<imppg::backend::IProcessingBackEnd> m_Processor;
+    std::unique_ptr<c_BatchPipeline> m_Pipeline;
 
-    bool m_ProcessNextFile{false};
+    /// Updates the progress string of a file in the files grid
+    void SetProgressInfo(std::size_t fileIdx, wxString info);
 
-    /// Starts processing of the next file
-    void ProcessNextFile();
-
-    /// Updates the progress string in the files grid
-    void SetProgressInfo(wxString info);
-
-    /// Returns 'false' on error
-    bool SaveOutputFile();
-
-    void OnProcessingCompleted(CompletionStatus status);
+    void OnFileCompleted(std::size_t fileIdx, const BatchFileResult& result);
 
 public:
     c_BatchDialog(
@@ -113,7 +105,7 @@ void c_BatchDialog::OnInit(wxInitDialogEvent&)
 {
     if (m_Settings.loadedSuccessfully)
     {
-        ProcessNextFile();
+        m_Pipeline->Start();
     }
 }
 
@@ -124,138 +116,38 @@ void c_BatchDialog::OnIdle(wxIdleEvent& event)
         Close();
     }
 
-    m_Processor->OnIdle(event);
-
-    if (m_ProcessNextFile && m_CurrentFileIdx.has_value() && *m_CurrentFileIdx < m_FileNames.Count())
-    {
-        ProcessNextFile();
-    }
-}
-
-/// Updates the progress string in the files grid
-void c_BatchDialog::SetProgressInfo(wxString info)
-{
-    if (m_CurrentFileIdx.has_value())
+    if (m_Pipeline)
     {
-        m_Grid.SetCellValue(m_CurrentFileIdx.value(), 1, info);
-
-        int newProgressColWidth = m_Grid.GetTextExtent(info).GetWidth() + 10;
-        if (m_Grid.GetColSize(1) < newProgressColWidth)
-            m_Grid.SetColSize(1, newProgressColWidth);
+        m_Pipeline->OnIdle(event);
     }
 }
 
-/// Returns 'false' on error
-bool c_BatchDialog::SaveOutputFile()
+/// Updates the progress string of a file in the files grid
+void c_BatchDialog::SetProgressInfo(std::size_t fileIdx, wxString info)
 {
-    wxFileName fn(m_FileNames[m_CurrentFileIdx.value()]);
-    switch (m_Settings.outputFmt)
-    {
-    case OutputFormat::BMP_8: fn.SetExt("bmp"); break;
-#if USE_FREEIMAGE
-    case OutputFormat::PNG_8: fn.SetExt("png"); break;
-#endif
-
-    case OutputFormat::TIFF_16:
-#if (USE_FREEIMAGE)
-    case OutputFormat::TIFF_8_LZW:
-    case OutputFormat::TIFF_16_ZIP:
-    case OutputFormat::TIFF_32F:
-    case OutputFormat::TIFF_32F_ZIP:
-#endif
-        fn.SetExt("tif");
-        break;
-
-#if USE_CFITSIO
-    case OutputFormat::FITS_8:
-    case OutputFormat::FITS_16:
-    case OutputFormat::FITS_32F:
-        fn.SetExt("fit");
-        break;
-#endif
-
-    default: break;
-    }
-
-    wxString destPath = wxFileName(m_Settings.outputDir, fn.GetName() + "_out", fn.GetExt()).GetFullPath();
-    if (!m_Processor->GetProcessedOutput().SaveToFile(ToFsPath(destPath), m_Settings.outputFmt))
-    {
-        wxMessageBox(wxString::Format(_("Could not save output file: %s"), destPath), _("Error"), wxICON_ERROR, this);
-        m_FileOperationFailure = true;
-        return false;
-    }
+    m_Grid.SetCellValue(fileIdx, 1, info);
 
-    return true;
+    int newProgressColWidth = m_Grid.GetTextExtent(info).GetWidth() + 10;
+    if (m_Grid.GetColSize(1) < newProgressColWidth)
+        m_Grid.SetColSize(1, newProgressColWidth);
 }
 
-void c_BatchDialog::OnProcessingCompleted(CompletionStatus status)
+void c_BatchDialog::OnFileCompleted(std::size_t fileIdx, const BatchFileResult& result)
 {
-    if (status == CompletionStatus::COMPLETED)
+    if (result.success)
     {
-        if (SaveOutputFile())
-        {
-            SetProgressInfo(_("Done"));
-        }
-        else
-        {
-            SetProgressInfo(_("Error"));
-        }
-
-
-        if (m_CurrentFileIdx.value() == m_FileNames.Count() - 1) // was it the last file?
-        {
-            m_ProgressCtrl->SetValue(m_FileNames.Count());
-            m_CurrentFileIdx = std::nullopt;
-            wxMessageBox(_("Processing completed."), _("Information"), wxICON_INFORMATION, this);
-        }
-        else
-        {
-            m_CurrentFileIdx.value() += 1;
-            m_ProcessNextFile = true;
-        }
+        SetProgressInfo(fileIdx, _("Done"));
+        m_NumFilesCompleted += 1;
+        m_ProgressCtrl->SetValue(m_NumFilesCompleted);
     }
     else
     {
-        SetProgressInfo("");
-        m_CurrentFileIdx = std::nullopt;
-    }
-}
-
-void c_BatchDialog::ProcessNextFile()
-{
-    m_ProcessNextFile = false;
-
-    if (!m_CurrentFileIdx.has_value())
-    {
-        m_CurrentFileIdx = 0;
-    }
-
-    m_ProgressCtrl->SetValue(m_CurrentFileIdx.value());
-
-    wxFileName path = wxFileName(m_FileNames[m_CurrentFileIdx.value()]);
-    wxString ext = path.GetExt().Lower();
-    std::string errorMsg;
-
-    auto img = LoadImageFileAs32f(
-        ToFsPath(path.GetFullPath()),
-        Configuration::NormalizeFITSValues,
-        &errorMsg
-    );
-    if (!img.has_value())
-    {
-        wxMessageBox(wxString::Format(_("Could not open file: %s."), path.GetFullPath()) + (errorMsg != "" ? "\n" + errorMsg : ""),
-            _("Error"), wxICON_ERROR, this);
+        SetProgressInfo(fileIdx, _("Error"));
+        // Stop the pipeline first, so that no handlers are called while the message box is shown.
+        m_Pipeline->Abort();
         m_FileOperationFailure = true;
-        return;
+        wxMessageBox(result.errorMsg, _("Error"), wxICON_ERROR, this);
     }
-
-    const auto& proc = m_Settings.procSettings;
-    if (proc.normalization.enabled)
-    {
-        NormalizeFpImage(img.value(), proc.normalization.min, proc.normalization.max);
-    }
-
-    m_Processor->StartProcessing(std::move(img.value()), proc);
 }
 
 void c_BatchDialog::OnCommandEvent(wxCommandEvent& event)
@@ -276,18 +168,6 @@ c_BatchDialog::c_BatchDialog(wxWindow* parent, wxArrayString fileNames,
 : wxDialog(parent, wxID_ANY, _("Batch processing"), wxDefaultPosition, wxDefaultSize,
         wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER)
 {
-    switch (Configuration::ProcessingBackEnd)
-    {
-    case BackEnd::CPU_AND_BITMAPS: m_Processor = imppg::backend::CreateCpuBmpProcessingBackend(); break;
-#if USE_OPENGL_BACKEND
-    case BackEnd::GPU_OPENGL: m_Processor = imppg::backend::CreateOpenGLProcessingBackend(Configuration::LRCmdBatchSizeMpixIters); break;
-#endif
-    default: IMPPG_ABORT();
-    }
-
-    m_Processor->SetProgressTextHandler([this](wxString info) { SetProgressInfo(info); });
-    m_Processor->SetProcessingCompletedHandler([this](CompletionStatus status) { OnProcessingCompleted(status); });
-
     m_FileOperationFailure = false;
 
     m_FileNames = std::move(fileNames);
@@ -307,6 +187,43 @@ c_BatchDialog::c_BatchDialog(wxWindow* parent, wxArrayString fileNames,
     m_Settings.outputDir = outputDirectory;
     m_Settings.outputFmt = outputFormat;
 
+    if (m_Settings.loadedSuccessfully)
+    {
+        const BackEnd backEnd = Configuration::ProcessingBackEnd;
+
+        BatchPipelineLimits limits;
+        // The OpenGL back end processes one file at a time; concurrent files would only compete for the GPU.
+        limits.maxConcurrentFiles = (backEnd == BackEnd::CPU_AND_BITMAPS) ? Configuration::BatchConcurrentFiles : 1;
+        limits.maxThreads = Configuration::BatchMaxThreads;
+        limits.memoryBudget = std::size_t{Configuration::BatchMemoryBudgetMiB} << 20;
+
+        m_Pipeline = std::make_unique<c_BatchPipeline>(
+            m_FileNames,
+            m_Settings.procSettings,
+            m_Settings.outputDir,
+            m_Settings.outputFmt,
+            Configuration::NormalizeFITSValues,
+            limits,
+            [backEnd]() -> std::unique_ptr<IProcessingBackEnd> {
+                switch (backEnd)
+                {
+                case BackEnd::CPU_AND_BITMAPS: return imppg::backend::CreateCpuBmpProcessingBackend();
+#if USE_OPENGL_BACKEND
+                case BackEnd::GPU_OPENGL: return imppg::backend::CreateOpenGLProcessingBackend(Configuration::LRCmdBatchSizeMpixIters);
+#endif
+                default: IMPPG_ABORT();
+                }
+            }
+        );
+
+        m_Pipeline->SetFileProgressHandler([this](std::size_t fileIdx, wxString info) { SetProgressInfo(fileIdx, info); });
+        m_Pipeline->SetFileCompletedHandler([this](std::size_t fileIdx, const BatchFileResult& result) { OnFileCompleted(fileIdx, result); });
+        m_Pipeline->SetFinishedHandler([this]() {
+            m_ProgressCtrl->SetValue(m_FileNames.Count());
+            wxMessageBox(_("Processing completed."), _("Information"), wxICON_INFORMATION, this);
+        });
+    }
+
     InitControls();
 }
 
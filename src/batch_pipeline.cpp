@@ -0,0 +1,370 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Pipelined batch processor implementation.
+*/
+
+#include "batch_pipeline.h"
+#include "common/common.h"
+#include "common/worker_pool.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <string>
+#include <wx/filename.h>
+#include <wx/intl.h>
+
+using namespace imppg::backend;
+
+namespace
+{
+
+double SecondsSince(std::chrono::steady_clock::time_point tstart)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - tstart).count();
+}
+
+std::size_t GetImageNumBytes(const c_Image& image)
+{
+    return image.GetBytesPerRow() * image.GetHeight();
+}
+
+bool IsFitsFile(const wxString& path)
+{
+    const wxString ext = wxFileName(path).GetExt().Lower();
+    return ext == "fit" || ext == "fits";
+}
+
+bool IsFitsFormat(OutputFormat outputFmt)
+{
+    switch (outputFmt)
+    {
+#if USE_CFITSIO
+    case OutputFormat::FITS_8:
+    case OutputFormat::FITS_16:
+    case OutputFormat::FITS_32F:
+        return true;
+#endif
+
+    default: return false;
+    }
+}
+
+}
+
+wxString GetBatchOutputPath(const wxString& inputFile, const wxString& outputDir, OutputFormat outputFmt)
+{
+    wxFileName fn(inputFile);
+    switch (outputFmt)
+    {
+    case OutputFormat::BMP_8: fn.SetExt("bmp"); break;
+#if USE_FREEIMAGE
+    case OutputFormat::PNG_8: fn.SetExt("png"); break;
+#endif
+
+    case OutputFormat::TIFF_16:
+#if (USE_FREEIMAGE)
+    case OutputFormat::TIFF_8_LZW:
+    case OutputFormat::TIFF_16_ZIP:
+    case OutputFormat::TIFF_32F:
+    case OutputFormat::TIFF_32F_ZIP:
+#endif
+        fn.SetExt("tif");
+        break;
+
+#if USE_CFITSIO
+    case OutputFormat::FITS_8:
+    case OutputFormat::FITS_16:
+    case OutputFormat::FITS_32F:
+        fn.SetExt("fit");
+        break;
+#endif
+
+    default: break;
+    }
+
+    return wxFileName(outputDir, fn.GetName() + "_out", fn.GetExt()).GetFullPath();
+}
+
+c_BatchPipeline::c_BatchPipeline(
+    wxArrayString fileNames,
+    ProcessingSettings procSettings,
+    wxString outputDir,
+    OutputFormat outputFmt,
+    bool normalizeFitsValues,
+    BatchPipelineLimits limits,
+    std::function<std::unique_ptr<IProcessingBackEnd>()> createBackEnd
+)
+: m_FileNames(std::move(fileNames)),
+  m_ProcSettings(std::move(procSettings)),
+  m_OutputDir(std::move(outputDir)),
+  m_OutputFmt(outputFmt),
+  m_NormalizeFitsValues(normalizeFitsValues),
+  m_Limits(limits)
+{
+    m_Limits.prefetchQueueLength = std::max<std::size_t>(1, m_Limits.prefetchQueueLength);
+
+    const std::size_t numSlots = std::clamp<std::size_t>(m_Limits.maxConcurrentFiles, 1, std::max<std::size_t>(1, m_FileNames.Count()));
+
+    // With a single file processed at a time, its back end uses `maxThreads` as is (0: the default number of threads)
+    const unsigned threadsPerSlot = (numSlots > 1)
+        ? GetThreadsPerWorker(static_cast<unsigned>(numSlots), m_Limits.maxThreads)
+        : m_Limits.maxThreads;
+
+    m_Slots.resize(numSlots);
+    for (std::size_t slotIdx = 0; slotIdx < numSlots; ++slotIdx)
+    {
+        auto& backEnd = m_Slots[slotIdx].backEnd;
+        backEnd = createBackEnd();
+        backEnd->SetMaxThreadCount(threadsPerSlot);
+        backEnd->SetProgressTextHandler([this, slotIdx](wxString info) {
+            const auto& current = m_Slots[slotIdx].current;
+            if (current.has_value() && m_OnFileProgress)
+            {
+                m_OnFileProgress(current->fileIdx, info);
+            }
+        });
+        backEnd->SetProcessingCompletedHandler([this, slotIdx](CompletionStatus status) {
+            OnSlotProcessingCompleted(slotIdx, status);
+        });
+    }
+
+    Log::Print(wxString::Format("Batch pipeline: %zu concurrent file(s), %u thread(s) per file, memory budget %zu MiB\n",
+        numSlots, threadsPerSlot, m_Limits.memoryBudget >> 20));
+}
+
+c_BatchPipeline::~c_BatchPipeline()
+{
+    Abort();
+}
+
+void c_BatchPipeline::Start()
+{
+    if (m_FileNames.IsEmpty())
+    {
+        m_EvtHandler.CallAfter([this]() { if (m_OnFinished) m_OnFinished(); });
+        return;
+    }
+
+    m_LoaderThread = std::thread(&c_BatchPipeline::LoaderThreadFunc, this);
+    m_WriterThread = std::thread(&c_BatchPipeline::WriterThreadFunc, this);
+}
+
+void c_BatchPipeline::Abort()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        if (m_AbortRequested) { return; }
+        m_AbortRequested = true;
+        m_PrefetchQueue.clear();
+        m_WriteQueue.clear();
+    }
+    m_LoaderCondition.notify_all();
+    m_WriterCondition.notify_all();
+
+    for (auto& slot: m_Slots)
+    {
+        if (slot.current.has_value())
+        {
+            slot.backEnd->AbortProcessing();
+            slot.current.reset();
+        }
+    }
+
+    // Both threads finish their current file operation (if any) and exit.
+    if (m_LoaderThread.joinable()) { m_LoaderThread.join(); }
+    if (m_WriterThread.joinable()) { m_WriterThread.join(); }
+}
+
+void c_BatchPipeline::OnIdle(wxIdleEvent& event)
+{
+    for (auto& slot: m_Slots)
+    {
+        slot.backEnd->OnIdle(event);
+    }
+}
+
+void c_BatchPipeline::LoaderThreadFunc()
+{
+    for (std::size_t fileIdx = 0; fileIdx < m_FileNames.Count(); ++fileIdx)
+    {
+        {
+            std::unique_lock lock(m_Mutex);
+            m_LoaderCondition.wait(lock, [this]() {
+                return m_AbortRequested ||
+                    (m_PrefetchQueue.size() < m_Limits.prefetchQueueLength &&
+                    (m_BytesInUse < m_Limits.memoryBudget || m_BytesInUse == 0));
+            });
+            if (m_AbortRequested) { return; }
+        }
+
+        const auto tstart = std::chrono::steady_clock::now();
+        const wxString path = m_FileNames[fileIdx];
+
+        LoadedImage loaded{fileIdx, std::nullopt, BatchFileResult{}};
+        std::string errorMsg;
+        {
+            std::unique_lock fitsLock(m_FitsIoMutex, std::defer_lock);
+            if (IsFitsFile(path)) { fitsLock.lock(); }
+            loaded.image = LoadImageFileAs32f(
+                ToFsPath(path), m_NormalizeFitsValues, m_ProcSettings.normalization.GetLevels(), &errorMsg
+            );
+        }
+
+        if (!loaded.image.has_value())
+        {
+            loaded.result.errorMsg = wxString::Format(_("Could not open file: %s."), path) + (errorMsg != "" ? "\n" + errorMsg : "");
+        }
+        loaded.result.loadTime = SecondsSince(tstart);
+
+        {
+            std::lock_guard lock(m_Mutex);
+            if (m_AbortRequested) { return; }
+            if (loaded.image.has_value()) { m_BytesInUse += GetImageNumBytes(*loaded.image); }
+            m_PrefetchQueue.push_back(std::move(loaded));
+        }
+        m_EvtHandler.CallAfter([this]() { DispatchLoadedImages(); });
+    }
+}
+
+void c_BatchPipeline::WriterThreadFunc()
+{
+    while (true)
+    {
+        std::optional<ProcessedImage> processed;
+        {
+            std::unique_lock lock(m_Mutex);
+            m_WriterCondition.wait(lock, [this]() { return m_AbortRequested || !m_WriteQueue.empty(); });
+            if (m_AbortRequested) { return; }
+            processed = std::move(m_WriteQueue.front());
+            m_WriteQueue.pop_front();
+        }
+
+        const auto tstart = std::chrono::steady_clock::now();
+        BatchFileResult& result = processed->result;
+
+        bool saved = false;
+        {
+            std::unique_lock fitsLock(m_FitsIoMutex, std::defer_lock);
+            if (IsFitsFormat(m_OutputFmt)) { fitsLock.lock(); }
+            saved = processed->image.SaveToFile(ToFsPath(result.outputPath), m_OutputFmt);
+        }
+
+        result.success = saved;
+        if (!saved)
+        {
+            result.errorMsg = wxString::Format(_("Could not save output file: %s"), result.outputPath);
+        }
+        result.saveTime = SecondsSince(tstart);
+
+        const std::size_t fileIdx = processed->fileIdx;
+        const std::size_t numBytes = GetImageNumBytes(processed->image);
+        processed.reset();
+        {
+            std::lock_guard lock(m_Mutex);
+            if (m_AbortRequested) { return; }
+            m_BytesInUse -= numBytes;
+        }
+        m_LoaderCondition.notify_one();
+
+        m_EvtHandler.CallAfter([this, fileIdx, result]() { OnFileCompleted(fileIdx, result); });
+    }
+}
+
+void c_BatchPipeline::DispatchLoadedImages()
+{
+    for (auto& slot: m_Slots)
+    {
+        while (!slot.current.has_value())
+        {
+            std::optional<LoadedImage> loaded;
+            {
+                std::lock_guard lock(m_Mutex);
+                if (m_AbortRequested || m_PrefetchQueue.empty()) { return; }
+                loaded = std::move(m_PrefetchQueue.front());
+                m_PrefetchQueue.pop_front();
+            }
+            m_LoaderCondition.notify_one();
+
+            if (!loaded->image.has_value())
+            {
+                OnFileCompleted(loaded->fileIdx, loaded->result);
+                continue;
+            }
+
+            slot.inputBytes = GetImageNumBytes(*loaded->image);
+            slot.startTime = std::chrono::steady_clock::now();
+            c_Image image = std::move(*loaded->image);
+            loaded->image.reset();
+            slot.current = std::move(loaded);
+            if (!slot.plan)
+            {
+                slot.plan = std::make_shared<imppg::backend::ProcessingPlan>(m_ProcSettings, image.GetWidth(), image.GetHeight());
+            }
+            slot.backEnd->StartProcessing(std::move(image), slot.plan);
+        }
+    }
+}
+
+void c_BatchPipeline::OnSlotProcessingCompleted(std::size_t slotIdx, CompletionStatus status)
+{
+    Slot& slot = m_Slots[slotIdx];
+    if (m_AbortRequested || !slot.current.has_value() || status != CompletionStatus::COMPLETED)
+    {
+        return;
+    }
+
+    ProcessedImage processed{slot.current->fileIdx, slot.backEnd->GetProcessedOutput(), std::move(slot.current->result)};
+    slot.current.reset();
+    processed.result.processingTime = SecondsSince(slot.startTime);
+    processed.result.outputPath = GetBatchOutputPath(m_FileNames[processed.fileIdx], m_OutputDir, m_OutputFmt);
+
+    if (m_OnFileProgress) { m_OnFileProgress(processed.fileIdx, _("Saving...")); }
+
+    {
+        std::lock_guard lock(m_Mutex);
+        // The back end no longer needs the input image; the output copy is owned by the write queue.
+        m_BytesInUse = m_BytesInUse - slot.inputBytes + GetImageNumBytes(processed.image);
+        m_WriteQueue.push_back(std::move(processed));
+    }
+    slot.inputBytes = 0;
+    m_WriterCondition.notify_one();
+    m_LoaderCondition.notify_one();
+
+    // Do not start the next file from within the back end's completion handler.
+    m_EvtHandler.CallAfter([this]() { DispatchLoadedImages(); });
+}
+
+void c_BatchPipeline::OnFileCompleted(std::size_t fileIdx, const BatchFileResult& result)
+{
+    if (m_AbortRequested) { return; }
+
+    m_NumFilesCompleted += 1;
+
+    Log::Print(wxString::Format("Batch: file %zu: load %.3f s, processing %.3f s, save %.3f s%s\n",
+        fileIdx, result.loadTime, result.processingTime, result.saveTime, result.success ? "" : " (failed)"));
+
+    if (m_OnFileCompleted) { m_OnFileCompleted(fileIdx, result); }
+
+    if (!m_AbortRequested && m_NumFilesCompleted == m_FileNames.Count() && m_OnFinished)
+    {
+        m_OnFinished();
+    }
+}
@@ -0,0 +1,194 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Pipelined batch processor header.
+*/
+
+#ifndef IMPPG_BATCH_PIPELINE_H
+#define IMPPG_BATCH_PIPELINE_H
+
+#include "backend/backend.h"
+#include "common/formats.h"
+#include "common/proc_settings.h"
+#include "image/image.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <wx/arrstr.h>
+#include <wx/event.h>
+#include <wx/string.h>
+
+struct BatchPipelineLimits
+{
+    /// Number of files processed concurrently (each by a separate back end instance).
+    unsigned maxConcurrentFiles{1};
+
+    /// Total number of processing threads shared by all concurrently processed files; 0 means: number of hardware threads.
+    unsigned maxThreads{0};
+
+    /// Max total size (in bytes) of decoded input and processed output images held by the pipeline.
+    /** At least one image is always admitted, even if it exceeds the budget. */
+    std::size_t memoryBudget{std::size_t{2} << 30};
+
+    /// Max number of decoded images waiting for processing.
+    std::size_t prefetchQueueLength{2};
+};
+
+struct BatchFileResult
+{
+    bool success{false};
+    wxString errorMsg; ///< Empty on success.
+    wxString outputPath;
+
+    // Durations (in seconds) of the processing stages.
+    double loadTime{0.0};
+    double processingTime{0.0};
+    double saveTime{0.0};
+};
+
+/// Returns the path of the output file corresponding to `inputFile`.
+wxString GetBatchOutputPath(const wxString& inputFile, const wxString& outputDir, OutputFormat outputFmt);
+
+/// Processes a list of image files using a three-stage pipeline.
+/** Stages:
+      - loader thread: decodes the input files in order into a bounded prefetch queue;
+      - processing: up to `BatchPipelineLimits::maxConcurrentFiles` files are processed at a time,
+        each by its own `IProcessingBackEnd` (controlled from the main thread);
+      - writer thread: saves the processed images.
+
+    All handlers are called from the main thread. The main thread's event loop must be running
+    and `OnIdle` must be called from its "on idle" handler. */
+class c_BatchPipeline
+{
+public:
+    c_BatchPipeline(
+        wxArrayString fileNames,
+        ProcessingSettings procSettings,
+        wxString outputDir,
+        OutputFormat outputFmt,
+        bool normalizeFitsValues,
+        BatchPipelineLimits limits,
+        /// Creates a processing back end; called once for each of the concurrently processed files.
+        std::function<std::unique_ptr<imppg::backend::IProcessingBackEnd>()> createBackEnd
+    );
+
+    c_BatchPipeline(const c_BatchPipeline&) = delete;
+    c_BatchPipeline& operator=(const c_BatchPipeline&) = delete;
+    c_BatchPipeline(c_BatchPipeline&&) = delete;
+    c_BatchPipeline& operator=(c_BatchPipeline&&) = delete;
+
+    /// Aborts processing (if still in progress).
+    ~c_BatchPipeline();
+
+    /// Called when the progress text of a file changes.
+    void SetFileProgressHandler(std::function<void(std::size_t fileIdx, wxString info)> handler) { m_OnFileProgress = handler; }
+
+    /// Called when a file has been saved or has failed to load, process or save.
+    void SetFileCompletedHandler(std::function<void(std::size_t fileIdx, const BatchFileResult&)> handler) { m_OnFileCompleted = handler; }
+
+    /// Called after all files have completed.
+    void SetFinishedHandler(std::function<void()> handler) { m_OnFinished = handler; }
+
+    void Start();
+
+    /// Stops all stages; no more handlers will be called.
+    void Abort();
+
+    void OnIdle(wxIdleEvent& event);
+
+private:
+    struct LoadedImage
+    {
+        std::size_t fileIdx;
+        std::optional<c_Image> image; ///< Empty if loading failed.
+        BatchFileResult result;
+    };
+
+    struct ProcessedImage
+    {
+        std::size_t fileIdx;
+        c_Image image;
+        BatchFileResult result;
+    };
+
+    struct Slot
+    {
+        std::unique_ptr<imppg::backend::IProcessingBackEnd> backEnd;
+        std::shared_ptr<imppg::backend::ProcessingPlan> plan; ///< Compiled once, reused for all files processed by `backEnd`.
+        std::optional<LoadedImage> current; ///< File being processed (`image` has been passed to the back end).
+        std::size_t inputBytes{0};
+        std::chrono::steady_clock::time_point startTime;
+    };
+
+    void LoaderThreadFunc();
+
+    void WriterThreadFunc();
+
+    /// Passes images from the prefetch queue to idle slots.
+    void DispatchLoadedImages();
+
+    void OnSlotProcessingCompleted(std::size_t slotIdx, imppg::backend::CompletionStatus status);
+
+    void OnFileCompleted(std::size_t fileIdx, const BatchFileResult& result);
+
+    wxArrayString m_FileNames;
+    ProcessingSettings m_ProcSettings;
+    wxString m_OutputDir;
+    OutputFormat m_OutputFmt;
+    bool m_NormalizeFitsValues;
+    BatchPipelineLimits m_Limits;
+
+    std::vector<Slot> m_Slots;
+
+    std::size_t m_NumFilesCompleted{0};
+
+    wxEvtHandler m_EvtHandler; ///< Receives calls queued by the loader and writer threads.
+
+    std::thread m_LoaderThread;
+    std::thread m_WriterThread;
+
+    std::mutex m_FitsIoMutex; ///< Serializes FITS loading and saving (CFITSIO is not necessarily built as reentrant).
+
+    // Guarded by `m_Mutex` ------------------------------------------
+
+    std::mutex m_Mutex;
+    std::condition_variable m_LoaderCondition; ///< Signalled when prefetch queue space or memory is released.
+    std::condition_variable m_WriterCondition; ///< Signalled when an image is added to `m_WriteQueue`.
+    std::deque<LoadedImage> m_PrefetchQueue;
+    std::deque<ProcessedImage> m_WriteQueue;
+    std::size_t m_BytesInUse{0}; ///< Total size of images held by the pipeline.
+    bool m_AbortRequested{false};
+
+    // ---------------------------------------------------------------
+
+    std::function<void(std::size_t, wxString)> m_OnFileProgress;
+    std::function<void(std::size_t, const BatchFileResult&)> m_OnFileCompleted;
+    std::function<void()> m_OnFinished;
+};
+
+#endif // IMPPG_BATCH_PIPELINE_H
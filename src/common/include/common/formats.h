@@ -23,6 +23,7 @@ File description:
 #ifndef IMPPG_FORMATS_HEADER
 #define IMPPG_FORMATS_HEADER
 
+#include <optional>
 #include <string>
 #include <wx/translation.h>
 
@@ -87,4 +88,7 @@ wxString GetOutputFormatDescription(OutputFormat fmt, wxString* wildcard = nullp
 /// Returns output filters suitable for use in a File Save dialog
 wxString GetOutputFilters();
 
+/// Returns the output format identified by its enumerator name (e.g., "TIFF_16"); case-insensitive.
+std::optional<OutputFormat> GetOutputFormatFromName(const wxString& name);
+
 #endif // IMPPG_FORMATS_HEADER
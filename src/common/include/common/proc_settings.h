@@ -27,7 +27,9 @@ File description:
 #include "common/tcrv.h"
 
 #include <array>
+#include <optional>
 #include <string>
+#include <tuple>
 #include <vector>
 #include <wx/stream.h>
 #include <wx/string.h>
@@ -75,6 +77,13 @@ struct ProcessingSettings
     {
         bool enabled{false};
         float min{0.0}, max{1.0};
+
+        /// Returns (min, max) if normalization is enabled.
+        std::optional<std::tuple<float, float>> GetLevels() const
+        {
+            if (enabled) { return std::make_tuple(min, max); }
+            else { return std::nullopt; }
+        }
     } normalization;
 
     struct
@@ -96,7 +96,7 @@ public:
 
     /// Tone-maps `input` to `output` using approximated tone curve values.
     /** LUT is not calculated automatically. Caller must call RefreshLut() after any update to the curve before using this method. */
-    void ApplyApproximatedToneCurve(const float input[], float output[], size_t length)
+    void ApplyApproximatedToneCurve(const float input[], float output[], size_t length) const
     {
         IMPPG_ASSERT(m_LUT.has_value());
         for (size_t i = 0; i < length; i++)
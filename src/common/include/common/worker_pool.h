@@ -0,0 +1,89 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Pool of worker threads processing numbered work items.
+*/
+
+#ifndef IMPPG_WORKER_POOL_H
+#define IMPPG_WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/// Returns the number of threads for parallelized operations of each of `numWorkers` concurrent workers.
+/** `totalThreads` (0 means: number of hardware threads) is split evenly between the workers, so that together
+    they do not oversubscribe the CPU. Returns at least 1. */
+unsigned GetThreadsPerWorker(unsigned numWorkers, unsigned totalThreads = 0);
+
+/// Sets the number of OpenMP threads used by parallel regions started from the calling thread.
+void SetThreadCount(unsigned numThreads);
+
+/// Pool of worker threads processing work items 0, 1, ..., `numItems` - 1.
+/** Each worker sets its number of threads (see `GetThreadsPerWorker`) and calls the worker function, which
+    processes the items returned by `Claim` until it returns an empty value. Items are claimed in order,
+    but only the ones below the claim limit (`numItems` unless set with `SetClaimLimit`). */
+class c_WorkerPool
+{
+public:
+    explicit c_WorkerPool(std::size_t numItems);
+
+    c_WorkerPool(const c_WorkerPool&) = delete;
+    c_WorkerPool& operator=(const c_WorkerPool&) = delete;
+
+    ~c_WorkerPool(); ///< Calls `Stop`.
+
+    /// Starts `numWorkers` workers sharing `totalThreads` threads (0 means: number of hardware threads).
+    void Start(unsigned numWorkers, unsigned totalThreads, std::function<void ()> workerFunc);
+
+    /// Returns the index of the next item to process; waits while it is not below the claim limit.
+    /** Returns an empty value if all items have been claimed or stop has been requested. */
+    std::optional<std::size_t> Claim();
+
+    /// Allows claiming items with indices below `limit`.
+    void SetClaimLimit(std::size_t limit);
+
+    /// Makes `Claim` return an empty value; the workers finish their current items.
+    void RequestStop();
+
+    /// Requests stop and waits for the workers to finish.
+    void Stop();
+
+private:
+    const std::size_t m_NumItems;
+
+    std::vector<std::thread> m_Workers;
+
+    // Guarded by `m_Mutex` ------------------------------------------
+
+    std::mutex m_Mutex;
+    std::condition_variable m_ClaimCondition; ///< Signalled when the claim limit is raised or stop is requested.
+    std::size_t m_NextToClaim{0};
+    std::size_t m_ClaimLimit;
+    bool m_StopRequested{false};
+
+    // ---------------------------------------------------------------
+};
+
+#endif // IMPPG_WORKER_POOL_H
@@ -21,6 +21,7 @@ File description:
     Supported file formats.
 */
 
+#include <utility>
 #include <wx/string.h>
 
 #include "common/formats.h"
@@ -125,3 +126,34 @@ wxString GetOutputFilters()
 
     return filters;
 }
+
+std::optional<OutputFormat> GetOutputFormatFromName(const wxString& name)
+{
+    const std::pair<const char*, OutputFormat> names[] =
+    {
+        { "BMP_8",        OutputFormat::BMP_8 },
+        { "TIFF_16",      OutputFormat::TIFF_16 },
+#if USE_FREEIMAGE
+        { "PNG_8",        OutputFormat::PNG_8 },
+        { "TIFF_8_LZW",   OutputFormat::TIFF_8_LZW },
+        { "TIFF_16_ZIP",  OutputFormat::TIFF_16_ZIP },
+        { "TIFF_32F",     OutputFormat::TIFF_32F },
+        { "TIFF_32F_ZIP", OutputFormat::TIFF_32F_ZIP },
+#endif
+#if USE_CFITSIO
+        { "FITS_8",       OutputFormat::FITS_8 },
+        { "FITS_16",      OutputFormat::FITS_16 },
+        { "FITS_32F",     OutputFormat::FITS_32F },
+#endif
+    };
+
+    for (const auto& [fmtName, fmt]: names)
+    {
+        if (name.IsSameAs(fmtName, false))
+        {
+            return fmt;
+        }
+    }
+
+    return std::nullopt;
+}
@@ -0,0 +1,113 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Pool of worker threads implementation.
+*/
+
+#include "common/worker_pool.h"
+
+#include <algorithm>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+unsigned GetThreadsPerWorker(unsigned numWorkers, unsigned totalThreads)
+{
+    if (totalThreads == 0)
+    {
+        totalThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    // Split the threads evenly between the workers, so that their parallelized operations do not oversubscribe the CPU
+    return std::max(1U, totalThreads / std::max(1U, numWorkers));
+}
+
+void SetThreadCount(unsigned numThreads)
+{
+#if defined(_OPENMP)
+    omp_set_num_threads(static_cast<int>(numThreads));
+#else
+    (void)numThreads;
+#endif
+}
+
+c_WorkerPool::c_WorkerPool(std::size_t numItems)
+: m_NumItems(numItems), m_ClaimLimit(numItems)
+{}
+
+c_WorkerPool::~c_WorkerPool()
+{
+    Stop();
+}
+
+void c_WorkerPool::Start(unsigned numWorkers, unsigned totalThreads, std::function<void ()> workerFunc)
+{
+    const unsigned threadsPerWorker = GetThreadsPerWorker(numWorkers, totalThreads);
+    for (unsigned i = 0; i < numWorkers; ++i)
+    {
+        m_Workers.emplace_back([threadsPerWorker, workerFunc] {
+            SetThreadCount(threadsPerWorker);
+            workerFunc();
+        });
+    }
+}
+
+std::optional<std::size_t> c_WorkerPool::Claim()
+{
+    std::unique_lock lock(m_Mutex);
+    m_ClaimCondition.wait(lock, [&] {
+        return m_StopRequested || m_NextToClaim >= m_NumItems || m_NextToClaim < m_ClaimLimit;
+    });
+    if (m_StopRequested || m_NextToClaim >= m_NumItems)
+    {
+        return std::nullopt;
+    }
+
+    return m_NextToClaim++;
+}
+
+void c_WorkerPool::SetClaimLimit(std::size_t limit)
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_ClaimLimit = limit;
+    }
+    m_ClaimCondition.notify_all();
+}
+
+void c_WorkerPool::RequestStop()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_StopRequested = true;
+    }
+    m_ClaimCondition.notify_all();
+}
+
+void c_WorkerPool::Stop()
+{
+    RequestStop();
+    for (auto& worker: m_Workers)
+    {
+        worker.join();
+    }
+    m_Workers.clear();
+}
@@ -1,6 +1,6 @@
 /*
 ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
-Copyright (C) 2016-2019 Filip Szczerek <ga.software@yahoo.com>
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
 
 This file is part of ImPPG.
 
@@ -18,33 +18,18 @@ You should have received a copy of the GNU General Public License
 along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
 
 File description:
-    Unsharp masking worker thread header.
+    File formats unit tests.
 */
 
-#ifndef IMPPG_UNSHARP_MASKING_WORKER_THREAD_H
-#define IMPPG_UNSHARP_MASKING_WORKER_THREAD_H
+#include "common/formats.h"
 
-#include "cpu_bmp/worker.h"
+#include <boost/test/unit_test.hpp>
 
-#include <optional>
-
-namespace imppg::backend {
-
-class c_UnsharpMaskingThread: public IWorkerThread
+BOOST_AUTO_TEST_CASE(GetOutputFormatFromName)
 {
-    virtual void DoWork();
-
-    std::optional<c_View<const IImageBuffer>> m_BlurredRawInput; ///< Raw/original image fragment smoothed to alleviate noise.
-    UnsharpMask m_UnsharpMask;
-
-public:
-    c_UnsharpMaskingThread(
-        WorkerParameters&& params,
-        std::optional<c_View<const IImageBuffer>>&& m_BlurredRawInput,
-        UnsharpMask unsharpMask
-    );
-};
-
-} // namespace imppg::backend
-
-#endif
+    BOOST_CHECK(GetOutputFormatFromName("BMP_8") == OutputFormat::BMP_8);
+    BOOST_CHECK(GetOutputFormatFromName("TIFF_16") == OutputFormat::TIFF_16);
+    BOOST_CHECK(GetOutputFormatFromName("tiff_16") == OutputFormat::TIFF_16);
+    BOOST_CHECK(!GetOutputFormatFromName("TIFF").has_value());
+    BOOST_CHECK(!GetOutputFormatFromName("").has_value());
+}
@@ -0,0 +1,127 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Worker pool unit tests.
+*/
+
+#include "common/worker_pool.h"
+
+#include <atomic>
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(ThreadsAreSplitEvenlyBetweenWorkers)
+{
+    BOOST_CHECK_EQUAL(GetThreadsPerWorker(1, 8), 8);
+    BOOST_CHECK_EQUAL(GetThreadsPerWorker(3, 8), 2);
+    BOOST_CHECK_EQUAL(GetThreadsPerWorker(8, 8), 1);
+    BOOST_CHECK_EQUAL(GetThreadsPerWorker(16, 8), 1);
+    BOOST_CHECK_EQUAL(GetThreadsPerWorker(0, 8), 8);
+    BOOST_CHECK_GE(GetThreadsPerWorker(1), 1);
+}
+
+BOOST_AUTO_TEST_CASE(EachItemIsProcessedOnce)
+{
+    constexpr std::size_t NUM_ITEMS = 1000;
+    std::vector<std::atomic<int>> numProcessed(NUM_ITEMS);
+
+    {
+        c_WorkerPool pool(NUM_ITEMS);
+        pool.Start(4, 4, [&] {
+            while (const auto idx = pool.Claim())
+            {
+                numProcessed[*idx] += 1;
+            }
+        });
+    }
+
+    for (std::size_t i = 0; i < NUM_ITEMS; ++i)
+    {
+        BOOST_REQUIRE_EQUAL(numProcessed[i].load(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ItemsAboveClaimLimitAreNotClaimed)
+{
+    constexpr std::size_t NUM_ITEMS = 10;
+    std::mutex mutex;
+    std::vector<std::size_t> claimed;
+
+    c_WorkerPool pool(NUM_ITEMS);
+    pool.SetClaimLimit(3);
+    pool.Start(2, 2, [&] {
+        while (const auto idx = pool.Claim())
+        {
+            std::lock_guard lock(mutex);
+            claimed.push_back(*idx);
+        }
+    });
+
+    const auto getNumClaimed = [&] { std::lock_guard lock(mutex); return claimed.size(); };
+    const auto waitForNumClaimed = [&](std::size_t expected) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (getNumClaimed() < expected && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    waitForNumClaimed(3);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    BOOST_CHECK_EQUAL(getNumClaimed(), 3);
+
+    pool.SetClaimLimit(NUM_ITEMS);
+    waitForNumClaimed(NUM_ITEMS);
+    pool.Stop();
+    BOOST_CHECK_EQUAL(claimed.size(), NUM_ITEMS);
+}
+
+BOOST_AUTO_TEST_CASE(NothingIsClaimedAfterStopRequest)
+{
+    std::atomic<std::size_t> numClaimed{0};
+    std::atomic<bool> stopRequested{false};
+
+    c_WorkerPool pool(100);
+    pool.Start(3, 3, [&] {
+        while (pool.Claim())
+        {
+            if (++numClaimed == 5)
+            {
+                pool.RequestStop();
+                stopRequested = true;
+            }
+        }
+    });
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!stopRequested && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pool.Stop();
+
+    // each of the other workers may have claimed one more item before the stop request
+    BOOST_CHECK_GE(numClaimed.load(), 5);
+    BOOST_CHECK_LE(numClaimed.load(), 7);
+}
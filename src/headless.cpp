@@ -0,0 +1,521 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Headless (no GUI) operation implementation.
+*/
+
+#include "appconfig.h"
+#include "backend/backend.h"
+#include "batch_pipeline.h"
+#include "common/common.h"
+#include "common/formats.h"
+#include "common/proc_settings.h"
+#include "headless.h"
+#include "image/image.h"
+#include "logging.h"
+#if ENABLE_SCRIPTING
+#include "scripting/interop.h"
+#include "scripting/script_image_processor.h"
+#include "scripting/script_runner.h"
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <wx/app.h>
+#include <wx/cmdline.h>
+#include <wx/fileconf.h>
+#include <wx/filename.h>
+#if USE_FREEIMAGE
+#include "FreeImage.h" // on MSW it has to be the last include (to make sure no wxW header follows it)
+#ifdef __APPLE__
+   #undef _WINDOWS_
+#endif
+#endif
+
+namespace
+{
+
+constexpr int EXIT_ALL_SUCCEEDED = 0;
+constexpr int EXIT_SOME_FAILED = 1;
+constexpr int EXIT_INVALID_ARGS = 2;
+
+/// Returns `s` as a JSON string literal.
+std::string JsonString(const wxString& s)
+{
+    std::string result = "\"";
+    for (const char c: std::string(s.ToUTF8()))
+    {
+        switch (c)
+        {
+        case '"': result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        case '\t': result += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                result += escaped;
+            }
+            else
+            {
+                result += c;
+            }
+        }
+    }
+    result += "\"";
+    return result;
+}
+
+/// Returns `value` as a JSON number (always with a dot as the decimal separator).
+std::string JsonNumber(double value)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", value);
+    return buf;
+}
+
+/// Writes a single-line JSON event to the standard output.
+void Report(const std::string& eventName, const std::string& fields = "")
+{
+    std::cout << "{\"event\":" << JsonString(eventName) << (fields.empty() ? "" : ",") << fields << "}" << std::endl;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point tstart)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - tstart).count();
+}
+
+class c_HeadlessApp: public wxAppConsole
+{
+public:
+    int OnRun() override;
+
+private:
+    bool OnInit() override;
+    int OnExit() override;
+    void OnInitCmdLine(wxCmdLineParser& parser) override;
+    bool OnCmdLineParsed(wxCmdLineParser& parser) override;
+
+    bool StartBatch();
+    void OnBatchFileCompleted(std::size_t fileIdx, const BatchFileResult& result);
+
+#if ENABLE_SCRIPTING
+    bool StartScript();
+    void OnScriptMessage(wxThreadEvent& event);
+#endif
+
+    void OnIdle(wxIdleEvent& event);
+
+    /// Reports an error which prevents starting the processing.
+    void ReportFatalError(const wxString& message, int exitCode);
+
+    std::unique_ptr<wxFileConfig> m_AppConfig;
+
+    bool m_Started{false};
+    int m_ExitCode{EXIT_ALL_SUCCEEDED};
+    std::chrono::steady_clock::time_point m_StartTime;
+
+    struct
+    {
+        bool batch{false};
+        wxString scriptFile;
+        wxString settingsFile;
+        wxString outputDir;
+        OutputFormat outputFmt{OutputFormat::TIFF_16};
+        wxArrayString inputFiles;
+        std::optional<long> concurrentFiles;
+        std::optional<long> threads;
+        std::optional<long> memoryBudgetMiB;
+    } m_Args;
+
+    std::unique_ptr<c_BatchPipeline> m_Pipeline;
+    std::size_t m_NumFilesFailed{0};
+
+#if ENABLE_SCRIPTING
+    std::unique_ptr<scripting::ScriptImageProcessor> m_ScriptProcessor;
+    std::unique_ptr<scripting::ScriptRunner> m_ScriptRunner;
+    std::unique_ptr<std::promise<void>> m_StopScript;
+#endif
+};
+
+void c_HeadlessApp::OnInitCmdLine(wxCmdLineParser& parser)
+{
+    wxAppConsole::OnInitCmdLine(parser);
+
+    parser.AddLongSwitch("batch", "process the input files using the specified settings");
+    parser.AddLongOption("script", "run the specified Lua script");
+    parser.AddLongOption("settings", "processing settings file (batch mode)");
+    parser.AddLongOption("out", "output directory (batch mode)");
+    parser.AddLongOption("format", "output format, e.g. TIFF_16 (batch mode)");
+    parser.AddLongOption("jobs", "number of files processed concurrently (batch mode)", wxCMD_LINE_VAL_NUMBER);
+    parser.AddLongOption("threads", "total number of processing threads; 0: all hardware threads (batch mode)", wxCMD_LINE_VAL_NUMBER);
+    parser.AddLongOption("memory", "memory budget in MiB for images held at a time (batch mode)", wxCMD_LINE_VAL_NUMBER);
+    parser.AddLongSwitch("log", "print diagnostic log to standard error");
+    parser.AddParam("input files", wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE);
+}
+
+bool c_HeadlessApp::OnCmdLineParsed(wxCmdLineParser& parser)
+{
+    if (!wxAppConsole::OnCmdLineParsed(parser))
+    {
+        return false;
+    }
+
+    if (parser.FoundSwitch("log") == wxCMD_SWITCH_ON)
+    {
+        Log::Initialize(Log::LogLevel::NORMAL, std::cerr);
+    }
+
+    m_Args.batch = (parser.FoundSwitch("batch") == wxCMD_SWITCH_ON);
+    const bool script = parser.Found("script", &m_Args.scriptFile);
+    if (m_Args.batch == script)
+    {
+        ReportFatalError("exactly one of --batch and --script has to be specified", EXIT_INVALID_ARGS);
+        return false;
+    }
+
+    if (m_Args.batch)
+    {
+        wxString fmtName;
+        if (!parser.Found("settings", &m_Args.settingsFile) ||
+            !parser.Found("out", &m_Args.outputDir) ||
+            !parser.Found("format", &fmtName))
+        {
+            ReportFatalError("--settings, --out and --format are required in batch mode", EXIT_INVALID_ARGS);
+            return false;
+        }
+
+        const auto fmt = GetOutputFormatFromName(fmtName);
+        if (!fmt.has_value())
+        {
+            ReportFatalError(wxString::Format("unsupported output format: %s", fmtName), EXIT_INVALID_ARGS);
+            return false;
+        }
+        m_Args.outputFmt = *fmt;
+
+        if (!wxFileName::DirExists(m_Args.outputDir))
+        {
+            ReportFatalError(wxString::Format("output directory does not exist: %s", m_Args.outputDir), EXIT_INVALID_ARGS);
+            return false;
+        }
+
+        for (std::size_t i = 0; i < parser.GetParamCount(); ++i)
+        {
+            m_Args.inputFiles.Add(parser.GetParam(i));
+        }
+        if (m_Args.inputFiles.IsEmpty())
+        {
+            ReportFatalError("no input files specified", EXIT_INVALID_ARGS);
+            return false;
+        }
+
+        const auto readNonNegative = [&](const char* name, std::optional<long>& destination) {
+            long value;
+            if (parser.Found(name, &value))
+            {
+                if (value < 0)
+                {
+                    ReportFatalError(wxString::Format("--%s must not be negative", name), EXIT_INVALID_ARGS);
+                    return false;
+                }
+                destination = value;
+            }
+            return true;
+        };
+        if (!readNonNegative("jobs", m_Args.concurrentFiles) ||
+            !readNonNegative("threads", m_Args.threads) ||
+            !readNonNegative("memory", m_Args.memoryBudgetMiB))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool c_HeadlessApp::OnInit()
+{
+    if (!wxAppConsole::OnInit()) // parses the command line
+    {
+        if (m_ExitCode == EXIT_ALL_SUCCEEDED) { m_ExitCode = EXIT_INVALID_ARGS; }
+        return true; // `OnRun` returns `m_ExitCode` without running the event loop
+    }
+
+#if USE_FREEIMAGE
+    FreeImage_Initialise();
+#endif
+
+    // Use the same configuration file as the GUI (for the back end and batch processing settings).
+    m_AppConfig = std::make_unique<wxFileConfig>("imppg", wxEmptyString, wxEmptyString, wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+    Configuration::Initialize(m_AppConfig.get());
+
+    SetTiffWriteOptions({Configuration::TiffRowsPerStrip, Configuration::TiffUsePredictor});
+    SetBufferPoolOptions({
+        static_cast<std::size_t>(Configuration::BufferPoolMaxCachedMiB) << 20,
+        Configuration::BufferPoolUseHugePages
+    });
+
+    Bind(wxEVT_IDLE, &c_HeadlessApp::OnIdle, this);
+
+    m_StartTime = std::chrono::steady_clock::now();
+
+    if (m_Args.batch)
+    {
+        m_Started = StartBatch();
+    }
+    else
+    {
+#if ENABLE_SCRIPTING
+        m_Started = StartScript();
+#else
+        ReportFatalError("scripting support is not enabled in this build", EXIT_INVALID_ARGS);
+#endif
+    }
+
+    return true;
+}
+
+int c_HeadlessApp::OnRun()
+{
+    if (m_Started)
+    {
+        wxAppConsole::OnRun();
+    }
+
+    return m_ExitCode;
+}
+
+int c_HeadlessApp::OnExit()
+{
+    m_Pipeline.reset();
+#if ENABLE_SCRIPTING
+    m_ScriptRunner.reset();
+    m_ScriptProcessor.reset();
+#endif
+
+    if (m_AppConfig)
+    {
+        Configuration::Initialize(nullptr);
+        m_AppConfig.reset();
+#if USE_FREEIMAGE
+        FreeImage_DeInitialise();
+#endif
+    }
+
+    return wxAppConsole::OnExit();
+}
+
+void c_HeadlessApp::ReportFatalError(const wxString& message, int exitCode)
+{
+    Report("error", "\"message\":" + JsonString(message));
+    m_ExitCode = exitCode;
+}
+
+void c_HeadlessApp::OnIdle(wxIdleEvent& event)
+{
+    if (m_Pipeline) { m_Pipeline->OnIdle(event); }
+#if ENABLE_SCRIPTING
+    if (m_ScriptProcessor) { m_ScriptProcessor->OnIdle(event); }
+#endif
+    event.Skip();
+}
+
+bool c_HeadlessApp::StartBatch()
+{
+    const auto settings = LoadSettings(m_Args.settingsFile);
+    if (!settings.has_value())
+    {
+        ReportFatalError(wxString::Format("could not load processing settings from %s", m_Args.settingsFile), EXIT_INVALID_ARGS);
+        return false;
+    }
+
+    BatchPipelineLimits limits;
+    limits.maxConcurrentFiles = static_cast<unsigned>(m_Args.concurrentFiles.value_or(Configuration::BatchConcurrentFiles));
+    limits.maxThreads = static_cast<unsigned>(m_Args.threads.value_or(Configuration::BatchMaxThreads));
+    limits.memoryBudget = static_cast<std::size_t>(m_Args.memoryBudgetMiB.value_or(Configuration::BatchMemoryBudgetMiB)) << 20;
+
+    // Without a display there is no OpenGL context; always use the CPU back end.
+    m_Pipeline = std::make_unique<c_BatchPipeline>(
+        m_Args.inputFiles,
+        *settings,
+        m_Args.outputDir,
+        m_Args.outputFmt,
+        Configuration::NormalizeFITSValues,
+        limits,
+        []() { return imppg::backend::CreateCpuBmpProcessingBackend(); }
+    );
+
+    m_Pipeline->SetFileProgressHandler([](std::size_t fileIdx, wxString info) {
+        Report("progress", "\"file\":" + std::to_string(fileIdx) + ",\"info\":" + JsonString(info));
+    });
+    m_Pipeline->SetFileCompletedHandler([this](std::size_t fileIdx, const BatchFileResult& result) {
+        OnBatchFileCompleted(fileIdx, result);
+    });
+    m_Pipeline->SetFinishedHandler([this]() {
+        Report("finished",
+            "\"files\":" + std::to_string(m_Args.inputFiles.Count()) +
+            ",\"failed\":" + std::to_string(m_NumFilesFailed) +
+            ",\"elapsed_s\":" + JsonNumber(SecondsSince(m_StartTime)));
+        m_ExitCode = (m_NumFilesFailed > 0) ? EXIT_SOME_FAILED : EXIT_ALL_SUCCEEDED;
+        ExitMainLoop();
+    });
+
+    Report("started", "\"mode\":\"batch\",\"files\":" + std::to_string(m_Args.inputFiles.Count()));
+    m_Pipeline->Start();
+
+    return true;
+}
+
+void c_HeadlessApp::OnBatchFileCompleted(std::size_t fileIdx, const BatchFileResult& result)
+{
+    std::string fields =
+        "\"file\":" + std::to_string(fileIdx) +
+        ",\"input\":" + JsonString(m_Args.inputFiles[fileIdx]) +
+        ",\"status\":" + (result.success ? "\"ok\"" : "\"error\"");
+
+    if (result.success)
+    {
+        fields += ",\"output\":" + JsonString(result.outputPath);
+    }
+    else
+    {
+        fields += ",\"message\":" + JsonString(result.errorMsg);
+        m_NumFilesFailed += 1;
+    }
+
+    fields +=
+        ",\"load_s\":" + JsonNumber(result.loadTime) +
+        ",\"processing_s\":" + JsonNumber(result.processingTime) +
+        ",\"save_s\":" + JsonNumber(result.saveTime);
+
+    Report("file_completed", fields);
+}
+
+#if ENABLE_SCRIPTING
+
+bool c_HeadlessApp::StartScript()
+{
+    auto scriptStream = std::make_unique<std::ifstream>(ToFsPath(m_Args.scriptFile), std::ios::binary);
+    if (!scriptStream->is_open())
+    {
+        ReportFatalError(wxString::Format("could not open script file %s", m_Args.scriptFile), EXIT_INVALID_ARGS);
+        return false;
+    }
+
+    m_ScriptProcessor = std::make_unique<scripting::ScriptImageProcessor>(
+        imppg::backend::CreateCpuBmpProcessingBackend(),
+        Configuration::NormalizeFITSValues
+    );
+
+    Bind(wxEVT_THREAD, &c_HeadlessApp::OnScriptMessage, this);
+
+    Report("started", "\"mode\":\"script\",\"script\":" + JsonString(m_Args.scriptFile));
+
+    m_StopScript = std::make_unique<std::promise<void>>();
+    m_ScriptRunner = std::make_unique<scripting::ScriptRunner>(std::move(scriptStream), *this, m_StopScript->get_future());
+    m_ScriptRunner->Run();
+
+    return true;
+}
+
+void c_HeadlessApp::OnScriptMessage(wxThreadEvent& event)
+{
+    namespace contents = scripting::contents;
+
+    auto payload = event.GetPayload<scripting::ScriptMessagePayload>();
+
+    const auto handler = Overload{
+        [&](const contents::None&) {},
+
+        [&](const contents::Error& contents) {
+            Report("error", "\"message\":" + JsonString(contents.message));
+            m_ExitCode = EXIT_SOME_FAILED;
+            m_ScriptProcessor->AbortProcessing();
+        },
+
+        [&](const contents::Warning& contents) {
+            Report("warning", "\"message\":" + JsonString(contents.message));
+        },
+
+        [&](const contents::ScriptFinished&) {
+            m_ScriptRunner->Wait();
+            Report("finished", "\"elapsed_s\":" + JsonNumber(SecondsSince(m_StartTime)));
+            ExitMainLoop();
+        },
+
+        [&](const contents::Progress& contents) {
+            Report("progress", "\"fraction\":" + JsonNumber(contents.fraction));
+        },
+
+        [&](const contents::PrintMessage& contents) {
+            Report("message", "\"text\":" + JsonString(contents.message));
+        },
+
+        [&](const auto& contents) {
+            // See `c_ScriptDialog::OnRunnerMessage` for why copies are made first.
+            scripting::MessageContents contentsCopy = contents;
+            auto heartbeat = payload.GetHeartbeat();
+            m_ScriptProcessor->StartProcessing(
+                contentsCopy,
+                heartbeat,
+                [payload = std::move(payload)](scripting::FunctionCallResult result) mutable {
+                    payload.SignalCompletion(std::move(result));
+                }
+            );
+        }
+    };
+
+    std::visit(handler, payload.GetContents());
+}
+
+#endif // ENABLE_SCRIPTING
+
+}
+
+bool IsHeadlessCommandLine(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--batch" || arg == "--script" || arg.rfind("--script=", 0) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int RunHeadless(int argc, char* argv[])
+{
+    // Creating the application object before `wxEntry` prevents creation of the GUI application
+    // (which would require a display).
+    wxAppConsole::SetInstance(new c_HeadlessApp());
+    return wxEntry(argc, argv);
+}
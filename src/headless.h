@@ -0,0 +1,40 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Headless (no GUI) operation header.
+*/
+
+#ifndef IMPPG_HEADLESS_H
+#define IMPPG_HEADLESS_H
+
+/// Returns 'true' if the command line requests headless operation (`--batch` or `--script`).
+bool IsHeadlessCommandLine(int argc, char* argv[]);
+
+/// Performs batch processing or runs a script without creating any windows; returns the process exit code.
+/** Usage:
+
+        imppg --batch --settings <settings.xml> --out <output dir> --format <format> [options] <files...>
+        imppg --script <script.lua>
+
+    Progress and results are reported on standard output, one JSON object per line.
+    Exit code: 0 - all files/script succeeded, 1 - some files or the script failed, 2 - invalid arguments. */
+int RunHeadless(int argc, char* argv[]);
+
+#endif // IMPPG_HEADLESS_H
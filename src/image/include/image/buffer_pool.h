@@ -0,0 +1,125 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+
+File description:
+    Pooled allocator of aligned memory blocks (image and work buffers).
+*/
+
+#ifndef IMPPG_BUFFER_POOL_HEADER
+#define IMPPG_BUFFER_POOL_HEADER
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/// Alignment (in bytes) of blocks returned by `AllocateAligned`, and of the rows of image and working buffers allocated by ImPPG.
+constexpr std::size_t IMAGE_ROW_ALIGNMENT = 64;
+
+struct BufferPoolOptions
+{
+    /// Max total size (in bytes) of released blocks kept for reuse.
+    std::size_t maxCachedBytes{std::size_t{1} << 30};
+
+    /// If true, large blocks are backed by transparent huge pages (where supported by the OS).
+    bool useHugePages{true};
+};
+
+struct BufferPoolStats
+{
+    std::size_t numHits{0};     ///< Number of allocations satisfied by a previously released block.
+    std::size_t numMisses{0};   ///< Number of allocations which required a new block.
+    std::size_t cachedBytes{0}; ///< Total size of released blocks currently kept for reuse.
+};
+
+void SetBufferPoolOptions(const BufferPoolOptions& options);
+
+BufferPoolStats GetBufferPoolStats();
+
+/// Returns a one-line summary of `stats` (for logging).
+std::string FormatBufferPoolStats(const BufferPoolStats& stats);
+
+/// Frees all released blocks kept for reuse.
+void TrimBufferPool();
+
+/// Returns a block allocated by `AllocateAligned` to the pool.
+struct AlignedBlockDeleter
+{
+    std::size_t capacity{0}; ///< Actual size of the block (may be larger than requested).
+
+    void operator()(void* ptr) const;
+};
+
+using AlignedBlock = std::unique_ptr<uint8_t[], AlignedBlockDeleter>;
+
+/// Returns an uninitialized memory block aligned to `IMAGE_ROW_ALIGNMENT`.
+/** Large blocks are taken from a pool of previously released blocks of similar size (rounded up
+    to one of the pool's size buckets), which saves the cost of page faults and zeroing of fresh
+    memory when image-sized buffers are repeatedly allocated. Thread-safe. */
+AlignedBlock AllocateAligned(std::size_t numBytes);
+
+/// Uninitialized array of `T` allocated with `AllocateAligned`.
+template<typename T>
+class c_AlignedArray
+{
+    static_assert(std::is_trivially_destructible_v<T>);
+
+public:
+    c_AlignedArray() = default;
+
+    explicit c_AlignedArray(std::size_t numElements)
+    : m_Block(AllocateAligned(numElements * sizeof(T))), m_Size(numElements)
+    {}
+
+    T* get() { return reinterpret_cast<T*>(m_Block.get()); }
+
+    const T* get() const { return reinterpret_cast<const T*>(m_Block.get()); }
+
+    T& operator[](std::size_t idx) { return get()[idx]; }
+
+    const T& operator[](std::size_t idx) const { return get()[idx]; }
+
+    std::size_t size() const { return m_Size; }
+
+    void swap(c_AlignedArray& other)
+    {
+        std::swap(m_Block, other.m_Block);
+        std::swap(m_Size, other.m_Size);
+    }
+
+    /// Makes sure the array has at least `numElements` elements; contents are not preserved.
+    void Reserve(std::size_t numElements)
+    {
+        if (m_Size < numElements)
+        {
+            m_Block.reset();
+            m_Block = AllocateAligned(numElements * sizeof(T));
+            m_Size = numElements;
+        }
+    }
+
+private:
+    AlignedBlock m_Block;
+    std::size_t m_Size{0};
+};
+
+#endif // IMPPG_BUFFER_POOL_HEADER
@@ -25,6 +25,7 @@ File description:
 #define ImPPG_IMAGE_H
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <filesystem>
 #include <memory>
@@ -36,6 +37,7 @@ File description:
 
 #include "common/formats.h"
 #include "common/imppg_assert.h"
+#include "image/buffer_pool.h"
 
 
 /// Conditionally swaps a 32-bit value
@@ -102,6 +104,12 @@ constexpr bool IsMono(PixelFormat pixFmt)
     return 1 == NumChannels[static_cast<std::size_t>(pixFmt)];
 }
 
+/// Returns the row stride (in bytes) to be used for an image or a working buffer.
+/** The stride is a multiple of `IMAGE_ROW_ALIGNMENT` and of `bytesPerPixel`. If the unpadded stride
+    would be a multiple of 512 (typical for power-of-two widths), one more alignment unit is added,
+    so that vertically adjacent pixels do not map to the same cache sets (and do not alias modulo 4 KiB). */
+std::size_t GetPaddedRowStride(unsigned width, std::size_t bytesPerPixel);
+
 class IImageBuffer
 {
 public:
@@ -118,7 +126,10 @@ public:
 
     virtual unsigned GetHeight() const = 0;
 
-    virtual size_t GetBytesPerRow() const = 0; ///< Returns number of bytes per row (including padding, if any).
+    /// Returns number of bytes per row (including padding, if any).
+    /** Buffers allocated by ImPPG (e.g., by `c_Image(width, height, pixFmt)`) use `GetPaddedRowStride`
+        and have rows aligned to `IMAGE_ROW_ALIGNMENT`; buffers wrapping external storage may differ. */
+    virtual size_t GetBytesPerRow() const = 0;
 
     virtual size_t GetBytesPerPixel() const = 0;
 
@@ -144,32 +155,72 @@ private:
     friend class c_Image;
 };
 
+/// Image with copy-on-write pixel storage.
+/** Copies of an image share the pixel buffer until one of them is accessed via a non-const method
+    (`GetRow`, `GetRowAs`, `GetBuffer` etc.); only then the buffer is copied. A reference or pointer obtained
+    from a non-const accessor must not be used for modification after the image has been copied.
+
+    Thread safety: metadata (size, pixel format) can always be read concurrently, and non-const accessors
+    can be called concurrently (e.g. by threads of an OpenMP loop writing to different rows). However,
+    the first non-const access may replace the pixel buffer, so const pixel accessors (`GetRow`, `GetBuffer`)
+    of the same object must not be called concurrently with it; call a non-const accessor beforehand if
+    an image shared between threads is both read and modified. */
 class c_Image
 {
 private:
-    std::unique_ptr<IImageBuffer> m_Buffer;
+    std::shared_ptr<IImageBuffer> m_Buffer;
+
+    // Copied from `m_Buffer`, so that they can be read while `m_Buffer` is being replaced by `DetachShared`.
+    unsigned m_Width;
+    unsigned m_Height;
+    PixelFormat m_PixelFormat;
+
+    /// If true, `m_Buffer` is known not to be shared with another `c_Image`.
+    mutable std::atomic<bool> m_Exclusive{true};
+
+    /// Makes sure `m_Buffer` is not shared with another image; called before every non-const access.
+    /** Can be called concurrently (e.g., by threads of an OpenMP loop writing to different rows). */
+    void Detach()
+    {
+        if (!m_Exclusive.load(std::memory_order_acquire)) { DetachShared(true); }
+    }
+
+    void DetachShared(bool copyContents);
 
 public:
     c_Image(unsigned width, unsigned height, PixelFormat pixFmt);
 
-    c_Image(std::unique_ptr<IImageBuffer> buffer): m_Buffer(std::move(buffer)) {}
+    c_Image(std::unique_ptr<IImageBuffer> buffer)
+    : m_Buffer(std::move(buffer)),
+      m_Width(m_Buffer->GetWidth()),
+      m_Height(m_Buffer->GetHeight()),
+      m_PixelFormat(m_Buffer->GetPixelFormat())
+    {}
 
-    c_Image(c_Image&& img) = default;
-    c_Image& operator=(c_Image &&img) = default;
+    c_Image(c_Image&& img) noexcept;
+    c_Image& operator=(c_Image&& img) noexcept;
 
-    c_Image(const c_Image &img);
-    c_Image& operator=(const c_Image &img);
+    /// Shares the pixel buffer of `img` (which is copied on first modification of either image).
+    c_Image(const c_Image& img);
+    c_Image& operator=(const c_Image& img);
 
     void ClearToZero(); ///< Clears all pixels to zero value.
 
+    /// Makes sure the pixel buffer is not shared with another image; unlike `Detach`, does not copy the contents if it is.
+    /** To be called before overwriting all pixels; afterwards, pixel values are undefined. */
+    void PrepareForOverwrite()
+    {
+        if (!m_Exclusive.load(std::memory_order_acquire)) { DetachShared(false); }
+    }
+
     wxRect GetImageRect() const { return wxRect{ 0, 0, static_cast<int>(GetWidth()), static_cast<int>(GetHeight()) }; };
 
-    unsigned GetWidth() const { return m_Buffer->GetWidth(); }
-    unsigned GetHeight() const { return m_Buffer->GetHeight(); }
+    unsigned GetWidth() const { return m_Width; }
+    unsigned GetHeight() const { return m_Height; }
     unsigned GetNumPixels() const { return GetWidth() * GetHeight(); }
-    PixelFormat GetPixelFormat() const { return m_Buffer->GetPixelFormat(); }
+    PixelFormat GetPixelFormat() const { return m_PixelFormat; }
 
-    void* GetRow(size_t row) { return m_Buffer->GetRow(row); }
+    void* GetRow(size_t row) { Detach(); return m_Buffer->GetRow(row); }
     const void* GetRow(size_t row) const { return m_Buffer->GetRow(row); }
 
     template <typename T>
@@ -178,7 +229,7 @@ public:
     template <typename T>
     const T* GetRowAs(size_t row) const { return static_cast<const T*>(GetRow(row)); }
 
-    IImageBuffer& GetBuffer() { return *m_Buffer; }
+    IImageBuffer& GetBuffer() { Detach(); return *m_Buffer; }
     const IImageBuffer& GetBuffer() const { return *m_Buffer; }
 
     /// Copies a rectangular area from 'src' to 'dest'. Pixel formats of 'src' and 'dest' have to be the same.
@@ -291,6 +342,38 @@ public:
     PixelFormat GetPixelFormat() const { return m_Buf->GetPixelFormat(); }
 };
 
+/// R, G, B channels of an image stored as three planes (mono images) in a single allocation.
+/** The planes can be shared with mono `c_Image`s (see `ShareChannels`); the pixel memory is released
+    when the buffer and all the images sharing it are destroyed. */
+class c_PlanarBuffer
+{
+public:
+    /// Allocates memory for pixel data; `planePixFmt` has to be PIX_MONO8, PIX_MONO16 or PIX_MONO32F.
+    c_PlanarBuffer(unsigned width, unsigned height, PixelFormat planePixFmt);
+
+    /// Returns the channels of `rgb` (PIX_RGB8, PIX_RGB16 or PIX_RGB32F).
+    static c_PlanarBuffer FromInterleaved(const IImageBuffer& rgb);
+
+    unsigned GetWidth() const { return m_Planes[0]->GetWidth(); }
+
+    unsigned GetHeight() const { return m_Planes[0]->GetHeight(); }
+
+    PixelFormat GetPlanePixelFormat() const { return m_Planes[0]->GetPixelFormat(); }
+
+    /// Returns the pixel format of the interleaved equivalent (PIX_RGB8, PIX_RGB16 or PIX_RGB32F).
+    PixelFormat GetInterleavedPixelFormat() const;
+
+    IImageBuffer& GetPlane(std::size_t channel) { return *m_Planes.at(channel); }
+
+    const IImageBuffer& GetPlane(std::size_t channel) const { return *m_Planes.at(channel); }
+
+    /// Returns the R, G, B planes as mono images sharing this buffer's pixel memory.
+    std::array<c_Image, 3> ShareChannels();
+
+private:
+    std::array<std::unique_ptr<IImageBuffer>, 3> m_Planes;
+};
+
 #if USE_FREEIMAGE
 
 struct FIBITMAP; // provided by FreeImage.h
@@ -381,12 +464,18 @@ private:
 };
 #endif // USE_FREEIMAGE
 
+/// Linearly transforms brightness of a PIX_MONO32F or PIX_RGB32F image, so that its lowest value becomes `minLevel`
+/// and the highest becomes `maxLevel`; the results are clamped to [0; 1].
 void NormalizeFpImage(c_Image& img, float minLevel, float maxLevel);
 
-/// Loads image and converts it to PIX_MONO32F or PIX_RGB32F.
+/// Loads image and converts it to PIX_MONO32F or PIX_RGB32F; if `normalizationLevels` are specified, also normalizes it
+/// (see `NormalizeFpImage`).
+/** Conversion and normalization are performed together, in a single parallel pass over the decoded image
+    (preceded by a scan for its lowest and highest values, which for TIFF files is performed while decoding). */
 std::optional<c_Image> LoadImageFileAs32f(
     const std::filesystem::path& fname,
     bool normalizeFITSvalues,
+    const std::optional<std::tuple<float, float>>& normalizationLevels, ///< Min. and max. level to normalize to.
     std::string* errorMsg = nullptr  ///< If not null, may receive an error message (if any).
 );
 
@@ -415,14 +504,36 @@ std::optional<c_Image> LoadImage(
     bool normalizeFITSvalues = false
 );
 
+/// Limits the floating-point pixel values read from a FITS file (see `LoadRawFitsImage`) to [0; 1].
+/** Negative values are set to 0. Images in pixel formats other than PIX_MONO32F are not modified. */
+void LimitFitsValues(
+    c_Image& image,
+    bool normalize ///< If true, values will be normalized so that the highest becomes 1.0; otherwise, they are clamped.
+);
+
 #if USE_CFITSIO
 /// Loads an image from a FITS file; the result's pixel format will be PIX_MONO8, PIX_MONO16 or PIX_MONO32F.
 std::optional<c_Image> LoadFitsImage(
     const std::filesystem::path& fname,
     bool normalize ///< If true, floating-point pixel values will be normalized so that the highest value becomes 1.0.
 );
+
+/// Loads an image from a FITS file without limiting the floating-point pixel values (see `LimitFitsValues`).
+std::optional<c_Image> LoadRawFitsImage(const std::filesystem::path& fname);
 #endif
 
+struct TiffWriteOptions
+{
+    /// Number of rows in each strip (compressed independently); 0 means: the whole image is a single strip.
+    unsigned rowsPerStrip{64};
+
+    /// If true, compressed files use the horizontal (integer) or floating-point predictor.
+    bool usePredictor{true};
+};
+
+/// Sets the options used when saving TIFF files; call at startup, before any image is saved.
+void SetTiffWriteOptions(const TiffWriteOptions& options);
+
 /// Returns (width, height).
 std::optional<std::tuple<unsigned, unsigned>> GetImageSize(
     const std::filesystem::path& fname     ///< Full path (including file name and extension).
@@ -0,0 +1,61 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Read-only memory-mapped file header.
+*/
+
+#ifndef IMPPG_MAPPED_FILE_H
+#define IMPPG_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+/// Read-only memory mapping of a whole file.
+/** The operating system's page cache performs the actual I/O when the contents are accessed. */
+class c_MappedFile
+{
+public:
+    /// Returns `std::nullopt` on error (also if the file is empty).
+    static std::optional<c_MappedFile> Open(const std::filesystem::path& path);
+
+    c_MappedFile(const c_MappedFile&) = delete;
+    c_MappedFile& operator=(const c_MappedFile&) = delete;
+
+    c_MappedFile(c_MappedFile&& other) noexcept;
+    c_MappedFile& operator=(c_MappedFile&& other) noexcept;
+
+    ~c_MappedFile();
+
+    const std::uint8_t* GetData() const { return m_Data; }
+
+    std::size_t GetSize() const { return m_Size; }
+
+private:
+    c_MappedFile() = default;
+
+    void Close();
+
+    const std::uint8_t* m_Data{nullptr};
+    std::size_t m_Size{0};
+};
+
+#endif // IMPPG_MAPPED_FILE_H
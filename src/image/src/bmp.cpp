@@ -29,6 +29,7 @@ File description:
 
 #include "image/image.h"
 #include "common/imppg_assert.h"
+#include "row_reader.h"
 
 bool IsMachineBigEndian();
 
@@ -212,7 +213,7 @@ std::optional<c_Image> ReadBmp(const std::filesystem::path& fileName)
     return img;
 }
 
-bool SaveBmp(const std::filesystem::path& fileName, const IImageBuffer& img)
+bool SaveBmp(const std::filesystem::path& fileName, c_RowReader& img)
 {
     const PixelFormat pixFmt = img.GetPixelFormat();
     IMPPG_ASSERT(pixFmt == PixelFormat::PIX_PAL8 ||
@@ -295,8 +296,16 @@ bool SaveBmp(const std::filesystem::path& fileName, const IImageBuffer& img)
         row = std::make_unique<uint8_t[]>(img.GetWidth() * bytesPP);
     }
 
+    const unsigned chunkRows = img.GetDefaultChunkRows();
+    unsigned chunkY0 = img.GetHeight();
     for (i = img.GetHeight() - 1; i >= 0; i--) // lines in a BMP are stored bottom to top
     {
+        if (static_cast<unsigned>(i) < chunkY0)
+        {
+            chunkY0 = (static_cast<unsigned>(i) + 1 > chunkRows) ? i + 1 - chunkRows : 0;
+            img.Fetch(chunkY0, i + 1 - chunkY0);
+        }
+
         if (pixFmt == PixelFormat::PIX_RGB8)
         {
             const auto* srcRow = img.GetRowAs<std::uint8_t>(i);
@@ -312,7 +321,10 @@ bool SaveBmp(const std::filesystem::path& fileName, const IImageBuffer& img)
             file.write(img.GetRowAs<char>(i), img.GetWidth() * bytesPP);
 
         if (skip > 0)
-            file.write(img.GetRowAs<char>(i), skip); //this is just padding, so write anything
+        {
+            const char padding[3] = { 0 };
+            file.write(padding, skip);
+        }
     }
 
     file.close();
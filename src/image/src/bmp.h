@@ -27,10 +27,12 @@ File description:
 #include <filesystem>
 #include <optional>
 
+#include "row_reader.h"
+
 std::optional<c_Image> ReadBmp(const std::filesystem::path& fileName);
 
 /// Returns `false` on error.
-bool SaveBmp(const std::filesystem::path& fileName, const IImageBuffer& img);
+bool SaveBmp(const std::filesystem::path& fileName, c_RowReader& img);
 
 /// Returns (width, height).
 std::optional<std::tuple<unsigned, unsigned>> GetBmpDimensions(const std::filesystem::path& fileName);
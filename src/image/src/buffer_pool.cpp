@@ -0,0 +1,247 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+
+File description:
+    Pooled allocator implementation.
+*/
+
+#include "common/imppg_assert.h"
+#include "image/buffer_pool.h"
+
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+
+/// Smaller blocks are not pooled.
+constexpr std::size_t MIN_POOLED_BYTES = std::size_t{256} << 10;
+
+/// Blocks at least this large are advised to use transparent huge pages.
+constexpr std::size_t MIN_HUGE_PAGE_BYTES = std::size_t{2} << 20;
+
+/// Returns the size of the pool bucket for a block of `numBytes` (>= MIN_POOLED_BYTES).
+/** Buckets are 2^n and 1.5*2^n bytes, so at most 1/3 of a block is wasted. */
+std::size_t GetBucketSize(std::size_t numBytes)
+{
+    std::size_t pow2 = MIN_POOLED_BYTES;
+    while (pow2 < numBytes)
+    {
+        if (pow2 + pow2 / 2 >= numBytes)
+        {
+            return pow2 + pow2 / 2;
+        }
+        pow2 *= 2;
+    }
+    return pow2;
+}
+
+class c_BufferPool
+{
+public:
+    void* Acquire(std::size_t capacity)
+    {
+        {
+            std::lock_guard lock(m_Mutex);
+            auto& freeBlocks = m_FreeBlocks[capacity];
+            if (!freeBlocks.empty())
+            {
+                void* block = freeBlocks.back();
+                freeBlocks.pop_back();
+                m_CachedBytes -= capacity;
+                m_NumHits += 1;
+                return block;
+            }
+            m_NumMisses += 1;
+        }
+
+        return AllocateBlock(capacity);
+    }
+
+    void Release(void* block, std::size_t capacity)
+    {
+        {
+            std::lock_guard lock(m_Mutex);
+            if (m_CachedBytes + capacity <= m_Options.maxCachedBytes)
+            {
+                m_FreeBlocks[capacity].push_back(block);
+                m_CachedBytes += capacity;
+                return;
+            }
+        }
+
+        FreeBlock(block, capacity);
+    }
+
+    void SetOptions(const BufferPoolOptions& options)
+    {
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Options = options;
+        }
+        Trim(options.maxCachedBytes);
+    }
+
+    /// Frees released blocks (starting with the largest) until at most `maxCachedBytes` are cached.
+    void Trim(std::size_t maxCachedBytes)
+    {
+        std::vector<std::pair<void*, std::size_t>> toFree;
+        {
+            std::lock_guard lock(m_Mutex);
+            for (auto it = m_FreeBlocks.rbegin(); it != m_FreeBlocks.rend() && m_CachedBytes > maxCachedBytes; ++it)
+            {
+                auto& [capacity, blocks] = *it;
+                while (!blocks.empty() && m_CachedBytes > maxCachedBytes)
+                {
+                    toFree.emplace_back(blocks.back(), capacity);
+                    blocks.pop_back();
+                    m_CachedBytes -= capacity;
+                }
+            }
+        }
+
+        for (const auto& [block, capacity]: toFree)
+        {
+            FreeBlock(block, capacity);
+        }
+    }
+
+    BufferPoolStats GetStats()
+    {
+        std::lock_guard lock(m_Mutex);
+        return BufferPoolStats{m_NumHits, m_NumMisses, m_CachedBytes};
+    }
+
+private:
+    void* AllocateBlock(std::size_t capacity)
+    {
+#if defined(__linux__)
+        // page-aligned, so that the block can be advised to use huge pages
+        void* block = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block == MAP_FAILED) { throw std::bad_alloc(); }
+
+        bool useHugePages;
+        {
+            std::lock_guard lock(m_Mutex);
+            useHugePages = m_Options.useHugePages;
+        }
+        if (useHugePages && capacity >= MIN_HUGE_PAGE_BYTES)
+        {
+            // only a hint; failure is not an error
+            madvise(block, capacity, MADV_HUGEPAGE);
+        }
+
+        return block;
+#else
+        return ::operator new[](capacity, std::align_val_t{IMAGE_ROW_ALIGNMENT});
+#endif
+    }
+
+    void FreeBlock(void* block, std::size_t capacity)
+    {
+#if defined(__linux__)
+        munmap(block, capacity);
+#else
+        (void)capacity;
+        ::operator delete[](block, std::align_val_t{IMAGE_ROW_ALIGNMENT});
+#endif
+    }
+
+    std::mutex m_Mutex;
+    BufferPoolOptions m_Options;
+    std::map<std::size_t, std::vector<void*>> m_FreeBlocks; ///< Key: block capacity (bucket size).
+    std::size_t m_CachedBytes{0};
+    std::size_t m_NumHits{0};
+    std::size_t m_NumMisses{0};
+};
+
+c_BufferPool& GetPool()
+{
+    // Never destroyed, so that blocks released during static destruction can still be returned.
+    static c_BufferPool* pool = new c_BufferPool();
+    return *pool;
+}
+
+} // anonymous namespace
+
+void SetBufferPoolOptions(const BufferPoolOptions& options)
+{
+    GetPool().SetOptions(options);
+}
+
+BufferPoolStats GetBufferPoolStats()
+{
+    return GetPool().GetStats();
+}
+
+std::string FormatBufferPoolStats(const BufferPoolStats& stats)
+{
+    const std::size_t numAllocs = stats.numHits + stats.numMisses;
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), "Buffer pool: hit rate %.1f%% (%zu of %zu allocations), %.1f MiB cached",
+        numAllocs > 0 ? 100.0 * stats.numHits / numAllocs : 0.0,
+        stats.numHits,
+        numAllocs,
+        static_cast<double>(stats.cachedBytes) / (1 << 20)
+    );
+    return buf;
+}
+
+void TrimBufferPool()
+{
+    GetPool().Trim(0);
+}
+
+void AlignedBlockDeleter::operator()(void* ptr) const
+{
+    if (ptr == nullptr) { return; }
+
+    if (capacity >= MIN_POOLED_BYTES)
+    {
+        GetPool().Release(ptr, capacity);
+    }
+    else
+    {
+        ::operator delete[](ptr, std::align_val_t{IMAGE_ROW_ALIGNMENT});
+    }
+}
+
+AlignedBlock AllocateAligned(std::size_t numBytes)
+{
+    if (numBytes >= MIN_POOLED_BYTES)
+    {
+        const std::size_t capacity = GetBucketSize(numBytes);
+        return AlignedBlock(static_cast<uint8_t*>(GetPool().Acquire(capacity)), AlignedBlockDeleter{capacity});
+    }
+    else
+    {
+        return AlignedBlock(
+            static_cast<uint8_t*>(::operator new[](numBytes, std::align_val_t{IMAGE_ROW_ALIGNMENT})),
+            AlignedBlockDeleter{numBytes}
+        );
+    }
+}
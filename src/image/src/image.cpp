@@ -24,6 +24,7 @@ File description:
 #include <boost/format.hpp>
 
 #include <algorithm>
+#include <array>
 #include <cfloat>
 #include <cmath>
 #include <cstdint>
@@ -31,9 +32,12 @@ File description:
 #include <cstring>
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <stdio.h>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include "common/imppg_assert.h"
 #include "image/image.h"
@@ -44,11 +48,14 @@ File description:
   #endif
 #else
   #include "bmp.h"
-  #include "tiff.h"
 #endif
+#include "pixel_conversion.h"
+#include "row_reader.h"
+#include "tiff.h"
 
 #if USE_CFITSIO
 #include <fitsio.h>
+#include "image/mapped_file.h"
 #endif
 
 namespace fs = std::filesystem;
@@ -171,11 +178,45 @@ static std::string GetExtension(const fs::path& filePath)
     }
 }
 
+static TiffWriteOptions g_TiffWriteOptions;
+
+void SetTiffWriteOptions(const TiffWriteOptions& options)
+{
+    g_TiffWriteOptions = options;
+}
+
+/// Returns the compression to use if an image of `pixFmt` shall be saved by the native TIFF encoder.
+static std::optional<TiffCompression> GetNativeTiffCompression(PixelFormat pixFmt, OutputFileType outpFileType)
+{
+    switch (pixFmt)
+    {
+    case PixelFormat::PIX_MONO8:
+    case PixelFormat::PIX_MONO16:
+    case PixelFormat::PIX_MONO32F:
+    case PixelFormat::PIX_RGB8:
+    case PixelFormat::PIX_RGB16:
+    case PixelFormat::PIX_RGB32F:
+        break;
+
+    default: return std::nullopt;
+    }
+
+    switch (outpFileType)
+    {
+    case OutputFileType::TIFF: return TiffCompression::None;
+#if USE_FREEIMAGE
+    case OutputFileType::TIFF_COMPR_LZW: return TiffCompression::LZW;
+    case OutputFileType::TIFF_COMPR_ZIP: return TiffCompression::Deflate;
+#endif
+    default: return std::nullopt;
+    }
+}
+
 #if USE_CFITSIO
 // Only saving as mono is supported.
-static bool SaveAsFits(const IImageBuffer& buf, const fs::path& fname)
+static bool SaveAsFits(c_RowReader& rows, const fs::path& fname)
 {
-    if (NumChannels[static_cast<size_t>(buf.GetPixelFormat())] != 1) { return false; }
+    if (NumChannels[static_cast<size_t>(rows.GetPixelFormat())] != 1) { return false; }
 
     constexpr std::size_t BUF_SIZE_DELTA = 128 * 1024;
     // must be constructed before `fptr`, so that `fptr`'s dtor runs first (it might write something to `buffer`)
@@ -183,18 +224,7 @@ static bool SaveAsFits(const IImageBuffer& buf, const fs::path& fname)
     std::size_t bufSize{BUF_SIZE_DELTA};
 
     FitsFileFinalizer fptr;
-    long dimensions[2] = { static_cast<long>(buf.GetWidth()), static_cast<long>(buf.GetHeight()) };
-    const auto num_pixels = buf.GetWidth() * buf.GetHeight();
-    // contents of the output FITS file
-    auto array = std::make_unique<uint8_t[]>(num_pixels * buf.GetBytesPerPixel());
-
-    const auto row_filler = [&](size_t bytesPerPixel)
-    {
-        for (unsigned row = 0; row < buf.GetHeight(); row++)
-            memcpy(array.get() + row * buf.GetWidth() * bytesPerPixel, buf.GetRow(row), buf.GetWidth() * bytesPerPixel);
-    };
-
-    row_filler(buf.GetBytesPerPixel());
+    long dimensions[2] = { static_cast<long>(rows.GetWidth()), static_cast<long>(rows.GetHeight()) };
 
     int status = 0;
 
@@ -205,7 +235,7 @@ static bool SaveAsFits(const IImageBuffer& buf, const fs::path& fname)
     if (status) { return false; }
 
     int bitPix, datatype;
-    switch (buf.GetPixelFormat())
+    switch (rows.GetPixelFormat())
     {
     case PixelFormat::PIX_MONO32F:
         bitPix = FLOAT_IMG;
@@ -225,7 +255,19 @@ static bool SaveAsFits(const IImageBuffer& buf, const fs::path& fname)
 
     fits_create_img(fptr.GetFile(), bitPix, 2, dimensions, &status);
     fits_write_history(fptr.GetFile(), "Processed in ImPPG.", &status);
-    fits_write_img(fptr.GetFile(), datatype, 1, dimensions[0] * dimensions[1], array.get(), &status);
+    const unsigned chunkRows = rows.GetDefaultChunkRows();
+    for (unsigned y0 = 0; y0 < rows.GetHeight() && !status; y0 += chunkRows)
+    {
+        const unsigned numRows = std::min(chunkRows, rows.GetHeight() - y0);
+        rows.Fetch(y0, numRows);
+        for (unsigned y = y0; y < y0 + numRows; ++y)
+        {
+            fits_write_img(
+                fptr.GetFile(), datatype, 1 + static_cast<LONGLONG>(y) * dimensions[0], dimensions[0],
+                const_cast<void*>(rows.GetRow(y)), &status
+            );
+        }
+    }
 
     if (status) { return false; }
 
@@ -434,18 +476,18 @@ static std::tuple<FREE_IMAGE_FORMAT, int> GetFiFormatAndFlags(OutputFileType out
     }
 }
 
-static bool SaveAsFreeImage(const IImageBuffer& buf, const fs::path& fname, OutputFileType outpFileType)
+static bool SaveAsFreeImage(c_RowReader& rows, const fs::path& fname, OutputFileType outpFileType)
 {
 #if USE_CFITSIO
     IMPPG_ASSERT(outpFileType != OutputFileType::FITS);
 #endif
-    IMPPG_ASSERT(buf.GetPixelFormat() != PixelFormat::PIX_PAL8);
+    IMPPG_ASSERT(rows.GetPixelFormat() != PixelFormat::PIX_PAL8);
 
     bool result = false;
 
     FREE_IMAGE_TYPE fiType = FIT_UNKNOWN;
     int fiBpp = 8;
-    switch (buf.GetPixelFormat())
+    switch (rows.GetPixelFormat())
     {
     case PixelFormat::PIX_MONO8:
         fiType = FIT_BITMAP;
@@ -491,37 +533,39 @@ static bool SaveAsFreeImage(const IImageBuffer& buf, const fs::path& fname, Outp
 
     //FIXME! static_assert(false, "FIXME: wrong channel order when saving RGB after Combine");
 
-    c_FreeImageHandleWrapper outputFiBmp = FreeImage_AllocateT(
-        fiType, buf.GetWidth(), buf.GetHeight(), fiBpp
-    );
+    const unsigned width = rows.GetWidth();
+    const unsigned height = rows.GetHeight();
+
+    c_FreeImageHandleWrapper outputFiBmp = FreeImage_AllocateT(fiType, width, height, fiBpp);
 
     if (!outputFiBmp)
         return false;
 
-    if (FIT_BITMAP == fiType && 24 == fiBpp)
+    // FreeImage stores the rows bottom-up
+    const unsigned chunkRows = rows.GetDefaultChunkRows();
+    for (unsigned y1 = height; y1 > 0;)
     {
-        for (unsigned row = 0; row < buf.GetHeight(); row++)
+        const unsigned y0 = (y1 > chunkRows) ? y1 - chunkRows : 0;
+        rows.Fetch(y0, y1 - y0);
+        for (unsigned y = y0; y < y1; ++y)
         {
-            const auto* srcRow = static_cast<const std::uint8_t*>(buf.GetRow(buf.GetHeight() - 1 - row));
-            std::uint8_t* destRow = FreeImage_GetScanLine(outputFiBmp.get(), row);
-            for (unsigned x = 0; x < buf.GetWidth(); ++x)
+            std::uint8_t* destRow = FreeImage_GetScanLine(outputFiBmp.get(), height - 1 - y);
+            if (FIT_BITMAP == fiType && 24 == fiBpp)
             {
-                destRow[3 * x + 0] = srcRow[3 * x + 2];
-                destRow[3 * x + 1] = srcRow[3 * x + 1];
-                destRow[3 * x + 2] = srcRow[3 * x + 0];
+                const auto* srcRow = rows.GetRowAs<std::uint8_t>(y);
+                for (unsigned x = 0; x < width; ++x)
+                {
+                    destRow[3 * x + 0] = srcRow[3 * x + 2];
+                    destRow[3 * x + 1] = srcRow[3 * x + 1];
+                    destRow[3 * x + 2] = srcRow[3 * x + 0];
+                }
+            }
+            else
+            {
+                memcpy(destRow, rows.GetRow(y), width * rows.GetBytesPerPixel());
             }
         }
-    }
-    else
-    {
-        for (unsigned row = 0; row < buf.GetHeight(); row++)
-        {
-            memcpy(
-                FreeImage_GetScanLine(outputFiBmp.get(), row),
-                buf.GetRow(buf.GetHeight() - 1 - row),
-                buf.GetWidth() * buf.GetBytesPerPixel()
-            );
-        }
+        y1 = y0;
     }
 
     const auto [fiFmt, fiFlags] = GetFiFormatAndFlags(outpFileType);
@@ -534,14 +578,64 @@ static bool SaveAsFreeImage(const IImageBuffer& buf, const fs::path& fname, Outp
 }
 #endif // if USE_FREEIMAGE
 
+static bool SaveRows(c_RowReader& rows, const fs::path& fname, OutputFileType outpFileType)
+{
+    const PixelFormat destPixFmt = rows.GetPixelFormat();
+
+#if USE_CFITSIO
+    if (outpFileType == OutputFileType::FITS)
+    {
+        return SaveAsFits(rows, fname);
+    }
+#endif
 
-/// Simple image buffer; pixels are stored in row-major order with no padding.
+    if (const auto tiffCompression = GetNativeTiffCompression(destPixFmt, outpFileType))
+    {
+        return SaveTiff(fname, rows, *tiffCompression, g_TiffWriteOptions);
+    }
+
+#if USE_FREEIMAGE
+    return SaveAsFreeImage(rows, fname, outpFileType);
+#else
+    switch (outpFileType)
+    {
+        case OutputFileType::BMP: return SaveBmp(fname, rows);
+        default: IMPPG_ABORT();
+    }
+#endif
+}
+
+/// Saves `buf` converted to `destPixFmt`; the writers convert the rows in chunks, as they go.
+static bool SaveConverted(const IImageBuffer& buf, PixelFormat destPixFmt, const fs::path& fname, OutputFileType outpFileType)
+{
+    c_RowReader rows(buf, destPixFmt);
+    return SaveRows(rows, fname, outpFileType);
+}
+
+
+std::size_t GetPaddedRowStride(unsigned width, std::size_t bytesPerPixel)
+{
+    // smallest multiple of both the alignment and the pixel size
+    std::size_t unit = IMAGE_ROW_ALIGNMENT;
+    while (unit % bytesPerPixel != 0) { unit += IMAGE_ROW_ALIGNMENT; }
+
+    std::size_t stride = (width * bytesPerPixel + unit - 1) / unit * unit;
+    if (stride > 0 && stride % 512 == 0)
+    {
+        stride += unit;
+    }
+
+    return stride;
+}
+
+/// Simple image buffer; pixels are stored in row-major order, rows are aligned and padded (see `GetPaddedRowStride`).
 class c_SimpleBuffer: public IImageBuffer
 {
     PixelFormat m_PixFmt;
     unsigned m_Width, m_Height;
     size_t m_BytesPerPixel;
-    std::unique_ptr<uint8_t[]> m_Pixels;
+    size_t m_BytesPerRow;
+    AlignedBlock m_Pixels;
     Palette m_Palette{};
 
 public:
@@ -549,20 +643,16 @@ public:
     : m_PixFmt(pixFmt),
       m_Width(width),
       m_Height(height),
-      m_BytesPerPixel(BytesPerPixel[static_cast<size_t>(pixFmt)])
-    {
-        m_Pixels.reset(new uint8_t[m_Width * m_Height * m_BytesPerPixel]);
-    }
+      m_BytesPerPixel(BytesPerPixel[static_cast<size_t>(pixFmt)]),
+      m_BytesPerRow(GetPaddedRowStride(m_Width, m_BytesPerPixel)),
+      m_Pixels(AllocateAligned(m_BytesPerRow * m_Height))
+    {}
 
     c_SimpleBuffer(const IImageBuffer& src)
-    : m_PixFmt(src.GetPixelFormat()),
-      m_Width(src.GetWidth()),
-      m_Height(src.GetHeight()),
-      m_BytesPerPixel(src.GetBytesPerPixel())
+    : c_SimpleBuffer(src.GetWidth(), src.GetHeight(), src.GetPixelFormat())
     {
-        m_Pixels.reset(new uint8_t[m_Width * m_Height * m_BytesPerPixel]);
         for (unsigned row = 0; row < m_Height; ++row)
-            memcpy(m_Pixels.get() + row * GetBytesPerRow(), src.GetRow(row), GetBytesPerRow());
+            memcpy(GetRow(row), src.GetRow(row), m_Width * m_BytesPerPixel);
 
         memcpy(&m_Palette, &src.GetPalette(), sizeof(m_Palette));
     }
@@ -571,13 +661,13 @@ public:
 
     unsigned GetHeight() const override { return m_Height; }
 
-    size_t GetBytesPerRow() const override { return m_Width * m_BytesPerPixel; }
+    size_t GetBytesPerRow() const override { return m_BytesPerRow; }
 
     size_t GetBytesPerPixel() const override { return m_BytesPerPixel; }
 
-    void* GetRow(size_t row) override { return m_Pixels.get() + row * m_Width * m_BytesPerPixel; }
+    void* GetRow(size_t row) override { return m_Pixels.get() + row * m_BytesPerRow; }
 
-    const void* GetRow(size_t row) const override { return m_Pixels.get() + row * m_Width * m_BytesPerPixel; }
+    const void* GetRow(size_t row) const override { return m_Pixels.get() + row * m_BytesPerRow; }
 
     PixelFormat GetPixelFormat() const override { return m_PixFmt; }
 
@@ -588,7 +678,7 @@ public:
     std::unique_ptr<IImageBuffer> GetCopy() const override
     {
         std::unique_ptr<c_SimpleBuffer> copy(new c_SimpleBuffer(m_Width, m_Height, m_PixFmt));
-        memcpy(copy->m_Pixels.get(), m_Pixels.get(), m_Width * m_Height * m_BytesPerPixel);
+        memcpy(copy->m_Pixels.get(), m_Pixels.get(), m_BytesPerRow * m_Height);
         memcpy(&copy->m_Palette, &m_Palette, sizeof(m_Palette));
         return copy;
     }
@@ -596,23 +686,62 @@ public:
 private:
     bool SaveToFile(const std::filesystem::path& fname, OutputFileType outpFileType) const override
     {
-#if USE_CFITSIO
-        if (outpFileType == OutputFileType::FITS)
-        {
-            return SaveAsFits(*this, fname);
-        }
-#endif
+        return SaveConverted(*this, m_PixFmt, fname, outpFileType);
+    }
+};
 
-#if USE_FREEIMAGE
-        return SaveAsFreeImage(*this, fname, outpFileType);
-#else
-        switch (outpFileType)
-        {
-            case OutputFileType::BMP: return SaveBmp(fname, *this);
-            case OutputFileType::TIFF: return SaveTiff(fname, *this);
-            default: IMPPG_ABORT();
-        }
-#endif
+/// A plane of `c_PlanarBuffer`; shares the ownership of the buffer's pixel memory.
+class c_PlaneBuffer: public IImageBuffer
+{
+    PixelFormat m_PixFmt;
+    unsigned m_Width, m_Height;
+    size_t m_BytesPerPixel;
+    size_t m_BytesPerRow;
+    std::shared_ptr<uint8_t[]> m_Storage;
+    uint8_t* m_Pixels; ///< Points into `m_Storage`.
+    Palette m_Palette{};
+
+public:
+    c_PlaneBuffer(std::shared_ptr<uint8_t[]> storage, uint8_t* pixels, unsigned width, unsigned height, PixelFormat pixFmt)
+    : m_PixFmt(pixFmt),
+      m_Width(width),
+      m_Height(height),
+      m_BytesPerPixel(BytesPerPixel[static_cast<size_t>(pixFmt)]),
+      m_BytesPerRow(GetPaddedRowStride(width, m_BytesPerPixel)),
+      m_Storage(std::move(storage)),
+      m_Pixels(pixels)
+    {}
+
+    /// Returns another plane object referring to the same pixels.
+    std::unique_ptr<c_PlaneBuffer> Share() const
+    {
+        return std::make_unique<c_PlaneBuffer>(m_Storage, m_Pixels, m_Width, m_Height, m_PixFmt);
+    }
+
+    unsigned GetWidth() const override { return m_Width; }
+
+    unsigned GetHeight() const override { return m_Height; }
+
+    size_t GetBytesPerRow() const override { return m_BytesPerRow; }
+
+    size_t GetBytesPerPixel() const override { return m_BytesPerPixel; }
+
+    void* GetRow(size_t row) override { return m_Pixels + row * m_BytesPerRow; }
+
+    const void* GetRow(size_t row) const override { return m_Pixels + row * m_BytesPerRow; }
+
+    PixelFormat GetPixelFormat() const override { return m_PixFmt; }
+
+    Palette& GetPalette() override { return m_Palette; }
+
+    const Palette& GetPalette() const override { return m_Palette; }
+
+    std::unique_ptr<IImageBuffer> GetCopy() const override { return std::make_unique<c_SimpleBuffer>(*this); }
+
+private:
+    bool SaveToFile(const std::filesystem::path& fname, OutputFileType outpFileType) const override
+    {
+        return SaveConverted(*this, m_PixFmt, fname, outpFileType);
     }
 };
 
@@ -622,10 +751,15 @@ bool c_FreeImageBuffer::SaveToFile(const std::filesystem::path& fname, OutputFil
 #if USE_CFITSIO
     if (outpFileType == OutputFileType::FITS)
     {
-        return SaveAsFits(*this, fname);
+        return SaveConverted(*this, GetPixelFormat(), fname, outpFileType);
     }
 #endif
 
+    if (GetNativeTiffCompression(GetPixelFormat(), outpFileType).has_value())
+    {
+        return SaveConverted(*this, GetPixelFormat(), fname, outpFileType);
+    }
+
     const auto [fiFormat, fiFlags] = GetFiFormatAndFlags(outpFileType);
 
     auto file = OpenFile(fname, AccessMode::Write);
@@ -637,22 +771,82 @@ bool c_FreeImageBuffer::SaveToFile(const std::filesystem::path& fname, OutputFil
 
 /// Allocates memory for pixel data
 c_Image::c_Image(unsigned width, unsigned height, PixelFormat pixFmt)
+: m_Buffer(std::make_unique<c_SimpleBuffer>(width, height, pixFmt)),
+  m_Width(width),
+  m_Height(height),
+  m_PixelFormat(pixFmt)
+{}
+
+c_Image::c_Image(c_Image&& img) noexcept
+: m_Buffer(std::move(img.m_Buffer)),
+  m_Width(img.m_Width),
+  m_Height(img.m_Height),
+  m_PixelFormat(img.m_PixelFormat),
+  m_Exclusive(img.m_Exclusive.load())
+{}
+
+c_Image& c_Image::operator=(c_Image&& img) noexcept
 {
-    m_Buffer = std::make_unique<c_SimpleBuffer>(width, height, pixFmt);
+    if (this != &img)
+    {
+        m_Buffer = std::move(img.m_Buffer);
+        m_Width = img.m_Width;
+        m_Height = img.m_Height;
+        m_PixelFormat = img.m_PixelFormat;
+        m_Exclusive.store(img.m_Exclusive.load());
+    }
+
+    return *this;
 }
 
 c_Image& c_Image::operator=(const c_Image& img)
 {
-    c_Image newImg(img);
-    *this = std::move(newImg);
+    if (this != &img)
+    {
+        m_Buffer = img.m_Buffer;
+        m_Width = img.m_Width;
+        m_Height = img.m_Height;
+        m_PixelFormat = img.m_PixelFormat;
+        m_Exclusive.store(false);
+        img.m_Exclusive.store(false);
+    }
 
     return *this;
 }
 
-/// Performs a deep copy of 'img'
 c_Image::c_Image(const c_Image& img)
+: m_Buffer(img.m_Buffer),
+  m_Width(img.m_Width),
+  m_Height(img.m_Height),
+  m_PixelFormat(img.m_PixelFormat),
+  m_Exclusive(false)
 {
-    m_Buffer = img.m_Buffer->GetCopy();
+    img.m_Exclusive.store(false);
+}
+
+void c_Image::DetachShared(bool copyContents)
+{
+    // Serializes the first non-const accesses; there may be several concurrent ones (e.g. from an OpenMP loop),
+    // and the images sharing the buffer may be detached concurrently by other threads.
+    static std::mutex detachMutex;
+    std::lock_guard lock(detachMutex);
+
+    if (m_Exclusive.load(std::memory_order_relaxed)) { return; }
+
+    if (m_Buffer.use_count() > 1)
+    {
+        if (copyContents)
+        {
+            m_Buffer = m_Buffer->GetCopy();
+        }
+        else
+        {
+            auto newBuffer = std::make_shared<c_SimpleBuffer>(GetWidth(), GetHeight(), GetPixelFormat());
+            newBuffer->GetPalette() = m_Buffer->GetPalette();
+            m_Buffer = std::move(newBuffer);
+        }
+    }
+    m_Exclusive.store(true, std::memory_order_release);
 }
 
 /// Clears all pixels to zero value
@@ -662,26 +856,7 @@ void c_Image::ClearToZero()
     const unsigned w = GetWidth();
     const unsigned h = GetHeight();
     for (unsigned i = 0; i < h; i++)
-        memset(m_Buffer->GetRow(i), 0, w * m_Buffer->GetBytesPerPixel());
-}
-
-template<typename Src, typename Dest, typename ConversionFunc>
-void ConvertWholeLine(
-    ConversionFunc conversionOperations,
-    unsigned width,
-    const uint8_t* inPtr,
-    int inPtrStep,
-    uint8_t* outPtr,
-    int outPtrStep
-)
-{
-    for (unsigned i = 0; i < width; i++)
-    {
-        const auto* src = reinterpret_cast<const Src*>(inPtr);
-        conversionOperations(src, reinterpret_cast<Dest*>(outPtr));
-        inPtr += inPtrStep;
-        outPtr += outPtrStep;
-    }
+        memset(GetRow(i), 0, w * m_Buffer->GetBytesPerPixel());
 }
 
 static c_SimpleBuffer GetConvertedPixelFormatFragment(
@@ -699,372 +874,97 @@ static c_SimpleBuffer GetConvertedPixelFormatFragment(
     IMPPG_ASSERT(x0 + width <= srcBuf.GetWidth());
     IMPPG_ASSERT(y0 + height <= srcBuf.GetHeight());
 
-    if (srcBuf.GetPixelFormat() == destPixFmt)
+    if (srcBuf.GetPixelFormat() == destPixFmt && x0 == 0 && y0 == 0 && width == srcBuf.GetWidth() && height == srcBuf.GetHeight())
     {
-        if (x0 == 0 && y0 == 0 && width == srcBuf.GetWidth() && height == srcBuf.GetHeight())
-        {
-            return c_SimpleBuffer(srcBuf);
-        }
-        else // no conversion required, just copy the data
-        {
-            c_SimpleBuffer result(width, height, destPixFmt);
-
-            auto bpp = result.GetBytesPerPixel();
-            for (unsigned j = 0; j < height; j++)
-                for (unsigned i = 0; i < width; i++)
-                    memcpy(result.GetRowAs<uint8_t>(j),
-                           srcBuf.GetRowAs<uint8_t>(j + y0) + (i + x0) * bpp,
-                           width * bpp);
-
-            return result;
-        }
+        return c_SimpleBuffer(srcBuf);
     }
 
     c_SimpleBuffer destBuf(width, height, destPixFmt);
-
-    int inPtrStep = srcBuf.GetBytesPerPixel(),
-        outPtrStep = BytesPerPixel[static_cast<size_t>(destPixFmt)];
-
-    for (unsigned j = 0; j < height; j++)
+    if (destPixFmt == PixelFormat::PIX_PAL8)
     {
-        const uint8_t* inPtr = srcBuf.GetRowAs<uint8_t>(j + y0) + x0 * srcBuf.GetBytesPerPixel();
-        uint8_t* outPtr = destBuf.GetRowAs<uint8_t>(j);
-
-        switch (srcBuf.GetPixelFormat())
-        {
-        case PixelFormat::PIX_MONO8: {
-            switch (destPixFmt)
-            {
-            case PixelFormat::PIX_MONO16:
-                ConvertWholeLine<uint8_t, uint16_t>([](const uint8_t* src, uint16_t* dest) {
-                    *dest = static_cast<uint16_t>(*src) << 8;
-                },
-                width, inPtr, inPtrStep, outPtr, outPtrStep);
-                break;
-
-            case PixelFormat::PIX_MONO32F:
-                ConvertWholeLine<uint8_t, float>([](const uint8_t* src, float* dest) {
-                    *dest = *src * 1.0f/0xFF;
-                },
-                width, inPtr, inPtrStep, outPtr, outPtrStep);
-                break;
-
-            case PixelFormat::PIX_RGB8:
-                ConvertWholeLine<uint8_t, uint8_t>([](const uint8_t* src, uint8_t* dest) {
-                    dest[0] = dest[1] = dest[2] = *src;
-                },
-                width, inPtr, inPtrStep, outPtr, outPtrStep);
-                break;
-
-            case PixelFormat::PIX_RGB16:
-                ConvertWholeLine<uint8_t, uint16_t>([](const uint8_t* src, uint16_t* dest) {
-                    dest[0] = dest[1] = dest[2] = static_cast<uint16_t>(*src) << 8;
-                },
-                width, inPtr, inPtrStep, outPtr, outPtrStep);
-                break;
-
-            default: IMPPG_ABORT();
-            }
-        } break;
-
-        case PixelFormat::PIX_MONO16: {
-            switch (destPixFmt)
-            {
-            case PixelFormat::PIX_MONO8: ConvertWholeLine<uint16_t, uint8_t>([](const uint16_t* src, uint8_t* dest) {
-                *dest = static_cast<uint8_t>(*src >> 8);
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_MONO32F: ConvertWholeLine<uint16_t, float>([](const uint16_t* src, float* dest) {
-                *dest = *src * 1.0f/0xFFFF;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_RGB8: ConvertWholeLine<uint16_t, uint8_t>([](const uint16_t* src, uint8_t* dest) {
-                dest[0] = dest[1] = dest[2] = static_cast<uint8_t>(*src >> 8);
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_RGB16: ConvertWholeLine<uint16_t, uint16_t>([](const uint16_t* src, uint16_t* dest) {
-                dest[0] = dest[1] = dest[2] = *src;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            default: IMPPG_ABORT();
-            }
-        } break;
-
-        case PixelFormat::PIX_MONO32F: {
-            switch (destPixFmt)
-            {
-            case PixelFormat::PIX_MONO8: ConvertWholeLine<float, uint8_t>([](const float* src, uint8_t* dest) {
-                *dest = static_cast<uint8_t>(*src * 0xFF);
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_MONO16: ConvertWholeLine<float, uint16_t>([](const float* src, uint16_t* dest) {
-                *dest = static_cast<uint16_t>(*src * 0xFFFF);
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-            case PixelFormat::PIX_RGB8: ConvertWholeLine<float, uint8_t>([](const float* src, uint8_t* dest) {
-                dest[0] = dest[1] = dest[2] = static_cast<uint8_t>(*src * 0xFF);
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_RGB16: ConvertWholeLine<float, uint16_t>([](const float* src, uint16_t* dest) {
-                dest[0] = dest[1] = dest[2] =  static_cast<uint16_t>(*src * 0xFFFF);
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_RGB32F: ConvertWholeLine<float, float>([](const float* src, float* dest) {
-                dest[0] = dest[1] = dest[2] = src[0];
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            default: IMPPG_ABORT();
-            }
-        } break;
-
-        // when converting from a color format to mono, use sum (scaled) of all channels as the pixel brightness
-        case PixelFormat::PIX_PAL8: {
-            const IImageBuffer::Palette& palette = srcBuf.GetPalette();
-
-            switch (destPixFmt)
-            {
-            case PixelFormat::PIX_MONO8: ConvertWholeLine<uint8_t, uint8_t>([&palette](const uint8_t* src, uint8_t* dest) {
-                *dest = (palette[3*(*src)] + palette[3*(*src)+1] + palette[3*(*src)+2]) / 3;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_MONO16: ConvertWholeLine<uint8_t, uint16_t>([&palette](const uint8_t* src, uint16_t* dest) {
-                *dest = (palette[3*(*src)] + palette[3*(*src)+1] + palette[3*(*src)+2]) / 3;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_MONO32F: ConvertWholeLine<uint8_t, float>([&palette](const uint8_t* src, float* dest) {
-                *dest = (palette[3*(*src)] + palette[3*(*src)+1] + palette[3*(*src)+2]) * 1.0f / (3*0xFF);
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_RGB8: ConvertWholeLine<uint8_t, uint8_t>([&palette](const uint8_t* src, uint8_t* dest) {
-                dest[0] = palette[3*(*src)];
-                dest[1] = palette[3*(*src)+1];
-                dest[2] = palette[3*(*src)+2];
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_RGB16: ConvertWholeLine<uint8_t, uint16_t>([&palette](const uint8_t* src, uint16_t* dest) {
-                dest[0] = static_cast<uint16_t>(palette[3*(*src)]) << 8;
-                dest[1] = static_cast<uint16_t>(palette[3*(*src)+1]) << 8;
-                dest[2] = static_cast<uint16_t>(palette[3*(*src)+2]) << 8;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            default: IMPPG_ABORT();
-            }
-        } break;
-
-        case PixelFormat::PIX_RGB8:
-        case PixelFormat::PIX_RGBA8: {
-            switch (destPixFmt)
-            {
-            case PixelFormat::PIX_MONO8: ConvertWholeLine<uint8_t, uint8_t>([](const uint8_t* src, uint8_t* dest) {
-                *dest = (src[0] + src[1] + src[2]) / 3;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_MONO16: ConvertWholeLine<uint8_t, uint16_t>([](const uint8_t* src, uint16_t* dest) {
-                *dest = ((src[0] + src[1] + src[2]) << 8) / 3;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_MONO32F: ConvertWholeLine<uint8_t, float>([](const uint8_t* src, float* dest) {
-                *dest = (src[0] + src[1] + src[2]) * 1.0f/(3*0xFF);
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_RGB32F: ConvertWholeLine<uint8_t, float>([](const uint8_t* src, float* dest) {
-                dest[0] = src[0] / static_cast<float>(0xFF);
-                dest[1] = src[1] / static_cast<float>(0xFF);
-                dest[2] = src[2] / static_cast<float>(0xFF);
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_RGB16: ConvertWholeLine<uint8_t, uint16_t>([](const uint8_t* src, uint16_t* dest) {
-                dest[0] = src[0] << 8;
-                dest[1] = src[1] << 8;
-                dest[2] = src[2] << 8;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            default: IMPPG_ABORT();
-            }
-        } break;
-
-        case PixelFormat::PIX_BGR8:
-        case PixelFormat::PIX_BGRA8: {
-            switch (destPixFmt)
-            {
-            case PixelFormat::PIX_RGB8: ConvertWholeLine<uint8_t, uint8_t>([](const uint8_t* src, uint8_t* dest) {
-                dest[0] = src[2];
-                dest[1] = src[1];
-                dest[2] = src[0];
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_MONO8: ConvertWholeLine<uint8_t, uint8_t>([](const uint8_t* src, uint8_t* dest) {
-                *dest = (src[0] + src[1] + src[2]) / 3;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_MONO16: ConvertWholeLine<uint8_t, uint16_t>([](const uint8_t* src, uint16_t* dest) {
-                *dest = ((src[0] + src[1] + src[2]) << 8) / 3;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_MONO32F: ConvertWholeLine<uint8_t, float>([](const uint8_t* src, float* dest) {
-                *dest = (src[0] + src[1] + src[2]) * 1.0f/(3*0xFF);
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_RGB32F: ConvertWholeLine<uint8_t, float>([](const uint8_t* src, float* dest) {
-                dest[0] = src[2] / static_cast<float>(0xFF);
-                dest[1] = src[1] / static_cast<float>(0xFF);
-                dest[2] = src[0] / static_cast<float>(0xFF);
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_RGB16: ConvertWholeLine<uint8_t, uint16_t>([](const uint8_t* src, uint16_t* dest) {
-                dest[0] = src[2] << 8;
-                dest[1] = src[1] << 8;
-                dest[2] = src[0] << 8;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-
-            default: IMPPG_ABORT();
-            }
-        } break;
-
-        case PixelFormat::PIX_RGB16:
-        case PixelFormat::PIX_RGBA16: {
-            switch (destPixFmt)
-            {
-            case PixelFormat::PIX_MONO8: ConvertWholeLine<uint16_t, uint8_t>([](const uint16_t* src, uint8_t* dest) {
-                *dest = ((src[0] + src[1] + src[2]) / 3) >> 8;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
-
-            case PixelFormat::PIX_MONO16: ConvertWholeLine<uint16_t, uint16_t>([](const uint16_t* src, uint16_t* dest) {
-                *dest = (src[0] + src[1] + src[2]) / 3;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
+        destBuf.GetPalette() = srcBuf.GetPalette();
+    }
+    ConvertPixelFormatRows(srcBuf, x0, y0, width, height, destBuf);
 
-            case PixelFormat::PIX_MONO32F: ConvertWholeLine<uint16_t, float>([](const uint16_t* src, float* dest) {
-                *dest = (src[0] + src[1] + src[2]) * 1.0f/(3*0xFFFF);
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
+    return destBuf;
+}
 
-            case PixelFormat::PIX_RGB8: ConvertWholeLine<uint16_t, uint8_t>([](const uint16_t* src, uint8_t* dest) {
-                dest[0] = src[0] >> 8;
-                dest[1] = src[1] >> 8;
-                dest[2] = src[2] >> 8;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
+c_RowReader::c_RowReader(const IImageBuffer& source, PixelFormat destPixFmt)
+: m_Source(source),
+  m_DestPixFmt(destPixFmt),
+  m_PassThrough(source.GetPixelFormat() == destPixFmt)
+{
+    IMPPG_ASSERT(!(destPixFmt == PixelFormat::PIX_PAL8 && source.GetPixelFormat() != PixelFormat::PIX_PAL8));
+}
 
-            case PixelFormat::PIX_RGB32F: ConvertWholeLine<std::uint16_t, float>([](const std::uint16_t* src, float* dest) {
-                dest[0] = static_cast<float>(src[0]) / 0xFFFF;
-                dest[1] = static_cast<float>(src[1]) / 0xFFFF;
-                dest[2] = static_cast<float>(src[2]) / 0xFFFF;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
+c_RowReader::~c_RowReader()
+{
+    if (m_NextChunk.valid()) { m_NextChunk.wait(); }
+}
 
-            default: IMPPG_ABORT();
-            }
-        } break;
+std::unique_ptr<IImageBuffer> c_RowReader::ConvertRows(unsigned y0, unsigned numRows) const
+{
+    return std::make_unique<c_SimpleBuffer>(
+        GetConvertedPixelFormatFragment(m_Source, m_DestPixFmt, 0, y0, m_Source.GetWidth(), numRows)
+    );
+}
 
-        case PixelFormat::PIX_RGB32F:
-        case PixelFormat::PIX_RGBA32F: {
-            switch (destPixFmt)
-            {
-            case PixelFormat::PIX_MONO8: ConvertWholeLine<float, uint8_t>([](const float* src, uint8_t* dest) {
-                *dest = ((src[0] + src[1] + src[2]) / 3) * 0xFF;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
+void c_RowReader::Fetch(unsigned y0, unsigned numRows)
+{
+    IMPPG_ASSERT(numRows > 0 && y0 + numRows <= GetHeight());
 
-            case PixelFormat::PIX_MONO16: ConvertWholeLine<float, uint16_t>([](const float* src, uint16_t* dest) {
-                *dest = ((src[0] + src[1] + src[2]) / 3) * 0xFFFF;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
+    // If this is the first fetch, assume reading bottom-up if it starts at the last row.
+    const bool readingBackwards = (m_ChunkNumRows > 0) ? (y0 < m_ChunkY0) : (y0 + numRows == GetHeight() && y0 > 0);
 
-            case PixelFormat::PIX_MONO32F: ConvertWholeLine<float, float>([](const float* src, float* dest) {
-                *dest = (src[0] + src[1] + src[2]) / 3.0;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
+    m_ChunkY0 = y0;
+    m_ChunkNumRows = numRows;
 
-            case PixelFormat::PIX_RGB8: ConvertWholeLine<float, uint8_t>([](const float* src, uint8_t* dest) {
-                dest[0] = src[0] * 0xFF;
-                dest[1] = src[1] * 0xFF;
-                dest[2] = src[2] * 0xFF;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
+    if (m_PassThrough) { return; }
 
-            case PixelFormat::PIX_RGB16: ConvertWholeLine<float, uint16_t>([](const float* src, uint16_t* dest) {
-                dest[0] = src[0] * 0xFFFF;
-                dest[1] = src[1] * 0xFFFF;
-                dest[2] = src[2] * 0xFFFF;
-            },
-            width, inPtr, inPtrStep, outPtr, outPtrStep);
-            break;
+    if (m_NextChunk.valid() && m_NextY0 == y0 && m_NextNumRows == numRows)
+    {
+        m_Chunk = m_NextChunk.get();
+    }
+    else
+    {
+        if (m_NextChunk.valid()) { m_NextChunk.get(); } // discard a mispredicted chunk
+        m_Chunk = ConvertRows(y0, numRows);
+    }
 
-            default: IMPPG_ABORT();
-            }
-        } break;
+    // start converting the next chunk
+    if (readingBackwards)
+    {
+        m_NextY0 = (y0 > numRows) ? y0 - numRows : 0;
+        m_NextNumRows = y0 - m_NextY0;
+    }
+    else
+    {
+        m_NextY0 = y0 + numRows;
+        m_NextNumRows = std::min(numRows, GetHeight() - m_NextY0);
+    }
 
-        default: IMPPG_ABORT();
-        }
+    if (m_NextNumRows > 0)
+    {
+        m_NextChunk = std::async(std::launch::async, [this, nextY0 = m_NextY0, nextNumRows = m_NextNumRows]() {
+            return ConvertRows(nextY0, nextNumRows);
+        });
     }
+}
 
-    return destBuf;
+unsigned c_RowReader::GetDefaultChunkRows() const
+{
+    const std::size_t bytesPerRow = std::max<std::size_t>(1, GetWidth() * GetBytesPerPixel());
+    return static_cast<unsigned>(std::clamp<std::size_t>(DEFAULT_CHUNK_BYTES / bytesPerRow, 1, GetHeight()));
 }
 
-static c_SimpleBuffer GetConvertedPixelFormatCopy(const IImageBuffer& srcBuf, PixelFormat destPixFmt)
+const void* c_RowReader::GetRow(unsigned y) const
 {
-    return GetConvertedPixelFormatFragment(srcBuf, destPixFmt, 0, 0, srcBuf.GetWidth(), srcBuf.GetHeight());
+    IMPPG_ASSERT(y >= m_ChunkY0 && y < m_ChunkY0 + m_ChunkNumRows);
+
+    if (m_PassThrough)
+        return m_Source.GetRow(y);
+    else
+        return m_Chunk->GetRow(y - m_ChunkY0);
 }
 
 /** Converts 'srcImage' to 'destPixFmt'; ; result uses c_SimpleBuffer for storage.
@@ -1139,17 +1039,36 @@ inline float ClampLuminance(float val, float maxVal)
         return val;
 }
 
-/// Cubic (Hermite) interpolation of 4 subsequent values fm1, f0, f1, f2 at location 0<=t<=1 between the middle elements (f0 and f1)
-template<typename T>
-inline float InterpolateCubic(float t, T fm1, T f0, T f1, T f2)
-{
-    float delta_k = static_cast<float>(f1) - f0;
-    float dk = (static_cast<float>(f1) - fm1)*0.5f, dk1 = (static_cast<float>(f2) - f0)*0.5f;
+/// Number of output rows of a single sub-pixel translation band (see `ResizeAndTranslateImpl`).
+constexpr int SUBPIXEL_SHIFT_BAND_ROWS = 32;
 
-    float a0 = f0, a1 = dk, a2 = 3.0f*delta_k - 2.0f*dk - dk1,
-        a3 = static_cast<float>(dk) + dk1 - 2.0f*delta_k;
+/// Returns the weights of 4 subsequent values fm1, f0, f1, f2 whose sum gives their cubic (Hermite) interpolation
+/// at location 0<=t<=1 between the middle elements (f0 and f1).
+std::array<float, 4> GetCubicInterpolationWeights(float t)
+{
+    const float t2 = t * t;
+    const float t3 = t2 * t;
+    return {
+        -0.5f*t + t2 - 0.5f*t3,
+        1.0f - 2.5f*t2 + 1.5f*t3,
+        0.5f*t + 2.0f*t2 - 1.5f*t3,
+        -0.5f*t2 + 0.5f*t3
+    };
+}
 
-    return t*(t*(a3*t + a2)+a1)+a0;
+/// Sets `output[i]` to the weighted sum of `input[i + offsets[k]]`, k = 0..3.
+template<typename T>
+void InterpolateCubicRow(const T* input, float* output, int length, const std::array<float, 4>& weights, const std::array<int, 4>& offsets)
+{
+    const T* in0 = input + offsets[0];
+    const T* in1 = input + offsets[1];
+    const T* in2 = input + offsets[2];
+    const T* in3 = input + offsets[3];
+    for (int i = 0; i < length; i++)
+    {
+        output[i] = weights[0] * static_cast<float>(in0[i]) + weights[1] * static_cast<float>(in1[i]) +
+                    weights[2] * static_cast<float>(in2[i]) + weights[3] * static_cast<float>(in3[i]);
+    }
 }
 
 template<typename Lum_t>
@@ -1275,40 +1194,62 @@ void ResizeAndTranslateImpl(
         int idx = xOfsFrac < 0.0f ? 1 : -1;
         int idy = yOfsFrac < 0.0f ? 1 : -1;
 
-        xOfsFrac = std::fabs(xOfsFrac);
-        yOfsFrac = std::fabs(yOfsFrac);
+        // The fractional offsets are the same for all pixels, so are the interpolation weights
+        const std::array<float, 4> xWeights = GetCubicInterpolationWeights(std::fabs(xOfsFrac));
+        const std::array<float, 4> yWeights = GetCubicInterpolationWeights(std::fabs(yOfsFrac));
 
-        int numChannels = NumChannels[static_cast<size_t>(srcImg.GetPixelFormat())];
+        const int numChannels = NumChannels[static_cast<size_t>(srcImg.GetPixelFormat())];
 
         // Skip 2-pixels borders on each side of the image
+        const int rowStart = destYstart + 2, rowEnd = destYend - 2;
+        const int colStart = destXstart + 2, colEnd = destXend - 2;
+        if (rowEnd < rowStart || colEnd < colStart) { return; }
+
+        // Output pixel (col, row) is interpolated from source pixels (srcX + k*idx, srcY + m*idy), k, m = -1..2,
+        // where srcX = col - xOfsInt + srcXmin, srcY = row - yOfsInt + srcYmin. Channels are interleaved,
+        // so the horizontal interpolation is applied to rows of values using offsets scaled by the number of channels.
+        const std::array<int, 4> xOffsets{ -idx * numChannels, 0, idx * numChannels, 2 * idx * numChannels };
+        const int minRelY = std::min(-idy, 2 * idy);
+        const int maxRelY = std::max(-idy, 2 * idy);
+
+        const int rowLength = (colEnd - colStart + 1) * numChannels; // in values
+        const int srcRowStart = (colStart - xOfsInt + srcXmin) * numChannels;
+        const int numBands = (rowEnd - rowStart + SUBPIXEL_SHIFT_BAND_ROWS) / SUBPIXEL_SHIFT_BAND_ROWS;
+
+        // Separable interpolation: each band's source rows are interpolated horizontally (once), then the results
+        // are interpolated vertically.
         #pragma omp parallel for
-        for (int row = destYstart+2; row <= destYend-2; row++)
+        for (int band = 0; band < numBands; band++)
         {
-            for (int col = destXstart+2; col <= destXend-2; col++)
+            const int bandStart = rowStart + band * SUBPIXEL_SHIFT_BAND_ROWS;
+            const int bandEnd = std::min(rowEnd, bandStart + SUBPIXEL_SHIFT_BAND_ROWS - 1);
+
+            // Source rows used by the band
+            const int srcYfirst = bandStart - yOfsInt + srcYmin + minRelY;
+            const int srcYlast = bandEnd - yOfsInt + srcYmin + maxRelY;
+
+            std::vector<float> horzInterpolated(static_cast<std::size_t>(srcYlast - srcYfirst + 1) * rowLength);
+            for (int srcY = srcYfirst; srcY <= srcYlast; srcY++)
             {
-                for (int ch = 0; ch < numChannels; ch++)
-                {
-                    float yvals[4];
+                InterpolateCubicRow(
+                    srcImg.GetRowAs<Lum_t>(srcY) + srcRowStart,
+                    &horzInterpolated[static_cast<std::size_t>(srcY - srcYfirst) * rowLength],
+                    rowLength,
+                    xWeights,
+                    xOffsets
+                );
+            }
 
-                    // Perform 4 interpolations at 4 adjacent rows, using X offsets -1, 0, 1, 2 (*idx)
-                    int y = row - idy;
-                    int srcY = y - yOfsInt + srcYmin;
-                    for (int relY = -1; relY <= 2; relY++)
-                    {
-                        int srcX = col - xOfsInt + srcXmin;
-                        yvals[relY+1] = InterpolateCubic(xOfsFrac,
-                            srcImg.GetRowAs<Lum_t>(srcY)[(srcX - idx)*numChannels + ch],
-                            srcImg.GetRowAs<Lum_t>(srcY)[(srcX      )*numChannels + ch],
-                            srcImg.GetRowAs<Lum_t>(srcY)[(srcX + idx)*numChannels + ch],
-                            srcImg.GetRowAs<Lum_t>(srcY)[(srcX + idx + idx)*numChannels + ch]);
-
-                        y += idy;
-                        srcY += idy;
-                    }
+            std::vector<float> vertInterpolated(rowLength);
+            for (int row = bandStart; row <= bandEnd; row++)
+            {
+                const float* srcRow = &horzInterpolated[static_cast<std::size_t>(row - yOfsInt + srcYmin - srcYfirst) * rowLength];
+                InterpolateCubicRow(srcRow, vertInterpolated.data(), rowLength, yWeights,
+                    { -idy * rowLength, 0, idy * rowLength, 2 * idy * rowLength });
 
-                    // Perform the final vertical (column) interpolation of the 4 horizontal (row) values interpolated previously
-                    destImg.GetRowAs<Lum_t>(row)[col*numChannels + ch] = static_cast<Lum_t>(ClampLuminance(InterpolateCubic(yOfsFrac, yvals[0], yvals[1], yvals[2], yvals[3]), maxLum));
-                }
+                Lum_t* destRow = destImg.GetRowAs<Lum_t>(row) + colStart * numChannels;
+                for (int i = 0; i < rowLength; i++)
+                    destRow[i] = static_cast<Lum_t>(ClampLuminance(vertInterpolated[i], maxLum));
             }
         }
     }
@@ -1358,191 +1299,171 @@ void NormalizeFpImage(c_Image& img, float minLevel, float maxLevel)
         img.GetPixelFormat() == PixelFormat::PIX_RGB32F
     );
 
-    const std::size_t numChannels = NumChannels[static_cast<std::size_t>(img.GetPixelFormat())];
-
-    // min and max brightness in the input image
-    float lmin = FLT_MAX;
-    float lmax = -FLT_MAX;
-    for (unsigned row = 0; row < img.GetHeight(); row++)
-        for (unsigned col = 0; col < img.GetWidth() * numChannels; col++)
-        {
-            const float val = img.GetRowAs<float>(row)[col];
-            if (val < lmin)
-                lmin = val;
-            if (val > lmax)
-                lmax = val;
-        }
+    const ValueRange range = GetValueRange(std::as_const(img).GetBuffer());
+    TransformValues(img.GetBuffer(), LevelsTransform::Normalization(range, minLevel, maxLevel));
+}
 
-    // Determine coefficients 'a' and 'b' which satisfy: new_luminance := a * old_luminance + b
-    const float a = (maxLevel - minLevel) / (lmax - lmin);
-    const float b = maxLevel - a * lmax;
+void LimitFitsValues(c_Image& image, bool normalize)
+{
+    if (image.GetPixelFormat() != PixelFormat::PIX_MONO32F) { return; }
 
-    // Pixels with brightness 'minLevel' become black and those of 'maxLevel' become white.
+    // If any value is < 0, set it to 0. If all remaining values are <= 1.0,
+    // leave them unchanged. If the maximum value is > 1.0, scale everything down
+    // so that maximum is 1.0.
 
-    for (unsigned row = 0; row < img.GetHeight(); row++)
-        for (unsigned col = 0; col < img.GetWidth() * numChannels; col++)
+    const unsigned width = image.GetWidth();
+    const unsigned height = image.GetHeight();
+    std::vector<float> rowMaxVals(height, 0.0f);
+    #pragma omp parallel for
+    for (int y = 0; y < static_cast<int>(height); y++)
+    {
+        float* row = image.GetRowAs<float>(y);
+        float rowMax = 0.0f;
+        for (unsigned x = 0; x < width; x++)
         {
-            float& val = img.GetRowAs<float>(row)[col];
-            val = a * val + b;
-            if (val < 0.0f)
-                val = 0.0f;
-            else if (val > 1.0f)
-                val = 1.0f;
+            row[x] = std::max(row[x], 0.0f);
+            rowMax = std::max(rowMax, row[x]);
         }
-}
+        rowMaxVals[y] = rowMax;
+    }
 
-#if USE_CFITSIO
-static std::optional<std::tuple<std::size_t, ModifiableUniquePtr>> LoadFileIntoBuffer(const fs::path& path)
-{
-    ModifiableUniquePtr buffer;
-    std::size_t bufferSize{0};
-    std::ifstream file{path, std::ios::binary};
-    if (!file.is_open()) { return std::nullopt; }
-    file.seekg(0, std::ios_base::end);
-    bufferSize = static_cast<std::size_t>(file.tellg());
-    buffer.Alloc(bufferSize);
-    file.seekg(0, std::ios_base::beg);
-    file.read(static_cast<char*>(buffer.GetData()), bufferSize);
-    if (!file.good()) { return std::nullopt; }
-    std::tuple<std::size_t, ModifiableUniquePtr> result{bufferSize, std::move(buffer)};
-    return result;
+    float maxval = 0.0f;
+    for (float rowMax: rowMaxVals) { maxval = std::max(maxval, rowMax); }
+
+    if (maxval > 1.0f)
+    {
+        // either scale down or clamp the values to 1.0
+        TransformValues(image.GetBuffer(), LevelsTransform{normalize ? 1.0f / maxval : 1.0f, 0.0f});
+    }
 }
 
-std::optional<c_Image> LoadFitsImage(const fs::path& fname, bool normalize)
+#if USE_CFITSIO
+/// FITS file opened from a read-only memory mapping (so that it does not have to be read into a buffer first).
+class c_MappedFitsFile
 {
-    constexpr std::size_t BUF_SIZE_DELTA = 512 * 1024;
+public:
+    /// Returns null on error.
+    static std::unique_ptr<c_MappedFitsFile> Open(const fs::path& path)
+    {
+        auto mapping = c_MappedFile::Open(path);
+        if (!mapping) { return nullptr; }
 
-    auto file_load_result = LoadFileIntoBuffer(fname);
-    if (!file_load_result.has_value()) { return std::nullopt; }
+        std::unique_ptr<c_MappedFitsFile> result{new c_MappedFitsFile(std::move(*mapping))};
+        // `cfitsio` does not modify a memory file opened as READONLY (hence also no reallocation function is needed).
+        int status = 0;
+        fits_open_memfile(result->m_File.GetFilePtr(), "(ignored)", READONLY, &result->m_Data, &result->m_Size, 0, nullptr, &status);
+        if (status) { return nullptr; }
 
-    auto [bufferSize, buffer] = std::move(file_load_result.value());
+        return result;
+    }
 
-    FitsFileFinalizer fptr;
+    c_MappedFitsFile(const c_MappedFitsFile&) = delete;
+    c_MappedFitsFile& operator=(const c_MappedFitsFile&) = delete;
 
-    int status = 0;
-    long dimensions[3] = { 0 };
-    int naxis;
-    int bitsPerPixel;
+    fitsfile* GetFile() const { return m_File.GetFile(); }
+
+private:
+    explicit c_MappedFitsFile(c_MappedFile&& mapping)
+    : m_Mapping(std::move(mapping)),
+      m_Data(const_cast<uint8_t*>(m_Mapping.GetData())),
+      m_Size(m_Mapping.GetSize())
+    {}
+
+    c_MappedFile m_Mapping;
 
-    fits_open_memfile(fptr.GetFilePtr(), "(ignored)", READONLY, buffer.GetBufPtr(), &bufferSize, BUF_SIZE_DELTA, &std::realloc, &status);
+    // `cfitsio` stores the addresses of `m_Data` and `m_Size` (hence the object is not movable).
+    void* m_Data;
+    std::size_t m_Size;
 
-    while (0 == status)
+    FitsFileFinalizer m_File; ///< Declared last, so that it is closed before the mapping is released.
+};
+
+/// Moves to the first HDU containing an image and reads its header; returns `false` on error.
+static bool ReadFitsImageHeader(fitsfile* file, int& bitsPerPixel, long (&dimensions)[3])
+{
+    int status = 0;
+    int naxis = 0;
+    while (true)
     {
-        fits_read_imghdr(fptr.GetFile(), 3, 0, &bitsPerPixel, &naxis, dimensions, 0, 0, 0, &status);
-        if (0 == status && (naxis > 3 || naxis <= 0))
-        {
-            // try opening a subsequent HDU; sometimes HDU [0] has 0 size (e.g., in some files from SDO)
-            int hduType{0};
-            fits_movrel_hdu(fptr.GetFile(), 1, &hduType, &status);
-            continue;
-        }
-        else if (status)
-        {
-            return std::nullopt;
-        }
-        else
-            break;
+        fits_read_imghdr(file, 3, 0, &bitsPerPixel, &naxis, dimensions, 0, 0, 0, &status);
+        if (status) { return false; }
+        if (naxis > 0 && naxis <= 3) { return true; }
 
-        //TODO: if 3 axes are detected, convert RGB to grayscale; now we only load the first channel
+        // try opening a subsequent HDU; sometimes HDU [0] has 0 size (e.g., in some files from SDO)
+        int hduType{0};
+        fits_movrel_hdu(file, 1, &hduType, &status);
+        if (status) { return false; }
     }
+}
+
+std::optional<c_Image> LoadRawFitsImage(const fs::path& fname)
+{
+    const auto fitsFile = c_MappedFitsFile::Open(fname);
+    if (!fitsFile) { return std::nullopt; }
+
+    int bitsPerPixel{0};
+    long dimensions[3] = { 0 };
+    if (!ReadFitsImageHeader(fitsFile->GetFile(), bitsPerPixel, dimensions)) { return std::nullopt; }
+    //TODO: if 3 axes are detected, convert RGB to grayscale; now we only load the first channel
 
     if (dimensions[0] < 0 || dimensions[1] < 0)
         return std::nullopt;
 
-    size_t numPixels = dimensions[0] * dimensions[1];
-    std::unique_ptr<uint8_t[]> fitsPixels{nullptr};
+    const unsigned width = static_cast<unsigned>(dimensions[0]);
+    const unsigned height = static_cast<unsigned>(dimensions[1]);
     int destType; // data type that the pixels will be converted to on read
     PixelFormat pixFmt;
 
     switch (bitsPerPixel)
     {
     case BYTE_IMG:
-        fitsPixels.reset(new uint8_t[numPixels * sizeof(uint8_t)]);
         destType = TBYTE;
         pixFmt = PixelFormat::PIX_MONO8;
         break;
 
     case SHORT_IMG:
-        fitsPixels.reset(new uint8_t[numPixels * sizeof(uint16_t)]);
         destType = TUSHORT;
         pixFmt = PixelFormat::PIX_MONO16;
         break;
 
     default:
         // all the remaining types will be converted to 32-bit floating-point
-        fitsPixels.reset(new uint8_t[numPixels * sizeof(float)]);
         destType = TFLOAT;
         pixFmt = PixelFormat::PIX_MONO32F;
         break;
     }
 
-    fits_read_img(fptr.GetFile(), destType, 1, numPixels, 0, fitsPixels.get(), 0, &status);
+    // Pixels are read directly into the rows of the result.
+    const auto readPixels = [&](c_Image& image) {
+        int status = 0;
+        for (unsigned row = 0; row < height && 0 == status; row++)
+        {
+            fits_read_img(fitsFile->GetFile(), destType, 1 + static_cast<LONGLONG>(row) * width, width, 0, image.GetRow(row), 0, &status);
+        }
+        return status;
+    };
+
+    auto result = c_Image(width, height, pixFmt);
+    int status = readPixels(result);
 
     if (NUM_OVERFLOW == status && (bitsPerPixel == BYTE_IMG || bitsPerPixel == SHORT_IMG))
     {
         // Input file had some negative values; let us just load it as floating-point
-        status = 0;
-        fitsPixels.reset(new uint8_t[numPixels * sizeof(float)]);
         destType = TFLOAT;
         pixFmt = PixelFormat::PIX_MONO32F;
-        fits_read_img(fptr.GetFile(), destType, 1, numPixels, 0, fitsPixels.get(), 0, &status);
-        if (status) { return std::nullopt; }
+        result = c_Image(width, height, pixFmt);
+        status = readPixels(result);
     }
 
     if (status) { return std::nullopt; }
 
+    return result;
+}
 
-    if (destType == TFLOAT)
-    {
-        // If any value is < 0, set it to 0. If all remaining values are <= 1.0,
-        // leave them unchanged. If the maximum value is > 1.0, scale everything down
-        // so that maximum is 1.0.
-
-        float maxval = 0.0f;
-        for (unsigned long y = 0; y < static_cast<unsigned long>(dimensions[1]); y++)
-            for (unsigned long  x = 0; x < static_cast<unsigned long>(dimensions[0]); x++)
-            {
-                float& val = reinterpret_cast<float*>(fitsPixels.get())[x + y*dimensions[0]];
-                if (val < 0.0f)
-                    val = 0.0f;
-                else if (val > maxval)
-                    maxval = val;
-            }
-
-        if (maxval > 1.0f)
-        {
-            if (normalize)
-            {
-                float maxvalinv = 1.0f/maxval;
-                for (int y = 0; y < dimensions[1]; y++)
-                    for (int x = 0; x < dimensions[0]; x++)
-                        reinterpret_cast<float*>(fitsPixels.get())[x + y*dimensions[0]] *= maxvalinv;
-            }
-            else
-            {
-                for (int y = 0; y < dimensions[1]; y++)
-                {
-                    for (int x = 0; x < dimensions[0]; x++)
-                    {
-                        float& val = reinterpret_cast<float*>(fitsPixels.get())[x + y*dimensions[0]];
-                        if (val > 1.0) val = 1.0;
-                    }
-                }
-            }
-        }
-    }
-
-    auto result = c_Image(dimensions[0], dimensions[1], pixFmt);
-    const auto bpp = BytesPerPixel[static_cast<size_t>(pixFmt)];
-    for (unsigned row = 0; row < result.GetHeight(); row++)
-    {
-        memcpy(
-            result.GetRow(row),
-            fitsPixels.get() + row * dimensions[0] * bpp,
-            dimensions[0] * bpp
-        );
-    }
-
+std::optional<c_Image> LoadFitsImage(const fs::path& fname, bool normalize)
+{
+    auto result = LoadRawFitsImage(fname);
+    if (result.has_value()) { LimitFitsValues(*result, normalize); }
     return result;
 }
 #endif
@@ -1577,6 +1498,18 @@ std::optional<c_Image> LoadImage(
 #endif
 
 #if USE_FREEIMAGE
+    if (extension == "tif" || extension == "tiff")
+    {
+        // The native reader is faster (decodes strips/tiles in parallel); files it does not support are read by FreeImage.
+        if (auto image = ReadTiff(fname))
+        {
+            if (destFmt.has_value() && image->GetPixelFormat() != destFmt.value())
+                return image->ConvertPixelFormat(destFmt.value());
+            else
+                return image;
+        }
+    }
+
     //TODO: add handling of FreeImage's error message (if any)
 
     auto file = OpenFile(fname, AccessMode::Read);
@@ -1647,20 +1580,55 @@ std::optional<c_Image> LoadImage(
 std::optional<c_Image> LoadImageFileAs32f(
     const fs::path& fname,
     bool normalizeFITSvalues,
+    const std::optional<std::tuple<float, float>>& normalizationLevels,
     std::string* errorMsg
 )
 {
-    const auto image = LoadImage(fname, std::nullopt, errorMsg, normalizeFITSvalues);
+    const auto extension = GetExtension(fname);
+    if (extension == "tif" || extension == "tiff")
+    {
+        // Fast path for files supported by the native reader; other ones are read by the general loader below.
+        ValueRange range{};
+        if (auto image = ReadTiffMappedAs32f(fname, normalizationLevels.has_value() ? &range : nullptr))
+        {
+            if (normalizationLevels.has_value())
+            {
+                const auto [minLevel, maxLevel] = normalizationLevels.value();
+                TransformValues(image->GetBuffer(), LevelsTransform::Normalization(range, minLevel, maxLevel));
+            }
+            return image;
+        }
+    }
+
+    auto image = LoadImage(fname, std::nullopt, errorMsg, normalizeFITSvalues);
     if (!image) { return std::nullopt; }
 
-    if (NumChannels[static_cast<std::size_t>(image->GetPixelFormat())] == 1)
+    const PixelFormat destPixFmt = (NumChannels[static_cast<std::size_t>(image->GetPixelFormat())] == 1)
+        ? PixelFormat::PIX_MONO32F
+        : PixelFormat::PIX_RGB32F;
+
+    std::optional<LevelsTransform> transform;
+    if (normalizationLevels.has_value())
     {
-        return image->ConvertPixelFormat(PixelFormat::PIX_MONO32F);
+        if (image->GetPixelFormat() == PixelFormat::PIX_PAL8)
+        {
+            // the range has to be found after conversion (the palette entries are averaged)
+            image = image->ConvertPixelFormat(destPixFmt);
+        }
+        const auto [minLevel, maxLevel] = normalizationLevels.value();
+        transform = LevelsTransform::Normalization(GetValueRange(std::as_const(*image).GetBuffer()), minLevel, maxLevel);
     }
-    else
+
+    if (image->GetPixelFormat() == destPixFmt)
     {
-        return image->ConvertPixelFormat(PixelFormat::PIX_RGB32F);
+        if (transform.has_value()) { TransformValues(image->GetBuffer(), transform.value()); }
+        return image;
     }
+
+    auto result = c_Image(image->GetWidth(), image->GetHeight(), destPixFmt);
+    ConvertPixelFormatRows(std::as_const(*image).GetBuffer(), 0, 0, image->GetWidth(), image->GetHeight(), result.GetBuffer(), transform);
+
+    return result;
 }
 
 std::optional<c_Image> LoadImageFileAsMono32f(
@@ -1703,39 +1671,14 @@ std::optional<std::tuple<unsigned, unsigned>> GetImageSize(const fs::path& fname
 #if USE_CFITSIO
     if (extension == "fit" || extension == "fits")
     {
-        auto file_load_result = LoadFileIntoBuffer(fname);
-        if (!file_load_result.has_value()) { return std::nullopt; }
-
-        auto [bufferSize, buffer] = std::move(file_load_result.value());
-
-        FitsFileFinalizer fptr;
+        const auto fitsFile = c_MappedFitsFile::Open(fname);
+        if (!fitsFile) { return std::nullopt; }
 
-        int status = 0;
+        int bitsPerPixel{0};
         long dimensions[3] = { 0 };
-        int naxis;
-        int bitsPerPixel;
-        constexpr std::size_t BUF_SIZE_DELTA = 512 * 1024;
-
-        fits_open_memfile(fptr.GetFilePtr(), "(ignored)", READONLY, buffer.GetBufPtr(), &bufferSize,
-            BUF_SIZE_DELTA, &std::realloc, &status);
+        if (!ReadFitsImageHeader(fitsFile->GetFile(), bitsPerPixel, dimensions)) { return std::nullopt; }
 
-        while (true)
-        {
-            fits_read_imghdr(fptr.GetFile(), 3, 0, &bitsPerPixel, &naxis, dimensions, 0, 0, 0, &status);
-            if (0 == status && (naxis > 3 || naxis <= 0))
-            {
-                // try opening a subsequent HDU; sometimes HDU [0] has 0 size (e.g., in some files from SDO)
-                int hduType{0};
-                fits_movrel_hdu(fptr.GetFile(), 1, &hduType, &status);
-                continue;
-            }
-            else if (status)
-            {
-                return std::nullopt;
-            }
-            else
-                return std::make_tuple(dimensions[0], dimensions[1]);
-        }
+        return std::make_tuple(dimensions[0], dimensions[1]);
     }
 #endif
 #if USE_FREEIMAGE
@@ -1830,17 +1773,16 @@ bool c_Image::SaveToFile(const fs::path& fname, OutputBitDepth outpBitDepth, Out
 {
     IMPPG_ASSERT(m_Buffer->GetPixelFormat() != PixelFormat::PIX_PAL8);
 
-    IImageBuffer* bufToSave = m_Buffer.get();
-    std::unique_ptr<c_SimpleBuffer> converted;
-
     const auto destPixFmt = GetOutputPixelFormat(m_Buffer->GetPixelFormat(), outpBitDepth);
-    if (m_Buffer->GetPixelFormat() != destPixFmt)
+    if (m_Buffer->GetPixelFormat() == destPixFmt)
     {
-        converted = std::make_unique<c_SimpleBuffer>(GetConvertedPixelFormatCopy(*m_Buffer.get(), destPixFmt));
-        bufToSave = converted.get();
+        return m_Buffer->SaveToFile(fname, outpFileType);
+    }
+    else
+    {
+        // rows are converted on the fly by the writer; no converted copy of the whole image is needed
+        return SaveConverted(*m_Buffer, destPixFmt, fname, outpFileType);
     }
-
-    return bufToSave->SaveToFile(fname, outpFileType);
 }
 
 static std::tuple<OutputBitDepth, OutputFileType> DecodeOutputFormat(OutputFormat outpFormat)
@@ -1878,55 +1820,10 @@ std::tuple<c_Image, c_Image, c_Image> c_Image::SplitRGB() const
 {
     IMPPG_ASSERT(3 == NumChannels[static_cast<std::size_t>(GetPixelFormat())]);
 
-    const auto destPixFmt = [=]() {
-        switch (this->GetPixelFormat())
-        {
-            case PixelFormat::PIX_RGB8: return PixelFormat::PIX_MONO8;
-            case PixelFormat::PIX_RGB16: return PixelFormat::PIX_MONO16;
-            case PixelFormat::PIX_RGB32F: return PixelFormat::PIX_MONO32F;
-
-            default: IMPPG_ABORT_MSG("unexpected pixel format");
-        }
-    }();
-
-    c_Image imgR(GetWidth(), GetHeight(), destPixFmt);
-    c_Image imgG(GetWidth(), GetHeight(), destPixFmt);
-    c_Image imgB(GetWidth(), GetHeight(), destPixFmt);
-
-    const auto ExtractChannelFromLine = [](unsigned width, std::size_t channel, const auto* src, auto* dest) {
-        for (unsigned i = 0; i < width; i++)
-        {
-            dest[i] = src[3 * i + channel];
-        }
-    };
-
-    for (unsigned y = 0; y < GetHeight(); ++y)
-    {
-        switch (destPixFmt)
-        {
-            case PixelFormat::PIX_MONO8:
-                ExtractChannelFromLine(GetWidth(), 0, GetRowAs<std::uint8_t>(y), imgR.GetRowAs<std::uint8_t>(y));
-                ExtractChannelFromLine(GetWidth(), 1, GetRowAs<std::uint8_t>(y), imgG.GetRowAs<std::uint8_t>(y));
-                ExtractChannelFromLine(GetWidth(), 2, GetRowAs<std::uint8_t>(y), imgB.GetRowAs<std::uint8_t>(y));
-                break;
-
-            case PixelFormat::PIX_MONO16:
-                ExtractChannelFromLine(GetWidth(), 0, GetRowAs<std::uint16_t>(y), imgR.GetRowAs<std::uint16_t>(y));
-                ExtractChannelFromLine(GetWidth(), 1, GetRowAs<std::uint16_t>(y), imgG.GetRowAs<std::uint16_t>(y));
-                ExtractChannelFromLine(GetWidth(), 2, GetRowAs<std::uint16_t>(y), imgB.GetRowAs<std::uint16_t>(y));
-                break;
-
-            case PixelFormat::PIX_MONO32F:
-                ExtractChannelFromLine(GetWidth(), 0, GetRowAs<float>(y), imgR.GetRowAs<float>(y));
-                ExtractChannelFromLine(GetWidth(), 1, GetRowAs<float>(y), imgG.GetRowAs<float>(y));
-                ExtractChannelFromLine(GetWidth(), 2, GetRowAs<float>(y), imgB.GetRowAs<float>(y));
-                break;
+    auto planes = c_PlanarBuffer::FromInterleaved(*m_Buffer);
+    auto [imgR, imgG, imgB] = planes.ShareChannels();
 
-            default: IMPPG_ABORT();
-        }
-    }
-
-    return {imgR, imgG, imgB};
+    return { std::move(imgR), std::move(imgG), std::move(imgB) };
 }
 
 c_Image c_Image::CombineRGB(const c_Image& red, const c_Image& green, const c_Image& blue)
@@ -2126,3 +2023,92 @@ void c_Image::MultiplyPixelValues(double factor)
         }
     }
 }
+
+c_PlanarBuffer::c_PlanarBuffer(unsigned width, unsigned height, PixelFormat planePixFmt)
+{
+    IMPPG_ASSERT(
+        planePixFmt == PixelFormat::PIX_MONO8 ||
+        planePixFmt == PixelFormat::PIX_MONO16 ||
+        planePixFmt == PixelFormat::PIX_MONO32F
+    );
+
+    // each plane starts at a multiple of the (aligned) row stride
+    const std::size_t planeBytes = GetPaddedRowStride(width, BytesPerPixel[static_cast<std::size_t>(planePixFmt)]) * height;
+    AlignedBlock block = AllocateAligned(3 * planeBytes);
+    const AlignedBlockDeleter deleter = block.get_deleter();
+    std::shared_ptr<uint8_t[]> storage(block.release(), deleter);
+    for (std::size_t ch = 0; ch < 3; ++ch)
+    {
+        m_Planes[ch] = std::make_unique<c_PlaneBuffer>(storage, storage.get() + ch * planeBytes, width, height, planePixFmt);
+    }
+}
+
+PixelFormat c_PlanarBuffer::GetInterleavedPixelFormat() const
+{
+    switch (GetPlanePixelFormat())
+    {
+    case PixelFormat::PIX_MONO8: return PixelFormat::PIX_RGB8;
+    case PixelFormat::PIX_MONO16: return PixelFormat::PIX_RGB16;
+    case PixelFormat::PIX_MONO32F: return PixelFormat::PIX_RGB32F;
+    default: IMPPG_ABORT();
+    }
+}
+
+template<typename T>
+static void DeinterleaveRows(const IImageBuffer& src, c_PlanarBuffer& planes)
+{
+    const unsigned width = planes.GetWidth();
+
+    #pragma omp parallel for
+    for (int y = 0; y < static_cast<int>(planes.GetHeight()); ++y)
+    {
+        const T* srcRow = src.GetRowAs<T>(y);
+        T* destR = planes.GetPlane(0).GetRowAs<T>(y);
+        T* destG = planes.GetPlane(1).GetRowAs<T>(y);
+        T* destB = planes.GetPlane(2).GetRowAs<T>(y);
+        for (unsigned x = 0; x < width; ++x)
+        {
+            destR[x] = srcRow[3 * x + 0];
+            destG[x] = srcRow[3 * x + 1];
+            destB[x] = srcRow[3 * x + 2];
+        }
+    }
+}
+
+c_PlanarBuffer c_PlanarBuffer::FromInterleaved(const IImageBuffer& rgb)
+{
+    switch (rgb.GetPixelFormat())
+    {
+    case PixelFormat::PIX_RGB8:
+    {
+        c_PlanarBuffer planes(rgb.GetWidth(), rgb.GetHeight(), PixelFormat::PIX_MONO8);
+        DeinterleaveRows<uint8_t>(rgb, planes);
+        return planes;
+    }
+
+    case PixelFormat::PIX_RGB16:
+    {
+        c_PlanarBuffer planes(rgb.GetWidth(), rgb.GetHeight(), PixelFormat::PIX_MONO16);
+        DeinterleaveRows<uint16_t>(rgb, planes);
+        return planes;
+    }
+
+    case PixelFormat::PIX_RGB32F:
+    {
+        c_PlanarBuffer planes(rgb.GetWidth(), rgb.GetHeight(), PixelFormat::PIX_MONO32F);
+        DeinterleaveRows<float>(rgb, planes);
+        return planes;
+    }
+
+    default: IMPPG_ABORT_MSG("unexpected pixel format");
+    }
+}
+
+std::array<c_Image, 3> c_PlanarBuffer::ShareChannels()
+{
+    return {
+        c_Image(static_cast<const c_PlaneBuffer&>(*m_Planes[0]).Share()),
+        c_Image(static_cast<const c_PlaneBuffer&>(*m_Planes[1]).Share()),
+        c_Image(static_cast<const c_PlaneBuffer&>(*m_Planes[2]).Share())
+    };
+}
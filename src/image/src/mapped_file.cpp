@@ -0,0 +1,120 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Read-only memory-mapped file implementation.
+*/
+
+#include "image/mapped_file.h"
+
+#ifdef __WXMSW__
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <utility>
+
+std::optional<c_MappedFile> c_MappedFile::Open(const std::filesystem::path& path)
+{
+    c_MappedFile result;
+
+#ifdef __WXMSW__
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) { return std::nullopt; }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return std::nullopt;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file); // the mapping keeps the file open
+    if (!mapping) { return std::nullopt; }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); // the view keeps the mapping alive
+    if (!view) { return std::nullopt; }
+
+    result.m_Data = static_cast<const std::uint8_t*>(view);
+    result.m_Size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) { return std::nullopt; }
+
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(fd);
+        return std::nullopt;
+    }
+
+    void* addr = mmap(nullptr, static_cast<std::size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (addr == MAP_FAILED) { return std::nullopt; }
+
+    // The contents are about to be read in full.
+    madvise(addr, static_cast<std::size_t>(fileStat.st_size), MADV_WILLNEED);
+
+    result.m_Data = static_cast<const std::uint8_t*>(addr);
+    result.m_Size = static_cast<std::size_t>(fileStat.st_size);
+#endif
+
+    return result;
+}
+
+c_MappedFile::c_MappedFile(c_MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+c_MappedFile& c_MappedFile::operator=(c_MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+    }
+    return *this;
+}
+
+c_MappedFile::~c_MappedFile()
+{
+    Close();
+}
+
+void c_MappedFile::Close()
+{
+    if (!m_Data) { return; }
+
+#ifdef __WXMSW__
+    UnmapViewOfFile(m_Data);
+#else
+    munmap(const_cast<std::uint8_t*>(m_Data), m_Size);
+#endif
+
+    m_Data = nullptr;
+    m_Size = 0;
+}
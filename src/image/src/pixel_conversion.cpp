@@ -0,0 +1,359 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+
+File description:
+    Pixel format conversion kernels implementation.
+
+    The kernels are branch-free loops over contiguous rows, with the channel layout and value types
+    as template parameters, so that they can be auto-vectorized by the compiler.
+*/
+
+#include "common/imppg_assert.h"
+#include "pixel_conversion.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+// NOTE: MSVC 18 requires a signed integral type 'for' loop counter
+//       when using OpenMP
+
+namespace
+{
+
+/// Conversions of fragments smaller than this are not parallelized.
+constexpr std::size_t MIN_PIXELS_FOR_PARALLEL_CONVERSION = 1 << 16;
+
+template<typename Dest, typename Src>
+inline Dest ConvertValue(Src value)
+{
+    if constexpr (std::is_same_v<Src, Dest>)
+        return value;
+    else if constexpr (std::is_same_v<Src, uint8_t> && std::is_same_v<Dest, uint16_t>)
+        return static_cast<uint16_t>(value << 8);
+    else if constexpr (std::is_same_v<Src, uint16_t> && std::is_same_v<Dest, uint8_t>)
+        return static_cast<uint8_t>(value >> 8);
+    else if constexpr (std::is_same_v<Dest, float>)
+        return value * (1.0f / std::numeric_limits<Src>::max());
+    else
+        return static_cast<Dest>(std::min(std::max(value, 0.0f), 1.0f) * std::numeric_limits<Dest>::max());
+}
+
+/// Returns the brightness (average of channels) of an RGB pixel.
+/** NOTE: for floating-point sources, the result may differ slightly from the conversion used before
+    the vectorized kernels: by 1 for integer destinations (e.g., RGB32F -> MONO16), by rounding for MONO32F
+    (previously averaged in double precision). With `-ffast-math`, the compiler is free to reassociate
+    the sum of channels, and does so when vectorizing. */
+template<typename Dest, typename Src>
+inline Dest RgbToMono(Src r, Src g, Src b)
+{
+    if constexpr (std::is_same_v<Src, float>)
+    {
+        return ConvertValue<Dest>((r + g + b) / 3);
+    }
+    else
+    {
+        const unsigned sum = unsigned{r} + g + b;
+        if constexpr (std::is_same_v<Dest, float>)
+            return sum * (1.0f / (3 * std::numeric_limits<Src>::max()));
+        else if constexpr (std::is_same_v<Src, uint8_t> && std::is_same_v<Dest, uint16_t>)
+            return static_cast<uint16_t>((sum << 8) / 3);
+        else
+            return ConvertValue<Dest>(static_cast<Src>(sum / 3));
+    }
+}
+
+/// Converts a row of pixels having `SrcChannels` channels (1, 3 or 4) to a row with `DestChannels` channels (1 or 3).
+/** If `SrcBGR` is true, the first and third source channels are swapped. Alpha is ignored. */
+template<typename Src, std::size_t SrcChannels, bool SrcBGR, typename Dest, std::size_t DestChannels>
+void ConvertRow(const void* srcRow, void* destRow, unsigned width)
+{
+    const Src* src = static_cast<const Src*>(srcRow);
+    Dest* dest = static_cast<Dest*>(destRow);
+
+    for (std::size_t x = 0; x < width; ++x)
+    {
+        const Src* s = src + SrcChannels * x;
+        Dest* d = dest + DestChannels * x;
+
+        if constexpr (DestChannels == 1)
+        {
+            if constexpr (SrcChannels == 1)
+                d[0] = ConvertValue<Dest>(s[0]);
+            else
+                d[0] = RgbToMono<Dest>(s[0], s[1], s[2]);
+        }
+        else if constexpr (SrcChannels == 1)
+        {
+            const Dest value = ConvertValue<Dest>(s[0]);
+            d[0] = value;
+            d[1] = value;
+            d[2] = value;
+        }
+        else
+        {
+            d[0] = ConvertValue<Dest>(s[SrcBGR ? 2 : 0]);
+            d[1] = ConvertValue<Dest>(s[1]);
+            d[2] = ConvertValue<Dest>(s[SrcBGR ? 0 : 2]);
+        }
+    }
+}
+
+template<typename Src, std::size_t SrcChannels, bool SrcBGR>
+PixelRowConverter GetRowConverterFrom(PixelFormat destPixFmt)
+{
+    switch (destPixFmt)
+    {
+    case PixelFormat::PIX_MONO8:   return &ConvertRow<Src, SrcChannels, SrcBGR, uint8_t, 1>;
+    case PixelFormat::PIX_MONO16:  return &ConvertRow<Src, SrcChannels, SrcBGR, uint16_t, 1>;
+    case PixelFormat::PIX_MONO32F: return &ConvertRow<Src, SrcChannels, SrcBGR, float, 1>;
+    case PixelFormat::PIX_RGB8:    return &ConvertRow<Src, SrcChannels, SrcBGR, uint8_t, 3>;
+    case PixelFormat::PIX_RGB16:   return &ConvertRow<Src, SrcChannels, SrcBGR, uint16_t, 3>;
+    case PixelFormat::PIX_RGB32F:  return &ConvertRow<Src, SrcChannels, SrcBGR, float, 3>;
+    default: return nullptr;
+    }
+}
+
+/// Converts a row of palette indices by copying the corresponding `BytesPerPixel`-sized entries of `lut`.
+template<std::size_t BytesPerPixel>
+void LookUpRow(const uint8_t* src, uint8_t* dest, unsigned width, const uint8_t* lut)
+{
+    for (std::size_t x = 0; x < width; ++x)
+    {
+        std::memcpy(dest + BytesPerPixel * x, lut + BytesPerPixel * src[x], BytesPerPixel);
+    }
+}
+
+void LookUpRow(std::size_t bytesPerPixel, const uint8_t* src, uint8_t* dest, unsigned width, const uint8_t* lut)
+{
+    switch (bytesPerPixel)
+    {
+    case 1: LookUpRow<1>(src, dest, width, lut); break;
+    case 2: LookUpRow<2>(src, dest, width, lut); break;
+    case 3: LookUpRow<3>(src, dest, width, lut); break;
+    case 4: LookUpRow<4>(src, dest, width, lut); break;
+    case 6: LookUpRow<6>(src, dest, width, lut); break;
+    case 12: LookUpRow<12>(src, dest, width, lut); break;
+    default: IMPPG_ABORT();
+    }
+}
+
+/// Returns the range of channel values of a row of pixels having `Channels` channels (alpha excluded).
+template<typename T, std::size_t Channels>
+ValueRange GetRowValueRange(const void* rowPtr, unsigned width)
+{
+    const T* row = static_cast<const T*>(rowPtr);
+    T rowMin = row[0];
+    T rowMax = row[0];
+
+    if constexpr (Channels == 4)
+    {
+        for (std::size_t x = 0; x < width; ++x)
+            for (std::size_t ch = 0; ch < 3; ++ch)
+            {
+                rowMin = std::min(rowMin, row[4 * x + ch]);
+                rowMax = std::max(rowMax, row[4 * x + ch]);
+            }
+    }
+    else
+    {
+        for (std::size_t i = 0; i < Channels * width; ++i)
+        {
+            rowMin = std::min(rowMin, row[i]);
+            rowMax = std::max(rowMax, row[i]);
+        }
+    }
+
+    return ValueRange{ConvertValue<float>(rowMin), ConvertValue<float>(rowMax)};
+}
+
+using RowValueRangeFunc = ValueRange (*)(const void* row, unsigned width);
+
+RowValueRangeFunc GetRowValueRangeFunc(PixelFormat pixFmt)
+{
+    switch (pixFmt)
+    {
+    case PixelFormat::PIX_MONO8:   return &GetRowValueRange<uint8_t, 1>;
+    case PixelFormat::PIX_RGB8:
+    case PixelFormat::PIX_BGR8:    return &GetRowValueRange<uint8_t, 3>;
+    case PixelFormat::PIX_RGBA8:
+    case PixelFormat::PIX_BGRA8:   return &GetRowValueRange<uint8_t, 4>;
+    case PixelFormat::PIX_MONO16:  return &GetRowValueRange<uint16_t, 1>;
+    case PixelFormat::PIX_RGB16:   return &GetRowValueRange<uint16_t, 3>;
+    case PixelFormat::PIX_RGBA16:  return &GetRowValueRange<uint16_t, 4>;
+    case PixelFormat::PIX_MONO32F: return &GetRowValueRange<float, 1>;
+    case PixelFormat::PIX_RGB32F:  return &GetRowValueRange<float, 3>;
+    case PixelFormat::PIX_RGBA32F: return &GetRowValueRange<float, 4>;
+    default: return nullptr;
+    }
+}
+
+void TransformRow(float* row, std::size_t numValues, const LevelsTransform& transform)
+{
+    for (std::size_t i = 0; i < numValues; ++i)
+    {
+        row[i] = std::min(std::max(transform.a * row[i] + transform.b, 0.0f), 1.0f);
+    }
+}
+
+bool IsFloatingPointMonoOrRGB(PixelFormat pixFmt)
+{
+    return pixFmt == PixelFormat::PIX_MONO32F || pixFmt == PixelFormat::PIX_RGB32F;
+}
+
+} // anonymous namespace
+
+LevelsTransform LevelsTransform::Normalization(const ValueRange& range, float minLevel, float maxLevel)
+{
+    // Values `minLevel` and `maxLevel` become black and white, respectively.
+    const float a = (maxLevel - minLevel) / (range.max - range.min);
+    const float b = maxLevel - a * range.max;
+    return LevelsTransform{a, b};
+}
+
+PixelRowConverter GetPixelRowConverter(PixelFormat srcPixFmt, PixelFormat destPixFmt)
+{
+    switch (srcPixFmt)
+    {
+    case PixelFormat::PIX_MONO8:   return GetRowConverterFrom<uint8_t, 1, false>(destPixFmt);
+    case PixelFormat::PIX_RGB8:    return GetRowConverterFrom<uint8_t, 3, false>(destPixFmt);
+    case PixelFormat::PIX_BGR8:    return GetRowConverterFrom<uint8_t, 3, true>(destPixFmt);
+    case PixelFormat::PIX_RGBA8:   return GetRowConverterFrom<uint8_t, 4, false>(destPixFmt);
+    case PixelFormat::PIX_BGRA8:   return GetRowConverterFrom<uint8_t, 4, true>(destPixFmt);
+    case PixelFormat::PIX_MONO16:  return GetRowConverterFrom<uint16_t, 1, false>(destPixFmt);
+    case PixelFormat::PIX_RGB16:   return GetRowConverterFrom<uint16_t, 3, false>(destPixFmt);
+    case PixelFormat::PIX_RGBA16:  return GetRowConverterFrom<uint16_t, 4, false>(destPixFmt);
+    case PixelFormat::PIX_MONO32F: return GetRowConverterFrom<float, 1, false>(destPixFmt);
+    case PixelFormat::PIX_RGB32F:  return GetRowConverterFrom<float, 3, false>(destPixFmt);
+    case PixelFormat::PIX_RGBA32F: return GetRowConverterFrom<float, 4, false>(destPixFmt);
+    default: return nullptr;
+    }
+}
+
+void ConvertPixelFormatRows(
+    const IImageBuffer& src,
+    unsigned x0,
+    unsigned y0,
+    unsigned width,
+    unsigned height,
+    IImageBuffer& dest,
+    const std::optional<LevelsTransform>& transform
+)
+{
+    IMPPG_ASSERT(x0 + width <= src.GetWidth() && y0 + height <= src.GetHeight());
+    IMPPG_ASSERT(width <= dest.GetWidth() && height <= dest.GetHeight());
+    IMPPG_ASSERT(!transform.has_value() || IsFloatingPointMonoOrRGB(dest.GetPixelFormat()));
+
+    const PixelFormat srcPixFmt = src.GetPixelFormat();
+    const PixelFormat destPixFmt = dest.GetPixelFormat();
+    const std::size_t srcBpp = src.GetBytesPerPixel();
+    const std::size_t destBpp = dest.GetBytesPerPixel();
+    // With static scheduling, each thread converts one contiguous block of rows.
+    const bool parallel = static_cast<std::size_t>(width) * height >= MIN_PIXELS_FOR_PARALLEL_CONVERSION;
+
+    // Called for each destination row right after it has been converted (while it is still in cache).
+    const std::size_t destValuesPerRow = width * NumChannels[static_cast<std::size_t>(destPixFmt)];
+    const auto finishRow = [&](int y) {
+        if (transform.has_value()) { TransformRow(dest.GetRowAs<float>(y), destValuesPerRow, *transform); }
+    };
+
+    if (srcPixFmt == destPixFmt)
+    {
+        #pragma omp parallel for schedule(static) if(parallel)
+        for (int y = 0; y < static_cast<int>(height); ++y)
+        {
+            std::memcpy(dest.GetRowAs<uint8_t>(y), src.GetRowAs<uint8_t>(y0 + y) + x0 * srcBpp, width * srcBpp);
+            finishRow(y);
+        }
+    }
+    else if (srcPixFmt == PixelFormat::PIX_PAL8)
+    {
+        // Convert the palette (treated as a row of RGB8 pixels) once, then look up the destination pixels.
+        const PixelRowConverter convertPalette = GetPixelRowConverter(PixelFormat::PIX_RGB8, destPixFmt);
+        IMPPG_ASSERT(convertPalette != nullptr);
+        alignas(float) uint8_t lut[IImageBuffer::PALETTE_LENGTH * sizeof(float)];
+        convertPalette(src.GetPalette().data(), lut, IImageBuffer::PALETTE_LENGTH / 3);
+
+        #pragma omp parallel for schedule(static) if(parallel)
+        for (int y = 0; y < static_cast<int>(height); ++y)
+        {
+            LookUpRow(destBpp, src.GetRowAs<uint8_t>(y0 + y) + x0, dest.GetRowAs<uint8_t>(y), width, lut);
+            finishRow(y);
+        }
+    }
+    else
+    {
+        const PixelRowConverter convert = GetPixelRowConverter(srcPixFmt, destPixFmt);
+        IMPPG_ASSERT(convert != nullptr);
+
+        #pragma omp parallel for schedule(static) if(parallel)
+        for (int y = 0; y < static_cast<int>(height); ++y)
+        {
+            convert(src.GetRowAs<uint8_t>(y0 + y) + x0 * srcBpp, dest.GetRowAs<uint8_t>(y), width);
+            finishRow(y);
+        }
+    }
+}
+
+ValueRange GetValueRange(const IImageBuffer& buf)
+{
+    const RowValueRangeFunc getRowRange = GetRowValueRangeFunc(buf.GetPixelFormat());
+    IMPPG_ASSERT(getRowRange != nullptr);
+
+    const unsigned width = buf.GetWidth();
+    const unsigned height = buf.GetHeight();
+    if (width == 0 || height == 0) { return ValueRange{0.0f, 0.0f}; }
+
+    const bool parallel = static_cast<std::size_t>(width) * height >= MIN_PIXELS_FOR_PARALLEL_CONVERSION;
+    std::vector<ValueRange> rowRanges(height);
+
+    #pragma omp parallel for schedule(static) if(parallel)
+    for (int y = 0; y < static_cast<int>(height); ++y)
+    {
+        rowRanges[y] = getRowRange(buf.GetRow(y), width);
+    }
+
+    ValueRange result = rowRanges[0];
+    for (const ValueRange& rowRange: rowRanges)
+    {
+        result.min = std::min(result.min, rowRange.min);
+        result.max = std::max(result.max, rowRange.max);
+    }
+
+    return result;
+}
+
+void TransformValues(IImageBuffer& buf, const LevelsTransform& transform)
+{
+    IMPPG_ASSERT(IsFloatingPointMonoOrRGB(buf.GetPixelFormat()));
+
+    const std::size_t valuesPerRow = buf.GetWidth() * NumChannels[static_cast<std::size_t>(buf.GetPixelFormat())];
+    const bool parallel = static_cast<std::size_t>(buf.GetWidth()) * buf.GetHeight() >= MIN_PIXELS_FOR_PARALLEL_CONVERSION;
+
+    #pragma omp parallel for schedule(static) if(parallel)
+    for (int y = 0; y < static_cast<int>(buf.GetHeight()); ++y)
+    {
+        TransformRow(buf.GetRowAs<float>(y), valuesPerRow, transform);
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+
+File description:
+    Pixel format conversion kernels header.
+*/
+
+#ifndef ImPPG_PIXEL_CONVERSION_H
+#define ImPPG_PIXEL_CONVERSION_H
+
+#include "image/image.h"
+
+#include <optional>
+
+/// Range of channel values; integer values are expressed as fractions of the maximum (i.e., from [0; 1]).
+struct ValueRange
+{
+    float min;
+    float max;
+};
+
+/// Linear transformation of floating-point values: v -> clamp(a * v + b, 0, 1).
+struct LevelsTransform
+{
+    float a;
+    float b;
+
+    /// Returns the transformation which maps `range.min` to `minLevel` and `range.max` to `maxLevel`.
+    static LevelsTransform Normalization(const ValueRange& range, float minLevel, float maxLevel);
+};
+
+/// Converts `width` pixels from `src` to `dest`.
+using PixelRowConverter = void (*)(const void* src, void* dest, unsigned width);
+
+/// Returns the row converter from `srcPixFmt` to `destPixFmt` or null if there is none.
+/** Destination can be a mono or RGB format; source can be any non-palette format. Floating-point values
+    are clamped to [0; 1] when converted to integers; when converting to mono, the channels are averaged. */
+PixelRowConverter GetPixelRowConverter(PixelFormat srcPixFmt, PixelFormat destPixFmt);
+
+/// Converts the fragment of `src` of size `width`x`height` starting at (`x0`, `y0`) to `dest`'s pixel format.
+/** The result is stored at the top-left of `dest`. Blocks of rows are converted in parallel. If `transform` is specified
+    (`dest` must then be PIX_MONO32F or PIX_RGB32F), it is applied to each row right after its conversion. */
+void ConvertPixelFormatRows(
+    const IImageBuffer& src,
+    unsigned x0,
+    unsigned y0,
+    unsigned width,
+    unsigned height,
+    IImageBuffer& dest,
+    const std::optional<LevelsTransform>& transform = std::nullopt
+);
+
+/// Returns the range of channel values (alpha excluded) of a non-palette image; the rows are scanned in parallel.
+ValueRange GetValueRange(const IImageBuffer& buf);
+
+/// Applies `transform` in place to a PIX_MONO32F or PIX_RGB32F image; the rows are processed in parallel.
+void TransformValues(IImageBuffer& buf, const LevelsTransform& transform);
+
+#endif // ImPPG_PIXEL_CONVERSION_H
@@ -0,0 +1,94 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2016-2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+
+File description:
+    Chunked reader of converted image rows header.
+*/
+
+#ifndef ImPPG_ROW_READER_H
+#define ImPPG_ROW_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+
+#include "image/image.h"
+
+/// Provides rows of an image converted to another pixel format, a chunk at a time.
+/** Used by the file writers, so that saving an image requires memory only for a few chunks of converted rows
+    instead of a full-size converted copy. While the caller consumes a chunk, the next one (in the direction
+    of reading, i.e., top-down or bottom-up) is converted in the background.
+    If no conversion is needed, rows of the source image are returned directly. */
+class c_RowReader
+{
+public:
+    static constexpr std::size_t DEFAULT_CHUNK_BYTES = std::size_t{4} << 20;
+
+    c_RowReader(const IImageBuffer& source, PixelFormat destPixFmt);
+
+    c_RowReader(const c_RowReader&) = delete;
+    c_RowReader& operator=(const c_RowReader&) = delete;
+
+    ~c_RowReader();
+
+    unsigned GetWidth() const { return m_Source.GetWidth(); }
+
+    unsigned GetHeight() const { return m_Source.GetHeight(); }
+
+    PixelFormat GetPixelFormat() const { return m_DestPixFmt; }
+
+    std::size_t GetBytesPerPixel() const { return BytesPerPixel[static_cast<std::size_t>(m_DestPixFmt)]; }
+
+    /// Returns the source image's palette (conversion to PIX_PAL8 is not supported).
+    const IImageBuffer::Palette& GetPalette() const { return m_Source.GetPalette(); }
+
+    /// Returns the number of rows in a chunk of (approximately) `DEFAULT_CHUNK_BYTES` (at least 1, at most the image height).
+    unsigned GetDefaultChunkRows() const;
+
+    /// Makes rows [y0; y0 + numRows) available via `GetRow`; pointers returned for previously fetched rows become invalid.
+    void Fetch(unsigned y0, unsigned numRows);
+
+    /// Returns a row from the most recently fetched range; can be called concurrently.
+    const void* GetRow(unsigned y) const;
+
+    template<typename T>
+    const T* GetRowAs(unsigned y) const { return static_cast<const T*>(GetRow(y)); }
+
+private:
+    /// Converts rows [y0; y0 + numRows) of the source image.
+    std::unique_ptr<IImageBuffer> ConvertRows(unsigned y0, unsigned numRows) const;
+
+    const IImageBuffer& m_Source;
+
+    PixelFormat m_DestPixFmt;
+
+    bool m_PassThrough{false}; ///< If true, rows of `m_Source` are returned directly.
+
+    unsigned m_ChunkY0{0};
+    unsigned m_ChunkNumRows{0};
+    std::unique_ptr<IImageBuffer> m_Chunk; ///< Converted rows [m_ChunkY0; m_ChunkY0 + m_ChunkNumRows).
+
+    unsigned m_NextY0{0};
+    unsigned m_NextNumRows{0};
+    std::future<std::unique_ptr<IImageBuffer>> m_NextChunk; ///< Rows [m_NextY0; m_NextY0 + m_NextNumRows) being converted in the background.
+};
+
+#endif // ImPPG_ROW_READER_H
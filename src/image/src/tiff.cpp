@@ -21,11 +21,20 @@ File description:
     TIFF-related functions.
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
 #include <climits>
+#include <cstring>
 #include <fstream>
+#include <thread>
+#include <vector>
 #include <boost/format.hpp>
+#include <zlib.h>
 
 #include "common/imppg_assert.h"
+#include "image/mapped_file.h"
+#include "row_reader.h"
 #include "tiff.h"
 
 
@@ -60,14 +69,28 @@ const int TAG_SAMPLES_PER_PIXEL =          0x115;
 const int TAG_ROWS_PER_STRIP =             0x116;
 const int TAG_STRIP_BYTE_COUNTS =          0x117;
 const int TAG_PLANAR_CONFIGURATION =       0x11C;
+const int TAG_PREDICTOR =                  0x13D;
+const int TAG_TILE_WIDTH =                 0x142;
+const int TAG_TILE_LENGTH =                0x143;
+const int TAG_TILE_OFFSETS =               0x144;
+const int TAG_TILE_BYTE_COUNTS =           0x145;
+const int TAG_SAMPLE_FORMAT =              0x153;
 
 const uint16_t NO_COMPRESSION = 1;
+const uint16_t COMPRESSION_LZW = 5;
+const uint16_t COMPRESSION_DEFLATE = 8;
+const uint16_t COMPRESSION_DEFLATE_OBSOLETE = 32946;
 const uint16_t PLANAR_CONFIGURATION_CHUNKY = 1;
 const uint16_t INTEL_BYTE_ORDER = ('I' << 8) + 'I'; // little-endian
 const uint16_t MOTOROLA_BYTE_ORDER = ('M' << 8) + 'M'; // big-endian
 const int PHMET_WHITE_IS_ZERO = 0;
 const int PHMET_BLACK_IS_ZERO = 1;
 const int PHMET_RGB = 2;
+const uint16_t PREDICTOR_NONE = 1;
+const uint16_t PREDICTOR_HORIZONTAL = 2;
+const uint16_t PREDICTOR_FLOATING_POINT = 3;
+const uint16_t SAMPLE_FORMAT_UINT = 1;
+const uint16_t SAMPLE_FORMAT_IEEEFP = 3;
 
 bool IsMachineBigEndian();
 
@@ -83,17 +106,6 @@ inline unsigned GetFieldTypeLength(TagType_t ttt)
     }
 }
 
-/// Changes endianess of 16-bit words in the specified buffer
-void SwapBufferWords(IImageBuffer& buf)
-{
-    for (unsigned j = 0; j < buf.GetHeight(); j++)
-    {
-        uint16_t* row = buf.GetRowAs<uint16_t>(j);
-        for (unsigned i = 0; i < buf.GetWidth(); i++)
-            row[i] = (row[i] << 8) | (row[i] >> 8);
-    }
-}
-
 /// Reverses values of an 8-bit grayscale buffer
 void NegateGrayscale8(IImageBuffer& buf)
 {
@@ -192,393 +204,997 @@ std::optional<std::tuple<unsigned, unsigned>> GetTiffDimensions(const std::files
         return std::make_tuple(imgWidth.value(), imgHeight.value());
 }
 
-/// Saves image in TIFF format; returns 'false' on error
-bool SaveTiff(const std::filesystem::path& fileName, const IImageBuffer& img)
+namespace
 {
-    IMPPG_ASSERT(img.GetPixelFormat() == PixelFormat::PIX_MONO8 ||
-                 img.GetPixelFormat() == PixelFormat::PIX_MONO16 ||
-                 img.GetPixelFormat() == PixelFormat::PIX_RGB8 ||
-                 img.GetPixelFormat() == PixelFormat::PIX_RGB16);
 
-    std::ofstream file(fileName, std::ios_base::trunc | std::ios_base::binary);
+// LZW codec ------------------------------------------------------------------------------------------------
+//
+// TIFF variant: codes are packed MSB-first, code width grows from 9 to 12 bits one code earlier than
+// in the "classic" LZW (the so-called early change) and the table is reset by the clear code.
 
-    if (file.fail())
-        return false;
+constexpr unsigned LZW_CLEAR_CODE = 256;
+constexpr unsigned LZW_EOI_CODE = 257;
+constexpr unsigned LZW_FIRST_CODE = 258;
+constexpr unsigned LZW_MIN_BITS = 9;
+constexpr unsigned LZW_MAX_BITS = 12;
+constexpr unsigned LZW_MAX_CODE = (1 << LZW_MAX_BITS) - 1;
 
-    bool isMBE = IsMachineBigEndian();
+class c_MsbBitWriter
+{
+public:
+    explicit c_MsbBitWriter(std::vector<uint8_t>& output): m_Output(output) {}
 
-    // Note: a 16-bit value (a "ttWord") stored in the 32-bit TiffField_t::value field has to be
-    // always "left-aligned", i.e. stored in the lower-address two bytes in the file, regardless
-    // of the file's and machine's endianess.
-    //
-    // This means that on a big-endian machine it has to be always shifted left by 16 bits
-    // prior to writing to the file.
+    void Put(unsigned code, unsigned width)
+    {
+        m_Acc = (m_Acc << width) | code;
+        m_NumBits += width;
+        while (m_NumBits >= 8)
+        {
+            m_Output.push_back(static_cast<uint8_t>(m_Acc >> (m_NumBits - 8)));
+            m_NumBits -= 8;
+        }
+        m_Acc &= (1u << m_NumBits) - 1;
+    }
 
-    TiffHeader_t tiffHeader;
-    tiffHeader.id = isMBE ? MOTOROLA_BYTE_ORDER : INTEL_BYTE_ORDER;
-    tiffHeader.version = TIFF_VERSION;
-    tiffHeader.dirOffset = sizeof(tiffHeader);
-    file.write(reinterpret_cast<const char*>(&tiffHeader), sizeof(tiffHeader));
+    void Flush()
+    {
+        if (m_NumBits > 0)
+        {
+            m_Output.push_back(static_cast<uint8_t>(m_Acc << (8 - m_NumBits)));
+        }
+        m_Acc = 0;
+        m_NumBits = 0;
+    }
 
-    uint16_t numDirEntries = 10;
-    file.write(reinterpret_cast<const char*>(&numDirEntries), sizeof(numDirEntries));
-
-    uint32_t nextDirOffset = 0;
-
-    TiffField_t field;
-
-    field.tag = TAG_IMAGE_WIDTH;
-    field.type = ttWord;
-    field.count = 1;
-    field.value = img.GetWidth();
-    if (isMBE) field.value <<= 16;
-    file.write(reinterpret_cast<const char*>(&field), sizeof(field));
-
-    field.tag = TAG_IMAGE_HEIGHT;
-    field.type = ttWord;
-    field.count = 1;
-    field.value = img.GetHeight();
-    if (isMBE) field.value <<= 16;
-    file.write(reinterpret_cast<const char*>(&field), sizeof(field));
-
-    field.tag = TAG_BITS_PER_SAMPLE;
-    field.type = ttWord;
-    field.count = 1;
-    switch (img.GetPixelFormat())
-    {
-    case PixelFormat::PIX_MONO8:
-    case PixelFormat::PIX_RGB8:
-        field.value = 8; break;
-
-    case PixelFormat::PIX_MONO16:
-    case PixelFormat::PIX_RGB16:
-        field.value = 16; break;
-
-    default: IMPPG_ABORT();
-    }
-    if (isMBE) field.value <<= 16;
-    file.write(reinterpret_cast<const char*>(&field), sizeof(field));
-
-    field.tag = TAG_COMPRESSION;
-    field.type = ttWord;
-    field.count = 1;
-    field.value = NO_COMPRESSION;
-    if (isMBE) field.value <<= 16;
-    file.write(reinterpret_cast<const char*>(&field), sizeof(field));
-
-    field.tag = TAG_PHOTOMETRIC_INTERPRETATION;
-    field.type = ttWord;
-    field.count = 1;
-    switch (img.GetPixelFormat())
-    {
-    case PixelFormat::PIX_MONO8:
-    case PixelFormat::PIX_MONO16:
-        field.value = PHMET_BLACK_IS_ZERO; break;
-
-    case PixelFormat::PIX_RGB8:
-    case PixelFormat::PIX_RGB16:
-        field.value = PHMET_RGB; break;
-
-    default: IMPPG_ABORT();
-    }
-    if (isMBE) field.value <<= 16;
-    file.write(reinterpret_cast<const char*>(&field), sizeof(field));
-
-    field.tag = TAG_STRIP_OFFSETS;
-    field.type = ttDWord;
-    field.count = 1;
-    // we write the header, num. of directory entries, 10 fields and a next directory offset (==0); pixel data starts next
-    field.value = sizeof(tiffHeader) + sizeof(numDirEntries) + 10*sizeof(field) + sizeof(nextDirOffset);
-    file.write(reinterpret_cast<const char*>(&field), sizeof(field));
-
-    field.tag = TAG_SAMPLES_PER_PIXEL;
-    field.type = ttWord;
-    field.count = 1;
-    switch (img.GetPixelFormat())
-    {
-    case PixelFormat::PIX_MONO8:
-    case PixelFormat::PIX_MONO16:
-        field.value = 1; break;
-
-    case PixelFormat::PIX_RGB8:
-    case PixelFormat::PIX_RGB16:
-        field.value = 3; break;
-
-    default: IMPPG_ABORT();
-    }
-    if (isMBE) field.value <<= 16;
-    file.write(reinterpret_cast<const char*>(&field), sizeof(field));
-
-    field.tag = TAG_ROWS_PER_STRIP;
-    field.type = ttWord;
-    field.count = 1;
-    field.value = img.GetHeight(); // there is only one strip for the whole image
-    if (isMBE) field.value <<= 16;
-    file.write(reinterpret_cast<const char*>(&field), sizeof(field));
-
-    field.tag = TAG_STRIP_BYTE_COUNTS;
-    field.type = ttDWord;
-    field.count = 1;
-    field.value = img.GetWidth() * img.GetHeight() * img.GetBytesPerPixel(); // there is only one strip for the whole image
-    file.write(reinterpret_cast<const char*>(&field), sizeof(field));
-
-    field.tag = TAG_PLANAR_CONFIGURATION;
-    field.type = ttWord;
-    field.count = 1;
-    field.value = PLANAR_CONFIGURATION_CHUNKY; // there is only one strip for the whole image
-    if (isMBE) field.value <<= 16;
-    file.write(reinterpret_cast<const char*>(&field), sizeof(field));
-
-    // write the next directory offset (0 = no other directories)
-    file.write(reinterpret_cast<const char*>(&nextDirOffset), sizeof(nextDirOffset));
-
-    for (unsigned i = 0; i < img.GetHeight(); i++)
-        file.write(img.GetRowAs<const char>(i), img.GetWidth() * img.GetBytesPerPixel());
+private:
+    std::vector<uint8_t>& m_Output;
+    uint32_t m_Acc{0};
+    unsigned m_NumBits{0};
+};
 
-    file.close();
-    return true;
+void LzwEncode(const uint8_t* input, std::size_t length, std::vector<uint8_t>& output)
+{
+    // The string table is a trie: each code (string) has a list of children (the string extended by one byte).
+    std::vector<uint16_t> firstChild(LZW_MAX_CODE + 1, 0); // 0 means: no child (code 0 is never a child)
+    std::vector<uint16_t> nextSibling(LZW_MAX_CODE + 1, 0);
+    std::vector<uint8_t> lastByte(LZW_MAX_CODE + 1, 0);
+
+    c_MsbBitWriter writer(output);
+    unsigned width = LZW_MIN_BITS;
+    unsigned nextCode = LZW_FIRST_CODE;
+
+    const auto resetTable = [&]() {
+        // entries >= LZW_FIRST_CODE are initialized when added
+        std::fill(firstChild.begin(), firstChild.begin() + 256, 0);
+        width = LZW_MIN_BITS;
+        nextCode = LZW_FIRST_CODE;
+    };
+
+    // Called after emitting a code, for which the decoder will add a string table entry.
+    const auto advance = [&]() {
+        nextCode += 1;
+        if (nextCode == LZW_MAX_CODE - 1)
+        {
+            writer.Put(LZW_CLEAR_CODE, width);
+            resetTable();
+        }
+        else if (nextCode > (1u << width) - 1)
+        {
+            width += 1;
+        }
+    };
+
+    writer.Put(LZW_CLEAR_CODE, width);
+
+    if (length > 0)
+    {
+        unsigned current = input[0];
+        for (std::size_t i = 1; i < length; ++i)
+        {
+            const uint8_t byte = input[i];
+
+            unsigned child = firstChild[current];
+            while (child != 0 && lastByte[child] != byte) { child = nextSibling[child]; }
+
+            if (child != 0)
+            {
+                current = child;
+                continue;
+            }
+
+            writer.Put(current, width);
+
+            lastByte[nextCode] = byte;
+            firstChild[nextCode] = 0;
+            nextSibling[nextCode] = firstChild[current];
+            firstChild[current] = static_cast<uint16_t>(nextCode);
+            advance();
+
+            current = byte;
+        }
+
+        writer.Put(current, width);
+        advance();
+    }
+
+    writer.Put(LZW_EOI_CODE, width);
+    writer.Flush();
 }
 
-/// Reads a TIFF image; returns 0 on error
-std::optional<c_Image> ReadTiff(
-    const std::filesystem::path& fileName,
-    std::string* errorMsg ///< If not null, receives error message (if any))
-)
+/// Returns `false` if `input` is invalid or does not decode to exactly `outputLength` bytes.
+bool LzwDecode(const uint8_t* input, std::size_t inputLength, uint8_t* output, std::size_t outputLength)
 {
-    int imgWidth = -1, imgHeight = -1;
-    PixelFormat pixFmt{};
+    std::vector<uint16_t> prefix(LZW_MAX_CODE + 1);
+    std::vector<uint8_t> lastByte(LZW_MAX_CODE + 1);
+    std::vector<uint8_t> firstByte(LZW_MAX_CODE + 1);
+    std::vector<uint16_t> stringLength(LZW_MAX_CODE + 1);
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        lastByte[i] = firstByte[i] = static_cast<uint8_t>(i);
+        stringLength[i] = 1;
+    }
 
-    std::ifstream file(fileName, std::ios_base::binary);
+    unsigned width = LZW_MIN_BITS;
+    unsigned nextCode = LZW_FIRST_CODE;
+    unsigned prevCode = LZW_CLEAR_CODE; // clear code means: no previous code
 
-    if (file.fail())
-        return std::nullopt;
+    uint32_t acc = 0;
+    unsigned numBits = 0;
+    std::size_t inputPos = 0;
+    std::size_t outputPos = 0;
 
-    TiffHeader_t tiffHeader;
-    file.read(reinterpret_cast<char*>(&tiffHeader), sizeof(tiffHeader));
-    if (file.gcount() != sizeof(tiffHeader))
+    while (true)
     {
-        if (errorMsg) *errorMsg = "file header is incomplete";
-        return std::nullopt;
+        while (numBits < width && inputPos < inputLength)
+        {
+            acc = (acc << 8) | input[inputPos++];
+            numBits += 8;
+        }
+        if (numBits < width) { break; } // some encoders omit the end-of-information code
+
+        const unsigned code = (acc >> (numBits - width)) & ((1u << width) - 1);
+        numBits -= width;
+        acc &= (1u << numBits) - 1;
+
+        if (code == LZW_EOI_CODE) { break; }
+
+        if (code == LZW_CLEAR_CODE)
+        {
+            width = LZW_MIN_BITS;
+            nextCode = LZW_FIRST_CODE;
+            prevCode = LZW_CLEAR_CODE;
+            continue;
+        }
+
+        if (prevCode != LZW_CLEAR_CODE)
+        {
+            if (code > nextCode) { return false; }
+
+            if (nextCode <= LZW_MAX_CODE)
+            {
+                // for `code == nextCode`, the new string is: previous string + its own first byte
+                const uint8_t first = (code == nextCode) ? firstByte[prevCode] : firstByte[code];
+                prefix[nextCode] = static_cast<uint16_t>(prevCode);
+                lastByte[nextCode] = first;
+                firstByte[nextCode] = firstByte[prevCode];
+                stringLength[nextCode] = stringLength[prevCode] + 1;
+                nextCode += 1;
+                if (nextCode >= (1u << width) - 1 && width < LZW_MAX_BITS)
+                {
+                    width += 1;
+                }
+            }
+        }
+        else if (code > 255)
+        {
+            return false;
+        }
+
+        const std::size_t length = stringLength[code];
+        if (outputPos + length > outputLength) { return false; }
+
+        unsigned c = code;
+        for (std::size_t i = length; i > 0; --i)
+        {
+            output[outputPos + i - 1] = lastByte[c];
+            c = prefix[c];
+        }
+        outputPos += length;
+
+        prevCode = code;
     }
 
-    bool isMBE = IsMachineBigEndian();
-    bool isFBE = tiffHeader.id == MOTOROLA_BYTE_ORDER; // true if the file has big endian data
-    bool enDiff = (isMBE != isFBE);
+    return outputPos == outputLength;
+}
 
-    if (SWAP16cnd(tiffHeader.version, enDiff) != TIFF_VERSION)
+// Deflate codec --------------------------------------------------------------------------------------------
+
+bool DeflateEncode(const uint8_t* input, std::size_t length, std::vector<uint8_t>& output)
+{
+    uLongf outputLength = compressBound(static_cast<uLong>(length));
+    output.resize(outputLength);
+    if (Z_OK != compress2(output.data(), &outputLength, input, static_cast<uLong>(length), Z_DEFAULT_COMPRESSION))
     {
-        if (errorMsg) *errorMsg = "unknown TIFF version";
-        return std::nullopt;
+        return false;
     }
+    output.resize(outputLength);
+    return true;
+}
 
-    // Seek to the first TIFF directory
-    file.seekg(SWAP32cnd(tiffHeader.dirOffset, enDiff), std::ios_base::beg);
+/// Returns `false` if `input` is invalid or decodes to fewer than `outputLength` bytes.
+bool DeflateDecode(const uint8_t* input, std::size_t inputLength, uint8_t* output, std::size_t outputLength)
+{
+    z_stream stream{};
+    if (Z_OK != inflateInit(&stream)) { return false; }
 
-    uint16_t numDirEntries;
-    file.read(reinterpret_cast<char*>(&numDirEntries), sizeof(numDirEntries));
-    numDirEntries = SWAP16cnd(numDirEntries, enDiff);
-    if (file.gcount() != sizeof(numDirEntries))
+    stream.next_in = const_cast<Bytef*>(input);
+    stream.avail_in = static_cast<uInt>(inputLength);
+    stream.next_out = output;
+    stream.avail_out = static_cast<uInt>(outputLength);
+
+    const int result = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+
+    // some encoders store more data than needed (e.g., padding rows), so a full output buffer also means success
+    return (result == Z_STREAM_END || result == Z_OK || result == Z_BUF_ERROR) && stream.avail_out == 0;
+}
+
+// Predictors -----------------------------------------------------------------------------------------------
+//
+// Both operate on a row of native byte order samples.
+
+template<typename T>
+T LoadSample(const uint8_t* ptr) { T value; std::memcpy(&value, ptr, sizeof(T)); return value; }
+
+template<typename T>
+void StoreSample(uint8_t* ptr, T value) { std::memcpy(ptr, &value, sizeof(T)); }
+
+template<typename T>
+void ApplyHorizontalPredictor(uint8_t* row, std::size_t numSamples, unsigned samplesPerPixel)
+{
+    for (std::size_t i = numSamples - 1; i >= samplesPerPixel && i < numSamples; --i)
     {
-        if (errorMsg) *errorMsg = "the number of TIFF directory entries tag is incomplete";
-        return std::nullopt;
+        const T diff = static_cast<T>(LoadSample<T>(row + i * sizeof(T)) - LoadSample<T>(row + (i - samplesPerPixel) * sizeof(T)));
+        StoreSample<T>(row + i * sizeof(T), diff);
     }
+}
 
-    unsigned numStrips = 0;
-    unsigned bitsPerSample = 0;
-    std::unique_ptr<uint32_t[]> stripOffsets;
-    std::unique_ptr<uint32_t[]> stripByteCounts;
-    unsigned rowsPerStrip = 0;
-    int photometricInterpretation = -1;
-    int samplesPerPixel = 0;
+template<typename T>
+void UndoHorizontalPredictor(uint8_t* row, std::size_t numSamples, unsigned samplesPerPixel)
+{
+    for (std::size_t i = samplesPerPixel; i < numSamples; ++i)
+    {
+        const T sum = static_cast<T>(LoadSample<T>(row + i * sizeof(T)) + LoadSample<T>(row + (i - samplesPerPixel) * sizeof(T)));
+        StoreSample<T>(row + i * sizeof(T), sum);
+    }
+}
 
-    std::fstream::pos_type nextFieldPos = file.tellg();
-    for (unsigned i = 0; i < numDirEntries; i++)
+/// Floating-point predictor: the bytes of the row's samples are reordered into planes (most significant
+/// bytes first), then differenced horizontally.
+void ApplyFloatingPointPredictor(uint8_t* row, std::size_t numSamples, unsigned samplesPerPixel, std::vector<uint8_t>& tmp)
+{
+    const bool isMBE = IsMachineBigEndian();
+    tmp.assign(row, row + numSamples * 4);
+    for (std::size_t i = 0; i < numSamples; ++i)
     {
-        TiffField_t tiffField;
+        for (std::size_t b = 0; b < 4; ++b)
+        {
+            row[b * numSamples + i] = tmp[i * 4 + (isMBE ? b : 3 - b)];
+        }
+    }
 
-        file.seekg(nextFieldPos, std::ios_base::beg);
-        file.read(reinterpret_cast<char*>(&tiffField), sizeof(tiffField));
-        if (file.gcount() != sizeof(tiffField))
+    for (std::size_t j = numSamples * 4 - 1; j >= samplesPerPixel; --j)
+    {
+        row[j] = static_cast<uint8_t>(row[j] - row[j - samplesPerPixel]);
+    }
+}
+
+void UndoFloatingPointPredictor(uint8_t* row, std::size_t numSamples, unsigned samplesPerPixel, std::vector<uint8_t>& tmp)
+{
+    for (std::size_t j = samplesPerPixel; j < numSamples * 4; ++j)
+    {
+        row[j] = static_cast<uint8_t>(row[j] + row[j - samplesPerPixel]);
+    }
+
+    const bool isMBE = IsMachineBigEndian();
+    tmp.assign(row, row + numSamples * 4);
+    for (std::size_t i = 0; i < numSamples; ++i)
+    {
+        for (std::size_t b = 0; b < 4; ++b)
         {
-            if (errorMsg) *errorMsg = "TIFF field is incomplete";
-            return std::nullopt;
+            row[i * 4 + (isMBE ? b : 3 - b)] = tmp[b * numSamples + i];
         }
-        nextFieldPos = file.tellg();
+    }
+}
 
-        tiffField.tag = SWAP16cnd(tiffField.tag, enDiff);
-        tiffField.type = SWAP16cnd(tiffField.type, enDiff);
-        tiffField.count = SWAP32cnd(tiffField.count, enDiff);
-        if (tiffField.count > 1 || tiffField.type == ttDWord)
-            tiffField.value = SWAP32cnd(tiffField.value, enDiff);
-        else if (tiffField.count == 1 && tiffField.type == ttWord)
+/// Reverses the byte order of `numSamples` samples of `bytesPerSample` (2 or 4) bytes each.
+void SwapSampleBytes(uint8_t* data, std::size_t numSamples, std::size_t bytesPerSample)
+{
+    for (std::size_t i = 0; i < numSamples; ++i)
+    {
+        std::reverse(data + i * bytesPerSample, data + (i + 1) * bytesPerSample);
+    }
+}
+
+// Reading --------------------------------------------------------------------------------------------------
+
+/// Provides bounds-checked access to TIFF structures in a memory-mapped file.
+class c_MappedTiffParser
+{
+public:
+    c_MappedTiffParser(const uint8_t* data, std::size_t size, bool bigEndian)
+    : m_Data(data), m_Size(size), m_BigEndian(bigEndian)
+    {}
+
+    std::optional<uint16_t> Read16(std::size_t offset) const
+    {
+        if (offset + 2 > m_Size) { return std::nullopt; }
+        const uint8_t* p = m_Data + offset;
+        return m_BigEndian ? static_cast<uint16_t>((p[0] << 8) | p[1]) : static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    std::optional<uint32_t> Read32(std::size_t offset) const
+    {
+        if (offset + 4 > m_Size) { return std::nullopt; }
+        const uint8_t* p = m_Data + offset;
+        const uint32_t b0 = p[0], b1 = p[1], b2 = p[2], b3 = p[3];
+        return m_BigEndian ? (b0 << 24) | (b1 << 16) | (b2 << 8) | b3 : b0 | (b1 << 8) | (b2 << 16) | (b3 << 24);
+    }
+
+    /// Returns the values of a directory entry of type BYTE, SHORT or LONG (stored inline or at the offset given by the entry).
+    std::optional<std::vector<uint32_t>> ReadFieldValues(std::size_t entryOffset) const
+    {
+        const auto type = Read16(entryOffset + 2);
+        const auto count = Read32(entryOffset + 4);
+        if (!type || !count) { return std::nullopt; }
+
+        unsigned typeLength = 0;
+        switch (*type)
         {
-            // This is a special case where a 16-bit value is stored in a 32-bit field,
-            // always in the lower-address bytes. So if the machine is big-endian,
-            // the value always has to be shifted right by 16 bits first, regardless of
-            // the file's endianess, and only then swapped, if the machine and file endianesses differ.
-            if (isMBE)
-                tiffField.value >>= 16;
+        case ttByte: typeLength = 1; break;
+        case ttWord: typeLength = 2; break;
+        case ttDWord: typeLength = 4; break;
+        default: return std::vector<uint32_t>{}; // other types are not used by any of the tags we read
+        }
 
-            tiffField.value = SWAP16in32cnd(tiffField.value, enDiff);
+        const std::size_t numBytes = static_cast<std::size_t>(*count) * typeLength;
+        std::size_t valuesOffset = entryOffset + 8;
+        if (numBytes > 4)
+        {
+            const auto offset = Read32(entryOffset + 8);
+            if (!offset) { return std::nullopt; }
+            valuesOffset = *offset;
         }
+        if (valuesOffset + numBytes > m_Size) { return std::nullopt; }
 
-        switch (tiffField.tag)
+        std::vector<uint32_t> values(*count);
+        for (std::size_t i = 0; i < values.size(); ++i)
         {
-        case TAG_IMAGE_WIDTH: imgWidth = tiffField.value; break;
+            switch (typeLength)
+            {
+            case 1: values[i] = m_Data[valuesOffset + i]; break;
+            case 2: values[i] = *Read16(valuesOffset + 2 * i); break;
+            case 4: values[i] = *Read32(valuesOffset + 4 * i); break;
+            }
+        }
 
-        case TAG_IMAGE_HEIGHT: imgHeight = tiffField.value; break;
+        return values;
+    }
 
-        case TAG_BITS_PER_SAMPLE:
-            if (tiffField.count == 1)
-                bitsPerSample = tiffField.value;
-            else
-            {
-                // Some files may have as many "bits per sample" values specified
-                // as there are channels. Make sure they are all the same.
+private:
+    const uint8_t* m_Data;
+    std::size_t m_Size;
+    bool m_BigEndian;
+};
 
-                file.seekg(tiffField.value, std::ios_base::beg);
+enum class SampleType { UInt8, UInt16, Float32 };
 
-                std::unique_ptr<uint16_t[]> fieldBuf(new uint16_t[tiffField.count]);
-                file.read(reinterpret_cast<char*>(fieldBuf.get()), tiffField.count * sizeof(uint16_t));
+/// Image data layout read from a TIFF directory.
+struct TiffLayout
+{
+    unsigned width{0};
+    unsigned height{0};
+    unsigned samplesPerPixel{1};
+    unsigned bitsPerSample{0};
+    SampleType sampleType{};
+    int photometricInterpretation{-1};
+    unsigned compression{NO_COMPRESSION};
+    unsigned predictor{PREDICTOR_NONE};
+    bool bigEndian{false}; ///< Byte order of the file.
+
+    // Pixel data is stored in chunks: strips (which span the whole width) or tiles.
+    bool tiled{false};
+    unsigned chunkWidth{0};
+    unsigned chunkHeight{0};
+    std::size_t chunksAcross{0};
+    std::vector<uint32_t> chunkOffsets;
+    std::vector<uint32_t> chunkByteCounts;
+
+    std::size_t GetBytesPerSample() const { return bitsPerSample / 8; }
+
+    std::size_t GetChunkBytesPerRow() const { return static_cast<std::size_t>(chunkWidth) * samplesPerPixel * GetBytesPerSample(); }
+
+    unsigned GetChunkX0(std::size_t chunk) const { return static_cast<unsigned>(chunk % chunksAcross) * chunkWidth; }
+
+    unsigned GetChunkY0(std::size_t chunk) const { return static_cast<unsigned>(chunk / chunksAcross) * chunkHeight; }
+
+    /// Returns the number of rows stored in the chunk (tiles are always stored whole; the last strip contains only the remaining rows).
+    unsigned GetChunkStoredRows(std::size_t chunk) const { return tiled ? chunkHeight : std::min(chunkHeight, height - GetChunkY0(chunk)); }
+};
+
+/// Returns `true` if all elements of `values` are equal (and there is at least one).
+bool AllEqual(const std::vector<uint32_t>& values)
+{
+    return !values.empty() && std::all_of(values.begin(), values.end(), [&](uint32_t v) { return v == values[0]; });
+}
 
-                bool allEqual = true;
-                uint16_t first = fieldBuf[0];
-                for (unsigned j = 1; j < tiffField.count; j++)
-                    if (fieldBuf[j] != first)
-                    {
-                        allEqual = false;
-                        break;
-                    }
+std::optional<TiffLayout> ParseTiff(const uint8_t* data, std::size_t fileSize, std::string* errorMsg)
+{
+    const auto fail = [errorMsg](const char* msg) -> std::optional<TiffLayout> {
+        if (errorMsg) { *errorMsg = msg; }
+        return std::nullopt;
+    };
 
-                 if (!allEqual)
-                 {
-                    if (errorMsg) *errorMsg = "files with differing bit depts per channel are not supported";
-                    return std::nullopt;
-                 }
+    if (fileSize < sizeof(TiffHeader_t)) { return fail("file header is incomplete"); }
 
-                 bitsPerSample = SWAP16cnd(first, enDiff);
-            }
+    TiffLayout layout;
+    if (data[0] == 'I' && data[1] == 'I')
+        layout.bigEndian = false;
+    else if (data[0] == 'M' && data[1] == 'M')
+        layout.bigEndian = true;
+    else
+        return fail("unknown byte order");
 
-            if (bitsPerSample != 8 && bitsPerSample != 16)
-            {
-                if (errorMsg) *errorMsg = "only 8 and 16 bits per channel files are supported";
-                return std::nullopt;
-            }
+    const c_MappedTiffParser parser(data, fileSize, layout.bigEndian);
+
+    if (parser.Read16(2) != TIFF_VERSION) { return fail("unknown TIFF version"); }
+
+    const auto dirOffset = parser.Read32(4);
+    const auto numDirEntries = dirOffset ? parser.Read16(*dirOffset) : std::nullopt;
+    if (!numDirEntries) { return fail("the number of TIFF directory entries tag is incomplete"); }
+
+    unsigned sampleFormat = SAMPLE_FORMAT_UINT;
+    unsigned rowsPerStrip = 0;
+    unsigned tileWidth = 0, tileLength = 0;
+
+    for (unsigned i = 0; i < *numDirEntries; ++i)
+    {
+        const std::size_t entryOffset = *dirOffset + 2 + i * sizeof(TiffField_t);
+        const auto tag = parser.Read16(entryOffset);
+        auto values = parser.ReadFieldValues(entryOffset);
+        if (!tag || !values) { return fail("TIFF field is incomplete"); }
+
+        const uint32_t single = (values->size() == 1) ? values->at(0) : 0;
+
+        switch (*tag)
+        {
+        case TAG_IMAGE_WIDTH: layout.width = single; break;
+
+        case TAG_IMAGE_HEIGHT: layout.height = single; break;
+
+        case TAG_BITS_PER_SAMPLE:
+            // some files specify as many values as there are channels
+            if (!AllEqual(*values)) { return fail("files with differing bit depts per channel are not supported"); }
+            layout.bitsPerSample = values->at(0);
             break;
 
-        case TAG_COMPRESSION:
-            if (tiffField.value != NO_COMPRESSION)
-            {
-                if (errorMsg) *errorMsg = "compression is not supported";
-                return std::nullopt;
-            }
+        case TAG_SAMPLE_FORMAT:
+            if (!AllEqual(*values)) { return fail("files with differing sample formats per channel are not supported"); }
+            sampleFormat = values->at(0);
             break;
 
-        case TAG_PHOTOMETRIC_INTERPRETATION: photometricInterpretation = tiffField.value; break;
+        case TAG_COMPRESSION: layout.compression = single; break;
 
-        case TAG_STRIP_OFFSETS:
-            numStrips = tiffField.count;
-            stripOffsets.reset(new uint32_t[numStrips]);
-            if (numStrips == 1)
-                stripOffsets[0] = tiffField.value;
-            else
+        case TAG_PREDICTOR: layout.predictor = single; break;
+
+        case TAG_PLANAR_CONFIGURATION:
+            if (single != PLANAR_CONFIGURATION_CHUNKY)
             {
-                file.seekg(tiffField.value, std::ios_base::beg);
-                for (unsigned i = 0; i < numStrips; i++)
-                {
-                    file.read(reinterpret_cast<char*>(&stripOffsets[i]), sizeof(stripOffsets[i]));
-                    stripOffsets[i] = SWAP32cnd(stripOffsets[i], enDiff);
-                }
+                return fail("files with planar configuration other than packed (chunky) are not supported");
             }
             break;
 
-        case TAG_SAMPLES_PER_PIXEL: samplesPerPixel = tiffField.value; break;
+        case TAG_PHOTOMETRIC_INTERPRETATION: layout.photometricInterpretation = static_cast<int>(single); break;
+
+        case TAG_SAMPLES_PER_PIXEL: layout.samplesPerPixel = single; break;
 
-        case TAG_ROWS_PER_STRIP: rowsPerStrip = tiffField.value; break;
+        case TAG_ROWS_PER_STRIP: rowsPerStrip = single; break;
+
+        case TAG_TILE_WIDTH: tileWidth = single; break;
+
+        case TAG_TILE_LENGTH: tileLength = single; break;
+
+        case TAG_STRIP_OFFSETS:
+        case TAG_TILE_OFFSETS:
+            layout.chunkOffsets = std::move(*values);
+            break;
 
         case TAG_STRIP_BYTE_COUNTS:
-            stripByteCounts.reset(new uint32_t[tiffField.count]);
-            if (tiffField.count == 1)
-                stripByteCounts[0] = tiffField.value;
-            else
-            {
-                file.seekg(tiffField.value, std::ios_base::beg);
-                for (unsigned i = 0; i < tiffField.count; i++)
-                {
-                    file.read(reinterpret_cast<char*>(&stripByteCounts[i]), sizeof(stripByteCounts[i]));
-                    stripByteCounts[i] = SWAP32cnd(stripByteCounts[i], enDiff);
-                }
-            }
+        case TAG_TILE_BYTE_COUNTS:
+            layout.chunkByteCounts = std::move(*values);
             break;
+        }
+    }
 
-        case TAG_PLANAR_CONFIGURATION:
-            if (tiffField.value != PLANAR_CONFIGURATION_CHUNKY)
+    if (layout.width == 0 || layout.height == 0 || layout.chunkOffsets.empty())
+    {
+        return fail("image dimensions or pixel data location are missing");
+    }
+
+    if (!(layout.samplesPerPixel == 1 && (layout.photometricInterpretation == PHMET_BLACK_IS_ZERO || layout.photometricInterpretation == PHMET_WHITE_IS_ZERO)) &&
+        !(layout.samplesPerPixel == 3 && layout.photometricInterpretation == PHMET_RGB))
+    {
+        return fail("only RGB and grayscale images are supported");
+    }
+
+    if (sampleFormat == SAMPLE_FORMAT_UINT && layout.bitsPerSample == 8)
+        layout.sampleType = SampleType::UInt8;
+    else if (sampleFormat == SAMPLE_FORMAT_UINT && layout.bitsPerSample == 16)
+        layout.sampleType = SampleType::UInt16;
+    else if (sampleFormat == SAMPLE_FORMAT_IEEEFP && layout.bitsPerSample == 32 && layout.photometricInterpretation != PHMET_WHITE_IS_ZERO)
+        layout.sampleType = SampleType::Float32;
+    else
+        return fail("only 8-, 16-bit integer and 32-bit floating-point samples are supported");
+
+    if (layout.compression != NO_COMPRESSION &&
+        layout.compression != COMPRESSION_LZW &&
+        layout.compression != COMPRESSION_DEFLATE &&
+        layout.compression != COMPRESSION_DEFLATE_OBSOLETE)
+    {
+        return fail("only uncompressed, LZW and Deflate files are supported");
+    }
+
+    if (layout.compression == NO_COMPRESSION)
+    {
+        layout.predictor = PREDICTOR_NONE; // predictors are used only by compression schemes
+    }
+    else if (layout.predictor != PREDICTOR_NONE &&
+             !(layout.predictor == PREDICTOR_HORIZONTAL && layout.sampleType != SampleType::Float32) &&
+             !(layout.predictor == PREDICTOR_FLOATING_POINT && layout.sampleType == SampleType::Float32))
+    {
+        return fail("unsupported predictor");
+    }
+
+    layout.tiled = (tileWidth > 0 && tileLength > 0);
+    layout.chunkWidth = layout.tiled ? tileWidth : layout.width;
+    layout.chunkHeight = layout.tiled ? tileLength : ((rowsPerStrip == 0) ? layout.height : std::min(rowsPerStrip, layout.height));
+    layout.chunksAcross = (layout.width + layout.chunkWidth - 1) / layout.chunkWidth;
+    const std::size_t chunksDown = (layout.height + layout.chunkHeight - 1) / layout.chunkHeight;
+    if (layout.chunkOffsets.size() != layout.chunksAcross * chunksDown)
+    {
+        return fail("the number of strips or tiles does not match image dimensions");
+    }
+
+    // Validate all chunks up front, so that decoding (performed in parallel) can only fail on invalid compressed data.
+    for (std::size_t chunk = 0; chunk < layout.chunkOffsets.size(); ++chunk)
+    {
+        std::size_t storedBytes = layout.GetChunkStoredRows(chunk) * layout.GetChunkBytesPerRow();
+        if (layout.compression != NO_COMPRESSION)
+        {
+            if (layout.chunkByteCounts.size() != layout.chunkOffsets.size()) { return fail("strip or tile byte counts are missing"); }
+            storedBytes = layout.chunkByteCounts[chunk];
+        }
+        if (layout.chunkOffsets[chunk] + storedBytes > fileSize)
+        {
+            if (errorMsg)
             {
-                if (errorMsg) *errorMsg = "files with planar configuration other than packed (chunky) are not supported";
-                return std::nullopt;
+                *errorMsg = boost::str(boost::format("the file is incomplete: pixel data in strip or tile %d is too short") % chunk);
             }
-            break;
+            return std::nullopt;
+        }
+    }
+
+    return layout;
+}
+
+/// Pixel data of a chunk, stored row after row (`TiffLayout::GetChunkBytesPerRow` bytes each).
+struct ChunkData
+{
+    const uint8_t* data;
+    bool bigEndian; ///< Byte order of samples.
+};
+
+/// Returns the pixel data of a chunk, decompressed (into `workBuf`) if needed; returns `std::nullopt` on error.
+std::optional<ChunkData> DecodeChunk(
+    const TiffLayout& layout,
+    const uint8_t* fileData,
+    std::size_t chunk,
+    std::vector<uint8_t>& workBuf,
+    std::vector<uint8_t>& predictorBuf
+)
+{
+    const uint8_t* stored = fileData + layout.chunkOffsets[chunk];
+    if (layout.compression == NO_COMPRESSION)
+    {
+        return ChunkData{stored, layout.bigEndian};
+    }
+
+    const unsigned numRows = layout.GetChunkStoredRows(chunk);
+    const std::size_t bytesPerRow = layout.GetChunkBytesPerRow();
+    workBuf.resize(numRows * bytesPerRow);
+
+    const bool decoded = (layout.compression == COMPRESSION_LZW)
+        ? LzwDecode(stored, layout.chunkByteCounts[chunk], workBuf.data(), workBuf.size())
+        : DeflateDecode(stored, layout.chunkByteCounts[chunk], workBuf.data(), workBuf.size());
+    if (!decoded) { return std::nullopt; }
+
+    const std::size_t samplesPerRow = static_cast<std::size_t>(layout.chunkWidth) * layout.samplesPerPixel;
+    const bool isMBE = IsMachineBigEndian();
+
+    if (layout.predictor == PREDICTOR_FLOATING_POINT)
+    {
+        // produces samples in native byte order
+        for (unsigned row = 0; row < numRows; ++row)
+        {
+            UndoFloatingPointPredictor(workBuf.data() + row * bytesPerRow, samplesPerRow, layout.samplesPerPixel, predictorBuf);
         }
+        return ChunkData{workBuf.data(), isMBE};
     }
 
-    if (rowsPerStrip == 0 && numStrips == 1)
-        // If there is only 1 strip, it contains all the rows
-        rowsPerStrip = imgHeight;
+    if (layout.predictor == PREDICTOR_HORIZONTAL)
+    {
+        if (layout.bigEndian != isMBE && layout.GetBytesPerSample() > 1)
+        {
+            SwapSampleBytes(workBuf.data(), samplesPerRow * numRows, layout.GetBytesPerSample());
+        }
+        for (unsigned row = 0; row < numRows; ++row)
+        {
+            uint8_t* rowPtr = workBuf.data() + row * bytesPerRow;
+            if (layout.sampleType == SampleType::UInt8)
+                UndoHorizontalPredictor<uint8_t>(rowPtr, samplesPerRow, layout.samplesPerPixel);
+            else
+                UndoHorizontalPredictor<uint16_t>(rowPtr, samplesPerRow, layout.samplesPerPixel);
+        }
+        return ChunkData{workBuf.data(), isMBE};
+    }
 
-    // Validate the values
+    return ChunkData{workBuf.data(), layout.bigEndian};
+}
 
-    if (samplesPerPixel == 1 && photometricInterpretation != PHMET_BLACK_IS_ZERO && photometricInterpretation != PHMET_WHITE_IS_ZERO ||
-        samplesPerPixel == 3 && photometricInterpretation != PHMET_RGB ||
-        samplesPerPixel != 1 && samplesPerPixel != 3)
+/// Converts samples to floating-point values from [0; 1] (integer samples) or as-is (floating-point samples).
+template<SampleType Type, bool BigEndian>
+void ConvertSamplesTo32f(const uint8_t* src, float* dest, std::size_t numSamples, bool negate)
+{
+    for (std::size_t i = 0; i < numSamples; ++i)
     {
-        if (errorMsg) *errorMsg = "only RGB and grayscale images are supported";
-        return std::nullopt;
+        float value;
+        if constexpr (Type == SampleType::UInt8)
+        {
+            value = src[i] * (1.0f / 0xFF);
+        }
+        else if constexpr (Type == SampleType::UInt16)
+        {
+            const uint8_t* p = src + 2 * i;
+            const uint16_t sample = BigEndian ? static_cast<uint16_t>((p[0] << 8) | p[1]) : static_cast<uint16_t>(p[0] | (p[1] << 8));
+            value = sample * (1.0f / 0xFFFF);
+        }
+        else
+        {
+            const uint8_t* p = src + 4 * i;
+            const uint32_t b0 = p[0], b1 = p[1], b2 = p[2], b3 = p[3];
+            const uint32_t bits = BigEndian ? (b0 << 24) | (b1 << 16) | (b2 << 8) | b3 : b0 | (b1 << 8) | (b2 << 16) | (b3 << 24);
+            std::memcpy(&value, &bits, sizeof(value));
+        }
+        dest[i] = negate ? 1.0f - value : value;
     }
+}
+
+using ConvertSamplesFunc = void(*)(const uint8_t*, float*, std::size_t, bool);
 
-    if (samplesPerPixel == 1)
+ConvertSamplesFunc GetSampleConverter(SampleType type, bool bigEndian)
+{
+    switch (type)
     {
-        if (bitsPerSample == 8)
-            pixFmt = PixelFormat::PIX_MONO8;
-        else if (bitsPerSample == 16)
-            pixFmt = PixelFormat::PIX_MONO16;
+    case SampleType::UInt8: return &ConvertSamplesTo32f<SampleType::UInt8, false>;
+    case SampleType::UInt16: return bigEndian ? &ConvertSamplesTo32f<SampleType::UInt16, true> : &ConvertSamplesTo32f<SampleType::UInt16, false>;
+    case SampleType::Float32: return bigEndian ? &ConvertSamplesTo32f<SampleType::Float32, true> : &ConvertSamplesTo32f<SampleType::Float32, false>;
     }
-    else if (samplesPerPixel == 3)
+    IMPPG_ABORT();
+}
+
+/// Calls `processChunk(chunk, chunkData)` for each chunk in parallel; returns `false` if decoding of any chunk failed.
+template<typename ProcessChunk>
+bool ForEachDecodedChunk(const TiffLayout& layout, const uint8_t* fileData, ProcessChunk processChunk)
+{
+    std::atomic<bool> failed{false};
+
+    #pragma omp parallel
+    {
+        std::vector<uint8_t> workBuf;
+        std::vector<uint8_t> predictorBuf;
+
+        #pragma omp for schedule(dynamic)
+        for (int chunk = 0; chunk < static_cast<int>(layout.chunkOffsets.size()); ++chunk)
+        {
+            if (failed) { continue; }
+
+            const auto chunkData = DecodeChunk(layout, fileData, chunk, workBuf, predictorBuf);
+            if (!chunkData)
+                failed = true;
+            else
+                processChunk(static_cast<std::size_t>(chunk), *chunkData);
+        }
+    }
+
+    return !failed;
+}
+
+// Writing --------------------------------------------------------------------------------------------------
+
+/// TIFF directory entry to be written.
+struct IfdEntry
+{
+    uint16_t tag;
+    uint16_t type;
+    std::vector<uint32_t> values;
+};
+
+/// Serializes the directory (in native byte order) to be stored at `dirOffset`; values which do not fit
+/// in an entry are stored after the directory.
+std::vector<uint8_t> SerializeIfd(std::vector<IfdEntry> entries, uint32_t dirOffset)
+{
+    std::sort(entries.begin(), entries.end(), [](const IfdEntry& e1, const IfdEntry& e2) { return e1.tag < e2.tag; });
+
+    const std::size_t dirLength = sizeof(uint16_t) + entries.size() * sizeof(TiffField_t) + sizeof(uint32_t);
+    std::vector<uint8_t> result(dirLength, 0);
+
+    StoreSample<uint16_t>(result.data(), static_cast<uint16_t>(entries.size()));
+    for (std::size_t i = 0; i < entries.size(); ++i)
     {
-        if (bitsPerSample == 8)
-            pixFmt = PixelFormat::PIX_RGB8;
-        else if (bitsPerSample == 16)
-            pixFmt = PixelFormat::PIX_RGB16;
+        const IfdEntry& entry = entries[i];
+        uint8_t* field = result.data() + sizeof(uint16_t) + i * sizeof(TiffField_t);
+        const std::size_t typeLength = (entry.type == ttWord) ? 2 : 4;
+
+        std::vector<uint8_t> valueBytes(entry.values.size() * typeLength);
+        for (std::size_t j = 0; j < entry.values.size(); ++j)
+        {
+            if (typeLength == 2)
+                StoreSample<uint16_t>(&valueBytes[j * 2], static_cast<uint16_t>(entry.values[j]));
+            else
+                StoreSample<uint32_t>(&valueBytes[j * 4], entry.values[j]);
+        }
+
+        StoreSample<uint16_t>(field, entry.tag);
+        StoreSample<uint16_t>(field + 2, entry.type);
+        StoreSample<uint32_t>(field + 4, static_cast<uint32_t>(entry.values.size()));
+        if (valueBytes.size() <= 4)
+        {
+            // stored in the lower-address bytes of the value field
+            std::copy(valueBytes.begin(), valueBytes.end(), field + 8);
+        }
+        else
+        {
+            StoreSample<uint32_t>(field + 8, static_cast<uint32_t>(dirOffset + result.size()));
+            result.insert(result.end(), valueBytes.begin(), valueBytes.end());
+            if (result.size() % 2 != 0) { result.push_back(0); } // values have to begin at word boundaries
+        }
     }
+    // the next directory offset (0 = no other directories) is already zeroed
+
+    return result;
+}
+
+} // anonymous namespace
+
+bool SaveTiff(
+    const std::filesystem::path& fileName,
+    c_RowReader& img,
+    TiffCompression compression,
+    const TiffWriteOptions& options
+)
+{
+    const PixelFormat pixFmt = img.GetPixelFormat();
+    IMPPG_ASSERT(pixFmt == PixelFormat::PIX_MONO8 ||
+                 pixFmt == PixelFormat::PIX_MONO16 ||
+                 pixFmt == PixelFormat::PIX_MONO32F ||
+                 pixFmt == PixelFormat::PIX_RGB8 ||
+                 pixFmt == PixelFormat::PIX_RGB16 ||
+                 pixFmt == PixelFormat::PIX_RGB32F);
+
+    const unsigned width = img.GetWidth();
+    const unsigned height = img.GetHeight();
+    const unsigned samplesPerPixel = static_cast<unsigned>(NumChannels[static_cast<std::size_t>(pixFmt)]);
+    const unsigned bytesPerSample = static_cast<unsigned>(img.GetBytesPerPixel()) / samplesPerPixel;
+    const bool isFloat = (pixFmt == PixelFormat::PIX_MONO32F || pixFmt == PixelFormat::PIX_RGB32F);
+    const std::size_t bytesPerRow = static_cast<std::size_t>(width) * img.GetBytesPerPixel();
+    const std::size_t samplesPerRow = static_cast<std::size_t>(width) * samplesPerPixel;
+
+    const unsigned rowsPerStrip = (options.rowsPerStrip == 0) ? height : std::min(options.rowsPerStrip, height);
+    const std::size_t numStrips = (height + rowsPerStrip - 1) / rowsPerStrip;
+    const auto getStripRows = [&](std::size_t strip) { return std::min<std::size_t>(rowsPerStrip, height - strip * rowsPerStrip); };
+
+    const bool usePredictor = (compression != TiffCompression::None && options.usePredictor);
+
+    // Rows are obtained from `img` in groups of whole strips; the strips of each group are compressed in parallel.
+    const unsigned stripsPerGroup = std::max({
+        1u,
+        std::thread::hardware_concurrency(),
+        img.GetDefaultChunkRows() / rowsPerStrip
+    });
+    const unsigned groupRows = static_cast<unsigned>(std::min<std::size_t>(std::size_t{stripsPerGroup} * rowsPerStrip, height));
+
+    std::ofstream file(fileName, std::ios_base::trunc | std::ios_base::binary);
+    if (file.fail())
+        return false;
+
+    // File layout: header, strips, directory (followed by the values which do not fit in its entries).
+    // The directory offset in the header is filled in at the end.
+
+    TiffHeader_t tiffHeader;
+    tiffHeader.id = IsMachineBigEndian() ? MOTOROLA_BYTE_ORDER : INTEL_BYTE_ORDER;
+    tiffHeader.version = TIFF_VERSION;
+    tiffHeader.dirOffset = 0;
+    file.write(reinterpret_cast<const char*>(&tiffHeader), sizeof(tiffHeader));
 
-    auto result = c_Image(imgWidth, imgHeight, pixFmt);
+    std::vector<uint32_t> stripOffsets(numStrips);
+    std::vector<uint32_t> stripByteCounts(numStrips);
+    uint64_t offset = sizeof(TiffHeader_t);
 
-    int currentRow = 0;
-    for (unsigned i = 0; i < numStrips; i++)
+    std::vector<std::vector<uint8_t>> compressedStrips(compression != TiffCompression::None ? stripsPerGroup : 0);
+
+    for (unsigned groupY0 = 0; groupY0 < height; groupY0 += groupRows)
     {
-        file.seekg(stripOffsets[i], std::ios_base::beg);
+        const unsigned numGroupRows = std::min(groupRows, height - groupY0);
+        img.Fetch(groupY0, numGroupRows);
+
+        const std::size_t firstStrip = groupY0 / rowsPerStrip;
+        const std::size_t numGroupStrips = (numGroupRows + rowsPerStrip - 1) / rowsPerStrip;
 
-        for (unsigned j = 0; j < rowsPerStrip && currentRow < imgHeight; j++, currentRow++)
+        if (compression == TiffCompression::None)
         {
-            std::streamsize numBytesToRead = imgWidth * BytesPerPixel[static_cast<size_t>(pixFmt)];
-            file.read(result.GetRowAs<char>(currentRow), numBytesToRead);
+            for (unsigned y = groupY0; y < groupY0 + numGroupRows; ++y)
+                file.write(img.GetRowAs<char>(y), bytesPerRow);
 
-            if (file.gcount() != numBytesToRead)
+            for (std::size_t strip = firstStrip; strip < firstStrip + numGroupStrips; ++strip)
             {
-                if (errorMsg) *errorMsg = boost::str(boost::format("the file is incomplete: pixel data in strip %d is too short; "
-                    "expected %d bytes, but read only %d")
-                    % i
-                    % stripByteCounts[i]
-                    % (currentRow * numBytesToRead)
-                );
-                return std::nullopt;
+                stripOffsets[strip] = static_cast<uint32_t>(offset);
+                stripByteCounts[strip] = static_cast<uint32_t>(getStripRows(strip) * bytesPerRow);
+                offset += stripByteCounts[strip];
             }
         }
+        else
+        {
+            std::atomic<bool> failed{false};
+
+            #pragma omp parallel
+            {
+                std::vector<uint8_t> rawStrip;
+                std::vector<uint8_t> predictorBuf;
+
+                #pragma omp for schedule(dynamic)
+                for (int i = 0; i < static_cast<int>(numGroupStrips); ++i)
+                {
+                    const std::size_t strip = firstStrip + i;
+                    const std::size_t numRows = getStripRows(strip);
+                    rawStrip.resize(numRows * bytesPerRow);
+                    for (std::size_t row = 0; row < numRows; ++row)
+                    {
+                        uint8_t* rawRow = rawStrip.data() + row * bytesPerRow;
+                        std::memcpy(rawRow, img.GetRowAs<uint8_t>(static_cast<unsigned>(strip * rowsPerStrip + row)), bytesPerRow);
+                        if (!usePredictor)
+                            continue;
+                        else if (isFloat)
+                            ApplyFloatingPointPredictor(rawRow, samplesPerRow, samplesPerPixel, predictorBuf);
+                        else if (bytesPerSample == 1)
+                            ApplyHorizontalPredictor<uint8_t>(rawRow, samplesPerRow, samplesPerPixel);
+                        else
+                            ApplyHorizontalPredictor<uint16_t>(rawRow, samplesPerRow, samplesPerPixel);
+                    }
+
+                    compressedStrips[i].clear();
+                    if (compression == TiffCompression::LZW)
+                        LzwEncode(rawStrip.data(), rawStrip.size(), compressedStrips[i]);
+                    else if (!DeflateEncode(rawStrip.data(), rawStrip.size(), compressedStrips[i]))
+                        failed = true;
+                }
+            }
+
+            if (failed) { return false; }
+
+            for (std::size_t i = 0; i < numGroupStrips; ++i)
+            {
+                file.write(reinterpret_cast<const char*>(compressedStrips[i].data()), compressedStrips[i].size());
+                stripOffsets[firstStrip + i] = static_cast<uint32_t>(offset);
+                stripByteCounts[firstStrip + i] = static_cast<uint32_t>(compressedStrips[i].size());
+                offset += compressedStrips[i].size();
+            }
+        }
+
+        if (offset > UINT32_MAX || file.fail()) { return false; } // offsets have to fit in 32 bits
+    }
+
+    if (offset % 2 != 0) // the directory has to begin at a word boundary
+    {
+        file.put(0);
+        offset += 1;
+    }
+
+    const uint32_t dirOffset = static_cast<uint32_t>(offset);
+
+    uint16_t compressionTag = NO_COMPRESSION;
+    if (compression == TiffCompression::LZW) compressionTag = COMPRESSION_LZW;
+    else if (compression == TiffCompression::Deflate) compressionTag = COMPRESSION_DEFLATE;
+
+    std::vector<IfdEntry> entries{
+        { TAG_IMAGE_WIDTH, ttDWord, { width } },
+        { TAG_IMAGE_HEIGHT, ttDWord, { height } },
+        { TAG_BITS_PER_SAMPLE, ttWord, std::vector<uint32_t>(samplesPerPixel, 8 * bytesPerSample) },
+        { TAG_COMPRESSION, ttWord, { compressionTag } },
+        { TAG_PHOTOMETRIC_INTERPRETATION, ttWord, { static_cast<uint32_t>(samplesPerPixel == 1 ? PHMET_BLACK_IS_ZERO : PHMET_RGB) } },
+        { TAG_STRIP_OFFSETS, ttDWord, stripOffsets },
+        { TAG_SAMPLES_PER_PIXEL, ttWord, { samplesPerPixel } },
+        { TAG_ROWS_PER_STRIP, ttDWord, { rowsPerStrip } },
+        { TAG_STRIP_BYTE_COUNTS, ttDWord, stripByteCounts },
+        { TAG_PLANAR_CONFIGURATION, ttWord, { PLANAR_CONFIGURATION_CHUNKY } },
+        { TAG_SAMPLE_FORMAT, ttWord, std::vector<uint32_t>(samplesPerPixel, isFloat ? SAMPLE_FORMAT_IEEEFP : SAMPLE_FORMAT_UINT) }
+    };
+    if (usePredictor)
+    {
+        entries.push_back({ TAG_PREDICTOR, ttWord, { isFloat ? PREDICTOR_FLOATING_POINT : PREDICTOR_HORIZONTAL } });
+    }
+
+    const auto ifd = SerializeIfd(std::move(entries), dirOffset);
+    if (offset + ifd.size() > UINT32_MAX) { return false; }
+    file.write(reinterpret_cast<const char*>(ifd.data()), ifd.size());
+
+    tiffHeader.dirOffset = dirOffset;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&tiffHeader), sizeof(tiffHeader));
+
+    file.close();
+    return !file.fail();
+}
+
+std::optional<c_Image> ReadTiff(
+    const std::filesystem::path& fileName,
+    std::string* errorMsg ///< If not null, receives error message (if any))
+)
+{
+    const auto file = c_MappedFile::Open(fileName);
+    if (!file) { return std::nullopt; }
+
+    const auto layout = ParseTiff(file->GetData(), file->GetSize(), errorMsg);
+    if (!layout) { return std::nullopt; }
+
+    PixelFormat pixFmt{};
+    switch (layout->sampleType)
+    {
+    case SampleType::UInt8: pixFmt = (layout->samplesPerPixel == 1) ? PixelFormat::PIX_MONO8 : PixelFormat::PIX_RGB8; break;
+    case SampleType::UInt16: pixFmt = (layout->samplesPerPixel == 1) ? PixelFormat::PIX_MONO16 : PixelFormat::PIX_RGB16; break;
+    case SampleType::Float32: pixFmt = (layout->samplesPerPixel == 1) ? PixelFormat::PIX_MONO32F : PixelFormat::PIX_RGB32F; break;
     }
 
-    if ((pixFmt == PixelFormat::PIX_MONO16 || pixFmt == PixelFormat::PIX_RGB16) && enDiff)
-        SwapBufferWords(result.GetBuffer());
+    auto result = c_Image(layout->width, layout->height, pixFmt);
+
+    const bool isMBE = IsMachineBigEndian();
+    const std::size_t bytesPerSample = layout->GetBytesPerSample();
+    const std::size_t chunkBytesPerRow = layout->GetChunkBytesPerRow();
 
-    if (photometricInterpretation == PHMET_WHITE_IS_ZERO)
+    const bool decoded = ForEachDecodedChunk(*layout, file->GetData(), [&](std::size_t chunk, const ChunkData& chunkData) {
+        const unsigned x0 = layout->GetChunkX0(chunk);
+        const unsigned y0 = layout->GetChunkY0(chunk);
+        const unsigned cols = std::min(layout->chunkWidth, layout->width - x0);
+        const unsigned rows = std::min(layout->chunkHeight, layout->height - y0);
+        const std::size_t numSamples = static_cast<std::size_t>(cols) * layout->samplesPerPixel;
+
+        for (unsigned row = 0; row < rows; ++row)
+        {
+            uint8_t* destRow = result.GetRowAs<uint8_t>(y0 + row) + x0 * layout->samplesPerPixel * bytesPerSample;
+            std::memcpy(destRow, chunkData.data + row * chunkBytesPerRow, numSamples * bytesPerSample);
+            if (chunkData.bigEndian != isMBE && bytesPerSample > 1)
+            {
+                SwapSampleBytes(destRow, numSamples, bytesPerSample);
+            }
+        }
+    });
+
+    if (!decoded)
+    {
+        if (errorMsg) *errorMsg = "invalid compressed pixel data";
+        return std::nullopt;
+    }
+
+    if (layout->photometricInterpretation == PHMET_WHITE_IS_ZERO)
     {
         // reverse the values so that "black" is zero, "white" is 255 or 65535
         if (pixFmt == PixelFormat::PIX_MONO8)
@@ -587,7 +1203,65 @@ std::optional<c_Image> ReadTiff(
             NegateGrayscale16(result.GetBuffer());
     }
 
-    file.close();
+    return result;
+}
+
+std::optional<c_Image> ReadTiffMappedAs32f(const std::filesystem::path& fileName, ValueRange* valueRange)
+{
+    const auto file = c_MappedFile::Open(fileName);
+    if (!file) { return std::nullopt; }
+
+    const auto layout = ParseTiff(file->GetData(), file->GetSize(), nullptr);
+    if (!layout) { return std::nullopt; }
+
+    auto result = c_Image(layout->width, layout->height, layout->samplesPerPixel == 1 ? PixelFormat::PIX_MONO32F : PixelFormat::PIX_RGB32F);
+
+    const bool negate = (layout->photometricInterpretation == PHMET_WHITE_IS_ZERO);
+    const std::size_t chunkBytesPerRow = layout->GetChunkBytesPerRow();
+
+    // Each chunk's value range is found right after its rows are converted (while they are still in cache).
+    std::vector<ValueRange> chunkRanges(valueRange ? layout->chunkOffsets.size() : 0, ValueRange{FLT_MAX, -FLT_MAX});
+
+    // Uncompressed chunks are converted directly from the mapping into the destination image (the page cache
+    // performs the I/O); compressed ones are first decompressed into a per-thread buffer.
+    const bool decoded = ForEachDecodedChunk(*layout, file->GetData(), [&](std::size_t chunk, const ChunkData& chunkData) {
+        const ConvertSamplesFunc convert = GetSampleConverter(layout->sampleType, chunkData.bigEndian);
+        const unsigned x0 = layout->GetChunkX0(chunk);
+        const unsigned y0 = layout->GetChunkY0(chunk);
+        const unsigned cols = std::min(layout->chunkWidth, layout->width - x0);
+        const unsigned rows = std::min(layout->chunkHeight, layout->height - y0);
+        const std::size_t numSamples = static_cast<std::size_t>(cols) * layout->samplesPerPixel;
+
+        for (unsigned row = 0; row < rows; ++row)
+        {
+            float* destRow = result.GetRowAs<float>(y0 + row) + x0 * layout->samplesPerPixel;
+            convert(chunkData.data + row * chunkBytesPerRow, destRow, numSamples, negate);
+
+            if (valueRange)
+            {
+                float rangeMin = chunkRanges[chunk].min;
+                float rangeMax = chunkRanges[chunk].max;
+                for (std::size_t i = 0; i < numSamples; ++i)
+                {
+                    rangeMin = std::min(rangeMin, destRow[i]);
+                    rangeMax = std::max(rangeMax, destRow[i]);
+                }
+                chunkRanges[chunk] = ValueRange{rangeMin, rangeMax};
+            }
+        }
+    });
+
+    if (!decoded) { return std::nullopt; }
+
+    if (valueRange)
+    {
+        *valueRange = ValueRange{FLT_MAX, -FLT_MAX};
+        for (const ValueRange& range: chunkRanges)
+        {
+            valueRange->min = std::min(valueRange->min, range.min);
+            valueRange->max = std::max(valueRange->max, range.max);
+        }
+    }
 
     return result;
 }
@@ -29,16 +29,41 @@ File description:
 #include <string>
 
 #include "image/image.h"
+#include "pixel_conversion.h"
+#include "row_reader.h"
 
 /// Returns (width, height).
 std::optional<std::tuple<unsigned, unsigned>> GetTiffDimensions(const std::filesystem::path& fileName);
 
+/// Reads an uncompressed, LZW- or Deflate-compressed TIFF image (8-, 16-bit integer or 32-bit floating-point samples,
+/// in strips or tiles) via memory mapping; the strips/tiles are decoded in parallel.
 std::optional<c_Image> ReadTiff(
     const std::filesystem::path& fileName,
     std::string* errorMsg = nullptr ///< If not null, receives error message (if any)
 );
 
-/// Returns `false` on error.
-bool SaveTiff(const std::filesystem::path& fileName, const IImageBuffer& img);
+/// Reads a TIFF image supported by `ReadTiff` via memory mapping, converting it in parallel directly to PIX_MONO32F or PIX_RGB32F.
+/** Returns `std::nullopt` if the file cannot be read this way (e.g., unsupported compression); the caller shall then
+    use a general loader. Integer samples are converted to [0; 1], floating-point samples are copied as-is. */
+std::optional<c_Image> ReadTiffMappedAs32f(
+    const std::filesystem::path& fileName,
+    ValueRange* valueRange = nullptr ///< If not null, receives the range of the result's values (found while decoding).
+);
+
+enum class TiffCompression
+{
+    None,
+    LZW,
+    Deflate
+};
+
+/// Saves a MONO8/16/32F or RGB8/16/32F image; the strips are compressed in parallel. Returns `false` on error.
+/** The rows are obtained from `img` in chunks and written out as soon as they are encoded. */
+bool SaveTiff(
+    const std::filesystem::path& fileName,
+    c_RowReader& img,
+    TiffCompression compression = TiffCompression::None,
+    const TiffWriteOptions& options = {}
+);
 
 #endif // ImPPG_TIFF_H
@@ -0,0 +1,122 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Image copy-on-write unit tests.
+*/
+
+#include "image/image.h"
+
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+
+namespace
+{
+
+constexpr unsigned WIDTH = 97;
+constexpr unsigned HEIGHT = 311;
+
+void Fill(c_Image& image, std::uint16_t value)
+{
+    for (unsigned y = 0; y < image.GetHeight(); ++y)
+    {
+        auto* row = image.GetRowAs<std::uint16_t>(y);
+        for (unsigned x = 0; x < image.GetWidth(); ++x)
+        {
+            row[x] = value;
+        }
+    }
+}
+
+/// Returns 'true' if all pixels of `image` equal `value`.
+bool HasValue(const c_Image& image, std::uint16_t value)
+{
+    for (unsigned y = 0; y < image.GetHeight(); ++y)
+    {
+        const auto* row = image.GetRowAs<std::uint16_t>(y);
+        for (unsigned x = 0; x < image.GetWidth(); ++x)
+        {
+            if (row[x] != value) { return false; }
+        }
+    }
+    return true;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(CopyDoesNotSeeSubsequentWrites)
+{
+    c_Image original(WIDTH, HEIGHT, PixelFormat::PIX_MONO16);
+    Fill(original, 1);
+
+    const c_Image copy = original;
+    Fill(original, 2);
+    BOOST_CHECK(HasValue(copy, 1));
+    BOOST_CHECK(HasValue(original, 2));
+
+    c_Image assigned(1, 1, PixelFormat::PIX_MONO16);
+    assigned = original;
+    Fill(assigned, 3);
+    BOOST_CHECK(HasValue(original, 2));
+    BOOST_CHECK(HasValue(assigned, 3));
+    BOOST_CHECK(HasValue(copy, 1));
+}
+
+BOOST_AUTO_TEST_CASE(PrepareForOverwriteDoesNotAffectCopy)
+{
+    c_Image original(WIDTH, HEIGHT, PixelFormat::PIX_MONO16);
+    Fill(original, 1);
+
+    const c_Image copy1 = original;
+    original.PrepareForOverwrite();
+    Fill(original, 2);
+    BOOST_CHECK(HasValue(copy1, 1));
+
+    c_Image copy2 = original;
+    copy2.PrepareForOverwrite();
+    BOOST_CHECK(HasValue(original, 2));
+    Fill(copy2, 3);
+    BOOST_CHECK(HasValue(original, 2));
+    BOOST_CHECK(HasValue(copy1, 1));
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentWritesToDifferentRows)
+{
+    c_Image original(WIDTH, HEIGHT, PixelFormat::PIX_MONO16);
+    Fill(original, 1);
+
+    for (int iteration = 0; iteration < 20; ++iteration)
+    {
+        const c_Image copy = original;
+
+        // the first write to each row may trigger detaching the shared buffer
+        #pragma omp parallel for
+        for (int y = 0; y < static_cast<int>(HEIGHT); ++y)
+        {
+            auto* row = original.GetRowAs<std::uint16_t>(y);
+            for (unsigned x = 0; x < WIDTH; ++x)
+            {
+                row[x] = static_cast<std::uint16_t>(iteration + 2);
+            }
+        }
+
+        BOOST_REQUIRE(HasValue(original, static_cast<std::uint16_t>(iteration + 2)));
+        BOOST_REQUIRE(HasValue(copy, static_cast<std::uint16_t>(iteration + 1)));
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Test image utilities implementation.
+*/
+
+#include "test_images.h"
+
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+c_Image CreateTestImage(unsigned width, unsigned height, PixelFormat pixFmt, unsigned seed)
+{
+    std::mt19937 generator(width * 1000 + height + seed * 1000003);
+    std::uniform_int_distribution<int> noise(0, 15);
+
+    c_Image image(width, height, pixFmt);
+    const unsigned numValues = width * NumChannels[static_cast<std::size_t>(pixFmt)];
+    for (unsigned y = 0; y < height; ++y)
+    {
+        for (unsigned i = 0; i < numValues; ++i)
+        {
+            const unsigned value = (i * 3 + y * 5 + seed * 7) % 200 + noise(generator);
+            switch (pixFmt)
+            {
+            case PixelFormat::PIX_MONO8:
+            case PixelFormat::PIX_RGB8:
+                image.GetRowAs<std::uint8_t>(y)[i] = static_cast<std::uint8_t>(value);
+                break;
+
+            case PixelFormat::PIX_MONO16:
+            case PixelFormat::PIX_RGB16:
+                image.GetRowAs<std::uint16_t>(y)[i] = static_cast<std::uint16_t>(value * 281);
+                break;
+
+            case PixelFormat::PIX_MONO32F:
+            case PixelFormat::PIX_RGB32F:
+                image.GetRowAs<float>(y)[i] = value / 215.0f - 0.1f;
+                break;
+
+            default: BOOST_FAIL("unexpected pixel format");
+            }
+        }
+    }
+
+    return image;
+}
+
+bool AreEqual(const c_Image& img1, const c_Image& img2)
+{
+    if (img1.GetWidth() != img2.GetWidth() || img1.GetHeight() != img2.GetHeight() || img1.GetPixelFormat() != img2.GetPixelFormat())
+    {
+        return false;
+    }
+
+    const std::size_t rowSize = img1.GetWidth() * img1.GetBuffer().GetBytesPerPixel();
+    for (unsigned y = 0; y < img1.GetHeight(); ++y)
+    {
+        if (0 != std::memcmp(img1.GetRow(y), img2.GetRow(y), rowSize)) { return false; }
+    }
+
+    return true;
+}
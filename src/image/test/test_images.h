@@ -0,0 +1,33 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Test image utilities header (shared by the tests of several libraries).
+*/
+
+#pragma once
+
+#include "image/image.h"
+
+/// Returns an image with smooth gradients and noise (so that predictors, compressors etc. have something to do).
+/** Pixel format can be one of PIX_MONO8/16/32F, PIX_RGB8/16/32F; images created with different seeds differ. */
+c_Image CreateTestImage(unsigned width, unsigned height, PixelFormat pixFmt, unsigned seed = 0);
+
+/// Returns 'true' if the images have the same size, pixel format and pixel values.
+bool AreEqual(const c_Image& img1, const c_Image& img2);
@@ -0,0 +1,128 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    TIFF reader and writer unit tests.
+*/
+
+#include "test_images.h"
+#include "tiff.h"
+
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <string>
+
+namespace
+{
+
+const std::filesystem::path& GetTestDir()
+{
+    static const std::filesystem::path dir = [] {
+        const auto path = std::filesystem::temp_directory_path() / "imppg_tests" / "tiff";
+        std::filesystem::create_directories(path);
+        return path;
+    }();
+    return dir;
+}
+
+void CheckRoundTrip(PixelFormat pixFmt, TiffCompression compression, const TiffWriteOptions& options)
+{
+    BOOST_TEST_CONTEXT("pixel format " << static_cast<int>(pixFmt) << ", compression " << static_cast<int>(compression)
+        << ", rows per strip " << options.rowsPerStrip << ", predictor " << options.usePredictor)
+    {
+        const c_Image image = CreateTestImage(67, 45, pixFmt);
+        const auto path = GetTestDir() / ("image" + std::to_string(static_cast<int>(pixFmt)) + ".tif");
+
+        c_RowReader rows(image.GetBuffer(), pixFmt);
+        BOOST_REQUIRE(SaveTiff(path, rows, compression, options));
+
+        std::string errorMsg;
+        const auto loaded = ReadTiff(path, &errorMsg);
+        BOOST_REQUIRE_MESSAGE(loaded.has_value(), errorMsg);
+        BOOST_CHECK(AreEqual(image, *loaded));
+    }
+}
+
+const PixelFormat TESTED_FORMATS[] = {
+    PixelFormat::PIX_MONO8,
+    PixelFormat::PIX_MONO16,
+    PixelFormat::PIX_MONO32F,
+    PixelFormat::PIX_RGB8,
+    PixelFormat::PIX_RGB16,
+    PixelFormat::PIX_RGB32F
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(UncompressedRoundTrip)
+{
+    for (const auto pixFmt: TESTED_FORMATS)
+    {
+        CheckRoundTrip(pixFmt, TiffCompression::None, TiffWriteOptions{});
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LzwRoundTrip)
+{
+    for (const auto pixFmt: TESTED_FORMATS)
+    {
+        for (const bool usePredictor: { false, true })
+        {
+            CheckRoundTrip(pixFmt, TiffCompression::LZW, TiffWriteOptions{64, usePredictor});
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DeflateRoundTrip)
+{
+    for (const auto pixFmt: TESTED_FORMATS)
+    {
+        for (const bool usePredictor: { false, true })
+        {
+            CheckRoundTrip(pixFmt, TiffCompression::Deflate, TiffWriteOptions{64, usePredictor});
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MultiStripRoundTrip)
+{
+    // 45 rows in strips of 7 rows (the last one is shorter), and a single strip
+    for (const unsigned rowsPerStrip: { 7U, 0U })
+    {
+        for (const auto compression: { TiffCompression::None, TiffCompression::LZW, TiffCompression::Deflate })
+        {
+            CheckRoundTrip(PixelFormat::PIX_MONO16, compression, TiffWriteOptions{rowsPerStrip, true});
+            CheckRoundTrip(PixelFormat::PIX_RGB32F, compression, TiffWriteOptions{rowsPerStrip, true});
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MappedReadConvertsTo32f)
+{
+    const c_Image image = CreateTestImage(67, 45, PixelFormat::PIX_RGB16);
+    const auto path = GetTestDir() / "mapped.tif";
+
+    c_RowReader rows(image.GetBuffer(), PixelFormat::PIX_RGB16);
+    BOOST_REQUIRE(SaveTiff(path, rows, TiffCompression::LZW, TiffWriteOptions{7, true}));
+
+    const auto loaded = ReadTiffMappedAs32f(path);
+    BOOST_REQUIRE(loaded.has_value());
+    BOOST_REQUIRE(loaded->GetPixelFormat() == PixelFormat::PIX_RGB32F);
+    BOOST_REQUIRE(AreEqual(image.ConvertPixelFormat(PixelFormat::PIX_RGB32F), *loaded));
+}
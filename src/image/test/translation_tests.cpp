@@ -0,0 +1,169 @@
+/*
+ImPPG (Image Post-Processor) - common operations for astronomical stacks and other images
+Copyright (C) 2025 Filip Szczerek <ga.software@yahoo.com>
+
+This file is part of ImPPG.
+
+ImPPG is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+ImPPG is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with ImPPG.  If not, see <http://www.gnu.org/licenses/>.
+
+File description:
+    Image sub-pixel translation unit tests.
+*/
+
+#include "image/image.h"
+#include "test_images.h"
+
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <cstdint>
+
+namespace
+{
+
+double GetValue(const c_Image& image, int x, int y, int ch)
+{
+    const int idx = x * static_cast<int>(NumChannels[static_cast<std::size_t>(image.GetPixelFormat())]) + ch;
+    switch (image.GetPixelFormat())
+    {
+    case PixelFormat::PIX_MONO8:
+    case PixelFormat::PIX_RGB8: return image.GetRowAs<std::uint8_t>(y)[idx];
+
+    case PixelFormat::PIX_MONO16:
+    case PixelFormat::PIX_RGB16: return image.GetRowAs<std::uint16_t>(y)[idx];
+
+    case PixelFormat::PIX_MONO32F:
+    case PixelFormat::PIX_RGB32F: return image.GetRowAs<float>(y)[idx];
+
+    default: BOOST_FAIL("unexpected pixel format"); return 0.0;
+    }
+}
+
+double GetMaxValue(PixelFormat pixFmt)
+{
+    switch (pixFmt)
+    {
+    case PixelFormat::PIX_MONO8:
+    case PixelFormat::PIX_RGB8: return 0xFF;
+
+    case PixelFormat::PIX_MONO16:
+    case PixelFormat::PIX_RGB16: return 0xFFFF;
+
+    default: return 1.0;
+    }
+}
+
+/// Returns the Catmull-Rom cubic interpolation of f(-1), f(0), f(1), f(2) at 0 <= t < 1.
+double InterpolateCubic(double t, double fm1, double f0, double f1, double f2)
+{
+    return f0 + 0.5 * t * (f1 - fm1 + t * (2.0 * fm1 - 5.0 * f0 + 4.0 * f1 - f2 + t * (3.0 * (f0 - f1) + f2 - fm1)));
+}
+
+/// Returns the expected value of the output of `c_Image::ResizeAndTranslate` (with `clearToZero`) of the whole `src`
+/// at (x, y), calculated directly for the single pixel.
+double GetReferenceValue(const c_Image& src, float xOfs, float yOfs, const c_Image& dest, int x, int y, int ch)
+{
+    // integer parts are truncated towards zero
+    const int xOfsInt = static_cast<int>(xOfs);
+    const int yOfsInt = static_cast<int>(yOfs);
+
+    const int destXstart = std::max(0, xOfsInt);
+    const int destYstart = std::max(0, yOfsInt);
+    const int destXend = std::min(xOfsInt + static_cast<int>(src.GetWidth()) - 1, static_cast<int>(dest.GetWidth()) - 1);
+    const int destYend = std::min(yOfsInt + static_cast<int>(src.GetHeight()) - 1, static_cast<int>(dest.GetHeight()) - 1);
+
+    if (x < destXstart || x > destXend || y < destYstart || y > destYend)
+    {
+        return 0.0;
+    }
+    else if (x < destXstart + 2 || x > destXend - 2 || y < destYstart + 2 || y > destYend - 2)
+    {
+        // 2-pixel border of the target area is copied without interpolation
+        return GetValue(src, x - xOfsInt, y - yOfsInt, ch);
+    }
+
+    // source position corresponding to (x, y)
+    const double srcX = x - static_cast<double>(xOfs);
+    const double srcY = y - static_cast<double>(yOfs);
+    const int x0 = static_cast<int>(std::floor(srcX));
+    const int y0 = static_cast<int>(std::floor(srcY));
+
+    double rowValues[4];
+    for (int j = -1; j <= 2; ++j)
+    {
+        rowValues[j + 1] = InterpolateCubic(srcX - x0,
+            GetValue(src, x0 - 1, y0 + j, ch), GetValue(src, x0, y0 + j, ch),
+            GetValue(src, x0 + 1, y0 + j, ch), GetValue(src, x0 + 2, y0 + j, ch));
+    }
+    const double value = InterpolateCubic(srcY - y0, rowValues[0], rowValues[1], rowValues[2], rowValues[3]);
+
+    const PixelFormat pixFmt = src.GetPixelFormat();
+    const double clamped = std::clamp(value, 0.0, GetMaxValue(pixFmt));
+    // integer values are truncated
+    return (pixFmt == PixelFormat::PIX_MONO32F || pixFmt == PixelFormat::PIX_RGB32F) ? clamped : std::trunc(clamped);
+}
+
+void CheckTranslation(PixelFormat pixFmt, unsigned width, unsigned height, float xOfs, float yOfs)
+{
+    BOOST_TEST_CONTEXT("pixel format " << static_cast<int>(pixFmt) << ", " << width << "x" << height
+        << ", offset (" << xOfs << ", " << yOfs << ")")
+    {
+        const c_Image src = CreateTestImage(width, height, pixFmt);
+        c_Image dest(width - 2, height + 3, pixFmt);
+        c_Image::ResizeAndTranslate(src.GetBuffer(), dest.GetBuffer(), 0, 0, width - 1, height - 1, xOfs, yOfs, true);
+
+        // integer values are truncated after interpolation (in single precision), so may differ by 1
+        const double tolerance = (pixFmt == PixelFormat::PIX_MONO32F || pixFmt == PixelFormat::PIX_RGB32F) ? 1.0e-5 : 1.0;
+
+        const int numChannels = static_cast<int>(NumChannels[static_cast<std::size_t>(pixFmt)]);
+        unsigned numMismatches = 0;
+        for (int y = 0; y < static_cast<int>(dest.GetHeight()); ++y)
+        {
+            for (int x = 0; x < static_cast<int>(dest.GetWidth()); ++x)
+            {
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    const double expected = GetReferenceValue(src, xOfs, yOfs, dest, x, y, ch);
+                    const double actual = GetValue(dest, x, y, ch);
+                    if (std::abs(actual - expected) > tolerance)
+                    {
+                        if (numMismatches++ == 0)
+                        {
+                            BOOST_ERROR("at (" << x << ", " << y << "), channel " << ch << ": expected " << expected
+                                << ", got " << actual);
+                        }
+                    }
+                }
+            }
+        }
+        BOOST_CHECK_EQUAL(0, numMismatches);
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(SubpixelTranslationMatchesPerPixelBicubicInterpolation)
+{
+    // heights are not multiples of the number of rows interpolated together
+    const PixelFormat formats[] = { PixelFormat::PIX_MONO32F, PixelFormat::PIX_RGB32F, PixelFormat::PIX_RGB16, PixelFormat::PIX_MONO8 };
+    const float offsets[][2] = { {2.3f, 1.6f}, {-3.7f, -1.2f}, {0.25f, -0.75f}, {-0.4f, 4.0f}, {5.0f, 0.5f} };
+    for (const PixelFormat pixFmt: formats)
+    {
+        for (const auto& offset: offsets)
+        {
+            CheckTranslation(pixFmt, 61, 77, offset[0], offset[1]);
+        }
+    }
+    CheckTranslation(PixelFormat::PIX_RGB32F, 40, 101, -1.35f, 2.85f);
+}
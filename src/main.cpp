@@ -21,6 +21,44 @@ File description:
     wxWidgets application definition.
 */
 
+#include "headless.h"
 #include "wxapp.h"
 
-IMPLEMENT_APP(c_MyApp)
+#ifdef __WXMSW__
+#include <cstdio>
+#include <wx/msw/wrapwin.h>
+#endif
+
+wxIMPLEMENT_APP_NO_MAIN(c_MyApp);
+
+#ifdef __WXMSW__
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
+{
+    if (IsHeadlessCommandLine(__argc, __argv))
+    {
+        // ImPPG is a GUI subsystem executable; write the output to the console of the invoking process (if any).
+        if (AttachConsole(ATTACH_PARENT_PROCESS))
+        {
+            std::freopen("CONOUT$", "w", stdout);
+            std::freopen("CONOUT$", "w", stderr);
+        }
+        return RunHeadless(__argc, __argv);
+    }
+
+    return wxEntry(hInstance, hPrevInstance, lpCmdLine, nCmdShow);
+}
+
+#else
+
+int main(int argc, char* argv[])
+{
+    if (IsHeadlessCommandLine(argc, argv))
+    {
+        return RunHeadless(argc, argv);
+    }
+
+    return wxEntry(argc, argv);
+}
+
+#endif
@@ -952,9 +952,10 @@ void c_MainWindow::OpenFile(wxFileName path, bool resetSelection)
 
     std::string errorMsg;
 
-    const auto loadResult = LoadImageFileAs32f(
+    auto loadResult = LoadImageFileAs32f(
         ToFsPath(path.GetFullPath()),
         Configuration::NormalizeFITSValues,
+        m_CurrentSettings.processing.normalization.GetLevels(),
         &errorMsg
     );
 
@@ -965,7 +966,7 @@ void c_MainWindow::OpenFile(wxFileName path, bool resetSelection)
     }
     else
     {
-        c_Image newImg = loadResult.value();
+        c_Image newImg = std::move(loadResult.value());
 
         auto& s = m_CurrentSettings;
 
@@ -977,9 +978,6 @@ void c_MainWindow::OpenFile(wxFileName path, bool resetSelection)
 
         UpdateWindowTitle();
 
-        if (s.processing.normalization.enabled)
-            NormalizeFpImage(newImg, s.processing.normalization.min, s.processing.normalization.max);
-
         std::optional<wxRect> newSelection;
         if (resetSelection)
         {
@@ -23,7 +23,12 @@ File description:
 
 #pragma once
 
+#include "image/buffer_pool.h"
+
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <vector>
 
 enum class ConvolutionMethod
 {
@@ -38,6 +43,13 @@ enum class ConvolutionMethod
     Core i5-3570K with DDR3 PC-10700 RAM, compiled with MS C++ 18.00, for 1-4 threads - Filip). */
 constexpr int YOUNG_VAN_VLIET_MIN_KERNEL_RADIUS = 8;
 
+/// Called periodically by long-running operations (only from the thread which started the operation);
+/// returns `true` if the operation is to be aborted.
+using AbortCheck = std::function<bool ()>;
+
+/// Number of rows processed between consecutive calls to `AbortCheck` (by functions which accept one).
+constexpr int ABORT_CHECK_TILE_ROWS = 64;
+
 /// Wrapper for an array which may contain row padding. Stores only the pointer and dimensions; can be copied, deleted without influencing the allocated memory.
 template<typename T>
 class c_PaddedArrayPtr
@@ -67,32 +79,86 @@ public:
     int GetBytesPerRow() const { return m_BytesPerRow; }
 };
 
-/// Calculates convolution of 'input' with a Gaussian kernel
-void ConvolveSeparable(
+/// Calculates convolution of 'input' with a Gaussian kernel; returns `false` if aborted (contents of 'output' are then undefined).
+bool ConvolveSeparable(
     c_PaddedArrayPtr<const float> input, ///< Input array.
     c_PaddedArrayPtr<float> output,      ///< Output array having as much rows and columns as 'input' does.
-    float sigma                          ///< Gaussian sigma.
+    float sigma,                         ///< Gaussian sigma.
+    const AbortCheck& checkAbort = {}    ///< If set, called every ABORT_CHECK_TILE_ROWS rows.
 );
 
-/// Calculates convolution of 'input' with a rotationally symmetric and separable (i.e. Gaussian) 'kernel' and writes it in transposed form to 'output'
-void ConvolveSeparableTranspose(
+/// Calculates convolution of 'input' with a rotationally symmetric and separable (i.e. Gaussian) 'kernel' and writes it in transposed form to 'output'.
+/// Returns `false` if aborted.
+bool ConvolveSeparableTranspose(
     c_PaddedArrayPtr<const float> input,  ///< Input array
     c_PaddedArrayPtr<float> output, ///< Transposed output array; contains as many rows as 'input' does columns and as many columns as 'input' does rows
     const float kernel[], ///< Contains convolution kernel's projection (horizontal/vertical); element [kernelRadius] is the middle
     int kernelRadius, ///< 'kernel' contains 2*kernelRadius-1 elements
     float tempBuf1[], ///< Temporary buffer 1, as many elements as 'input'
-    float tempBuf2[] ///< Temporary buffer 2, as many elements as 'input'
+    float tempBuf2[], ///< Temporary buffer 2, as many elements as 'input'
+    const AbortCheck& checkAbort = {} ///< If set, called every ABORT_CHECK_TILE_ROWS rows
 );
 
-/// Calculates convolution of 'input' with an approximated Gaussian kernel (Young & van Vliet recursive method) and writes it in transposed form to 'output'
-void ConvolveGaussianRecursiveTranspose(
+/// Calculates convolution of 'input' with an approximated Gaussian kernel (Young & van Vliet recursive method) and writes it in transposed form to 'output'.
+/// Returns `false` if aborted.
+bool ConvolveGaussianRecursiveTranspose(
     c_PaddedArrayPtr<const float> input,  ///< Input array
     c_PaddedArrayPtr<float> output,       ///< Transposed output array; contains as many rows as 'input' does columns and as many columns as 'input' does rows
     float sigma,                          ///< Gaussian sigma
     float tempBuf1[],                     ///< width*height elements
-    float tempBuf2[]                      ///< width*height elements
+    float tempBuf2[],                     ///< width*height elements
+    const AbortCheck& checkAbort = {}     ///< If set, called every ABORT_CHECK_TILE_ROWS rows
 );
 
+/// Coefficients of the Young & van Vliet recursive Gaussian filter.
+struct YvVCoefficients
+{
+    float b0inv, b1, b2, b3, B;
+};
+
+YvVCoefficients CalculateYvVCoefficients(float sigma);
+
+/// Gaussian convolution compiled for a given sigma.
+/** Holds the kernel projection (or the Young & van Vliet coefficients) and the temporary buffers,
+    which are reused by subsequent convolutions. Not thread-safe: an instance must not be used
+    by concurrently running operations. */
+class c_GaussianConvolution
+{
+public:
+    explicit c_GaussianConvolution(float sigma, ConvolutionMethod method = ConvolutionMethod::AUTO);
+
+    float GetSigma() const { return m_Sigma; }
+
+    /// Allocates the temporary buffers for convolving arrays of up to the specified number of elements.
+    void Reserve(std::size_t numElements);
+
+    /// Calculates convolution of 'input' and writes it in transposed form to 'output'; returns `false` if aborted.
+    bool ConvolveTranspose(
+        c_PaddedArrayPtr<const float> input, ///< Input array.
+        c_PaddedArrayPtr<float> output,      ///< Transposed output array.
+        const AbortCheck& checkAbort = {}    ///< If set, called every ABORT_CHECK_TILE_ROWS rows.
+    );
+
+    /// Calculates convolution of 'input' and writes it to 'output'; returns `false` if aborted.
+    bool Convolve(
+        c_PaddedArrayPtr<const float> input, ///< Input array.
+        c_PaddedArrayPtr<float> output,      ///< Output array having as much rows and columns as 'input' does.
+        const AbortCheck& checkAbort = {}    ///< If set, called every ABORT_CHECK_TILE_ROWS rows.
+    );
+
+private:
+    float m_Sigma;
+    int m_KernelRadius;
+    bool m_Recursive; ///< If 'true', Young & van Vliet recursive convolution is used.
+    std::vector<float> m_Kernel; ///< Kernel projection (if not `m_Recursive`).
+    YvVCoefficients m_YvV{}; ///< Valid if `m_Recursive`.
+
+    // Taken from the buffer pool, so that short-lived instances (e.g. created by `ConvolveSeparable`) do not pay for fresh allocations.
+    c_AlignedArray<float> m_TempBuf1;
+    c_AlignedArray<float> m_TempBuf2;
+    c_AlignedArray<float> m_OutputT;
+};
+
 /// Matrices are transposed in square blocks of this length to a side
 constexpr int TRANSPOSITION_BLOCK_SIZE = 16;
 
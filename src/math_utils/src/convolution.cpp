@@ -25,9 +25,65 @@ File description:
 #include "math_utils/convolution.h"
 #include "math_utils/gauss.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstring>
-#include <memory>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+/// Returns 'true' in the thread which started the current parallel region (or if there is none).
+inline bool IsMasterThread()
+{
+#if defined(_OPENMP)
+    return omp_get_thread_num() == 0;
+#else
+    return true;
+#endif
+}
+
+/// Calls `rowFunc(y)` for each `y` in [0, numRows) in parallel, in tiles of ABORT_CHECK_TILE_ROWS rows;
+/// `checkAbort` (if set) is called beforehand and before each tile processed by the calling thread. Returns `false` if aborted.
+template<typename RowFunc>
+bool ProcessRowsInTiles(int numRows, const AbortCheck& checkAbort, RowFunc rowFunc)
+{
+    if (!checkAbort)
+    {
+        #pragma omp parallel for
+        for (int y = 0; y < numRows; y++)
+            rowFunc(y);
+
+        return true;
+    }
+
+    // The other threads may process all the tiles before the calling thread gets any, so check once beforehand
+    if (checkAbort())
+        return false;
+
+    // Set once the abort check fires; the remaining tiles are skipped
+    std::atomic<bool> aborted{false};
+
+    const int numTiles = (numRows + ABORT_CHECK_TILE_ROWS - 1) / ABORT_CHECK_TILE_ROWS;
+    #pragma omp parallel for schedule(dynamic)
+    for (int tile = 0; tile < numTiles; tile++)
+    {
+        // `checkAbort` may only be called from the calling thread (e.g., it may call `wxThread::TestDestroy`),
+        // i.e., the master thread of the parallel region; the other threads only read its result
+        if (IsMasterThread() && !aborted && checkAbort())
+            aborted = true;
+
+        if (aborted)
+            continue;
+
+        const int tileEnd = std::min((tile + 1) * ABORT_CHECK_TILE_ROWS, numRows);
+        for (int y = tile * ABORT_CHECK_TILE_ROWS; y < tileEnd; y++)
+            rowFunc(y);
+    }
+
+    return !aborted;
+}
 
 /// Performs a single step of 1D convolution using the middle kernel value 'kernelVal'
 inline void Convolve1Dstep_OfsZero(const float input[], float output[], int len, float kernelVal)
@@ -94,7 +150,7 @@ inline void YvVFilterValues(
     }
 }
 
-inline void CalculateYvVCoefficients(float sigma, float& b0inv, float& b1, float& b2, float& b3, float& B)
+YvVCoefficients CalculateYvVCoefficients(float sigma)
 {
     float q;
     if (sigma >= 0.5f && sigma <= 2.5f)
@@ -102,62 +158,75 @@ inline void CalculateYvVCoefficients(float sigma, float& b0inv, float& b1, float
     else
         q = 0.98711f * sigma - 0.9633f;
 
+    YvVCoefficients c;
     float b0 = 1.57825f + 2.44413f * q + 1.4281f*q*q + 0.422205f*q*q*q;
-    b1 = 2.44413f*q + 2.85619f*q*q + 1.26661f*q*q*q;
-    b2 = -1.4281f*q*q - 1.26661f*q*q*q;
-    b3 = 0.422205f*q*q*q;
-    B = 1.0f - ((b1 + b2 + b3) / b0);
-    b0inv = 1.0f/b0;
+    c.b1 = 2.44413f*q + 2.85619f*q*q + 1.26661f*q*q*q;
+    c.b2 = -1.4281f*q*q - 1.26661f*q*q*q;
+    c.b3 = 0.422205f*q*q*q;
+    c.B = 1.0f - ((c.b1 + c.b2 + c.b3) / b0);
+    c.b0inv = 1.0f/b0;
+
+    return c;
 }
 
-void ConvolveGaussianRecursiveTranspose(
+/// Calculates convolution using precalculated Young & van Vliet coefficients; see `ConvolveGaussianRecursiveTranspose`.
+static bool ConvolveGaussianRecursiveTranspose(
     c_PaddedArrayPtr<const float> input,
     c_PaddedArrayPtr<float> output,
-    float sigma,
+    const YvVCoefficients& c,
     float tempBuf1[],
-    float tempBuf2[]
+    float tempBuf2[],
+    const AbortCheck& checkAbort
 )
 {
     int width = input.width(), height = input.height();
-    IMPPG_ASSERT(sigma >= 0.5f);
-
-    float b0inv, b1, b2, b3, B;
-    CalculateYvVCoefficients(sigma, b0inv, b1, b2, b3, B);
 
     float* convRows = tempBuf1;
 
     // Convolve rows
-    #pragma omp parallel for
-    for (int y = 0; y < height; y++)
-    {
+    const bool rowsDone = ProcessRowsInTiles(height, checkAbort, [&](int y) {
         // Perform forward filtering
-        YvVFilterValues(input.row_const(y), &convRows[y*width], width, 1, b0inv, b1, b2, b3, B);
+        YvVFilterValues(input.row_const(y), &convRows[y*width], width, 1, c.b0inv, c.b1, c.b2, c.b3, c.B);
 
         // Perform backward filtering
-        YvVFilterValues(&convRows[y*width], &convRows[y*width], width, -1, b0inv, b1, b2, b3, B);
-    }
+        YvVFilterValues(&convRows[y*width], &convRows[y*width], width, -1, c.b0inv, c.b1, c.b2, c.b3, c.B);
+    });
+    if (!rowsDone)
+        return false;
 
     float* convRowsT = tempBuf2;
     Transpose<float>(convRows, convRowsT, width, height, width*sizeof(float), height*sizeof(float), TRANSPOSITION_BLOCK_SIZE);
 
     // Convolve columns (now: rows, since we are using 'convRowsT' as source)
-    #pragma omp parallel for
-    for (int y = 0; y < width; y++)
-    {
+    return ProcessRowsInTiles(width, checkAbort, [&](int y) {
         // Perform forward filtering
-        YvVFilterValues(&convRowsT[y*height], output.row(y), height, 1, b0inv, b1, b2, b3, B);
+        YvVFilterValues(&convRowsT[y*height], output.row(y), height, 1, c.b0inv, c.b1, c.b2, c.b3, c.B);
         // Perform backward filtering
-        YvVFilterValues(output.row(y), output.row(y), height, -1, b0inv, b1, b2, b3, B);
-    }
+        YvVFilterValues(output.row(y), output.row(y), height, -1, c.b0inv, c.b1, c.b2, c.b3, c.B);
+    });
 }
 
-void ConvolveSeparableTranspose(
+bool ConvolveGaussianRecursiveTranspose(
+    c_PaddedArrayPtr<const float> input,
+    c_PaddedArrayPtr<float> output,
+    float sigma,
+    float tempBuf1[],
+    float tempBuf2[],
+    const AbortCheck& checkAbort
+)
+{
+    IMPPG_ASSERT(sigma >= 0.5f);
+    return ConvolveGaussianRecursiveTranspose(input, output, CalculateYvVCoefficients(sigma), tempBuf1, tempBuf2, checkAbort);
+}
+
+bool ConvolveSeparableTranspose(
     c_PaddedArrayPtr<const float> input,
     c_PaddedArrayPtr<float> output,
     const float kernel[],
     int kernelRadius,
     float tempBuf1[],
-    float tempBuf2[]
+    float tempBuf2[],
+    const AbortCheck& checkAbort
 )
 {
     // NOTE: The function uses only half of 'kernel' (it is symmetrical), but passing the whole array may simplify vectorization in the future.
@@ -175,9 +244,7 @@ void ConvolveSeparableTranspose(
     if (width > 2*(kernelRadius-1))
     {
         // Convolve each row
-        #pragma omp parallel for
-        for (int y = 0; y < height; y++)
-        {
+        const bool rowsDone = ProcessRowsInTiles(height, checkAbort, [&](int y) {
             Convolve1Dstep_OfsZero(input.row_const(y) + kernelRadius - 1,
                     convRows + kernelRadius - 1 + y*width,
                     width - 2 * (kernelRadius - 1),
@@ -190,7 +257,9 @@ void ConvolveSeparableTranspose(
                     width - 2 * (kernelRadius - 1),
                     kernel[i + kernelRadius - 1], i);
             }
-        }
+        });
+        if (!rowsDone)
+            return false;
     }
 
     // For near-border elements assume the border values are replicated outside of array
@@ -265,9 +334,7 @@ void ConvolveSeparableTranspose(
     if (height > 2*(kernelRadius-1))
     {
         // Convolve each column (now: row)
-        #pragma omp parallel for
-        for (int y = 0; y < width; y++)
-        {
+        const bool columnsDone = ProcessRowsInTiles(width, checkAbort, [&](int y) {
             Convolve1Dstep_OfsZero(convRowsT + kernelRadius - 1 + y*height,
                 output.row(y) + kernelRadius - 1,
                 height - 2 * (kernelRadius - 1),
@@ -280,43 +347,88 @@ void ConvolveSeparableTranspose(
                     height - 2 * (kernelRadius - 1),
                     kernel[i + kernelRadius - 1], i);
             }
-        }
+        });
+        if (!columnsDone)
+            return false;
     }
 
     // The caller expects a transposed output, so we can leave it as is.
+    return true;
 }
 
 
-void ConvolveSeparable(
+c_GaussianConvolution::c_GaussianConvolution(float sigma, ConvolutionMethod method)
+: m_Sigma(sigma),
+  m_KernelRadius(static_cast<int>(ceil(sigma * 3.0f)))
+{
+    m_Recursive = (method == ConvolutionMethod::YOUNG_VAN_VLIET ||
+        (method == ConvolutionMethod::AUTO && m_KernelRadius >= YOUNG_VAN_VLIET_MIN_KERNEL_RADIUS));
+
+    if (m_Recursive)
+    {
+        IMPPG_ASSERT(sigma >= 0.5f);
+        m_YvV = CalculateYvVCoefficients(sigma);
+    }
+    else
+    {
+        m_Kernel.resize(2 * m_KernelRadius - 1);
+        CalculateGaussianKernelProjection(m_Kernel.data(), m_KernelRadius, sigma, true);
+    }
+}
+
+void c_GaussianConvolution::Reserve(std::size_t numElements)
+{
+    m_TempBuf1.Reserve(numElements);
+    m_TempBuf2.Reserve(numElements);
+}
+
+bool c_GaussianConvolution::ConvolveTranspose(
     c_PaddedArrayPtr<const float> input,
     c_PaddedArrayPtr<float> output,
-    float sigma
+    const AbortCheck& checkAbort
 )
 {
-    int width = input.width(), height = input.height();
-    int kernelRadius = static_cast<int>(ceil(sigma * 3.0f));
-
-    std::unique_ptr<float[]> outputT(new float[input.height() * input.width()]); // transposed output
-    std::unique_ptr<float[]> temp1(new float[input.width() * input.height()]);
-    std::unique_ptr<float[]> temp2(new float[input.width() * input.height()]);
+    Reserve(static_cast<std::size_t>(input.width()) * input.height());
 
-    if (kernelRadius < YOUNG_VAN_VLIET_MIN_KERNEL_RADIUS)
+    if (m_Recursive)
     {
-        std::unique_ptr<float[]> kernel(new float[2 * kernelRadius - 1]);
-        CalculateGaussianKernelProjection(kernel.get(), kernelRadius, sigma, true);
-
-        ConvolveSeparableTranspose(
-                input,
-                c_PaddedArrayPtr<float>(outputT.get(), height, width),
-                kernel.get(), kernelRadius, temp1.get(), temp2.get());
+        return ConvolveGaussianRecursiveTranspose(input, output, m_YvV, m_TempBuf1.get(), m_TempBuf2.get(), checkAbort);
     }
     else
     {
-        ConvolveGaussianRecursiveTranspose(
-                input,
-                c_PaddedArrayPtr<float>(outputT.get(), height, width),
-                sigma, temp1.get(), temp2.get());
+        return ConvolveSeparableTranspose(
+            input, output, m_Kernel.data(), m_KernelRadius, m_TempBuf1.get(), m_TempBuf2.get(), checkAbort
+        );
     }
+}
+
+bool c_GaussianConvolution::Convolve(
+    c_PaddedArrayPtr<const float> input,
+    c_PaddedArrayPtr<float> output,
+    const AbortCheck& checkAbort
+)
+{
+    const int width = input.width(), height = input.height();
+
+    const std::size_t numElements = static_cast<std::size_t>(width) * height;
+    m_OutputT.Reserve(numElements);
 
-    Transpose(outputT.get(), output.row(0), height, width, height*sizeof(float), output.GetBytesPerRow(), TRANSPOSITION_BLOCK_SIZE);
+    if (!ConvolveTranspose(input, c_PaddedArrayPtr<float>(m_OutputT.get(), height, width), checkAbort))
+    {
+        return false;
+    }
+
+    Transpose(m_OutputT.get(), output.row(0), height, width, height*sizeof(float), output.GetBytesPerRow(), TRANSPOSITION_BLOCK_SIZE);
+
+    return true;
+}
+
+bool ConvolveSeparable(
+    c_PaddedArrayPtr<const float> input,
+    c_PaddedArrayPtr<float> output,
+    float sigma,
+    const AbortCheck& checkAbort
+)
+{
+    return c_GaussianConvolution(sigma).Convolve(input, output, checkAbort);
 }
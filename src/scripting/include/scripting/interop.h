@@ -83,6 +83,9 @@ struct AlignImages
     bool subpixelAlignment;
     std::filesystem::path outputDir;
     std::optional<std::string> outputFNameSuffix;
+    RoiMode roiMode;
+    Rectangle_t roi; ///< Used if `roiMode` is `RoiMode::USER`
+    bool coarseToFine; ///< See `AlignmentParameters_t::coarseToFine`
     std::function<void(double)> progressCallback;
 };
 
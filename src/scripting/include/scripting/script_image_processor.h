@@ -69,7 +69,12 @@ private:
         CompletionFunc onCompletion
     );
 
+    /// Returns `m_Plan` updated to `settings` (created on first use).
+    std::shared_ptr<imppg::backend::ProcessingPlan> GetPlan(const ProcessingSettings& settings, const c_Image& image);
+
     std::unique_ptr<imppg::backend::IProcessingBackEnd> m_Processor;
+    /// Reused by subsequent processing requests, so that the setup is not repeated if settings do not change.
+    std::shared_ptr<imppg::backend::ProcessingPlan> m_Plan;
     bool m_NormalizeFitsValues{false};
     std::unique_ptr<c_ImageAlignmentWorkerThread> m_AlignmentWorker;
     std::unique_ptr<wxEvtHandler> m_AlignmentEvtHandler;
@@ -76,6 +76,21 @@ std::vector<wxString> GetStringTable(lua_State* lua, int stackPos)
     return result;
 }
 
+std::vector<int> GetIntegerTable(lua_State* lua, int stackPos)
+{
+    luaL_checktype(lua, stackPos, LUA_TTABLE);
+    const std::size_t len = lua_rawlen(lua, stackPos);
+    std::vector<int> result;
+    result.reserve(len);
+    for (std::size_t i = 1; i <= len; ++i)
+    {
+        lua_rawgeti(lua, stackPos, i);
+        result.push_back(GetInteger(lua, lua_gettop(lua)));
+        lua_pop(lua, 1);
+    }
+    return result;
+}
+
 void CheckNumArgs(lua_State* lua, const char* functionName, int expectedNum)
 {
     const int numArgs = lua_gettop(lua);
@@ -87,6 +102,17 @@ void CheckNumArgs(lua_State* lua, const char* functionName, int expectedNum)
     }
 }
 
+void CheckNumArgs(lua_State* lua, const char* functionName, int minNum, int maxNum)
+{
+    const int numArgs = lua_gettop(lua);
+    if (numArgs < minNum || numArgs > maxNum)
+    {
+        throw ScriptExecutionError{
+            wxString::Format(_("expected %d to %d arguments to %s"), minNum, maxNum, functionName).ToStdString()
+        };
+    }
+}
+
 void CheckType(lua_State* lua, int stackPos, int type, bool allowNil)
 {
     if (allowNil && lua_isnil(lua, stackPos))
@@ -76,8 +76,13 @@ bool GetBoolean(lua_State* lua, int stackPos);
 
 std::vector<wxString> GetStringTable(lua_State* lua, int stackPos);
 
+std::vector<int> GetIntegerTable(lua_State* lua, int stackPos);
+
 void CheckNumArgs(lua_State* lua, const char* functionName, int expectedNum);
 
+/// Checks if the number of arguments is between `minNum` and `maxNum` (inclusive).
+void CheckNumArgs(lua_State* lua, const char* functionName, int minNum, int maxNum);
+
 void CheckType(lua_State* lua, int stackPos, int type, bool allowNil = false);
 
 }
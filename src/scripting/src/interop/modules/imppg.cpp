@@ -192,7 +192,7 @@ const luaL_Reg functions[] = {
     {"align_images", [](lua_State* lua) -> int {
         if (scripting::g_State->CheckStopRequested(lua)) { return 0; }
 
-        CheckNumArgs(lua, "align_images", 7);
+        CheckNumArgs(lua, "align_images", 7, 9);
         std::vector<fs::path> inputFiles;
         for (const auto& s: GetStringTable(lua, 1))
         {
@@ -234,6 +234,43 @@ const luaL_Reg functions[] = {
             });
         }
 
+        // optional region of interest: `imppg.AUTO_ROI` or a table {x, y, width, height}
+        RoiMode roiMode = RoiMode::WHOLE_IMAGE;
+        Rectangle_t roi;
+        if (lua_gettop(lua) >= 8 && !lua_isnil(lua, 8))
+        {
+            if (lua_istable(lua, 8))
+            {
+                const std::vector<int> values = GetIntegerTable(lua, 8);
+                if (values.size() != 4 || values[2] <= 0 || values[3] <= 0)
+                {
+                    throw ScriptExecutionError{"region of interest must be a table {x, y, width, height} with positive width and height"};
+                }
+                roiMode = RoiMode::USER;
+                roi = Rectangle_t(values[0], values[1], values[2], values[3]);
+                if (alignMode == AlignmentMethod::PHASE_CORRELATION && !inputFiles.empty())
+                {
+                    const auto imgSize = GetImageSize(inputFiles[0]);
+                    if (imgSize.has_value() && !IsRoiWithinImage(roi, std::get<0>(*imgSize), std::get<1>(*imgSize)))
+                    {
+                        throw ScriptExecutionError(boost::str(boost::format("region of interest must lie within the first image (%dx%d)")
+                            % std::get<0>(*imgSize) % std::get<1>(*imgSize)));
+                    }
+                }
+            }
+            else if (GetInteger(lua, 8) == static_cast<int>(RoiMode::AUTOMATIC))
+            {
+                roiMode = RoiMode::AUTOMATIC;
+            }
+            else
+            {
+                throw ScriptExecutionError{"invalid region of interest"};
+            }
+        }
+
+        // optional coarse-to-fine phase correlation (Boolean)
+        const bool coarseToFine = (lua_gettop(lua) >= 9 && !lua_isnil(lua, 9)) ? GetBoolean(lua, 9) : false;
+
         const auto progressCallback = [senderWeak = scripting::g_State->Sender()](double value) {
             if (const auto sender = senderWeak.lock())
             {
@@ -248,6 +285,9 @@ const luaL_Reg functions[] = {
             subpixelAlignment,
             outputDir,
             outputFNameSuffix,
+            roiMode,
+            roi,
+            coarseToFine,
             std::move(progressCallback)
         });
 
@@ -290,7 +330,9 @@ const std::vector<std::pair<std::string, int>> constants{
     {"SOLAR_LIMB", static_cast<int>(AlignmentMethod::LIMB)},
 
     {"CROP",         static_cast<int>(CropMode::CROP_TO_INTERSECTION)},
-    {"PAD",          static_cast<int>(CropMode::PAD_TO_BOUNDING_BOX)}
+    {"PAD",          static_cast<int>(CropMode::PAD_TO_BOUNDING_BOX)},
+
+    {"AUTO_ROI",     static_cast<int>(RoiMode::AUTOMATIC)}
 };
 
 }
@@ -81,17 +81,6 @@ void ScriptImageProcessor::OnIdle(wxIdleEvent& event)
 
 void ScriptImageProcessor::OnProcessImageFile(const contents::ProcessImageFile& call, CompletionFunc onCompletion)
 {
-    std::string loadErrorMsg;
-    auto loadResult = LoadImageFileAs32f(call.imagePath, m_NormalizeFitsValues, &loadErrorMsg);
-    if (!loadResult)
-    {
-        onCompletion(call_result::Error{
-            wxString::Format(_("failed to load image from %s; %s"), call.imagePath.native(), loadErrorMsg)
-        });
-        return;
-    }
-    c_Image image = std::move(loadResult.value());
-
     const auto settings = LoadSettings(call.settingsPath.native());
     if (!settings.has_value())
     {
@@ -101,10 +90,18 @@ void ScriptImageProcessor::OnProcessImageFile(const contents::ProcessImageFile&
         return;
     }
 
-    if (settings->normalization.enabled)
+    std::string loadErrorMsg;
+    auto loadResult = LoadImageFileAs32f(
+        call.imagePath, m_NormalizeFitsValues, settings->normalization.GetLevels(), &loadErrorMsg
+    );
+    if (!loadResult)
     {
-        NormalizeFpImage(image, settings->normalization.min, settings->normalization.max);
+        onCompletion(call_result::Error{
+            wxString::Format(_("failed to load image from %s; %s"), call.imagePath.native(), loadErrorMsg)
+        });
+        return;
     }
+    c_Image image = std::move(loadResult.value());
 
     m_Processor->SetProcessingCompletedHandler(
         [this, onCompletion = std::move(onCompletion), outPath = call.outputImagePath, outFmt = call.outputFormat]
@@ -122,7 +119,8 @@ void ScriptImageProcessor::OnProcessImageFile(const contents::ProcessImageFile&
                 }
         }
     );
-    m_Processor->StartProcessing(std::move(image), *settings);
+    auto plan = GetPlan(*settings, image);
+    m_Processor->StartProcessing(std::move(image), std::move(plan));
 }
 
 void ScriptImageProcessor::OnProcessImage(const contents::ProcessImage& call, CompletionFunc onCompletion)
@@ -140,7 +138,25 @@ void ScriptImageProcessor::OnProcessImage(const contents::ProcessImage& call, Co
             });
         }
     );
-    m_Processor->StartProcessing(std::move(image), call.settings);
+    auto plan = GetPlan(call.settings, image);
+    m_Processor->StartProcessing(std::move(image), std::move(plan));
+}
+
+std::shared_ptr<imppg::backend::ProcessingPlan> ScriptImageProcessor::GetPlan(
+    const ProcessingSettings& settings,
+    const c_Image& image
+)
+{
+    if (!m_Plan)
+    {
+        m_Plan = std::make_shared<imppg::backend::ProcessingPlan>(settings, image.GetWidth(), image.GetHeight());
+    }
+    else
+    {
+        m_Plan->Update(settings);
+    }
+
+    return m_Plan;
 }
 
 static double CalculateProgress(
@@ -245,6 +261,7 @@ void ScriptImageProcessor::OnAlignImages(
     alignParams.alignmentMethod = call.alignMode;
     alignParams.subpixelAlignment = call.subpixelAlignment;
     alignParams.cropMode = call.cropMode;
+    alignParams.frameCacheBudget = DEFAULT_ALIGNMENT_FRAME_CACHE_BUDGET;
     alignParams.inputs = [&]() {
         wxArrayString files;
         for (const auto& path: call.inputFiles)
@@ -256,6 +273,9 @@ void ScriptImageProcessor::OnAlignImages(
     alignParams.normalizeFitsValues = false;
     alignParams.outputDir = call.outputDir.native();
     alignParams.outputFNameSuffix = call.outputFNameSuffix;
+    alignParams.roiMode = call.roiMode;
+    alignParams.roi = call.roi;
+    alignParams.coarseToFine = call.coarseToFine;
 
     m_AlignmentWorker = std::make_unique<c_ImageAlignmentWorkerThread>(*m_AlignmentEvtHandler, std::move(alignParams));
     m_AlignmentWorker->Run();
@@ -33,6 +33,7 @@ File description:
 #include "wxapp.h"
 #include "appconfig.h"
 #include "cursors.h"
+#include "image/image.h"
 #include "logging.h"
 #include "main_window.h"
 #if USE_FREEIMAGE
@@ -74,6 +75,12 @@ bool c_MyApp::OnInit()
     m_AppConfig = new wxFileConfig("imppg", wxEmptyString, wxEmptyString, wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
     Configuration::Initialize(m_AppConfig);
 
+    SetTiffWriteOptions({Configuration::TiffRowsPerStrip, Configuration::TiffUsePredictor});
+    SetBufferPoolOptions({
+        static_cast<std::size_t>(Configuration::BufferPoolMaxCachedMiB) << 20,
+        Configuration::BufferPoolUseHugePages
+    });
+
     if (Configuration::OpenGLInitIncomplete)
     {
         wxMessageBox(_("OpenGL back end failed to initialize when ImPPG was last started. Reverting to CPU + bitmaps mode."), _("Warning"), wxICON_WARNING | wxOK);